@@ -0,0 +1,114 @@
+#  Copyright 2020 HPS/SAFARI Research Groups
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy of
+#  this software and associated documentation files (the "Software"), to deal in
+#  the Software without restriction, including without limitation the rights to
+#  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+#  of the Software, and to permit persons to whom the Software is furnished to do
+#  so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all
+#  copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+
+"""
+Author: HPS Research Group
+Date: 10/17/2026
+Description: Benchmarks bp_replay over a set of traces and predictors. Each
+trace is first replayed from the trace itself with the first predictor, which
+also writes its branch cache. Every predictor then runs alone from the cache,
+and all of them together once more. Prints the time, branches per second and
+MPKI of every run.
+"""
+
+from __future__ import print_function
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+from scarab_globals import scarab_paths
+
+parser = argparse.ArgumentParser(description="Benchmark bp_replay", epilog="""
+From a branch cache, gshare and hybridgp replay millions of branches per
+second. tagescl replays only about 1.5 million, and mtage tens of thousands:
+both are bound by the predictor code itself, not by the replay.""")
+parser.add_argument('traces', nargs='+', help="Traces to replay (as for --cbp_trace_r0).")
+parser.add_argument('--mechs', default="gshare,hybridgp,tagescl,mtage", help="Comma-separated predictors from bp_table.def.")
+parser.add_argument('--bp_replay', default=scarab_paths.src_dir + "/bp_replay", help="bp_replay binary.")
+parser.add_argument('--params', default=None, help="PARAMS file for every run. Without it, only the defaults are used.")
+parser.add_argument('--work_dir', default="bp_replay_bench", help="Directory for the runs and the branch caches.")
+parser.add_argument('--inst_limit', type=int, default=0, help="Instructions to replay from each trace, 0 for all.")
+parser.add_argument('--keep_caches', action='store_true', help="Reuse branch caches left by an earlier run instead of reading the traces.")
+parser.add_argument('--bp_replay_args', default="", help="Arguments to pass to bp_replay directly.")
+args = parser.parse_args()
+
+speed_re = re.compile(r"^\s+([\d.]+) s\s+([\d.]+) Mbr/s\s+([\d.]+) Minst/s")
+mpki_re  = re.compile(r"^\s+(\S+)\s+(\d+)\s+([\d.]+)\s+([\d.]+)$")
+
+def run_bp_replay(run_dir, trace, cache, mechs):
+  if os.path.exists(run_dir):
+    shutil.rmtree(run_dir)
+  os.makedirs(run_dir)
+  if args.params:
+    shutil.copy(args.params, os.path.join(run_dir, "PARAMS.in"))
+  else:
+    open(os.path.join(run_dir, "PARAMS.in"), 'w').close()
+
+  cmd = [args.bp_replay, "--cbp_trace_r0", os.path.abspath(trace),
+         "--bp_replay_branch_cache", os.path.abspath(cache),
+         "--bp_replay_mechs", ",".join(mechs),
+         "--bp_replay_inst_limit", str(args.inst_limit),
+         "--bp_replay_top_branches", "0"] + args.bp_replay_args.split()
+  proc = subprocess.Popen(cmd, cwd=run_dir, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+  out = proc.communicate()[0]
+  with open(os.path.join(run_dir, "out.txt"), 'w') as f:
+    f.write(out)
+  if proc.returncode:
+    print(out, file=sys.stderr)
+    sys.exit("bp_replay failed in {}".format(run_dir))
+
+  secs, mbrs, mpki = 0.0, 0.0, {}
+  for line in out.splitlines():
+    match = speed_re.match(line)
+    if match:
+      secs, mbrs = float(match.group(1)), float(match.group(2))
+    match = mpki_re.match(line)
+    if match and match.group(1) in mechs:
+      mpki[match.group(1)] = float(match.group(3))
+  return secs, mbrs, mpki
+
+def main():
+  mechs = args.mechs.split(",")
+
+  print("{:<24} {:<6} {:<32} {:>9} {:>9}  {}".format("trace", "from", "predictors", "secs", "Mbr/s", "MPKI"))
+  for idx, trace in enumerate(args.traces):
+    name  = "{}_{}".format(idx, os.path.basename(trace).split(".")[0])
+    cache = os.path.join(args.work_dir, name + ".brc")
+    runs  = [("trace", mechs[:1])] + [("cache", [mech]) for mech in mechs]
+    if len(mechs) > 1:
+      runs.append(("cache", mechs))
+    if os.path.exists(cache) and args.keep_caches:
+      runs = runs[1:]
+    elif os.path.exists(cache):
+      os.remove(cache)
+
+    for source, run_mechs in runs:
+      run_dir = os.path.join(args.work_dir, "{}.{}.{}".format(name, source, "+".join(run_mechs)))
+      secs, mbrs, mpki = run_bp_replay(run_dir, trace, cache, run_mechs)
+      print("{:<24} {:<6} {:<32} {:>9.2f} {:>9.2f}  {}".format(
+        name[:24], source, ",".join(run_mechs)[:32], secs, mbrs,
+        " ".join("{}={:.3f}".format(mech, mpki[mech]) for mech in run_mechs if mech in mpki)))
+      sys.stdout.flush()
+
+if __name__ == "__main__":
+  main()
@@ -37,6 +37,7 @@ parser = argparse.ArgumentParser(description="Scarab Batch")
 parser.add_argument('jobfile', help="Jobfile to operator on.")
 parser.add_argument('--run', action='store_true', help="Run all jobs in jobfile.")
 parser.add_argument('--progress', action='store_true', help="Print progress of all jobs in jobfile.")
+parser.add_argument('--trace_fanout', action='store_true', help="Decode each trace once for all runs that simulate it (trace jobs on the local BatchManager only).")
 parser.add_argument('--stat', action='append', default=None, help="Print stat from results of all jobs in jobfile.")
 parser.add_argument('--core', action='append', default=None, help="Core(s) to get stats for. Only valid with --stat option.")
 parser.add_argument('--export_stat_csv', default=None, help="Export the stat as a csv file with the specified name.")
@@ -50,6 +51,8 @@ args = parser.parse_args()
 
 if not args.run and not args.progress and not args.stat:
   print("Usage: Must supply either --run, --stat, or --progress option.")
+if args.trace_fanout and not args.run:
+  print("Usage: --trace_fanout is only valid with --run option.")
 if args.results_dir and not args.stat:
   print("Usage: --results_dir is only valid with --stat option.")
 if args.core and not args.stat:
@@ -80,7 +83,7 @@ def import_jobfile(jobfile):
 
 def run_all():
   scarab_run_manager.make()
-  scarab_run_manager.run()
+  scarab_run_manager.run(trace_fanout=args.trace_fanout)
 
 def show_progress():
   scarab_run_manager.print_progress()
@@ -44,6 +44,8 @@ Interface:
 Types of BatchManagers:
   BatchManager: This will run jobs on locally on your machine. By default, BatchManager will greedily launch one job per core
           on your local system. Although this can be configured (see the constructor for BatchManager).
+          With trace_fanout, runs within a phase that simulate the same traces are launched together and share one
+          decode of each trace through Scarab's TRACE_FANOUT rings.
   PBSBatchManager: This will launch jobs on a PBS system. All jobs will be launched at once, however the dependencies between
           jobs will be conveyed to PBS. See the constructor for PBSJobManager for more details.
   SBATCHJobManager: Coming Soon!
@@ -121,6 +123,8 @@ class BatchManager:
     precommands: a set of Bash commands to run before each job begins. (currently not used)
     postcommands: a set of Bash commands to run at the end of each job. (currently not used)
     trapcommands: a set of Bash commands to run if a job terminates unnaturally (e.g., timeout). (currently not used)
+    trace_fanout: launch the runs of a phase that simulate the same traces together, decoding each trace once for all
+           of them. A group of runs counts as one job, so fewer groups are run at a time.
   """
   def __init__(self,
                phase_list=[],
@@ -129,9 +133,11 @@ class BatchManager:
                processor_cores_per_node=None,
                precommands=JobDefaults.precommands,
                postcommands=JobDefaults.postcommands,
-               trapcommands=JobDefaults.trapcommands
+               trapcommands=JobDefaults.trapcommands,
+               trace_fanout=False
               ):
     self.phase_list = phase_list
+    self.trace_fanout = trace_fanout
     self.email=email
     self.walltime=walltime
     self.processor_cores_per_node=processor_cores_per_node
@@ -151,6 +157,47 @@ class BatchManager:
     print(cmd)
     return returncode
 
+  @staticmethod
+  def run_command_group(cmd_list):
+    """
+    Runs a group of commands that share trace fan-out rings. They must all run at the same time.
+    """
+    if len(cmd_list) == 1:
+      return BatchManager.run_command(cmd_list[0])
+
+    for cmd in cmd_list:
+      cmd.write_to_snapshot_log(0)
+      cmd.run_in_background()
+    returncode = 0
+    for cmd in cmd_list:
+      cmd.returncode = cmd.process.wait()
+      print("Finished command with return code: {}".format(cmd.returncode))
+      print(cmd)
+      returncode = returncode or cmd.returncode
+    return returncode
+
+  def group_by_trace(self, command_list):
+    """
+    Splits command_list into groups of commands that simulate the same traces (in the same core order). Each group
+    gets its own set of fan-out rings. Groups are at most as large as the number of jobs run at a time.
+    """
+    max_readers = self.processor_cores_per_node or multiprocessing.cpu_count()
+    groups = {}
+    for cmd in command_list:
+      key = tuple(cmd.trace_list) if getattr(cmd, 'trace_list', None) else id(cmd)
+      groups.setdefault(key, []).append(cmd)
+
+    group_list = []
+    for cmd_list in groups.values():
+      for i in range(0, len(cmd_list), max_readers):
+        group = cmd_list[i:i + max_readers]
+        if len(group) > 1:
+          fanout_name = "scarab_fanout_{pid}_{group_id}".format(pid=os.getpid(), group_id=len(group_list))
+          for cmd in group:
+            cmd.cmd += " --trace_fanout {name} --trace_fanout_readers {readers}".format(name=fanout_name, readers=len(group))
+        group_list.append(group)
+    return group_list
+
   def run(self):
     """
     If num_threads is None, Pool() uses number of cores in the system.
@@ -170,8 +217,15 @@ class BatchManager:
         num_threads=self.processor_cores_per_node
         ))
 
-      with multiprocessing.Pool(self.processor_cores_per_node) as pool:
-        pool.map(BatchManager.run_command, command_list)
+      if self.trace_fanout:
+        group_list = self.group_by_trace(command_list)
+        max_group = max([len(group) for group in group_list], default=1)
+        num_threads = self.processor_cores_per_node or multiprocessing.cpu_count()
+        with multiprocessing.Pool(max(1, num_threads // max_group)) as pool:
+          pool.map(BatchManager.run_command_group, group_list)
+      else:
+        with multiprocessing.Pool(self.processor_cores_per_node) as pool:
+          pool.map(BatchManager.run_command, command_list)
 
 class PBSBatchManager(BatchManager):
   """Launches jobs on a PBS system. Jobs are all launched at once, but the job dependency information is conveyed to the PBS system.
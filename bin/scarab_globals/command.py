@@ -47,6 +47,7 @@ class Command:
     self.process     = None
     self.name        = name
     self.snapshot_log = None
+    self.trace_list  = None # Traces simulated by the command, used by trace fan-out
 
     # Batch Variables
     self.walltime        = CommandDefaults.walltime
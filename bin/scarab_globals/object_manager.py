@@ -58,13 +58,16 @@ class ScarabRunManager(ObjectManager):
         job.create_snapshot()
         job.make()
 
-    def run(self):
+    def run(self, trace_fanout=False):
       """
       If a BatchManager has not been specified, then create a local BatchManager
       If no phase has been specified, then create a phase and add all known ScarabRuns objects to phase
+      trace_fanout turns on trace fan-out in the BatchManager (see BatchManager)
       """
       if not self.batch_manager:
         self.batch_manager = BatchManager()
+      if trace_fanout:
+        self.batch_manager.trace_fanout = True
       if len(self.batch_manager.phase_list) == 0:
         self.batch_manager.phase_list.append(Phase(self.pool))
 
@@ -380,6 +380,23 @@ def get_program_or_checkpoint_options(job):
 
   return run_exec
 
+def get_trace_list(job):
+  """
+  Returns the traces that job simulates (one per core), or None if job is not
+  a Trace or a Mix of only Traces.
+  """
+  if type(job) is Trace:
+    return [os.path.abspath(job.path)]
+  if type(job) is Mix:
+    trace_list = []
+    for mix in job.mix_list:
+      mix_traces = get_trace_list(mix)
+      if mix_traces is None:
+        return None
+      trace_list += mix_traces
+    return trace_list
+  return None
+
 def generate_run_command(job, results_dir, scarab_params):
   scarab_args = job.scarab_args + scarab_params.scarab_args + \
           " --num_cores {num_cores} --output_dir {output_dir}".format(num_cores=job.num_cores, output_dir=results_dir)
@@ -405,4 +422,5 @@ def generate_run_command(job, results_dir, scarab_params):
   cmd.memory_per_core = scarab_params.memory_per_core
   cmd.cores = scarab_params.cores
   cmd.snapshot_log = scarab_params.snapshot_log
+  cmd.trace_list = get_trace_list(job)
   return cmd
@@ -53,6 +53,8 @@ parser.add_argument('--pin', default=scarab_paths.pin_dir + "/pin", help="Path t
 parser.add_argument('--frontend_pin_tool', default=scarab_paths.pin_bin, help="Path to the pin tool that will act as the frontend.")
 parser.add_argument('--checkpoint_loader', default=scarab_paths.checkpoint_loader_bin, help="Path to checkpoint loader executable.")
 parser.add_argument('--frontend', default="exec", choices=["exec", "trace"], help="Selects between the Trace fronend and the Exec-driven frontend.")
+parser.add_argument('--trace_fanout', default=None, help="Name of the shared-memory rings through which several Scarab runs on the same traces share one trace decode (trace frontend only).")
+parser.add_argument('--trace_fanout_readers', default=None, type=int, help="Number of Scarab runs that read the --trace_fanout rings.")
 
 args = parser.parse_args()
 
@@ -117,6 +119,8 @@ class Scarab:
       frontend_specific_args = f'--fetch_off_path_ops 0 --frontend trace'
       for i, trace in enumerate(self.trace_list):
         frontend_specific_args += f' --cbp_trace_r{i} {trace}'
+      if args.trace_fanout:
+        frontend_specific_args += f' --trace_fanout {args.trace_fanout} --trace_fanout_readers {args.trace_fanout_readers}'
     
     elif self.frontend == 'exec_driven':
       frontend_specific_args = f'--frontend pin_exec_driven --pin_exec_driven_fe_socket {self.socket_path}'
@@ -51,6 +51,7 @@
 #include "core.param.h"
 #include "debug/debug.param.h"
 #include "frontend/pin_trace_fe.h"
+#include "general.param.h"
 #include "statistics.h"
 
 /******************************************************************************/
@@ -216,6 +217,20 @@ void init_bp_data(uns8 proc_id, Bp_Data* bp_data) {
     bp_data->late_bp = NULL;
   }
 
+  /* reject a checkpoint the predictors can't take before warming them up */
+  if(WARMUP_CKPT_SAVE || WARMUP_CKPT_LOAD) {
+    if(!bp_data->bp->ckpt_func)
+      FATAL_ERROR(proc_id,
+                  "Branch predictor '%s' does not support warmup checkpoints "
+                  "(WARMUP_CKPT_SAVE/WARMUP_CKPT_LOAD)\n",
+                  bp_data->bp->name);
+    if(USE_LATE_BP && !bp_data->late_bp->ckpt_func)
+      FATAL_ERROR(proc_id,
+                  "Late branch predictor '%s' does not support warmup "
+                  "checkpoints (WARMUP_CKPT_SAVE/WARMUP_CKPT_LOAD)\n",
+                  bp_data->late_bp->name);
+  }
+
 
   /* init btb structure */
   bp_data->bp_btb = &bp_btb_table[BTB_MECH];
@@ -695,3 +710,47 @@ void bp_recover_op(Bp_Data* bp_data, Cf_Type cf_type, Recovery_Info* info) {
   if(ENABLE_BP_CONF && bp_data->br_conf->recover_func)
     bp_data->br_conf->recover_func();
 }
+
+
+/******************************************************************************/
+/* bp_ckpt: saves or restores the warmed-up predictor state of a core. The
+   histories, the BTB, the CRS and the indirect target predictor are handled
+   here; the direction predictors provide their own ckpt_func (init_bp_data
+   rejects the ones that don't). */
+
+void bp_ckpt(Bp_Data* bp_data, Ckpt* ckpt) {
+  uns8 proc_id = bp_data->proc_id;
+
+  ckpt_region(ckpt, "bp global_hist", &bp_data->global_hist,
+              sizeof(bp_data->global_hist));
+  ckpt_region(ckpt, "bp targ_hist", &bp_data->targ_hist,
+              sizeof(bp_data->targ_hist));
+  cache_ckpt(&bp_data->btb, ckpt);
+
+  ckpt_region(ckpt, "bp crs entries", bp_data->crs.entries,
+              sizeof(Crs_Entry) * CRS_ENTRIES * 2);
+  ckpt_region(ckpt, "bp crs off_path", bp_data->crs.off_path,
+              sizeof(Flag) * CRS_ENTRIES);
+  ckpt_region(ckpt, "bp crs depth", &bp_data->crs.depth,
+              sizeof(bp_data->crs.depth));
+  ckpt_region(ckpt, "bp crs head", &bp_data->crs.head,
+              sizeof(bp_data->crs.head));
+  ckpt_region(ckpt, "bp crs tail", &bp_data->crs.tail,
+              sizeof(bp_data->crs.tail));
+  ckpt_region(ckpt, "bp crs tos", &bp_data->crs.tos, sizeof(bp_data->crs.tos));
+  ckpt_region(ckpt, "bp crs next", &bp_data->crs.next,
+              sizeof(bp_data->crs.next));
+
+  if(bp_data->tc_tagged.entries)
+    cache_ckpt(&bp_data->tc_tagged, ckpt);
+  if(bp_data->tc_tagless)
+    ckpt_region(ckpt, "bp tc_tagless", bp_data->tc_tagless,
+                sizeof(Addr) * (0x1 << IBTB_HIST_LENGTH));
+  if(bp_data->tc_selector)
+    ckpt_region(ckpt, "bp tc_selector", bp_data->tc_selector,
+                sizeof(uns8) * (0x1 << IBTB_HIST_LENGTH));
+
+  bp_data->bp->ckpt_func(proc_id, ckpt);
+  if(USE_LATE_BP)
+    bp_data->late_bp->ckpt_func(proc_id, ckpt);
+}
@@ -217,6 +217,8 @@ typedef struct Bp_struct {
                                the bp that has to be updated after retirement*/
   void (*recover_func)(Recovery_Info*); /* called to recover the bp when a
                                            misprediction is realized */
+  void (*ckpt_func)(uns8, Ckpt*); /* called to save or restore the warmed-up
+                                     state of a core (NULL if unsupported) */
 } Bp;
 
 typedef struct Bp_Btb_struct {
@@ -282,6 +284,7 @@ void bp_target_known_op(Bp_Data*, Op*);
 void bp_resolve_op(Bp_Data*, Op*);
 void bp_retire_op(Bp_Data*, Op*);
 void bp_recover_op(Bp_Data*, Cf_Type, Recovery_Info*);
+void bp_ckpt(Bp_Data*, Ckpt*);
 
 
 /**************************************************************************************/
@@ -106,3 +106,9 @@ void bp_gshare_update(Op* op) {
   DEBUG(proc_id, "Updating addr:%s  pht:%u  ent:%u  dir:%d\n", hexstr64s(addr),
         pht_index, gshare_state.pht[pht_index], op->oracle_info.dir);
 }
+
+void bp_gshare_ckpt(uns8 proc_id, Ckpt* ckpt) {
+  auto& gshare_state = gshare_state_all_cores.at(proc_id);
+  ckpt_region(ckpt, "gshare pht", gshare_state.pht.data(),
+              gshare_state.pht.size());
+}
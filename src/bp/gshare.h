@@ -36,6 +36,7 @@ void bp_gshare_spec_update(Op*);
 void bp_gshare_update(Op*);
 void bp_gshare_retire(Op*);
 void bp_gshare_recover(Recovery_Info*);
+void bp_gshare_ckpt(uns8, Ckpt*);
 
 #ifdef __cplusplus
 }
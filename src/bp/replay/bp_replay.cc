@@ -0,0 +1,608 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : bp/replay/bp_replay.cc
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Standalone branch predictor replay. Reads the control-flow
+ *                records of the trace in cbp_trace_r0 and drives one or more
+ *                bp_table.def predictors (bp_replay_mechs) with them through
+ *                the same entry points, and in the same order, as bp.c.
+ *                Predictors run side by side over a single decode of the
+ *                trace; each one gets its own proc_id, so its tables are the
+ *                ones a core with that id would use. Parameters are read
+ *                exactly as Scarab reads them (PARAMS.in and the command
+ *                line), so the predictor knobs sweep the same way.
+ *
+ *                Only the direction predictor is modeled: the BTB, the CRS and
+ *                the indirect predictor are perfect, and gshare and hybridgp
+ *                see the branch address instead of the fetch address. Each
+ *                predictor keeps up to bp_replay_window branches in flight;
+ *                the oldest one resolves (update, then retire) when another
+ *                is predicted, and a misprediction recovers the predictor
+ *                and resolves everything in flight, as there is no wrong
+ *                path to fetch. Time advances one cycle per instruction.
+ *
+ *                With trace_fanout, parallel bp_replay processes of a sweep
+ *                also share the decompression of the trace.
+ *
+ *                Decompressing and decoding the trace costs far more than
+ *                most predictors do, so bp_replay_branch_cache keeps just the
+ *                branches of the trace in an uncompressed file. The first run
+ *                writes it while reading the trace, and later runs replay
+ *                from it without touching the trace. From the cache, gshare
+ *                and hybridgp run at millions of branches per second, but
+ *                TAGE-SC-L and the CBP predictors are bound by their own
+ *                update and prediction work (see docs/running-scarab.md).
+ ***************************************************************************************/
+
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "bp/bp.h"
+#include "debug/debug_print.h"
+#include "frontend/pin_trace_read.h"
+#include "libs/hash_lib.h"
+#include "param_parser.h"
+#include "statistics.h"
+
+#include "bp/bp.param.h"
+#include "core.param.h"
+}
+
+/**************************************************************************************/
+/* Macros */
+
+#define REPLAY_CACHE_MAGIC "BPRCACH1"
+#define REPLAY_CACHE_CHUNK 4096 /* records read at a time */
+
+/**************************************************************************************/
+/* Types */
+
+/* One executed branch, as kept in the branch cache */
+typedef struct Replay_Record_struct {
+  Addr  target;
+  Addr  npc;
+  uns32 branch;     /* static branch, numbered in order of first execution */
+  uns32 insts : 31; /* instructions since the previous branch, this one too */
+  uns32 dir : 1;
+} Replay_Record;
+
+/* One static branch, as kept in the branch cache after the records */
+typedef struct Replay_Cache_Branch_struct {
+  Addr  pc;
+  uns32 size;
+  uns32 cf_type;
+} Replay_Cache_Branch;
+
+typedef struct Replay_Cache_Header_struct {
+  char    magic[8];
+  Counter num_insts; /* instructions of the trace the records cover */
+  Counter num_records;
+  Counter num_branches;
+  uns32   record_size; /* sizeof(Replay_Record) */
+  uns32   complete;    /* TRUE if the records reach the end of the trace */
+} Replay_Cache_Header;
+
+typedef struct Replay_Slot_struct {
+  Op         op;
+  Inst_Info  inst_info;
+  Table_Info table_info;
+  Counter    pred_cycle;
+} Replay_Slot;
+
+typedef struct Replay_Bp_struct {
+  const Bp*                bp;
+  uns8                     proc_id;
+  uns32                    global_hist;
+  std::vector<Replay_Slot> slots; /* ring of in-flight branches */
+  uns                      head;
+  uns                      num_in_flight;
+  Counter                  mispreds;
+} Replay_Bp;
+
+typedef struct Replay_Branch_struct {
+  Addr    pc;
+  uns8    size;
+  Cf_Type cf_type;
+  Counter execs;
+  Counter taken;
+} Replay_Branch;
+
+/**************************************************************************************/
+/* Global Variables */
+
+static std::vector<Replay_Bp>     replay_bps;
+static std::vector<Replay_Branch> replay_branches;
+static std::vector<Counter>       replay_mispreds; /* [branch][bp] */
+static Hash_Table                 replay_branch_index;
+static Counter                    replay_op_num;
+
+/**************************************************************************************/
+/* Local prototypes */
+
+static void    replay_init_bps(void);
+static uns     replay_branch(Addr pc, uns8 size, Cf_Type cf_type);
+static void    replay_resolve_oldest(Replay_Bp* rbp);
+static Op*     replay_predict(Replay_Bp* rbp, Addr pc, uns8 size,
+                              Cf_Type cf_type, Flag dir, Addr target, Addr npc);
+static void    replay_recover(Replay_Bp* rbp, Op* op);
+static void    replay_record(const Replay_Record* rec);
+static void    replay_write_cache(FILE* cache, Replay_Cache_Header* header);
+static Counter replay_trace(FILE* cache, Replay_Cache_Header* header);
+static Counter replay_cache(FILE* cache);
+static void    replay_report(const char* trace, Counter num_insts, double secs);
+static void    replay_dump_branches(const char* file_name);
+static double  replay_now(void);
+
+/**************************************************************************************/
+/* replay_init_bps: looks up the predictors named in bp_replay_mechs and gives
+   each one a core of its own */
+
+static void replay_init_bps(void) {
+  char  buf[MAX_STR_LENGTH + 1];
+  char* saveptr;
+
+  strncpy(buf, BP_REPLAY_MECHS ? BP_REPLAY_MECHS : bp_table[BP_MECH].name,
+          MAX_STR_LENGTH);
+  buf[MAX_STR_LENGTH] = '\0';
+  for(char* name = strtok_r(buf, ",", &saveptr); name;
+      name       = strtok_r(NULL, ",", &saveptr)) {
+    Replay_Bp rbp = {};
+    uns       ii;
+
+    for(ii = 0; bp_table[ii].name; ii++)
+      if(!strncmp(name, bp_table[ii].name, MAX_STR_LENGTH))
+        break;
+    if(!bp_table[ii].name)
+      FATAL_ERROR(0, "Invalid value ('%s') for parameter 'bp_replay_mechs'\n",
+                  name);
+    // Predictors that share an init function share their per-core tables too,
+    // which are built for whichever of them initializes first.
+    for(const Replay_Bp& other : replay_bps)
+      if(other.bp->init_func == bp_table[ii].init_func)
+        FATAL_ERROR(0,
+                    "Branch predictors '%s' and '%s' cannot be replayed "
+                    "together\n",
+                    other.bp->name, name);
+    rbp.bp      = &bp_table[ii];
+    rbp.proc_id = replay_bps.size();
+    replay_bps.push_back(rbp);
+  }
+  ASSERTM(0, replay_bps.size() && replay_bps.size() <= MAX_NUM_PROCS,
+          "bp_replay_mechs must name between 1 and %d predictors\n",
+          MAX_NUM_PROCS);
+  ASSERTM(0, BP_REPLAY_WINDOW > 0, "bp_replay_window must be at least 1\n");
+
+  // The predictors size their tables by NUM_CORES and pick their flavor by
+  // BP_MECH when they are initialized.
+  NUM_CORES  = replay_bps.size();
+  op_count   = (Counter*)calloc(NUM_CORES, sizeof(Counter));
+  inst_count = (Counter*)calloc(NUM_CORES, sizeof(Counter));
+  init_global_stats_array();
+  for(Replay_Bp& rbp : replay_bps) {
+    init_global_stats(rbp.proc_id);
+    rbp.slots.resize(BP_REPLAY_WINDOW);
+    BP_MECH = rbp.bp->id;
+    rbp.bp->init_func();
+  }
+}
+
+/**************************************************************************************/
+/* replay_branch: returns the index of the static branch at pc */
+
+static uns replay_branch(Addr pc, uns8 size, Cf_Type cf_type) {
+  Flag new_entry;
+  uns* idx = (uns*)hash_table_access_create(&replay_branch_index, pc,
+                                            &new_entry);
+  if(new_entry) {
+    Replay_Branch br = {pc, size, cf_type, 0, 0};
+    *idx             = replay_branches.size();
+    replay_branches.push_back(br);
+    replay_mispreds.resize(replay_mispreds.size() + replay_bps.size(), 0);
+  }
+  return *idx;
+}
+
+/**************************************************************************************/
+/* replay_resolve_oldest: the oldest in-flight branch executes and retires */
+
+static void replay_resolve_oldest(Replay_Bp* rbp) {
+  Replay_Slot* slot = &rbp->slots[rbp->head];
+
+  // hybridgp expects a branch to resolve after it decodes
+  cycle_count = MAX2(cycle_count, slot->pred_cycle + DECODE_CYCLES + 1);
+  rbp->bp->update_func(&slot->op);
+  rbp->bp->retire_func(&slot->op);
+  rbp->head = (rbp->head + 1) % BP_REPLAY_WINDOW;
+  rbp->num_in_flight--;
+}
+
+/**************************************************************************************/
+/* replay_predict: predicts one branch the way bp_predict_op does and returns
+   its op */
+
+static Op* replay_predict(Replay_Bp* rbp, Addr pc, uns8 size, Cf_Type cf_type,
+                          Flag dir, Addr target, Addr npc) {
+  Replay_Slot* slot;
+  Op*          op;
+  Addr         pred_npc;
+
+  if(rbp->num_in_flight == BP_REPLAY_WINDOW)
+    replay_resolve_oldest(rbp);
+  slot = &rbp->slots[(rbp->head + rbp->num_in_flight++) % BP_REPLAY_WINDOW];
+  op   = &slot->op;
+
+  slot->pred_cycle                     = cycle_count;
+  slot->inst_info.addr                 = pc;
+  slot->inst_info.trace_info.inst_size = size;
+  slot->table_info.cf_type             = cf_type;
+  op->proc_id                          = rbp->proc_id;
+  op->op_num                           = replay_op_num;
+  op->inst_info                        = &slot->inst_info;
+  op->table_info                       = &slot->table_info;
+  op->oracle_info.dir                  = dir;
+  op->oracle_info.target               = target;
+  op->oracle_info.npc                  = npc;
+  op->oracle_info.pred_addr            = pc;
+  op->recovery_info.proc_id            = rbp->proc_id;
+  op->recovery_info.pred_global_hist   = rbp->global_hist;
+  op->recovery_info.new_dir            = dir;
+  op->recovery_info.op_num             = replay_op_num;
+  op->recovery_info.PC                 = pc;
+  op->recovery_info.cf_type            = cf_type;
+  op->recovery_info.oracle_dir         = dir;
+  op->recovery_info.branchTarget       = target;
+
+  rbp->bp->timestamp_func(op);
+  if(cf_type == CF_CBR) {
+    op->oracle_info.pred_global_hist = rbp->global_hist;
+    op->oracle_info.pred             = rbp->bp->pred_func(op);
+    rbp->global_hist = (rbp->global_hist >> 1) | (op->oracle_info.pred << 31);
+  } else {
+    op->oracle_info.pred = TAKEN;
+  }
+  rbp->bp->spec_update_func(op);
+
+  // the target of a taken prediction always comes from a perfect BTB
+  pred_npc = op->oracle_info.pred ? target : ADDR_PLUS_OFFSET(pc, size);
+  op->oracle_info.mispred = op->oracle_info.pred != dir && pred_npc != npc;
+  return op;
+}
+
+/**************************************************************************************/
+/* replay_recover: recovers a mispredicted branch the way bp_recover_op does
+   and resolves everything in flight */
+
+static void replay_recover(Replay_Bp* rbp, Op* op) {
+  Recovery_Info* info = &op->recovery_info;
+
+  if(info->cf_type == CF_CBR)
+    rbp->global_hist = (info->pred_global_hist >> 1) | (info->new_dir << 31);
+  else
+    rbp->global_hist = info->pred_global_hist;
+  rbp->bp->recover_func(info);
+  while(rbp->num_in_flight)
+    replay_resolve_oldest(rbp);
+}
+
+/**************************************************************************************/
+/* replay_report: prints the MPKI of each predictor and the branches they
+   mispredict the most */
+
+static void replay_report(const char* trace, Counter num_insts, double secs) {
+  Counter              num_brs = 0, num_cbrs = 0;
+  std::vector<uns>     order(replay_branches.size());
+  std::vector<Counter> total(replay_branches.size(), 0);
+  uns                  num_bps = replay_bps.size();
+  uns                  ii, jj;
+
+  for(ii = 0; ii < replay_branches.size(); ii++) {
+    order[ii] = ii;
+    num_brs += replay_branches[ii].execs;
+    if(replay_branches[ii].cf_type == CF_CBR)
+      num_cbrs += replay_branches[ii].execs;
+    for(jj = 0; jj < num_bps; jj++)
+      total[ii] += replay_mispreds[ii * num_bps + jj];
+  }
+
+  fprintf(mystdout, "bp_replay: %s\n", trace);
+  fprintf(mystdout,
+          "  insts %llu  branches %llu  cbrs %llu  static branches %llu  "
+          "window %u\n",
+          num_insts, num_brs, num_cbrs, (Counter)replay_branches.size(),
+          BP_REPLAY_WINDOW);
+  fprintf(mystdout, "  %.2f s  %.2f Mbr/s  %.2f Minst/s\n", secs,
+          num_brs / secs / 1e6, num_insts / secs / 1e6);
+  fprintf(mystdout, "\n  %-12s %12s %10s %14s\n", "predictor", "mispreds",
+          "MPKI", "mispred/kcbr");
+  for(const Replay_Bp& rbp : replay_bps)
+    fprintf(mystdout, "  %-12s %12llu %10.4f %14.4f\n", rbp.bp->name,
+            rbp.mispreds, 1000.0 * rbp.mispreds / MAX2(num_insts, 1),
+            1000.0 * rbp.mispreds / MAX2(num_cbrs, 1));
+
+  if(!BP_REPLAY_TOP_BRANCHES)
+    return;
+  std::sort(order.begin(), order.end(), [&total](uns a, uns b) {
+    return total[a] != total[b] ? total[a] > total[b] : a < b;
+  });
+  fprintf(mystdout, "\n  most mispredicted branches\n  %-18s %-8s %12s %8s",
+          "pc", "cf_type", "execs", "taken%");
+  for(const Replay_Bp& rbp : replay_bps)
+    fprintf(mystdout, " %12s", rbp.bp->name);
+  fprintf(mystdout, "\n");
+  for(ii = 0; ii < MIN2(BP_REPLAY_TOP_BRANCHES, order.size()); ii++) {
+    const Replay_Branch* br = &replay_branches[order[ii]];
+    if(!total[order[ii]])
+      break;
+    fprintf(mystdout, "  0x%-16s %-8s %12llu %7.2f%%", hexstr64(br->pc),
+            cf_type_names[br->cf_type], br->execs,
+            100.0 * br->taken / br->execs);
+    for(jj = 0; jj < num_bps; jj++)
+      fprintf(mystdout, " %12llu", replay_mispreds[order[ii] * num_bps + jj]);
+    fprintf(mystdout, "\n");
+  }
+}
+
+/**************************************************************************************/
+/* replay_dump_branches: writes the stats of every static branch */
+
+static void replay_dump_branches(const char* file_name) {
+  FILE* file    = fopen(file_name, "w");
+  uns   num_bps = replay_bps.size();
+
+  ASSERTM(0, file, "Could not open %s\n", file_name);
+  fprintf(file, "pc,cf_type,execs,taken");
+  for(const Replay_Bp& rbp : replay_bps)
+    fprintf(file, ",%s", rbp.bp->name);
+  fprintf(file, "\n");
+  for(uns ii = 0; ii < replay_branches.size(); ii++) {
+    const Replay_Branch* br = &replay_branches[ii];
+    fprintf(file, "0x%s,%s,%llu,%llu", hexstr64(br->pc),
+            cf_type_names[br->cf_type], br->execs, br->taken);
+    for(uns jj = 0; jj < num_bps; jj++)
+      fprintf(file, ",%llu", replay_mispreds[ii * num_bps + jj]);
+    fprintf(file, "\n");
+  }
+  fclose(file);
+}
+
+static double replay_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**************************************************************************************/
+/* replay_record: predicts one branch with every predictor */
+
+static void replay_record(const Replay_Record* rec) {
+  Replay_Branch* br = &replay_branches[rec->branch];
+
+  cycle_count += rec->insts;
+  br->execs++;
+  br->taken += rec->dir;
+  replay_op_num++;
+  for(Replay_Bp& rbp : replay_bps) {
+    Op* op = replay_predict(&rbp, br->pc, br->size, br->cf_type, rec->dir,
+                            rec->target, rec->npc);
+    if(op->oracle_info.mispred) {
+      rbp.mispreds++;
+      replay_mispreds[rec->branch * replay_bps.size() + rbp.proc_id]++;
+      replay_recover(&rbp, op);
+    }
+  }
+}
+
+/**************************************************************************************/
+/* replay_trace: replays the branches of cbp_trace_r0 and, if cache is not
+   NULL, writes their records to it. Returns the number of instructions
+   read. */
+
+static Counter replay_trace(FILE* cache, Replay_Cache_Header* header) {
+  const ctype_pin_inst* pi        = NULL;
+  Counter               num_insts = 0;
+  Counter               insts     = 0;
+
+  pin_trace_file_pointer_init(1);
+  pin_trace_open(0, CBP_TRACE_R0);
+  while((!BP_REPLAY_INST_LIMIT || num_insts < BP_REPLAY_INST_LIMIT) &&
+        (pi = pin_trace_next(0))) {
+    Cf_Type       cf_type = (Cf_Type)pi->cf_type;
+    Replay_Record rec;
+
+    if(pi->fake_inst)
+      continue;
+    num_insts++;
+    insts++;
+    rec.target = pi->branch_target;
+    rec.npc    = pi->instruction_next_addr;
+    rec.dir    = cf_type == CF_CBR ? pi->actually_taken : TAKEN;
+    if(pi->is_repeat) {
+      // the uop generator ends every repeated instruction with a conditional
+      // branch back to itself
+      cf_type    = CF_CBR;
+      rec.target = pi->instruction_addr;
+      rec.dir    = rec.npc == rec.target;
+    } else if(cf_type == NOT_CF) {
+      continue;
+    }
+
+    ASSERTM(0, insts < (1U << 31), "Too many instructions between branches\n");
+    rec.branch = replay_branch(pi->instruction_addr, pi->size, cf_type);
+    rec.insts  = insts;
+    replay_record(&rec);
+    if(cache && fwrite(&rec, sizeof(rec), 1, cache) != 1)
+      FATAL_ERROR(0, "Could not write the branch cache\n");
+    header->num_records++;
+    insts = 0;
+  }
+  cycle_count += insts;
+  pin_trace_close(0);
+
+  header->num_insts = num_insts;
+  header->complete  = !pi;
+  return num_insts;
+}
+
+/**************************************************************************************/
+/* replay_write_cache: finishes a cache whose records replay_trace wrote */
+
+static void replay_write_cache(FILE* cache, Replay_Cache_Header* header) {
+  for(const Replay_Branch& br : replay_branches) {
+    Replay_Cache_Branch cbr = {br.pc, br.size, (uns32)br.cf_type};
+    if(fwrite(&cbr, sizeof(cbr), 1, cache) != 1)
+      FATAL_ERROR(0, "Could not write the branch cache\n");
+  }
+  memcpy(header->magic, REPLAY_CACHE_MAGIC, sizeof(header->magic));
+  header->num_branches = replay_branches.size();
+  header->record_size  = sizeof(Replay_Record);
+  if(fseek(cache, 0, SEEK_SET) ||
+     fwrite(header, sizeof(*header), 1, cache) != 1)
+    FATAL_ERROR(0, "Could not write the branch cache\n");
+}
+
+/**************************************************************************************/
+/* replay_cache: replays the branches of a cache written by replay_trace.
+   Returns the number of instructions they cover. */
+
+static Counter replay_cache(FILE* cache) {
+  Replay_Cache_Header              header;
+  std::vector<Replay_Cache_Branch> cbrs;
+  std::vector<Replay_Record>       recs(REPLAY_CACHE_CHUNK);
+  Counter                          num_insts = 0;
+  Counter                          limit;
+  Counter                          left;
+
+  if(fread(&header, sizeof(header), 1, cache) != 1 ||
+     memcmp(header.magic, REPLAY_CACHE_MAGIC, sizeof(header.magic)) ||
+     header.record_size != sizeof(Replay_Record))
+    FATAL_ERROR(0, "%s is not a bp_replay branch cache\n",
+                BP_REPLAY_BRANCH_CACHE);
+  if(!header.complete &&
+     (!BP_REPLAY_INST_LIMIT || BP_REPLAY_INST_LIMIT > header.num_insts))
+    FATAL_ERROR(0,
+                "Branch cache %s covers only %llu instructions of the trace "
+                "(it was written with a smaller bp_replay_inst_limit)\n",
+                BP_REPLAY_BRANCH_CACHE, header.num_insts);
+  limit = BP_REPLAY_INST_LIMIT ? MIN2(BP_REPLAY_INST_LIMIT, header.num_insts) :
+                                 header.num_insts;
+
+  cbrs.resize(header.num_branches);
+  if(fseek(cache, header.num_records * sizeof(Replay_Record), SEEK_CUR) ||
+     fread(cbrs.data(), sizeof(Replay_Cache_Branch), cbrs.size(), cache) !=
+       cbrs.size() ||
+     fseek(cache, sizeof(header), SEEK_SET))
+    FATAL_ERROR(0, "Branch cache %s is truncated\n", BP_REPLAY_BRANCH_CACHE);
+
+  // static branches are numbered in order of first execution, so each new
+  // one is the next to add
+  for(left = header.num_records; left;) {
+    size_t count = fread(recs.data(), sizeof(Replay_Record),
+                         MIN2(left, (Counter)REPLAY_CACHE_CHUNK), cache);
+    if(!count)
+      FATAL_ERROR(0, "Branch cache %s is truncated\n", BP_REPLAY_BRANCH_CACHE);
+    left -= count;
+    for(size_t ii = 0; ii < count; ii++) {
+      const Replay_Record* rec = &recs[ii];
+      if(num_insts + rec->insts > limit)
+        goto done;
+      num_insts += rec->insts;
+      if(rec->branch == replay_branches.size()) {
+        const Replay_Cache_Branch* cbr = &cbrs[rec->branch];
+        replay_branch(cbr->pc, cbr->size, (Cf_Type)cbr->cf_type);
+      }
+      ASSERT(0, rec->branch < replay_branches.size());
+      replay_record(rec);
+    }
+  }
+
+done:
+  cycle_count += limit - num_insts;
+  return limit;
+}
+
+/**************************************************************************************/
+
+int main(int argc, char* argv[]) {
+  Counter num_insts;
+  double  start;
+  FILE*   cache = NULL;
+
+  mystdout = stdout;
+  mystderr = stderr;
+  mystatus = NULL;
+
+  get_params(argc, argv);
+  ASSERTM(0, CBP_TRACE_R0, "No trace file specified (use --cbp_trace_r0)\n");
+  replay_init_bps();
+  init_hash_table(&replay_branch_index, "bp_replay branches", 1 << 16,
+                  sizeof(uns));
+
+  start = replay_now();
+  if(BP_REPLAY_BRANCH_CACHE && (cache = fopen(BP_REPLAY_BRANCH_CACHE, "rb"))) {
+    num_insts = replay_cache(cache);
+    fclose(cache);
+  } else {
+    Replay_Cache_Header header = {};
+    char                tmp_name[MAX_STR_LENGTH + 1];
+
+    if(BP_REPLAY_BRANCH_CACHE) {
+      // written under a temporary name, so that a parallel run never reads a
+      // partial cache
+      snprintf(tmp_name, sizeof(tmp_name), "%s.%d", BP_REPLAY_BRANCH_CACHE,
+               (int)getpid());
+      cache = fopen(tmp_name, "wb");
+      if(!cache || fwrite(&header, sizeof(header), 1, cache) != 1)
+        FATAL_ERROR(0, "Could not create %s: %s\n", tmp_name,
+                    strerror(errno));
+    }
+    num_insts = replay_trace(cache, &header);
+    if(cache) {
+      replay_write_cache(cache, &header);
+      if(fclose(cache) || rename(tmp_name, BP_REPLAY_BRANCH_CACHE))
+        FATAL_ERROR(0, "Could not write the branch cache %s: %s\n",
+                    BP_REPLAY_BRANCH_CACHE, strerror(errno));
+    }
+  }
+  for(Replay_Bp& rbp : replay_bps)
+    while(rbp.num_in_flight)
+      replay_resolve_oldest(&rbp);
+
+  replay_report(CBP_TRACE_R0, num_insts, replay_now() - start);
+  if(BP_REPLAY_BRANCH_FILE)
+    replay_dump_branches(BP_REPLAY_BRANCH_FILE);
+  return 0;
+}
@@ -66,6 +66,10 @@ Branch_Type get_branch_type(uns proc_id, Cf_Type cf_type) {
   }
   return br_type;
 }
+
+void ckpt_region_func(void* ckpt, const char* name, void* ptr, size_t size) {
+  ckpt_region((Ckpt*)ckpt, name, ptr, size);
+}
 }  // end of anonymous namespace
 
 void bp_tagescl_init() {
@@ -127,3 +131,7 @@ void bp_tagescl_recover(Recovery_Info* recovery_info) {
     get_branch_type(proc_id, recovery_info->cf_type), recovery_info->new_dir,
     recovery_info->branchTarget);
 }
+
+void bp_tagescl_ckpt(uns8 proc_id, Ckpt* ckpt) {
+  tagescl_predictors.at(proc_id)->ckpt(Ckpt_Regions{ckpt_region_func, ckpt});
+}
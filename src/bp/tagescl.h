@@ -36,6 +36,7 @@ void bp_tagescl_spec_update(Op* op);
 void bp_tagescl_update(Op* op);
 void bp_tagescl_retire(Op* op);
 void bp_tagescl_recover(Recovery_Info*);
+void bp_tagescl_ckpt(uns8, Ckpt*);
 
 #ifdef __cplusplus
 }
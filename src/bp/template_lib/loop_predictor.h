@@ -212,6 +212,11 @@ class Loop_Predictor {
     prediction_info->hit_bank = -1;
   }
 
+  void ckpt(const Ckpt_Regions& regions) {
+    regions("loop table", table_.data(),
+            table_.size() * sizeof(LoopPredictorEntry));
+  }
+
  private:
   struct LoopPredictorEntry {
     int16_t total_iterations = 0;  // 10 bits
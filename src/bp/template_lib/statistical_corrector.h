@@ -192,6 +192,44 @@ class Statistical_Corrector {
     }
   }
 
+  // The tables hold no pointers, so each is saved as a whole.
+  void ckpt(const Ckpt_Regions& regions) {
+#define SC_CKPT(member) regions("sc " #member, &member, sizeof(member))
+    SC_CKPT(global_history_);
+    SC_CKPT(path_);
+    SC_CKPT(first_local_history_table_);
+    SC_CKPT(second_local_history_table_);
+    SC_CKPT(third_local_history_table_);
+    SC_CKPT(imli_counter_);
+    SC_CKPT(imli_table_);
+    SC_CKPT(first_high_confidence_ctr_);
+    SC_CKPT(second_high_confidence_ctr_);
+    SC_CKPT(update_threshold_);
+    SC_CKPT(p_update_thresholds_);
+    SC_CKPT(global_history_gehl_);
+    SC_CKPT(path_gehl_);
+    SC_CKPT(first_local_gehl_);
+    SC_CKPT(second_local_gehl_);
+    SC_CKPT(third_local_gehl_);
+    SC_CKPT(first_imli_gehl_);
+    SC_CKPT(second_imli_gehl_);
+    SC_CKPT(global_history_threshold_table_);
+    SC_CKPT(path_threshold_table_);
+    SC_CKPT(first_local_threshold_table_);
+    SC_CKPT(second_local_threshold_table_);
+    SC_CKPT(third_local_threshold_table_);
+    SC_CKPT(first_imli_threshold_table_);
+    SC_CKPT(second_imli_threshold_table_);
+    SC_CKPT(bias_threshold_table_);
+#undef SC_CKPT
+    regions("sc bias", bias_table_.data(),
+            bias_table_.size() * sizeof(Counter_Type));
+    regions("sc bias sk", bias_sk_table_.data(),
+            bias_sk_table_.size() * sizeof(Counter_Type));
+    regions("sc bias bank", bias_bank_table_.data(),
+            bias_bank_table_.size() * sizeof(Counter_Type));
+  }
+
  private:
   using Counter_Type = Saturating_Counter<CONFIG::SC::PRECISION, true>;
   using Per_PC_Threshold_Table_Type =
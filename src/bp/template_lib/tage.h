@@ -23,7 +23,11 @@
 #define __TAGE_H_
 
 #include <cmath>
+#include <cstddef>
 #include <vector>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #include "utils.h"
 
@@ -79,64 +83,23 @@ class Long_History_Register {
 
   int64_t head_idx() const { return head_; }
 
+  void ckpt(const Ckpt_Regions& regions) {
+    regions("tage history bits", history_bits_.data(), history_bits_.size());
+    regions("tage history head", &head_, sizeof(head_));
+    regions("tage history speculative bits", &num_speculative_bits_,
+            sizeof(num_speculative_bits_));
+  }
+
  private:
   int num_speculative_bits_ = 0;  // keeps track of how many bits can be
                                   // discarded during a rewind without losing
                                   // bits in the most significant position.
-  std::vector<bool> history_bits_;
-  int64_t           head_ = 0;
-  int64_t           buffer_size_;
-  int64_t           buffer_access_mask_;
-  int64_t           max_num_speculative_bits_;
-};
-
-/* Computes the a folded history of a large history, as bits are shifted into
- * the history. The caller should update the folded history everytime  */
-template <int history_size>
-class Folded_History {
- public:
-  Folded_History(int original_length, int compressed_length) :
-      current_value_(0), original_length_(original_length),
-      compressed_length_(compressed_length),
-      outpoint_(original_length % compressed_length) {}
-
-  int64_t get_value() const { return current_value_; }
-
-  void update(const Long_History_Register<history_size>& history_register) {
-    // Shift in the most recent GHR bit.
-    current_value_ = (current_value_ << 1) ^ history_register[0];
-
-    // Shift out the least recent GHR bit.
-    current_value_ ^= history_register[original_length_] << outpoint_;
-
-    // Fold shifted-out bit in.
-    current_value_ ^= current_value_ >> compressed_length_;
-
-    // Mask out the unused bits.
-    current_value_ &= (1 << compressed_length_) - 1;
-  }
-
-  void update_reverse(
-    const Long_History_Register<history_size>& history_register) {
-    // Fold out the most recent GHR bit.
-    current_value_ ^= history_register[0];
-
-    // Fold out the least recent GHR bit.
-    current_value_ ^= history_register[original_length_] << outpoint_;
-
-    // Rotate the low bit around to high bit.
-    current_value_ = ((current_value_ & 1) << (compressed_length_ - 1)) |
-                     (current_value_ >> 1);
-
-    // Mask out the unused bits.
-    current_value_ &= (1 << compressed_length_) - 1;
-  }
-
- private:
-  int64_t current_value_;
-  int     original_length_;
-  int     compressed_length_;
-  int     outpoint_;
+  // One byte per bit: the bits are read far more often than written.
+  std::vector<uint8_t> history_bits_;
+  int64_t              head_ = 0;
+  int64_t              buffer_size_;
+  int64_t              buffer_access_mask_;
+  int64_t              max_num_speculative_bits_;
 };
 
 template <class TAGE_CONFIG>
@@ -196,6 +159,85 @@ struct Tage_Tag_Bits {
   int arr[N];
 };
 
+/* Per history length constants for computing the indices and tags of the
+ * tagged tables. Entry i serves tables 2i+1 and 2i+2. Keeping them in arrays
+ * lets the index and tag computation for all tables be one loop over
+ * compile-time constants, which the compiler can vectorize. */
+template <class TAGE_CONFIG>
+struct Tage_Lane_Constants {
+  static constexpr int N   = TAGE_CONFIG::NUM_HISTORIES;
+  static constexpr int LOG = TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
+  constexpr Tage_Lane_Constants() :
+      history_size(), path_mask(), path_rotate(), pc_shift(), tag_mask(),
+      fold_length(), fold_outpoint(), fold_mask() {
+    Tage_History_Sizes<TAGE_CONFIG> history_sizes;
+    Tage_Tag_Bits<TAGE_CONFIG>      tag_bits;
+    for(int i = 0; i < N; ++i) {
+      int bank       = 2 * i + 1;
+      int path_width = (history_sizes.arr[i] > TAGE_CONFIG::PATH_HISTORY_WIDTH) ?
+                         TAGE_CONFIG::PATH_HISTORY_WIDTH :
+                         history_sizes.arr[i];
+      history_size[i] = history_sizes.arr[i];
+      path_mask[i]    = (1u << path_width) - 1;
+      path_rotate[i]  = bank < LOG ? bank : 0;
+      pc_shift[i]     = (LOG > bank ? LOG - bank : bank - LOG) + 1;
+      tag_mask[i]     = (1u << tag_bits.arr[i]) - 1;
+
+      // Folded history j of history length i is kept at j * N + i: one
+      // folded to the index width, two to the tag width (and one less).
+      int fold_widths[3] = {LOG, tag_bits.arr[i], tag_bits.arr[i] - 1};
+      for(int j = 0; j < 3; ++j) {
+        fold_length[j * N + i]   = fold_widths[j];
+        fold_outpoint[j * N + i] = history_sizes.arr[i] % fold_widths[j];
+        fold_mask[j * N + i]     = (1u << fold_widths[j]) - 1;
+      }
+    }
+  }
+  uint32_t history_size[N];
+  uint32_t path_mask[N];
+  uint32_t path_rotate[N];  // 0 if the path hash is not rotated
+  uint32_t pc_shift[N];
+  uint32_t tag_mask[N];
+  uint32_t fold_length[3 * N];
+  uint32_t fold_outpoint[3 * N];
+  uint32_t fold_mask[3 * N];
+};
+
+/* Where each tagged table lives in the combined entry storage and which bank
+ * it uses. Arrays are padded to a multiple of 8 tables so that the tag match
+ * can gather and compare 4 or 8 tables at a time. */
+template <class TAGE_CONFIG>
+struct Tage_Table_Layout {
+  static constexpr int NUM_TABLES = 2 * TAGE_CONFIG::NUM_HISTORIES + 1;
+  static constexpr int NUM_SLOTS  = (NUM_TABLES + 7) & ~7;
+  static_assert(NUM_TABLES <= 64, "tag matches are kept in a 64-bit mask");
+
+  constexpr Tage_Table_Layout() :
+      enabled_mask(0), first_entry(), num_banks(), bank_offset() {
+    Tage_Tables_Enabled<TAGE_CONFIG> tables_enabled;
+    int num_short_enabled = 0;
+    int num_long_enabled  = 0;
+    for(int i = 1; i < NUM_TABLES; ++i) {
+      bool is_long   = i >= TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE;
+      first_entry[i] = is_long ? (TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS
+                                  << TAGE_CONFIG::LOG_ENTRIES_PER_BANK) :
+                                 0;
+      num_banks[i]   = is_long ? TAGE_CONFIG::LONG_HISTORY_NUM_BANKS :
+                                 TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
+      if(tables_enabled.arr[i]) {
+        // Enabled tables of a group take consecutive banks.
+        int ordinal    = is_long ? num_long_enabled++ : num_short_enabled++;
+        bank_offset[i] = ordinal % num_banks[i];
+        enabled_mask |= uint64_t(1) << i;
+      }
+    }
+  }
+  uint64_t enabled_mask;
+  int32_t  first_entry[NUM_SLOTS];
+  int32_t  num_banks[NUM_SLOTS];
+  int32_t  bank_offset[NUM_SLOTS];
+};
+
 struct Bimodal_Output {
   bool prediction;
   bool confidence;
@@ -222,8 +264,8 @@ struct Tage_Prediction_Info {
   int  alt_bank;
 
   // Extra information needed for updates.
-  int     indices[2 * TAGE_CONFIG::NUM_HISTORIES + 1];
-  int     tags[2 * TAGE_CONFIG::NUM_HISTORIES + 1];
+  int     indices[Tage_Table_Layout<TAGE_CONFIG>::NUM_SLOTS];
+  int     tags[Tage_Table_Layout<TAGE_CONFIG>::NUM_SLOTS];
   int     num_global_history_bits;
   int64_t global_history_head_checkpoint_;
   int64_t path_history_checkpoint;
@@ -233,9 +275,8 @@ template <class TAGE_CONFIG>
 class Tage_Histories {
  public:
   Tage_Histories(int max_in_flight_branches) :
-      history_register_(max_in_flight_branches) {
+      history_register_(max_in_flight_branches), folded_histories_() {
     path_history_ = 0;
-    intialize_folded_history();
   }
 
   void push_into_history(uint64_t br_pc, uint64_t br_target,
@@ -266,36 +307,40 @@ class Tage_Histories {
       path_history_ = (path_history_ << 1) ^ (path_hash & 127);
       path_hash >>= 1;
 
-      for(int j = 0; j < TAGE_CONFIG::NUM_HISTORIES; ++j) {
-        folded_histories_for_indices_[j].update(history_register_);
-        folded_histories_for_tags_0_[j].update(history_register_);
-        folded_histories_for_tags_1_[j].update(history_register_);
-      }
+      update_folded_histories();
     }
 
     path_history_ = path_history_ &
                     ((1 << TAGE_CONFIG::PATH_HISTORY_WIDTH) - 1);
   }
 
-  void intialize_folded_history(void);
-
-  // Hash function for the path history used in creating table indices.
-  int64_t compute_path_hash(int64_t path_history, int max_width, int bank,
-                            int index_size) const;
+  // Shifts the most recent bit of the global history into all folded
+  // histories (and the bit that falls off each history length out).
+  void update_folded_histories(void);
+
+  // Undoes update_folded_histories() for the most recent history bit.
+  void rewind_folded_histories(void);
+
+  void ckpt(const Ckpt_Regions& regions) {
+    history_register_.ckpt(regions);
+    regions("tage folded histories", folded_histories_,
+            sizeof(folded_histories_));
+    regions("tage path history", &path_history_, sizeof(path_history_));
+    regions("tage head old", &head_old_, sizeof(head_old_));
+    regions("tage path history old", &path_history_old_,
+            sizeof(path_history_old_));
+  }
 
   // Derived constants
   static constexpr int twice_num_histories_ = 2 * TAGE_CONFIG::NUM_HISTORIES;
-  static constexpr Tage_History_Sizes<TAGE_CONFIG> history_sizes_ = {};
-  static constexpr Tage_Tag_Bits<TAGE_CONFIG>      tag_bits_      = {};
+  static constexpr Tage_History_Sizes<TAGE_CONFIG>  history_sizes_ = {};
+  static constexpr Tage_Lane_Constants<TAGE_CONFIG> lanes_         = {};
 
   // Predictor State
   Long_History_Register<TAGE_CONFIG::MAX_HISTORY_SIZE> history_register_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>>
-    folded_histories_for_indices_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>>
-    folded_histories_for_tags_0_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>>
-    folded_histories_for_tags_1_;
+  // The folded histories of all history lengths, laid out as described in
+  // Tage_Lane_Constants.
+  uint32_t folded_histories_[3 * TAGE_CONFIG::NUM_HISTORIES];
 
   int64_t path_history_;
   int64_t head_old_;
@@ -307,8 +352,8 @@ class Tage {
  public:
   Tage(Random_Number_Generator& random_number_gen, int max_in_flight_branches) :
       tagged_table_ptrs_(), tage_histories_(max_in_flight_branches),
-      low_history_tagged_table_(), high_history_tagged_table_(),
-      alt_selector_table_(), random_number_gen_(random_number_gen) {
+      tagged_entries_(), alt_selector_table_(),
+      random_number_gen_(random_number_gen) {
     initialize_table_sizes();
     intialize_predictor_state();
   }
@@ -515,12 +560,7 @@ class Tage {
       tick_ += (tick_penalty - 2 * num_allocated);
       tick_ = std::max(tick_, 0);
       if(tick_ >= TAGE_CONFIG::TICKS_UNTIL_USEFUL_SHIFT) {
-        shift_tage_useful_bits(low_history_tagged_table_,
-                               TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS *
-                                 (1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK));
-        shift_tage_useful_bits(high_history_tagged_table_,
-                               TAGE_CONFIG::LONG_HISTORY_NUM_BANKS *
-                                 (1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK));
+        shift_tage_useful_bits(tagged_entries_, num_tagged_entries_);
         tick_ = 0;
       }
     }
@@ -587,14 +627,7 @@ class Tage {
       (prediction_info.global_history_head_checkpoint_ -
        tage_histories_.history_register_.head_idx());
     for(int i = 0; i < num_flushed_bits; ++i) {
-      for(int j = 0; j < TAGE_CONFIG::NUM_HISTORIES; ++j) {
-        tage_histories_.folded_histories_for_indices_[j].update_reverse(
-          tage_histories_.history_register_);
-        tage_histories_.folded_histories_for_tags_0_[j].update_reverse(
-          tage_histories_.history_register_);
-        tage_histories_.folded_histories_for_tags_1_[j].update_reverse(
-          tage_histories_.history_register_);
-      }
+      tage_histories_.rewind_folded_histories();
       tage_histories_.history_register_.rewind(1);
     }
     tage_histories_.path_history_ = prediction_info.path_history_checkpoint;
@@ -608,19 +641,34 @@ class Tage {
     *prediction_info = {};
   }
 
+  // The random number generator is shared, so Tage_SC_L saves it.
+  void ckpt(const Ckpt_Regions& regions) {
+    tage_histories_.ckpt(regions);
+    regions("tage bimodal", bimodal_table_, sizeof(bimodal_table_));
+    regions("tage tagged", tagged_entries_, sizeof(tagged_entries_));
+    regions("tage alt selector", alt_selector_table_,
+            sizeof(alt_selector_table_));
+    regions("tage tick", &tick_, sizeof(tick_));
+  }
+
  private:
   struct Bimodal_Entry {
     int8_t hysteresis = 1;
     int8_t prediction = 0;
   };
 
+  // Packed into 32 bits with the tag in the upper half, so that the tags of
+  // several tables can be fetched with one gather.
   struct Tagged_Entry {
     Saturating_Counter<TAGE_CONFIG::PRED_COUNTER_WIDTH, true> pred_counter;
     Saturating_Counter<TAGE_CONFIG::USEFUL_BITS, false>       useful;
-    int                                                       tag = 0;
+    int16_t                                                   tag = 0;
 
     Tagged_Entry() : pred_counter(0), useful(0) {}
   };
+  static_assert(TAGE_CONFIG::SHORT_HISTORY_TAG_BITS < 16 &&
+                  TAGE_CONFIG::LONG_HISTORY_TAG_BITS < 16,
+                "tags must fit in Tagged_Entry::tag");
 
   void initialize_tag_bits(void);
   void initialize_table_sizes(void);
@@ -637,14 +685,19 @@ class Tage {
 
   // Get the banks IDs of matching tables with longest histories.
   // A bank of 0 means a match was not found.
-  Matched_Table_Banks get_two_longest_matching_tables(int indices[],
-                                                      int tags[]) const;
+  Matched_Table_Banks get_two_longest_matching_tables(const int indices[],
+                                                      const int tags[]) const;
 
   void shift_tage_useful_bits(Tagged_Entry* table, int size);
 
 
   // Derived constants
   static constexpr Tage_Tables_Enabled<TAGE_CONFIG> tables_enabled_ = {};
+  static constexpr Tage_Table_Layout<TAGE_CONFIG>   table_layout_   = {};
+  static constexpr int                              num_tagged_entries_ =
+    (TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS +
+     TAGE_CONFIG::LONG_HISTORY_NUM_BANKS)
+    << TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
 
   Tagged_Entry*
     tagged_table_ptrs_[Tage_Histories<TAGE_CONFIG>::twice_num_histories_ + 1];
@@ -652,12 +705,8 @@ class Tage {
   // Predictor State
   Tage_Histories<TAGE_CONFIG> tage_histories_;
   Bimodal_Entry bimodal_table_[1 << TAGE_CONFIG::BIMODAL_LOG_TABLES_SIZE];
-  Tagged_Entry
-    low_history_tagged_table_[TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS *
-                              (1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK)];
-  Tagged_Entry
-    high_history_tagged_table_[TAGE_CONFIG::LONG_HISTORY_NUM_BANKS *
-                               (1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK)];
+  // The low history banks followed by the high history banks.
+  Tagged_Entry tagged_entries_[num_tagged_entries_];
 
   Saturating_Counter<TAGE_CONFIG::ALT_SELECTOR_ENTRY_WIDTH, true>
       alt_selector_table_[1 << TAGE_CONFIG::ALT_SELECTOR_LOG_TABLE_SIZE];
@@ -674,137 +723,148 @@ template <class TAGE_CONFIG>
 constexpr Tage_Tables_Enabled<TAGE_CONFIG> Tage<TAGE_CONFIG>::tables_enabled_;
 
 template <class TAGE_CONFIG>
-constexpr Tage_Tag_Bits<TAGE_CONFIG> Tage_Histories<TAGE_CONFIG>::tag_bits_;
+constexpr Tage_Table_Layout<TAGE_CONFIG> Tage<TAGE_CONFIG>::table_layout_;
+
+template <class TAGE_CONFIG>
+constexpr Tage_Lane_Constants<TAGE_CONFIG> Tage_Histories<TAGE_CONFIG>::lanes_;
 
 template <class TAGE_CONFIG>
 void Tage<TAGE_CONFIG>::initialize_table_sizes(void) {
-  for(int i = 1; i < TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE; ++i) {
-    tagged_table_ptrs_[i] = low_history_tagged_table_;
-  }
-  for(int i = TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE;
-      i <= Tage_Histories<TAGE_CONFIG>::twice_num_histories_; ++i) {
-    tagged_table_ptrs_[i] = high_history_tagged_table_;
+  for(int i = 1; i <= Tage_Histories<TAGE_CONFIG>::twice_num_histories_; ++i) {
+    tagged_table_ptrs_[i] = tagged_entries_ + table_layout_.first_entry[i];
   }
 }
 
 template <class TAGE_CONFIG>
-void Tage_Histories<TAGE_CONFIG>::intialize_folded_history(void) {
-  // insert dummy entries for the zeroth entry of the vector
-  for(int i = 0; i < TAGE_CONFIG::NUM_HISTORIES; i++) {
-    // For some reason I cannot pass LOG_ENTRIES_PER_BANK to emplace_bank()
-    // directly (gcc complains that variable is undefined), do not know why.
-    // REVISIT: since I got rid of LOG_ENTRIES_PER_BANK as a constant, this
-    // should be fine now.
-    const int LOG_ENTRIES_PER_BANK2 = TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
-    folded_histories_for_indices_.emplace_back(history_sizes_.arr[i],
-                                               LOG_ENTRIES_PER_BANK2);
-    folded_histories_for_tags_0_.emplace_back(history_sizes_.arr[i],
-                                              tag_bits_.arr[i]);
-    folded_histories_for_tags_1_.emplace_back(history_sizes_.arr[i],
-                                              tag_bits_.arr[i] - 1);
+void Tage_Histories<TAGE_CONFIG>::update_folded_histories(void) {
+  constexpr int N = TAGE_CONFIG::NUM_HISTORIES;
+
+  // All folded histories of a history length shift out the same bit.
+  uint32_t newest_bit = history_register_[0];
+  uint32_t oldest_bits[N];
+  for(int i = 0; i < N; ++i) {
+    oldest_bits[i] = history_register_[lanes_.history_size[i]];
   }
-}
 
-template <class TAGE_CONFIG>
-void Tage<TAGE_CONFIG>::intialize_predictor_state(void) {
-  tick_                           = 0;
-  random_number_gen_.phist_ptr_   = &tage_histories_.path_history_old_;
-  random_number_gen_.ptghist_ptr_ = &tage_histories_.head_old_;
+  // Fully unrolled, so that the per-lane shift amounts become constants.
+  // Without AVX2 there is no vector shift by a per-lane amount, and the loop
+  // would otherwise run one lane at a time with shifts loaded from memory.
+#pragma GCC unroll 64
+  for(int j = 0; j < 3; ++j) {
+#pragma GCC unroll 64
+    for(int i = 0; i < N; ++i) {
+      int lane = j * N + i;
+      // Shift in the most recent GHR bit and shift out the least recent one.
+      uint32_t value = (folded_histories_[lane] << 1) ^ newest_bit;
+      value ^= oldest_bits[i] << lanes_.fold_outpoint[lane];
+
+      // Fold the shifted-out bit in and mask out the unused bits.
+      value ^= value >> lanes_.fold_length[lane];
+      folded_histories_[lane] = value & lanes_.fold_mask[lane];
+    }
+  }
 }
 
 template <class TAGE_CONFIG>
-int64_t Tage_Histories<TAGE_CONFIG>::compute_path_hash(int64_t path_history,
-                                                       int max_width, int bank,
-                                                       int index_size) const {
-  int64_t temp1, temp2;
+void Tage_Histories<TAGE_CONFIG>::rewind_folded_histories(void) {
+  constexpr int N = TAGE_CONFIG::NUM_HISTORIES;
 
-  // truncate path history to index size.
-  path_history = (path_history & ((1 << max_width) - 1));
-  temp1        = (path_history & ((1 << index_size) - 1));
-
-  // Take high part of path history and left rotate it by "bank" ammount
-  // this is just to generate a unique hash for each bank
-  temp2 = (path_history >> index_size);
-  if(bank < index_size) {
-    temp2 = ((temp2 << bank) & ((1 << index_size) - 1)) +
-            (temp2 >> (index_size - bank));
+  uint32_t newest_bit = history_register_[0];
+  uint32_t oldest_bits[N];
+  for(int i = 0; i < N; ++i) {
+    oldest_bits[i] = history_register_[lanes_.history_size[i]];
   }
 
-  // fold rotated high part of path into low part of path
-  path_history = temp1 ^ temp2;
-
-  // left rotate that chunk by "bank"
-  if(bank < index_size) {
-    path_history = ((path_history << bank) & ((1 << index_size) - 1)) +
-                   (path_history >> (index_size - bank));
+  // Fully unrolled, as in update_folded_histories.
+#pragma GCC unroll 64
+  for(int j = 0; j < 3; ++j) {
+#pragma GCC unroll 64
+    for(int i = 0; i < N; ++i) {
+      int lane = j * N + i;
+      // Fold out the most recent and the least recent GHR bits.
+      uint32_t value = folded_histories_[lane] ^ newest_bit;
+      value ^= oldest_bits[i] << lanes_.fold_outpoint[lane];
+
+      // Rotate the low bit around to the high bit and mask out the unused
+      // bits.
+      value = ((value & 1) << (lanes_.fold_length[lane] - 1)) | (value >> 1);
+      folded_histories_[lane] = value & lanes_.fold_mask[lane];
+    }
   }
-  return path_history;
+}
+
+template <class TAGE_CONFIG>
+void Tage<TAGE_CONFIG>::intialize_predictor_state(void) {
+  tick_                           = 0;
+  random_number_gen_.phist_ptr_   = &tage_histories_.path_history_old_;
+  random_number_gen_.ptghist_ptr_ = &tage_histories_.head_old_;
 }
 
 template <class TAGE_CONFIG>
 void Tage<TAGE_CONFIG>::fill_table_indices_tags(
   uint64_t br_pc, Tage_Prediction_Info<TAGE_CONFIG>* output) const {
-  // Generate tags and indices, ignore bank bits for now.
-  for(int i = 1; i <= Tage_Histories<TAGE_CONFIG>::twice_num_histories_;
-      i += 2) {
-    if(tables_enabled_.arr[i] || tables_enabled_.arr[i + 1]) {
-      int max_path_width = (tage_histories_.history_sizes_.arr[(i - 1) / 2] >
-                            TAGE_CONFIG::PATH_HISTORY_WIDTH) ?
-                             TAGE_CONFIG::PATH_HISTORY_WIDTH :
-                             tage_histories_.history_sizes_.arr[(i - 1) / 2];
-      int64_t path_hash = tage_histories_.compute_path_hash(
-        tage_histories_.path_history_, max_path_width, i,
-        TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
-      int64_t index = br_pc;
-      index ^= br_pc >> (std::abs(TAGE_CONFIG::LOG_ENTRIES_PER_BANK - i) + 1);
-      index ^=
-        tage_histories_.folded_histories_for_indices_[(i - 1) / 2].get_value();
-      index ^= path_hash;
-      output->indices[i] = index &
-                           ((1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK) - 1);
-
-      int64_t tag = br_pc;
-      tag ^=
-        tage_histories_.folded_histories_for_tags_0_[(i - 1) / 2].get_value();
-      tag ^=
-        tage_histories_.folded_histories_for_tags_1_[(i - 1) / 2].get_value()
-        << 1;
-      output->tags[i] = tag &
-                        ((1 << tage_histories_.tag_bits_.arr[(i - 1) / 2]) - 1);
-
-      output->tags[i + 1]    = output->tags[i];
-      output->indices[i + 1] = output->indices[i] ^
-                               (output->tags[i] &
-                                ((1 << TAGE_CONFIG::LOG_ENTRIES_PER_BANK) - 1));
-    }
-  }
-
-  // Now add bank bits to the indices of high history tables.
-  int temp = (br_pc ^
-              (tage_histories_.path_history_ &
-               ((int64_t(1)
-                 << tage_histories_.history_sizes_
-                      .arr[(TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE - 1) / 2]) -
-                1))) %
-             TAGE_CONFIG::LONG_HISTORY_NUM_BANKS;
-  for(int i = TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE;
-      i <= Tage_Histories<TAGE_CONFIG>::twice_num_histories_; ++i) {
-    if(tables_enabled_.arr[i]) {
-      output->indices[i] += (temp << TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
-      temp++;
-      temp = temp % TAGE_CONFIG::LONG_HISTORY_NUM_BANKS;
-    }
+  constexpr int N          = TAGE_CONFIG::NUM_HISTORIES;
+  constexpr int LOG        = TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
+  constexpr int index_mask = (1 << LOG) - 1;
+  const auto&   lanes      = tage_histories_.lanes_;
+  const auto&   folded     = tage_histories_.folded_histories_;
+
+  // Generate the tag and the (bankless) index of the first table of every
+  // history length. Everything is masked to at most 16 bits in the end, so
+  // 32-bit lanes are enough (but the PC shift must see the whole PC). Both
+  // loops are fully unrolled, as in update_folded_histories.
+  uint32_t pc           = br_pc;
+  uint32_t path_history = tage_histories_.path_history_;
+  uint32_t indices[N];
+  uint32_t tags[N];
+#pragma GCC unroll 64
+  for(int i = 0; i < N; ++i) {
+    // Hash the path history: fold its high part (left rotated by the bank
+    // number, to make each bank's hash unique) into its low part, and rotate
+    // the result again.
+    uint32_t rotate = lanes.path_rotate[i];
+    uint32_t path   = path_history & lanes.path_mask[i];
+    uint32_t high   = path >> LOG;
+    high = rotate ? ((high << rotate) & index_mask) + (high >> (LOG - rotate)) :
+                    high;
+    path = (path & index_mask) ^ high;
+    path = rotate ? ((path << rotate) & index_mask) + (path >> (LOG - rotate)) :
+                    path;
+
+    uint32_t pc_hash = br_pc >> lanes.pc_shift[i];
+    indices[i]       = (pc ^ pc_hash ^ folded[i] ^ path) & index_mask;
+    tags[i] = (pc ^ folded[N + i] ^ (folded[2 * N + i] << 1)) &
+              lanes.tag_mask[i];
   }
 
-  // Now add bank bits to the indices of low history tables.
-  temp = (br_pc ^ (tage_histories_.path_history_ &
-                   ((1 << tage_histories_.history_sizes_.arr[0]) - 1))) %
-         TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
-  for(int i = 1; i <= TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE - 1; ++i) {
+  // The second table of a history length uses the same tag and a different
+  // index. Enabled tables of each group (low and high history) then get
+  // consecutive banks starting from one picked by the PC and path history.
+  int short_bank = (br_pc ^ (tage_histories_.path_history_ &
+                             ((1 << tage_histories_.history_sizes_.arr[0]) -
+                              1))) %
+                   TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
+  int long_bank = (br_pc ^
+                   (tage_histories_.path_history_ &
+                    ((int64_t(1)
+                      << tage_histories_.history_sizes_
+                           .arr[(TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE - 1) /
+                                2]) -
+                     1))) %
+                  TAGE_CONFIG::LONG_HISTORY_NUM_BANKS;
+#pragma GCC unroll 64
+  for(int i = 1; i <= 2 * N; ++i) {
+    int  lane    = (i - 1) / 2;
+    bool is_long = i >= TAGE_CONFIG::FIRST_LONG_HISTORY_TABLE;
+    int  bank    = (is_long ? long_bank : short_bank) +
+               table_layout_.bank_offset[i];
+    bank -= bank >= table_layout_.num_banks[i] ? table_layout_.num_banks[i] :
+                                                  0;
+    output->tags[i]    = tags[lane];
+    output->indices[i] = (i & 1) ? indices[lane] :
+                                   indices[lane] ^ (tags[lane] & index_mask);
     if(tables_enabled_.arr[i]) {
-      output->indices[i] += (temp << TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
-      temp++;
-      temp = temp % TAGE_CONFIG::SHORT_HISTORY_NUM_BANKS;
+      output->indices[i] += bank << LOG;
     }
   }
 }
@@ -843,21 +903,52 @@ void Tage<TAGE_CONFIG>::update_bimodal(uint64_t br_pc, bool resolve_dir) {
 
 template <class TAGE_CONFIG>
 Matched_Table_Banks Tage<TAGE_CONFIG>::get_two_longest_matching_tables(
-  int indices[], int tags[]) const {
-  int first_match  = 0;
-  int second_match = 0;
-  for(int i = 2 * TAGE_CONFIG::NUM_HISTORIES; i > 0; --i) {
-    if(tables_enabled_.arr[i]) {
-      if(tagged_table_ptrs_[i][indices[i]].tag == tags[i]) {
-        if(first_match == 0) {
-          first_match = i;
-        } else {
-          second_match = i;
-          break;
-        }
-      }
-    }
+  const int indices[], const int tags[]) const {
+  // Compare the tags of all tables at once into a mask of matching tables.
+  // Unused slots (table 0 and the padding) have index and tag 0 and are
+  // masked out with the disabled tables.
+  constexpr int num_slots = Tage_Table_Layout<TAGE_CONFIG>::NUM_SLOTS;
+  uint64_t      matches   = 0;
+#if defined(__AVX2__)
+  static_assert(sizeof(Tagged_Entry) == 4 && offsetof(Tagged_Entry, tag) == 2,
+                "the tag must be the upper half of a 32-bit entry");
+  for(int i = 0; i < num_slots; i += 8) {
+    __m256i entry_index = _mm256_add_epi32(
+      _mm256_loadu_si256((const __m256i*)(indices + i)),
+      _mm256_loadu_si256((const __m256i*)(table_layout_.first_entry + i)));
+    __m256i entries   = _mm256_i32gather_epi32((const int*)tagged_entries_,
+                                             entry_index, sizeof(Tagged_Entry));
+    __m256i entry_tag = _mm256_srli_epi32(entries, 16);
+    __m256i match     = _mm256_cmpeq_epi32(
+      entry_tag, _mm256_loadu_si256((const __m256i*)(tags + i)));
+    matches |= uint64_t(_mm256_movemask_ps(_mm256_castsi256_ps(match))) << i;
   }
+#elif defined(__SSE2__)
+  alignas(16) int32_t entry_tags[num_slots];
+  for(int i = 0; i < num_slots; ++i) {
+    entry_tags[i] =
+      tagged_entries_[table_layout_.first_entry[i] + indices[i]].tag;
+  }
+  for(int i = 0; i < num_slots; i += 4) {
+    __m128i match = _mm_cmpeq_epi32(
+      _mm_load_si128((const __m128i*)(entry_tags + i)),
+      _mm_loadu_si128((const __m128i*)(tags + i)));
+    matches |= uint64_t(_mm_movemask_ps(_mm_castsi128_ps(match))) << i;
+  }
+#else
+  for(int i = 0; i < num_slots; ++i) {
+    matches |= uint64_t(
+                 tagged_entries_[table_layout_.first_entry[i] + indices[i]]
+                   .tag == tags[i])
+               << i;
+  }
+#endif
+  matches &= table_layout_.enabled_mask;
+
+  // The longest two matching tables are the two highest bits.
+  int first_match = matches ? 63 - __builtin_clzll(matches) : 0;
+  matches &= ~(uint64_t(1) << first_match);
+  int second_match = matches ? 63 - __builtin_clzll(matches) : 0;
   return Matched_Table_Banks{first_match, second_match};
 }
 
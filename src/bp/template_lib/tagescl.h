@@ -50,6 +50,9 @@ class Tage_SC_L_Base {
                                              Branch_Type br_type,
                                              bool        resolve_dir,
                                              uint64_t    br_target)      = 0;
+  // Saves or restores the whole predictor through regions. Only valid while
+  // no branches are in flight.
+  virtual void ckpt(const Ckpt_Regions& regions) = 0;
 };
 
 /* Interface functions:
@@ -121,6 +124,16 @@ class Tage_SC_L : public Tage_SC_L_Base {
                                      Branch_Type br_type, bool resolve_dir,
                                      uint64_t br_target) override;
 
+  void ckpt(const Ckpt_Regions& regions) override {
+    random_number_gen_.ckpt(regions);
+    tage_.ckpt(regions);
+    statistical_corrector_.ckpt(regions);
+    loop_predictor_.ckpt(regions);
+    regions("loop predictor beneficial", &loop_predictor_beneficial_,
+            sizeof(loop_predictor_beneficial_));
+    prediction_info_buffer_.ckpt("tagescl prediction info", regions);
+  }
+
  private:
   Random_Number_Generator               random_number_gen_;
   Tage<typename CONFIG::TAGE>           tage_;
@@ -23,6 +23,7 @@
 #define __TAGE_SC_L_LIB_H_
 
 #include <cassert>
+#include <cstddef>
 
 inline int get_min_num_bits_to_represent(int x) {
   assert(x > 0);
@@ -120,6 +121,18 @@ class Saturating_Counter {
   Int_Type counter_;
 };
 
+/* Passed to the ckpt() functions, which call it with every piece of predictor
+ * state so that the simulator can save it to or restore it from a checkpoint
+ * (in place). */
+struct Ckpt_Regions {
+  void (*func)(void* arg, const char* name, void* ptr, size_t size);
+  void* arg;
+
+  void operator()(const char* name, void* ptr, size_t size) const {
+    func(arg, name, ptr, size);
+  }
+};
+
 // This is an ugly way to do random number generation, but I want to keep it
 // compatible with Seznec for now.
 class Random_Number_Generator {
@@ -135,6 +148,10 @@ class Random_Number_Generator {
     return (seed_);
   }
 
+  void ckpt(const Ckpt_Regions& regions) {
+    regions("random seed", &seed_, sizeof(seed_));
+  }
+
   int      seed_ = 0;
   int64_t* phist_ptr_;
   int64_t* ptghist_ptr_;
@@ -185,6 +202,13 @@ class Circular_Buffer {
     size_ -= 1;
   }
 
+  void ckpt(const char* name, const Ckpt_Regions& regions) {
+    regions(name, buffer_.data(), buffer_.size() * sizeof(T));
+    regions(name, &back_, sizeof(back_));
+    regions(name, &front_, sizeof(front_));
+    regions(name, &size_, sizeof(size_));
+  }
+
  private:
   std::vector<T> buffer_;
   int64_t        buffer_size_;
@@ -42,24 +42,87 @@
 #include "memory/cache_part.h"
 #include "memory/memory.param.h"
 #include "op_pool.h"
+#include "prefetcher/l2l1pref.param.h"
 #include "prefetcher/pref.param.h"
 #include "prefetcher/pref_common.h"
+#include "ramulator.h"
 #include "sim.h"
 #include "statistics.h"
+#include "trigger.h"
 
 #include "freq.h"
 
 Flag perf_pred_started = FALSE;
 
+extern Rob_Stall_Reason       rob_stall_reason;
+extern Rob_Block_Issue_Reason rob_block_issue_reason;
+
 /**************************************************************************************/
 /* Static prototypes */
 
 static void cmp_recover(void);
 static void cmp_redirect(void);
 static void cmp_measure_chip_util(void);
+static void cmp_ckpt_check(void);
 static void cmp_istreams(void);
 static void cmp_cores(void);
+static void cmp_core_cycle(uns proc_id);
 static void warmup_uncore(uns proc_id, Addr addr, Flag write);
+static Flag cmp_chip_idle(void);
+static Counter cmp_core_next_event(uns proc_id);
+static Flag cmp_idle_probe(void);
+static Flag cmp_idle_jump(void);
+
+/**************************************************************************************/
+/* Idle-cycle skipping state (see cmp_idle_cycle) */
+
+/* What one idle cycle of a clock domain changes, recorded by cmp_idle_probe */
+typedef struct Idle_Cycle_struct {
+  Stat_Delta* stat_deltas;
+  uns         num_stat_deltas;
+  uns         max_stat_deltas;  // allocated size of stat_deltas
+  uns         ret_stall_inc;    // change of node->ret_stall_length (cores)
+  uns         mem_block_inc;    // change of node->mem_block_length (cores)
+} Idle_Cycle;
+
+/* The last two probes of a clock domain: core proc_id, or the L1 at index
+   NUM_CORES */
+typedef struct Idle_Domain_struct {
+  Idle_Cycle probes[2];
+  uns        cur;          // probes[cur] is the latest one
+  uns        num_probes;   // consecutive probes recorded, up to 2
+  Counter    first_cycle;  // first cycle of the domain in a jump
+} Idle_Domain;
+
+/* Bounds of a jump, see cmp_idle_trigger_limit */
+typedef struct Idle_Jump_struct {
+  Counter start;  // time of the first skipped step
+  Counter limit;  // the last skipped step may not start after this
+} Idle_Jump;
+
+static Flag         idle_skip_on;  // IDLE_CYCLE_SKIP and the config allows it
+static Flag         idle_probe_blocked;  // last probe failed, wait for activity
+static uns          idle_busy_core;      // core cmp_chip_idle last found busy
+static Idle_Domain* idle_domains;  // NUM_CORES + 1 domains
+static Counter*     idle_horizon;  // per core: first core cycle that may be busy
+static Counter*     idle_stat_snapshot;
+static Stat_Delta*  idle_stat_deltas;  // the deltas of the running probe
+
+static void cmp_idle_record(Idle_Domain* domain, uns num_stat_deltas,
+                            uns ret_stall_inc, uns mem_block_inc);
+static Flag cmp_idle_stable(const Idle_Domain* domain);
+static void cmp_idle_reset(void);
+static void cmp_idle_trigger_limit(const Stat* stat, Counter threshold,
+                                   void* arg);
+static void cmp_idle_trigger_sum(const Stat* stat, Counter threshold,
+                                 void* arg);
+static Counter cmp_idle_stat_at(const Stat* stat, const Idle_Jump* jump,
+                                const Counter* incs, Flag is_time,
+                                Counter fs);
+
+static inline Freq_Domain_Id cmp_idle_freq_domain(uns ii) {
+  return ii < NUM_CORES ? FREQ_DOMAIN_CORES[ii] : FREQ_DOMAIN_L1;
+}
 
 /**************************************************************************************/
 /* cmp_init */
@@ -73,6 +136,24 @@ void cmp_init(uns mode) {
         0, cmp_model.memory.uncores[0].l1->cache.repl_policy == REPL_PARTITION);
       cmp_model.memory.uncores[0].l1->cache.repl_policy = REPL_TRUE_LRU;
     }
+    if(IDLE_CYCLE_SKIP) {
+      /* These features do work every cycle that the next-event checks of
+         the stages and the memory system do not see */
+      idle_skip_on = !PERF_PRED_ENABLE && !MEMVIEW && !PIPEVIEW &&
+                     !DUMB_CORE_ON && !STREAM_PREFETCH_ON && !L2WAY_PREF &&
+                     !L2MARKV_PREF_ON && !L1_PART_ON;
+      if(!idle_skip_on)
+        WARNINGU(0, "IDLE_CYCLE_SKIP is not supported with the enabled "
+                    "features, simulating every cycle\n");
+    }
+    if(idle_skip_on) {
+      uns num_stats      = NUM_CORES * NUM_GLOBAL_STATS;
+      idle_domains       = (Idle_Domain*)calloc(NUM_CORES + 1,
+                                          sizeof(Idle_Domain));
+      idle_horizon       = (Counter*)calloc(NUM_CORES, sizeof(Counter));
+      idle_stat_snapshot = (Counter*)malloc(num_stats * sizeof(Counter));
+      idle_stat_deltas   = (Stat_Delta*)malloc(num_stats * sizeof(Stat_Delta));
+    }
     return;
   }
 
@@ -126,6 +207,9 @@ void cmp_init(uns mode) {
 
   cache_part_init();
 
+  if(WARMUP_CKPT_SAVE || WARMUP_CKPT_LOAD)
+    cmp_ckpt_check();
+
   ASSERTM(0, !USE_LATE_BP || LATE_BP_LATENCY < (DECODE_CYCLES + MAP_CYCLES),
           "Late branch prediction latency should be less than the total "
           "latency of the frontend stages of the pipeline (decode + map)");
@@ -194,29 +278,417 @@ void cmp_istreams(void) {
 }
 
 void cmp_cores(void) {
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    cmp_core_cycle(proc_id);
+}
+
+/* cmp_core_cycle: Runs the pipeline of one core if its clock is ready. */
+
+static void cmp_core_cycle(uns proc_id) {
+  if(DUMB_CORE_ON && DUMB_CORE == proc_id)
+    return;
+
+  if(freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
+    cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+
+    set_bp_data(&cmp_model.bp_data[proc_id]);
+    set_bp_recovery_info(&cmp_model.bp_recovery_info[proc_id]);
+    cmp_set_all_stages(proc_id);
+
+    update_dcache_stage(&exec->sd);
+    update_exec_stage(&node->sd);
+    update_node_stage(map->last_sd);
+    update_map_stage(dec->last_sd);
+    update_decode_stage(&ic->sd);
+    update_icache_stage();
+
+    node_sched_ops();
+
+    cmp_measure_chip_util();
+  }
+}
+
+/**************************************************************************************/
+/* cmp_idle_cycle: Called by full_sim in place of cmp_cycle when
+   IDLE_CYCLE_SKIP is on. While every core waits on an outside event (a miss,
+   a timer, a long-latency op) and the on-chip memory queues are empty, a
+   cycle of a core or of the L1 changes only the stats and the stall length
+   counters, and it changes them the same way each time. Once the last two
+   cycles of every clock domain, which are simulated normally, agree on that
+   change, cmp_idle_jump moves time to the end of the idle period in one step.
+   Returns TRUE if it simulated the current step (and maybe later ones). */
+
+Flag cmp_idle_cycle(void) {
+  if(!idle_skip_on)
+    return FALSE;
+
+  if(!cmp_chip_idle()) {
+    idle_probe_blocked = FALSE;
+    cmp_idle_reset();
+    return FALSE;
+  }
+
+  /* A failed probe is not repeated until the chip does something */
+  if(idle_probe_blocked)
+    return FALSE;
+
+  Flag stable = TRUE;
+  for(uns ii = 0; ii <= NUM_CORES; ii++)
+    stable &= cmp_idle_stable(&idle_domains[ii]);
+  if(stable && cmp_idle_jump())
+    return TRUE;
+
+  return cmp_idle_probe();
+}
+
+/**************************************************************************************/
+/* cmp_chip_idle: TRUE if no core and no on-chip memory queue has anything to
+   do this cycle. Sets idle_horizon to the cycle each core may wake up at. */
+
+static Flag cmp_chip_idle(void) {
+  if(mem_next_event() != MAX_CTR)
+    return FALSE;
+
+  /* A busy core tends to stay busy, so the one found last time goes first */
+  if(cmp_core_next_event(idle_busy_core) <= cycle_count)
+    return FALSE;
+
   for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    if(DUMB_CORE_ON && DUMB_CORE == proc_id)
+    Counter next = cmp_core_next_event(proc_id);
+    if(next <= cycle_count) {
+      idle_busy_core = proc_id;
+      return FALSE;
+    }
+    idle_horizon[proc_id] = next;
+  }
+
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* cmp_core_next_event: Returns the first cycle at which a stage of the core
+   has something to do. Leaves cycle_count and the stage globals set to the
+   core. */
+
+static Counter cmp_core_next_event(uns proc_id) {
+  cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+
+  set_bp_data(&cmp_model.bp_data[proc_id]);
+  set_bp_recovery_info(&cmp_model.bp_recovery_info[proc_id]);
+  cmp_set_all_stages(proc_id);
+
+  Counter events[] = {bp_recovery_info->recovery_cycle,
+                      bp_recovery_info->redirect_cycle,
+                      dcache_stage_next_event(),
+                      exec_stage_next_event(),
+                      node_stage_next_event(map->last_sd),
+                      map_stage_next_event(dec->last_sd),
+                      decode_stage_next_event(&ic->sd),
+                      icache_stage_next_event()};
+  Counter next     = MAX_CTR;
+  for(uns ii = 0; ii < sizeof(events) / sizeof(events[0]); ii++)
+    next = MIN2(next, events[ii]);
+  return next;
+}
+
+/**************************************************************************************/
+/* cmp_idle_probe: Simulates the current step like cmp_cycle and records what
+   the cycle of each ready domain changed. Returns FALSE without simulating
+   anything if Ramulator ticks in this step, since its stats are not per
+   cycle; the recorded probes stay valid across such a step. */
+
+static Flag cmp_idle_probe(void) {
+  if(freq_is_ready(FREQ_DOMAIN_MEMORY))
+    return FALSE;
+
+  Flag exact = TRUE;
+  uns  num_deltas;
+
+  stat_snapshot(idle_stat_snapshot);
+
+  cmp_istreams();
+  update_memory();
+  exact &= stat_get_deltas(idle_stat_snapshot, idle_stat_deltas, &num_deltas);
+  if(freq_is_ready(FREQ_DOMAIN_L1))
+    cmp_idle_record(&idle_domains[NUM_CORES], num_deltas, 0, 0);
+  else
+    exact &= num_deltas == 0;
+
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if(!freq_is_ready(FREQ_DOMAIN_CORES[proc_id]))
       continue;
 
+    Node_Stage*            node_stage   = &cmp_model.node_stage[proc_id];
+    uns                    ret_stall    = node_stage->ret_stall_length;
+    uns                    mem_block    = node_stage->mem_block_length;
+    Rob_Stall_Reason       stall_reason = rob_stall_reason;
+    Rob_Block_Issue_Reason block_reason = rob_block_issue_reason;
+
+    cmp_core_cycle(proc_id);
+
+    /* The ROB reasons carry over into the icache stage of the next core
+       stepped, so a cycle that changes them is not the same in every step */
+    exact &= rob_stall_reason == stall_reason &&
+             rob_block_issue_reason == block_reason;
+    exact &= stat_get_deltas(idle_stat_snapshot, idle_stat_deltas,
+                             &num_deltas);
+    cmp_idle_record(&idle_domains[proc_id], num_deltas,
+                    node_stage->ret_stall_length - ret_stall,
+                    node_stage->mem_block_length - mem_block);
+  }
+
+  if(DVFS_ON)
+    dvfs_cycle();
+  cache_part_update();
+  exact &= stat_get_deltas(idle_stat_snapshot, idle_stat_deltas,
+                           &num_deltas) &&
+           num_deltas == 0;
+
+  if(!exact) {
+    idle_probe_blocked = TRUE;
+    cmp_idle_reset();
+  }
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* cmp_idle_record: Saves the probe in idle_stat_deltas as the latest one of
+   the domain. */
+
+static void cmp_idle_record(Idle_Domain* domain, uns num_stat_deltas,
+                            uns ret_stall_inc, uns mem_block_inc) {
+  Idle_Cycle* probe = &domain->probes[!domain->cur];
+
+  if(num_stat_deltas > probe->max_stat_deltas) {
+    probe->max_stat_deltas = num_stat_deltas;
+    probe->stat_deltas     = (Stat_Delta*)realloc(
+      probe->stat_deltas, num_stat_deltas * sizeof(Stat_Delta));
+  }
+  memcpy(probe->stat_deltas, idle_stat_deltas,
+         num_stat_deltas * sizeof(Stat_Delta));
+  probe->num_stat_deltas = num_stat_deltas;
+  probe->ret_stall_inc   = ret_stall_inc;
+  probe->mem_block_inc   = mem_block_inc;
+
+  domain->cur        = !domain->cur;
+  domain->num_probes = MIN2(domain->num_probes + 1, 2);
+}
+
+/**************************************************************************************/
+/* cmp_idle_stable: TRUE if the last two probes of the domain agree */
+
+static Flag cmp_idle_stable(const Idle_Domain* domain) {
+  const Idle_Cycle* a = &domain->probes[0];
+  const Idle_Cycle* b = &domain->probes[1];
+
+  if(domain->num_probes < 2 || a->num_stat_deltas != b->num_stat_deltas ||
+     a->ret_stall_inc != b->ret_stall_inc ||
+     a->mem_block_inc != b->mem_block_inc)
+    return FALSE;
+  for(uns ii = 0; ii < a->num_stat_deltas; ii++) {
+    if(a->stat_deltas[ii].count != b->stat_deltas[ii].count ||
+       a->stat_deltas[ii].inc != b->stat_deltas[ii].inc)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* cmp_idle_reset: Forgets every probe */
+
+static void cmp_idle_reset(void) {
+  for(uns ii = 0; ii <= NUM_CORES; ii++)
+    idle_domains[ii].num_probes = 0;
+}
+
+/**************************************************************************************/
+/* cmp_idle_jump: Simulates the steps from now until the first one that may
+   not be idle, all at once: time skips to the last of them, every domain's
+   probed change is applied once per cycle the domain had in them, and
+   Ramulator is ticked at each of its own cycles. The last step is the one
+   before a core wakes up, before pref_update resets the hfilter, the first
+   at which a trigger fires or core 0 reaches a forward progress check, or
+   the one in which Ramulator returns a response. The response lands in the
+   l1fill_queue, which nothing looks at before the next L1 cycle. Returns
+   FALSE without simulating anything if only the current step fits. */
+
+static Flag cmp_idle_jump(void) {
+  Idle_Jump jump = {freq_time(), MAX_CTR};
+
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if(idle_horizon[proc_id] != MAX_CTR)
+      jump.limit = MIN2(jump.limit,
+                        freq_cycle_start_time(FREQ_DOMAIN_CORES[proc_id],
+                                              idle_horizon[proc_id]) -
+                          1);
+  }
+
+  if(PREF_FRAMEWORK_ON && PREF_HFILTER_ON && PREF_HFILTER_RESET_ENABLE) {
+    Counter cycle = freq_cycle_count(FREQ_DOMAIN_L1) +
+                    !freq_is_ready(FREQ_DOMAIN_L1);
+    Counter reset = (cycle + PREF_HFILTER_RESET_INTERVAL - 1) /
+                    PREF_HFILTER_RESET_INTERVAL * PREF_HFILTER_RESET_INTERVAL;
+    jump.limit = MIN2(jump.limit,
+                      freq_cycle_start_time(FREQ_DOMAIN_L1, reset) - 1);
+  }
+
+  /* full_sim checks forward progress after every step in which core 0 is at
+     a multiple of FORWARD_PROGRESS_INTERVAL. The check gives the same answer
+     in all steps at one core 0 cycle, so the last step may be any of them. */
+  Counter cycle = freq_cycle_count(FREQ_DOMAIN_CORES[0]) +
+                  !freq_is_ready(FREQ_DOMAIN_CORES[0]);
+  Counter check = (cycle + FORWARD_PROGRESS_INTERVAL - 1) /
+                  FORWARD_PROGRESS_INTERVAL * FORWARD_PROGRESS_INTERVAL;
+  jump.limit    = MIN2(jump.limit,
+                    freq_cycle_start_time(FREQ_DOMAIN_CORES[0], check + 1) - 1);
+
+  trigger_scan(cmp_idle_trigger_limit, &jump);
+
+  if(jump.limit <= jump.start)
+    return FALSE;
+  Counter last = freq_last_ready_time(jump.limit);
+  if(last == jump.start)
+    return FALSE;
+
+  for(uns ii = 0; ii <= NUM_CORES; ii++) {
+    Freq_Domain_Id id           = cmp_idle_freq_domain(ii);
+    idle_domains[ii].first_cycle = freq_cycle_count(id) + !freq_is_ready(id);
+  }
+
+  Counter tick = freq_cycle_start_time(
+    FREQ_DOMAIN_MEMORY, freq_cycle_count(FREQ_DOMAIN_MEMORY) +
+                          !freq_is_ready(FREQ_DOMAIN_MEMORY));
+  for(; tick <= last; tick += freq_get_cycle_time(FREQ_DOMAIN_MEMORY)) {
+    Counter watched = 0, watched_after = 0;
+
+    freq_skip_to(tick);
+    cycle_count = freq_cycle_count(FREQ_DOMAIN_MEMORY);
+    trigger_scan(cmp_idle_trigger_sum, &watched);
+    ramulator_tick();
+    trigger_scan(cmp_idle_trigger_sum, &watched_after);
+
+    /* the trigger limit above did not know about Ramulator's stats */
+    if(mem_next_event() != MAX_CTR || watched_after != watched) {
+      last = tick;
+      break;
+    }
+  }
+  freq_skip_to(last);
+
+  for(uns ii = 0; ii <= NUM_CORES; ii++) {
+    Idle_Domain* domain = &idle_domains[ii];
+    Idle_Cycle*  idle   = &domain->probes[domain->cur];
+    Counter      cycles = freq_cycle_count(cmp_idle_freq_domain(ii)) + 1 -
+                     domain->first_cycle;
+
+    stat_apply_deltas(idle->stat_deltas, idle->num_stat_deltas, cycles);
+    if(ii < NUM_CORES) {
+      cmp_model.node_stage[ii].ret_stall_length += idle->ret_stall_inc *
+                                                   cycles;
+      cmp_model.node_stage[ii].mem_block_length += idle->mem_block_inc *
+                                                   cycles;
+    } else if(cycles) {
+      /* PERF_PRED_CYCLE is assigned, so it is right after the deltas too */
+      cycle_count = freq_cycle_count(FREQ_DOMAIN_L1);
+      perf_pred_cycle();
+      pref_skip_cycles(cycles);
+    }
+  }
+
+  /* Finish the last step like cmp_cycle would */
+  if(freq_is_ready(FREQ_DOMAIN_MEMORY))
+    cycle_count = freq_cycle_count(FREQ_DOMAIN_MEMORY);
+  if(freq_is_ready(FREQ_DOMAIN_L1))
+    cycle_count = freq_cycle_count(FREQ_DOMAIN_L1);
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     if(freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
       cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
-
       set_bp_data(&cmp_model.bp_data[proc_id]);
       set_bp_recovery_info(&cmp_model.bp_recovery_info[proc_id]);
       cmp_set_all_stages(proc_id);
+    }
+  }
+  if(DVFS_ON)
+    dvfs_cycle();
+  cache_part_update();
 
-      update_dcache_stage(&exec->sd);
-      update_exec_stage(&node->sd);
-      update_node_stage(map->last_sd);
-      update_map_stage(dec->last_sd);
-      update_decode_stage(&ic->sd);
-      update_icache_stage();
-
-      node_sched_ops();
+  cmp_idle_reset();
+  return TRUE;
+}
 
-      cmp_measure_chip_util();
+/**************************************************************************************/
+/* cmp_idle_trigger_limit: Lowers the limit of the jump to the first step at
+   which the trigger fires, using the probed changes of the stat it watches.
+   A trigger at or past its threshold already fires in the current step. */
+
+static void cmp_idle_trigger_limit(const Stat* stat, Counter threshold,
+                                   void* arg) {
+  Idle_Jump* jump = (Idle_Jump*)arg;
+  Counter    incs[MAX_NUM_PROCS + 1];
+  Flag       is_time = FALSE;  // stat counts femtoseconds (freq_skip_to)
+  Flag       changes = FALSE;
+
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    is_time |= stat == &global_stat_array[proc_id][EXECUTION_TIME] ||
+               stat == &global_stat_array[proc_id][POWER_TIME];
+
+  for(uns ii = 0; ii <= NUM_CORES; ii++) {
+    Idle_Cycle* idle = &idle_domains[ii].probes[idle_domains[ii].cur];
+    SCounter    inc  = 0;
+    for(uns jj = 0; jj < idle->num_stat_deltas; jj++) {
+      if(idle->stat_deltas[jj].count == &stat->count)
+        inc += (SCounter)idle->stat_deltas[jj].inc;
+    }
+    if(inc < 0) {
+      jump->limit = MIN2(jump->limit, jump->start);  // not monotonic
+      return;
     }
+    incs[ii] = inc;
+    changes |= inc > 0;
+  }
+
+  if(cmp_idle_stat_at(stat, jump, incs, is_time, jump->start) >= threshold) {
+    jump->limit = MIN2(jump->limit, jump->start);
+    return;
+  }
+  if((!changes && !is_time) || jump->limit <= jump->start ||
+     cmp_idle_stat_at(stat, jump, incs, is_time, jump->limit) < threshold)
+    return;
+
+  Counter lo = jump->start, hi = jump->limit;
+  while(hi - lo > 1) {
+    Counter mid = lo + (hi - lo) / 2;
+    if(cmp_idle_stat_at(stat, jump, incs, is_time, mid) >= threshold)
+      hi = mid;
+    else
+      lo = mid;
   }
+  jump->limit = hi;
+}
+
+/**************************************************************************************/
+/* cmp_idle_stat_at: Value the trigger sees after a jump whose last step is
+   the last one starting by fs */
+
+static Counter cmp_idle_stat_at(const Stat* stat, const Idle_Jump* jump,
+                                const Counter* incs, Flag is_time,
+                                Counter fs) {
+  Counter step  = freq_last_ready_time(fs);
+  Counter count = stat->count + stat->total_count +
+                  (is_time ? step - jump->start : 0);
+
+  for(uns ii = 0; ii <= NUM_CORES; ii++)
+    count += incs[ii] * freq_cycles_until(cmp_idle_freq_domain(ii), step);
+  return count;
+}
+
+/**************************************************************************************/
+/* cmp_idle_trigger_sum: Adds up the stats the triggers watch */
+
+static void cmp_idle_trigger_sum(const Stat* stat, Counter threshold,
+                                 void* arg) {
+  UNUSED(threshold);
+  *(Counter*)arg += stat->count + stat->total_count;
 }
 
 /**************************************************************************************/
@@ -297,9 +769,7 @@ void cmp_wake(Op* src_op, Op* dep_op, uns8 rdy_bit) {
      !dep_op->in_rdy_list) {
     _DEBUG(dep_op->proc_id, DEBUG_NODE_STAGE,
            "Adding to ready list  op_num:%s\n", unsstr64(dep_op->op_num));
-    dep_op->next_rdy    = node->rdy_head;
-    node->rdy_head      = dep_op;
-    dep_op->in_rdy_list = TRUE;
+    node_add_to_ready_list(dep_op);
   }
 }
 
@@ -466,6 +936,42 @@ void cmp_warmup(Op* op) {
   }
 }
 
+/**************************************************************************************/
+/* Save or restore everything cmp_warmup touches, so that a later run can
+   restore it instead of simulating the warmup instructions again. */
+
+void cmp_ckpt(Ckpt* ckpt) {
+  uns proc_id;
+
+  for(proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Icache_Stage* ic = &(cmp_model.icache_stage[proc_id]);
+    cache_ckpt(&ic->icache, ckpt);
+    ckpt_region(ckpt, "icache next_fetch_addr", &ic->next_fetch_addr,
+                sizeof(ic->next_fetch_addr));
+    cache_ckpt(&(cmp_model.dcache_stage[proc_id].dcache), ckpt);
+    bp_ckpt(&(cmp_model.bp_data[proc_id]), ckpt);
+    if(PRIVATE_L1 || proc_id == 0)
+      cache_ckpt(&(cmp_model.memory.uncores[proc_id].l1->cache), ckpt);
+  }
+}
+
+/* Rejects, at init, the configurations cmp_ckpt can't save (the branch
+   predictors are checked by init_bp_data) */
+static void cmp_ckpt_check(void) {
+  uns proc_id;
+
+  if(L1_PART_SHADOW_WARMUP)
+    FATAL_ERROR(0, "Warmup checkpoints do not cover the L1 partition shadow "
+                   "caches (L1_PART_SHADOW_WARMUP)\n");
+
+  for(proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    cache_ckpt_check(&(cmp_model.icache_stage[proc_id].icache));
+    cache_ckpt_check(&(cmp_model.dcache_stage[proc_id].dcache));
+    if(PRIVATE_L1 || proc_id == 0)
+      cache_ckpt_check(&(cmp_model.memory.uncores[proc_id].l1->cache));
+  }
+}
+
 static void cmp_measure_chip_util() {
   Flag chip_busy = exec->fus_busy ||
                    mem->uncores[exec->proc_id].num_outstanding_l1_accesses >
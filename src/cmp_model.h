@@ -80,12 +80,14 @@ extern Cmp_Model cmp_model;
 void cmp_init(uns mode);
 void cmp_reset(void);
 void cmp_cycle(void);
+Flag cmp_idle_cycle(void);
 void cmp_debug(void);
 void cmp_per_core_done(uns8);
 void cmp_done(void);
 void cmp_wake(Op*, Op*, uns8);
 void cmp_retire_hook(Op*);
 void cmp_warmup(Op*);
+void cmp_ckpt(Ckpt*);
 
 /**************************************************************************************/
 
@@ -585,6 +585,17 @@ void update_dcache_stage(Stage_Data* src_sd) {
 }
 
 
+/**************************************************************************************/
+/* dcache_stage_next_event: Returns the first cycle at which the dcache stage
+   can change anything besides stats, assuming exec passes it no ops. */
+
+Counter dcache_stage_next_event(void) {
+  if(dc->sd.op_count)
+    return cycle_count;
+  return dc->idle_cycle > cycle_count ? dc->idle_cycle : MAX_CTR;
+}
+
+
 /**************************************************************************************/
 /* dcache_fill_line: */
 
@@ -100,6 +100,8 @@ Flag dcache_fill_line(Mem_Req*);
 void update_iso_miss(Op*);
 Flag do_oracle_dcache_access(Op*, Addr*);
 
+Counter dcache_stage_next_event(void);
+
 /**************************************************************************************/
 
 #endif /* #ifndef __DCACHE_STAGE_H__ */
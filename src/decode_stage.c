@@ -197,6 +197,26 @@ void update_decode_stage(Stage_Data* src_sd) {
 }
 
 
+/**************************************************************************************/
+/* decode_stage_next_event: Returns cycle_count if an op can move between the
+   decode latches this cycle and MAX_CTR otherwise. With every latch either
+   stalled or empty, update_decode_stage only swaps empty latches. */
+
+Counter decode_stage_next_event(Stage_Data* src_sd) {
+  uns ii;
+
+  for(ii = 0; ii < STAGE_MAX_DEPTH - 1; ii++) {
+    if(dec->sds[ii].op_count == 0 && dec->sds[ii + 1].op_count > 0)
+      return cycle_count;
+  }
+
+  if(dec->sds[STAGE_MAX_DEPTH - 1].op_count == 0 && src_sd->op_count > 0)
+    return cycle_count;
+
+  return MAX_CTR;
+}
+
+
 /**************************************************************************************/
 /* process_decode_op: */
 
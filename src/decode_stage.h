@@ -61,6 +61,8 @@ void recover_decode_stage(void);
 void debug_decode_stage(void);
 void update_decode_stage(Stage_Data*);
 
+Counter decode_stage_next_event(Stage_Data*);
+
 
 /**************************************************************************************/
 
@@ -0,0 +1,137 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : dvfs/dram_sharing.c
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : DRAM bank sharing model for DVFS speedup prediction.
+ *
+ * The time of each core is split into compute time, which scales with the core
+ * frequency, L1 access stall time, which does not scale, and DRAM stall time,
+ * which scales with the DRAM latency. The latency is a fixed service time plus
+ * a wait in a queue on the banks, which at bank utilization U is proportional
+ * to U / (1 - U). By Little's law, the reads in flight (the summed MLP of the
+ * cores) are either being served by a bank in demand or waiting, which gives
+ * the waiting share of the current latency. Without MLP measurements the whole
+ * latency is treated as waiting, proportional to 1 / (1 - U).
+ * Banks are kept busy by row activations, so the utilization grows with the
+ * summed row activation rate of the cores, and the row activation rate of a
+ * core grows with its speedup. The utilization of a configuration is the fixed
+ * point of these two relations, found by bisection (the utilization implied by
+ * a guess only falls as the guess rises).
+ ***************************************************************************************/
+
+#include "dvfs/dram_sharing.h"
+#include "globals/assert.h"
+#include "globals/utils.h"
+
+/**************************************************************************************/
+/* Macros */
+
+/* Utilization at which the bank queue is treated as saturated */
+#define DRAM_SHARING_MAX_UTIL 0.99
+#define DRAM_SHARING_ITERS 48
+
+/**************************************************************************************/
+/* Local prototypes */
+
+static double wait_fraction(Dram_Sharing_Input const* input);
+static double predict_speedups(Dram_Sharing_Input const* input,
+                               double const* freq_speedups, double util,
+                               double* speedups);
+
+/**************************************************************************************/
+/* wait_fraction: Share of the current DRAM latency spent waiting for a bank. */
+
+static double wait_fraction(Dram_Sharing_Input const* input) {
+  double reads = 0.0;
+  for(uns proc_id = 0; proc_id < input->num_cores; proc_id++)
+    reads += input->mlp[proc_id];
+  if(reads <= 0.0)
+    return 1.0;  // not measured
+
+  double served = input->bank_util * input->num_banks;
+  return reads > served ? 1.0 - served / reads : 0.0;
+}
+
+/**************************************************************************************/
+/* predict_speedups: Speedups of all cores if the banks ran at utilization
+   util. Returns the utilization those speedups would cause. */
+
+static double predict_speedups(Dram_Sharing_Input const* input,
+                               double const* freq_speedups, double util,
+                               double* speedups) {
+  double cur_util      = MIN2(input->bank_util, DRAM_SHARING_MAX_UTIL);
+  double wait_frac     = wait_fraction(input);
+  double latency_ratio = 1.0 - wait_frac;
+  double row_opens     = 0.0;
+  double new_row_opens = 0.0;
+
+  if(wait_frac == 1.0)
+    latency_ratio = (1.0 - cur_util) / (1.0 - util);
+  else if(cur_util > 0.0)
+    latency_ratio += wait_frac * util * (1.0 - cur_util) /
+                     ((1.0 - util) * cur_util);
+
+  for(uns proc_id = 0; proc_id < input->num_cores; proc_id++) {
+    double stall_frac    = input->stall_frac[proc_id];
+    double l1_stall_frac = input->l1_stall_frac[proc_id];
+    speedups[proc_id]    = 1.0 / ((1.0 - stall_frac - l1_stall_frac) /
+                                   freq_speedups[proc_id] +
+                                 stall_frac * latency_ratio + l1_stall_frac);
+    row_opens += input->row_opens[proc_id];
+    new_row_opens += input->row_opens[proc_id] * speedups[proc_id];
+  }
+
+  return row_opens > 0.0 ? cur_util * new_row_opens / row_opens : cur_util;
+}
+
+/**************************************************************************************/
+/* dram_sharing_solve: */
+
+void dram_sharing_solve(Dram_Sharing_Input const* input,
+                        double const* freq_speedups, uns num_configs,
+                        double* speedups) {
+  ASSERT(0, input->num_cores <= MAX_NUM_PROCS);
+
+  for(uns ii = 0; ii < num_configs; ii++) {
+    double const* config_freq_speedups = freq_speedups + ii * input->num_cores;
+    double*       config_speedups      = speedups + ii * input->num_cores;
+
+    double lo = 0.0;
+    double hi = DRAM_SHARING_MAX_UTIL;
+    if(predict_speedups(input, config_freq_speedups, hi, config_speedups) >=
+       hi)
+      continue;  // saturated: the speedups at the maximum utilization stand
+
+    for(uns iter = 0; iter < DRAM_SHARING_ITERS; iter++) {
+      double mid = (lo + hi) / 2.0;
+      if(predict_speedups(input, config_freq_speedups, mid, config_speedups) >
+         mid)
+        lo = mid;
+      else
+        hi = mid;
+    }
+    predict_speedups(input, config_freq_speedups, (lo + hi) / 2.0,
+                     config_speedups);
+  }
+}
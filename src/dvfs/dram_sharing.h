@@ -0,0 +1,62 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : dvfs/dram_sharing.h
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : DRAM bank sharing model for DVFS speedup prediction
+ ***************************************************************************************/
+
+#ifndef __DRAM_SHARING_H__
+#define __DRAM_SHARING_H__
+
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Types */
+
+/* Measurements of the last DVFS interval, at the current configuration */
+typedef struct Dram_Sharing_Input_struct {
+  uns    num_cores;
+  uns    num_banks;
+  double bank_util;                  // average fraction of banks in demand
+  double row_opens[MAX_NUM_PROCS];   // row activations per DRAM cycle
+  double mlp[MAX_NUM_PROCS];         // DRAM reads in flight per DRAM cycle
+  double stall_frac[MAX_NUM_PROCS];  // fraction of cycles stalled on DRAM
+  double l1_stall_frac[MAX_NUM_PROCS];  // fraction of cycles stalled on L1
+                                        // accesses (0 unless
+                                        // DVFS_COUNT_L1_ACCESS_STALL)
+} Dram_Sharing_Input;
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Predict the speedup of every core for each of num_configs candidate
+   configurations. freq_speedups and speedups are num_configs rows of
+   num_cores values; freq_speedups holds the core frequency of the candidate
+   relative to the current one. */
+void dram_sharing_solve(Dram_Sharing_Input const* input,
+                        double const* freq_speedups, uns num_configs,
+                        double* speedups);
+
+#endif  // __DRAM_SHARING_H__
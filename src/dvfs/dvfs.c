@@ -30,7 +30,9 @@
 #include <errno.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include "debug/debug_macros.h"
+#include "dram_sharing.h"
 #include "dvfs.param.h"
 #include "freq.h"
 #include "globals/assert.h"
@@ -96,6 +98,8 @@ static FILE*      config_trace;
 static Trigger*   start_trigger;
 static Trigger*   trigger;
 static Proc_Info* proc_infos;
+static double*    dram_sharing_freq_speedups;  // [num_configs][NUM_CORES]
+static double*    dram_sharing_speedups;       // [num_configs][NUM_CORES]
 
 /**************************************************************************************/
 /* Local prototypes */
@@ -114,6 +118,7 @@ static Metric get_metric(void);
 static double gmean(const double* array, uns num);
 static double compute_oracle_metric(void);
 static void   invoke_dram_sharing_solver(double* pred_speedups, Config* config);
+static void   compute_dram_sharing_speedups(void);
 static void compute_stall_time_speedups(double* pred_speedups, Config* config);
 static void compute_bw_sharing_speedups(double* pred_speedups, Config* config);
 
@@ -161,8 +166,10 @@ void dvfs_init(void) {
   stat_mon = stat_mon_create_from_array(monitored_stats,
                                         NUM_ELEMENTS(monitored_stats));
 
-  start_trigger = trigger_create("DVFS START", DVFS_START, TRIGGER_ONCE);
-  trigger       = trigger_create("DVFS PERIOD", DVFS_PERIOD, TRIGGER_REPEAT);
+  /* a static configuration never looks at the period */
+  const char* period = DVFS_STATIC ? "never" : DVFS_PERIOD;
+  start_trigger      = trigger_create("DVFS START", DVFS_START, TRIGGER_ONCE);
+  trigger            = trigger_create("DVFS PERIOD", period, TRIGGER_REPEAT);
 
   if(DVFS_LOG) {
     dvfs_log = file_tag_fopen(NULL, "dvfs", "w");
@@ -170,6 +177,15 @@ void dvfs_init(void) {
   }
 
   proc_infos = malloc(NUM_CORES * sizeof(Proc_Info));
+  if(DVFS_USE_DRAM_SHARING && !DVFS_USE_BW_SHARING &&
+     !DVFS_DRAM_SHARING_SOLVER_BIN && !DVFS_DRAM_SHARING_NATIVE)
+    FATAL_ERROR(0, "DVFS_USE_DRAM_SHARING needs DVFS_DRAM_SHARING_SOLVER_BIN, "
+                   "or DVFS_DRAM_SHARING_NATIVE for the built-in model\n");
+  if(DVFS_USE_DRAM_SHARING && DVFS_DRAM_SHARING_NATIVE) {
+    dram_sharing_freq_speedups = malloc(num_configs * NUM_CORES *
+                                        sizeof(double));
+    dram_sharing_speedups = malloc(num_configs * NUM_CORES * sizeof(double));
+  }
 
   if(!DVFS_STATIC) {
     /* set the processor to the initial config */
@@ -318,8 +334,12 @@ void dvfs_cycle(void) {
     return;
   }
 
+  /* Poll the start trigger every cycle so that it does not stay armed past
+     its threshold (IDLE_CYCLE_SKIP stops at every armed trigger that is) */
+  Flag started = trigger_on(start_trigger);
+
   if(trigger_fired(trigger)) {
-    if(trigger_on(start_trigger)) {
+    if(started) {
       if(DVFS_REPLAY_CONFIG_TRACE) {
         set_config_num(dvfs_read_config_trace());
       } else if(DVFS_USE_ORACLE) {
@@ -452,14 +472,23 @@ static void dvfs_reconfigure_dram_sharing(void) {
   uns    min_metric_idx = num_configs;
   if(metric.energy_exp != 0)
     power_intf_calc();
+  /* with individual core frequencies, there are too many configs to log */
+  Flag log_predictions = DVFS_LOG && !DVFS_INDIVIDUAL_CORES;
   if(DVFS_LOG)
-    fprintf(dvfs_log, "Time: %llu\tInsts: %llu\tPredictions: (too many)\n",
-            sim_time, inst_count[0]);
+    fprintf(dvfs_log, "Time: %llu\tInsts: %llu\tPredictions:%s", sim_time,
+            inst_count[0], log_predictions ? "" : " (too many)\n");
+  Flag native_dram_sharing = DVFS_USE_DRAM_SHARING &&
+                             DVFS_DRAM_SHARING_NATIVE;
+  if(!DVFS_USE_BW_SHARING && native_dram_sharing)
+    compute_dram_sharing_speedups();
   for(uns i = 0; i < num_configs; ++i) {
     Config* config                       = &configs[i];
     double  pred_speedups[MAX_NUM_PROCS] = {0};
     if(DVFS_USE_BW_SHARING) {
       compute_bw_sharing_speedups(pred_speedups, config);
+    } else if(native_dram_sharing) {
+      memcpy(pred_speedups, dram_sharing_speedups + i * NUM_CORES,
+             NUM_CORES * sizeof(double));
     } else if(DVFS_USE_DRAM_SHARING) {
       invoke_dram_sharing_solver(pred_speedups, config);
     } else {
@@ -501,8 +530,17 @@ static void dvfs_reconfigure_dram_sharing(void) {
       0,
       "Predicted metric for config \%d is %f (norm. power %f, slowdown %f)\n",
       i, metric, pred_norm_power, pred_gmean_slowdown);
-    // if (DVFS_LOG) fprintf(dvfs_log, " (%f, %f)", pred_norm_power,
-    // pred_gmean_slowdown);
+    if(log_predictions && native_dram_sharing &&
+       DVFS_DRAM_SHARING_SOLVER_BIN) {
+      /* comparison run: log what the external solver predicts next to the
+         built-in model, which still makes the decision */
+      double solver_speedups[MAX_NUM_PROCS] = {0};
+      invoke_dram_sharing_solver(solver_speedups, config);
+      fprintf(dvfs_log, " (%f, %f, %f)", pred_norm_power, pred_gmean_slowdown,
+              1.0 / gmean(solver_speedups, NUM_CORES));
+    } else if(log_predictions) {
+      fprintf(dvfs_log, " (%f, %f)", pred_norm_power, pred_gmean_slowdown);
+    }
     if(metric < min_metric) {
       min_metric     = metric;
       min_metric_idx = i;
@@ -592,6 +630,50 @@ static void invoke_dram_sharing_solver(double* pred_speedups, Config* config) {
   }
 }
 
+/* Native counterpart of the DRAM sharing solver: predicts the speedups of all
+   configurations at once from the stats of the last interval */
+static void compute_dram_sharing_speedups(void) {
+  Dram_Sharing_Input input;
+
+  Counter dram_cycles      = stat_mon_get_count(stat_mon, 0, DRAM_CYCLES);
+  Counter blp_times_cycles = stat_mon_get_count(stat_mon, 0,
+                                                DRAM_BANK_IN_DEMAND);
+  input.num_cores = NUM_CORES;
+  input.num_banks = RAMULATOR_CHANNELS * RAMULATOR_BANKS;
+  input.bank_util = (double)blp_times_cycles / (double)dram_cycles /
+                    (double)input.num_banks;
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Counter row_opens        = stat_mon_get_count(stat_mon, proc_id,
+                                                  POWER_DRAM_ACTIVATE);
+    Counter mlp_times_cycles = stat_mon_get_count(stat_mon, proc_id,
+                                                  DRAM_GLOBAL_MLP);
+    Counter core_cycles  = stat_mon_get_count(stat_mon, proc_id, NODE_CYCLE);
+    Counter stall_cycles = stat_mon_get_count(stat_mon, proc_id,
+                                              RET_BLOCKED_L1_MISS);
+    Counter l1_stall_cycles = DVFS_COUNT_L1_ACCESS_STALL ?
+                                stat_mon_get_count(stat_mon, proc_id,
+                                                   RET_BLOCKED_L1_ACCESS) :
+                                0;
+    input.row_opens[proc_id]     = (double)row_opens / (double)dram_cycles;
+    input.mlp[proc_id]           = (double)mlp_times_cycles /
+                                   (double)dram_cycles;
+    input.stall_frac[proc_id]    = (double)stall_cycles / (double)core_cycles;
+    input.l1_stall_frac[proc_id] = (double)l1_stall_cycles /
+                                   (double)core_cycles;
+  }
+
+  for(uns i = 0; i < num_configs; ++i) {
+    for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      dram_sharing_freq_speedups[i * NUM_CORES + proc_id] =
+        (double)cur_config->core_cycle_times[proc_id] /
+        (double)configs[i].core_cycle_times[proc_id];
+    }
+  }
+
+  dram_sharing_solve(&input, dram_sharing_freq_speedups, num_configs,
+                     dram_sharing_speedups);
+}
+
 static void compute_stall_time_speedups(double* pred_speedups, Config* config) {
   for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     Counter core_cycles  = stat_mon_get_count(stat_mon, proc_id, NODE_CYCLE);
@@ -694,7 +694,7 @@ void perf_pred_reset_stats(void) {
 
 void perf_pred_cycle(void) {
   chip_cycle_count                   = freq_cycle_count(FREQ_DOMAIN_L1);
-  GET_STAT_EVENT(0, PERF_PRED_CYCLE) = chip_cycle_count;
+  SET_STAT_EVENT(0, PERF_PRED_CYCLE, chip_cycle_count);
 }
 
 double perf_pred_slowdown(uns proc_id, Perf_Pred_Mech mech, uns chip_cycle_time,
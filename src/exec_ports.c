@@ -265,6 +265,14 @@ void init_exec_ports_rs_list(uns proc_id, Reservation_Station* rs,
       idx  = __builtin_ffs(next);    // Find the next set bit
     }
     rs[i].num_fus = num_fus;
+
+    rs[i].type_fus = (uns64*)calloc(FU_TYPE_WIDTH, sizeof(uns64));
+    for(uns32 type = 0; type < FU_TYPE_WIDTH; ++type) {
+      for(int32 jj = 0; jj < num_fus; ++jj) {
+        if(rs[i].connected_fus[jj]->type & (1ull << type))
+          rs[i].type_fus[type] |= 1ull << rs[i].connected_fus[jj]->fu_id;
+      }
+    }
     ASSERTM(
       proc_id, num_fus <= NUM_FUS,
       "RS must be connected to less than or equal the total number of FUs\n");
@@ -393,6 +393,29 @@ void update_exec_stage(Stage_Data* src_sd) {
   memview_fus_busy(exec->proc_id, exec->fus_busy);
 }
 
+/**************************************************************************************/
+/* exec_stage_next_event: Returns the first cycle at which update_exec_stage
+   can change anything besides stats, assuming nothing is scheduled to it.
+   Empty functional units only change state when they go idle. */
+
+Counter exec_stage_next_event(void) {
+  Counter next = MAX_CTR;
+  uns     ii;
+
+  if(exec->sd.op_count)
+    return cycle_count;
+
+  for(ii = 0; ii < NUM_FUS; ii++) {
+    Func_Unit* fu = &exec->fus[ii];
+    if(fu->held_by_mem)
+      return cycle_count;
+    if(fu->idle_cycle > cycle_count)
+      next = MIN2(next, fu->idle_cycle);
+  }
+
+  return next;
+}
+
 void exec_stage_inc_power_stats(Op* op) {
   STAT_EVENT(op->proc_id, POWER_ROB_READ);
   STAT_EVENT(op->proc_id, POWER_ROB_WRITE);
@@ -78,6 +78,8 @@ void debug_exec_stage(void);
 void update_exec_stage(Stage_Data*);
 void finalize_exec_stage(void);
 
+Counter exec_stage_next_event(void);
+
 /**************************************************************************************/
 
 
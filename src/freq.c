@@ -31,6 +31,7 @@
 #include "debug/debug_macros.h"
 #include "globals/assert.h"
 #include "globals/global_defs.h"
+#include "globals/utils.h"
 #include "memory/memory.param.h"
 #include "ramulator.param.h"
 #include "statistics.h"
@@ -110,18 +111,18 @@ void freq_init(void) {
   }
   for(int proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     sprintf(buf, "CORE_%d", proc_id);
-    FREQ_DOMAIN_CORES[proc_id]                     = freq_domain_create(buf,
+    FREQ_DOMAIN_CORES[proc_id] = freq_domain_create(buf,
                                                     core_cycle_times[proc_id]);
-    GET_STAT_EVENT(proc_id, PARAM_CORE_CYCLE_TIME) = core_cycle_times[proc_id];
+    SET_STAT_EVENT(proc_id, PARAM_CORE_CYCLE_TIME, core_cycle_times[proc_id]);
   }
   FREQ_DOMAIN_L1 = freq_domain_create("L1", l1_cycle_time);
   // FREQ_DOMAIN_MEMORY = freq_domain_create("MEMORY", MEMORY_CYCLE_TIME);
   FREQ_DOMAIN_MEMORY = freq_domain_create("MEMORY", RAMULATOR_TCK);
   /* These stats simplify data analysis by allowing cycle times to
      be used in get_cmp_data stat formulas */
-  GET_STAT_EVENT(0, PARAM_L1_CYCLE_TIME) = l1_cycle_time;
+  SET_STAT_EVENT(0, PARAM_L1_CYCLE_TIME, l1_cycle_time);
   // GET_STAT_EVENT(0, PARAM_MEMORY_CYCLE_TIME) = MEMORY_CYCLE_TIME;
-  GET_STAT_EVENT(0, PARAM_MEMORY_CYCLE_TIME) = RAMULATOR_TCK;
+  SET_STAT_EVENT(0, PARAM_MEMORY_CYCLE_TIME, RAMULATOR_TCK);
 }
 
 static Freq_Domain_Id freq_domain_create(char* name, uns cycle_time) {
@@ -187,6 +188,19 @@ void freq_reset_cycle_counts(void) {
   }
 }
 
+void freq_ckpt(Ckpt* ckpt) {
+  ckpt_region(ckpt, "freq time", &cur_time, sizeof(cur_time));
+  for(uns i = 0; i < num_domains; i++) {
+    ckpt_region(ckpt, "freq cycles", &domains[i].cycles,
+                sizeof(domains[i].cycles));
+    ckpt_region(ckpt, "freq cycle_time", &domains[i].cycle_time,
+                sizeof(domains[i].cycle_time));
+    ckpt_region(ckpt, "freq time_until_next_cycle",
+                &domains[i].time_until_next_cycle,
+                sizeof(domains[i].time_until_next_cycle));
+  }
+}
+
 Counter freq_cycle_count(Freq_Domain_Id id) {
   ASSERT(0, id < num_domains);
   return domains[id].cycles;
@@ -203,6 +217,78 @@ Counter freq_future_time(Freq_Domain_Id id, Counter cycles) {
   return freq_time() + (cycles - domains[id].cycles) * domains[id].cycle_time;
 }
 
+/* Start time of the cycle after the domain's current one */
+static inline Counter freq_next_cycle_time(Domain_Info* domain) {
+  return cur_time + (domain->time_until_next_cycle ?
+                       domain->time_until_next_cycle :
+                       domain->cycle_time);
+}
+
+Counter freq_cycle_start_time(Freq_Domain_Id id, Counter cycle) {
+  ASSERT(0, id < num_domains);
+  Domain_Info* domain = &domains[id];
+  if(cycle == domain->cycles && domain->time_until_next_cycle == 0)
+    return cur_time;
+  ASSERT(0, cycle > domain->cycles);
+  return freq_next_cycle_time(domain) +
+         (cycle - domain->cycles - 1) * domain->cycle_time;
+}
+
+Counter freq_cycles_until(Freq_Domain_Id id, Counter fs) {
+  ASSERT(0, id < num_domains);
+  ASSERT(0, fs >= cur_time);
+  Domain_Info* domain = &domains[id];
+  Counter      next   = freq_next_cycle_time(domain);
+  Counter      count  = domain->time_until_next_cycle == 0;
+  if(fs >= next)
+    count += (fs - next) / domain->cycle_time + 1;
+  return count;
+}
+
+Counter freq_last_ready_time(Counter fs) {
+  ASSERT(0, fs >= cur_time);
+  Counter last = cur_time;
+  for(uns i = 0; i < num_domains; i++) {
+    Counter next = freq_next_cycle_time(&domains[i]);
+    if(fs >= next) {
+      Counter start = next + (fs - next) / domains[i].cycle_time *
+                               domains[i].cycle_time;
+      last = MAX2(last, start);
+    }
+  }
+  return last;
+}
+
+void freq_skip_to(Counter fs) {
+  ASSERT(0, fs >= cur_time);
+  if(fs == cur_time)
+    return;
+
+  Flag any_ready = FALSE;
+  for(uns i = 0; i < num_domains; i++) {
+    Counter next = freq_next_cycle_time(&domains[i]);
+    if(fs >= next) {
+      Counter num_cycles = (fs - next) / domains[i].cycle_time + 1;
+      Counter last_start = next + (num_cycles - 1) * domains[i].cycle_time;
+      domains[i].cycles += num_cycles;
+      domains[i].time_until_next_cycle = last_start == fs ?
+                                           0 :
+                                           last_start +
+                                             domains[i].cycle_time - fs;
+    } else {
+      domains[i].time_until_next_cycle = next - fs;
+    }
+    any_ready |= domains[i].time_until_next_cycle == 0;
+  }
+  ASSERTM(0, any_ready, "No frequency domain is ready at time %lld fs\n",
+          fs);
+
+  INC_STAT_EVENT_ALL(EXECUTION_TIME, fs - cur_time);
+  INC_STAT_EVENT_ALL(POWER_TIME, fs - cur_time);
+  cur_time = fs;
+  DEBUG(0, "Skipping time to %lld fs\n", cur_time);
+}
+
 void freq_set_cycle_time(Freq_Domain_Id id, uns cycle_time) {
   ASSERT(0, id < num_domains);
   ASSERT(0, cycle_time > 0);
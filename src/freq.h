@@ -30,6 +30,7 @@
 #define __FREQ_H__
 
 #include "globals/global_types.h"
+#include "libs/ckpt_lib.h"
 
 /**************************************************************************************/
 /* Types */
@@ -60,6 +61,9 @@ void freq_advance_time(void);
 /* Reset cycle time of each domain to zero but keep the time value. */
 void freq_reset_cycle_counts(void);
 
+/* Save or restore the time and the state of every domain */
+void freq_ckpt(Ckpt* ckpt);
+
 /* Returns the cycle count in the specified frequency domain */
 Counter freq_cycle_count(Freq_Domain_Id id);
 
@@ -71,6 +75,23 @@ Counter freq_time(void);
    changing its frequency) */
 Counter freq_future_time(Freq_Domain_Id, Counter cycle_count);
 
+/* Returns the time when the specified cycle of a domain starts. The
+   cycle must be the current cycle of a ready domain or a later one. */
+Counter freq_cycle_start_time(Freq_Domain_Id id, Counter cycle);
+
+/* Returns how many cycles of the specified domain start between the
+   current time (inclusive) and the specified time (inclusive) */
+Counter freq_cycles_until(Freq_Domain_Id id, Counter fs);
+
+/* Returns the latest time not after the specified time when some
+   domain is ready (never earlier than the current time) */
+Counter freq_last_ready_time(Counter fs);
+
+/* Advances time to the specified time, which must be a time when some
+   domain is ready. Leaves every domain as repeated calls to
+   freq_advance_time would. */
+void freq_skip_to(Counter fs);
+
 /* Sets the cycle time of the specified frequency domain (takes effect
    on the next cycle of that domain) */
 void freq_set_cycle_time(Freq_Domain_Id, uns cycle_time);
@@ -103,6 +103,23 @@ void frontend_done(Flag* retired_exit) {
   }
 }
 
+Flag frontend_can_ckpt(void) {
+  /* the shared trace readers all start at the same record */
+  return FRONTEND == FE_TRACE && !TRACE_FANOUT;
+}
+
+void frontend_ckpt(Ckpt* ckpt) {
+  switch(FRONTEND) {
+    case FE_TRACE: {
+      trace_ckpt(ckpt);
+      break;
+    }
+    default:
+      ASSERT(0, 0);
+      break;
+  }
+}
+
 Addr frontend_next_fetch_addr(uns proc_id) {
   return frontend->next_fetch_addr(proc_id);
 }
@@ -29,6 +29,7 @@
 #define __FRONTEND_H__
 
 #include "globals/global_types.h"
+#include "libs/ckpt_lib.h"
 
 /*************************************************************/
 /* External frontend interface */
@@ -59,6 +60,13 @@ void frontend_recover(uns proc_id, uns64 inst_uid);
 /* Let the frontend know that this instruction is retired) */
 void frontend_retire(uns proc_id, uns64 inst_uid);
 
+/* Can the frontend save its position in a warmup checkpoint and seek back to
+   it (instead of reading through the warmup instructions again)? */
+Flag frontend_can_ckpt(void);
+
+/* Save or restore (seek to) the position of every core */
+void frontend_ckpt(Ckpt* ckpt);
+
 /*************************************************************/
 
 #endif /*  __FRONTEND_H__*/
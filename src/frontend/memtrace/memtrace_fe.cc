@@ -26,6 +26,7 @@
  * Description  : Frontend to simulate traces in memtrace format
  ***************************************************************************************/
 
+extern "C" {
 #include "debug/debug.param.h"
 #include "debug/debug_macros.h"
 #include "globals/assert.h"
@@ -33,6 +34,7 @@
 #include "globals/global_types.h"
 #include "globals/global_vars.h"
 #include "globals/utils.h"
+}
 
 #include "bp/bp.h"
 #include "bp/bp.param.h"
@@ -47,28 +49,81 @@
 
 #include "frontend/memtrace/memtrace_trace_reader_memtrace.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 /**************************************************************************************/
 /* Macros */
 
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_TRACE_READ, ##args)
 
+#define MEMTRACE_BLOCK_INSTS 4096  // decoded records per block
+#define MEMTRACE_RING_BLOCKS 4     // blocks decoded ahead per core
+
 //#define PRINT_INSTRUCTION_INFO
+/**************************************************************************************/
+/* Types */
+
+/* One core's trace. A prefetch thread fast-forwards the trace and then decodes
+   it into a small ring of blocks, which the simulator consumes. The trace
+   reader and the state below are only touched by that thread. */
+class Memtrace_Core {
+ public:
+  Memtrace_Core(uns proc_id, TraceReader* reader);
+  ~Memtrace_Core();
+
+  int read(ctype_pin_inst* next_pi);
+
+ private:
+  struct Block {
+    std::vector<ctype_pin_inst> insts;
+    size_t                      count;
+  };
+
+  void prefetch_loop();
+  void fast_forward();
+  int  decode(ctype_pin_inst* next_pi);
+
+  uns          proc_id;
+  TraceReader* reader;
+  uint64_t     ins_id;
+  uint64_t     prior_tid;
+  uint64_t     prior_pid;
+  const InstInfo* first;  // first instruction to simulate, if fast_forward
+                          // already read it
+
+  Block                   blocks[MEMTRACE_RING_BLOCKS];
+  uint64_t                produced;
+  uint64_t                consumed;
+  bool                    done;
+  bool                    stop;
+  std::mutex              lock;
+  std::condition_variable not_full;
+  std::condition_variable not_empty;
+  std::thread             thread;
+
+  /* consumer side, only touched by the simulator thread */
+  Block* cur_block;
+  size_t cur_idx;
+};
+
 /**************************************************************************************/
 /* Global Variables */
 
 char*           trace_files[MAX_NUM_PROCS];
-TraceReader*    trace_readers[MAX_NUM_PROCS];
+Memtrace_Core*  trace_cores[MAX_NUM_PROCS];
 ctype_pin_inst* next_pi;
-uint64_t        ins_id    = 0;
-uint64_t        prior_tid = 0;
-uint64_t        prior_pid = 0;
 
 /**************************************************************************************/
 /* Private Functions */
 
-void fill_in_dynamic_info(ctype_pin_inst* info, const InstInfo* insi) {
-  uint8_t ld = 0;
-  uint8_t st = 0;
+void fill_in_dynamic_info(ctype_pin_inst* info, const InstInfo* insi,
+                          uint64_t ins_id) {
+  const MemtraceInstRecord* rec = insi->rec;
+  uint8_t                   ld  = 0;
+  uint8_t                   st  = 0;
 
   // Note: should be overwritten for a taken control flow instruction
   info->instruction_addr      = insi->pc;
@@ -83,87 +138,195 @@ void fill_in_dynamic_info(ctype_pin_inst* info, const InstInfo* insi) {
             << " taken " << (uint32_t)info->actually_taken << " target "
             << info->branch_target << " pid " << insi->pid << " tid "
             << insi->tid << " asm "
-            << std::string(
-                 xed_iclass_enum_t2str(xed_decoded_inst_get_iclass(insi->ins)))
+            << std::string(xed_iclass_enum_t2str(
+                 (xed_iclass_enum_t)rec->info.true_op_type))
             << " uid " << std::dec << info->inst_uid << std::endl;
 #endif
 
-  if(xed_decoded_inst_get_iclass(insi->ins) == XED_ICLASS_RET_FAR ||
-     xed_decoded_inst_get_iclass(insi->ins) == XED_ICLASS_RET_NEAR)
+  if(rec->flags & REC_RET)
     info->actually_taken = 1;
 
-  for(uint8_t op = 0;
-      op < xed_decoded_inst_number_of_memory_operands(insi->ins); op++) {
-    // predicated true ld/st are handled just as regular ld/st
-    if(xed_decoded_inst_mem_read(insi->ins, op) && !insi->mem_used[op]) {
-      // Handle predicated stores specially?
-      info->ld_vaddr[ld++] = insi->mem_addr[op];
-    } else if(xed_decoded_inst_mem_read(insi->ins, op)) {
+  // predicated true ld/st are handled just as regular ld/st
+  for(uint8_t op = 0; op < rec->n_mem_operands && op < 2; op++) {
+    if(rec->mem_read & (1 << op)) {
       info->ld_vaddr[ld++] = insi->mem_addr[op];
     }
-    if(xed_decoded_inst_mem_written(insi->ins, op) && !insi->mem_used[op]) {
-      // Handle predicated stores specially?
-      info->st_vaddr[st++] = insi->mem_addr[op];
-    } else if(xed_decoded_inst_mem_written(insi->ins, op)) {
+    if(rec->mem_written & (1 << op)) {
       info->st_vaddr[st++] = insi->mem_addr[op];
     }
   }
 }
 
-int ffwd(const xed_decoded_inst_t* ins) {
-  if(!FAST_FORWARD) {
-    return 0;
+int roi(const MemtraceInstRecord* rec) {
+  return (rec->flags & REC_ROI) != 0;
+}
+
+/**************************************************************************************/
+/* Memtrace_Core */
+
+Memtrace_Core::Memtrace_Core(uns proc_id, TraceReader* reader) :
+    proc_id(proc_id), reader(reader), ins_id(0), prior_tid(0), prior_pid(0),
+    first(NULL), produced(0), consumed(0), done(false), stop(false), cur_block(NULL),
+    cur_idx(0) {
+  for(int ii = 0; ii < MEMTRACE_RING_BLOCKS; ii++) {
+    blocks[ii].insts.resize(MEMTRACE_BLOCK_INSTS);
+    blocks[ii].count = 0;
   }
-  if(XED_INS_Opcode(ins) == XED_ICLASS_XCHG &&
-     XED_INS_OperandReg(ins, 0) == XED_REG_RCX &&
-     XED_INS_OperandReg(ins, 1) == XED_REG_RCX) {
-    return 0;
+  thread = std::thread(&Memtrace_Core::prefetch_loop, this);
+}
+
+Memtrace_Core::~Memtrace_Core() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stop = true;
   }
-  if(ins_id == FAST_FORWARD_TRACE_INS) {
+  not_full.notify_all();
+  thread.join();
+  delete reader;
+}
+
+/* Copies the next decoded record into next_pi. Returns 0, and leaves next_pi
+   unchanged, at the end of the trace or of the ROI. The ROI marker that ends
+   the ROI is never returned. */
+int Memtrace_Core::read(ctype_pin_inst* next_pi) {
+  if(cur_block && cur_idx < cur_block->count) {
+    *next_pi = cur_block->insts[cur_idx++];
+    return 1;
+  }
+
+  std::unique_lock<std::mutex> guard(lock);
+  if(cur_block) {
+    consumed++;
+    cur_block = NULL;
+    not_full.notify_one();
+  }
+  not_empty.wait(guard, [this] { return produced > consumed || done; });
+  if(produced == consumed)
     return 0;
+  cur_block = &blocks[consumed % MEMTRACE_RING_BLOCKS];
+  cur_idx   = 0;
+  guard.unlock();
+  return read(next_pi);
+}
+
+void Memtrace_Core::prefetch_loop() {
+  fast_forward();
+
+  while(true) {
+    Block* block;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      not_full.wait(guard, [this] {
+        return produced - consumed < MEMTRACE_RING_BLOCKS || stop;
+      });
+      if(stop)
+        return;
+      block = &blocks[produced % MEMTRACE_RING_BLOCKS];
+    }
+
+    /* the block is owned by this thread until produced is bumped */
+    bool last = false;
+    for(block->count = 0; block->count < MEMTRACE_BLOCK_INSTS;
+        block->count++) {
+      if(!decode(&block->insts[block->count])) {
+        last = true;
+        break;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      produced++;
+      done = last;
+    }
+    not_empty.notify_one();
+    if(last)
+      return;
   }
-  return 1;
 }
 
-int roi(const xed_decoded_inst_t* ins) {
-  if(XED_INS_Opcode(ins) == XED_ICLASS_XCHG &&
-     XED_INS_OperandReg(ins, 0) == XED_REG_RCX &&
-     XED_INS_OperandReg(ins, 1) == XED_REG_RCX) {
-    return 1;
+/* Positions the trace like the pin trace frontend does: at instruction
+   FAST_FORWARD_TRACE_INS (from 0), or right after the FAST_FORWARD_ROI-th
+   ROI marker if that is set. ins_id is the number of the instruction last
+   read. */
+void Memtrace_Core::fast_forward() {
+  bool to_roi = FAST_FORWARD && FAST_FORWARD_ROI;
+
+  if(FAST_FORWARD) {
+    std::cout << "Core " << proc_id << ": enter fast forward " << ins_id
+              << std::endl;
+    if(!to_roi)
+      ins_id += reader->skipInstructions(FAST_FORWARD_TRACE_INS, false);
   }
-  return 0;
+
+  const InstInfo* insi = reader->nextInstruction();
+
+  if(to_roi) {
+    // Skip in bulk up to each ROI marker and count it
+    for(uns markers = 0;; ins_id++, insi = reader->nextInstruction()) {
+      if(!insi->valid)
+        FATAL_ERROR(proc_id, "Memtrace has only %u ROI markers\n", markers);
+      if(roi(insi->rec) && ++markers == FAST_FORWARD_ROI)
+        break;
+      ins_id += reader->skipInstructions(UINT64_MAX, true);
+    }
+  } else {
+    if(!insi->valid)
+      FATAL_ERROR(proc_id, "Memtrace ends before instruction %llu\n",
+                  (unsigned long long)ins_id);
+    if(!roi(insi->rec))
+      first = insi;  // a marker here starts the ROI instead of ending it
+  }
+
+  if(FAST_FORWARD) {
+    std::cout << "Core " << proc_id << ": exit fast forward " << ins_id
+              << std::endl;
+  }
+
+  prior_pid = insi->pid;
+  prior_tid = insi->tid;
+  assert(prior_tid);
+  assert(prior_pid);
 }
 
-int memtrace_trace_read(int proc_id, ctype_pin_inst* next_pi) {
-  InstInfo* insi;
+/* Decodes the next instruction of the traced thread. Returns 0 at the end of
+   the trace or of the ROI. */
+int Memtrace_Core::decode(ctype_pin_inst* next_pi) {
+  InstInfo* insi = const_cast<InstInfo*>(first);
 
-  do {
-    insi = const_cast<InstInfo*>(trace_readers[proc_id]->nextInstruction());
+  first = NULL;
+  while(!insi || insi->pid != prior_pid || insi->tid != prior_tid) {
+    insi = const_cast<InstInfo*>(reader->nextInstruction());
     ins_id++;
     if(!insi->valid) {
-      insi = const_cast<InstInfo*>(trace_readers[proc_id]->nextInstruction());
+      insi = const_cast<InstInfo*>(reader->nextInstruction());
       ins_id++;
       return 0;  // end of trace
     }
-  } while(insi->pid != prior_pid || insi->tid != prior_tid);
+  }
 
-  memset(next_pi, 0, sizeof(ctype_pin_inst));
-  fill_in_dynamic_info(next_pi, insi);
-  fill_in_basic_info(next_pi, insi->ins);
-  uint32_t max_op_width = add_dependency_info(next_pi, insi->ins);
-  fill_in_simd_info(next_pi, insi->ins, max_op_width);
-  apply_x87_bug_workaround(next_pi, insi->ins);
-  fill_in_cf_info(next_pi, insi->ins);
-  print_err_if_invalid(next_pi, insi->ins);
+  if(insi->rec->flags & REC_DECODE) {
+    memset(next_pi, 0, sizeof(ctype_pin_inst));
+    fill_in_dynamic_info(next_pi, insi, ins_id);
+    fill_in_basic_info(next_pi, insi->ins);
+    uint32_t max_op_width = add_dependency_info(next_pi, insi->ins);
+    fill_in_simd_info(next_pi, insi->ins, max_op_width);
+    apply_x87_bug_workaround(next_pi, insi->ins);
+    fill_in_cf_info(next_pi, insi->ins);
+    print_err_if_invalid(next_pi, insi->ins);
+  } else {
+    // The static fields were decoded once per PC (or by an earlier run)
+    memcpy(next_pi, &insi->rec->info, sizeof(ctype_pin_inst));
+    fill_in_dynamic_info(next_pi, insi, ins_id);
+  }
 
   // End of ROI
-  if(roi(insi->ins))
+  if(roi(insi->rec))
     return 0;
 
   return 1;
 }
 
-
 /**************************************************************************************/
 /* trace_init() */
 
@@ -179,6 +342,9 @@ void memtrace_init(void) {
 
   next_pi = (ctype_pin_inst*)malloc(NUM_CORES * sizeof(ctype_pin_inst));
 
+  if(MEMTRACE_INST_CACHE)
+    TraceReader::instCacheIs(MEMTRACE_INST_CACHE);
+
   /* temp variable needed for easy initialization syntax */
   char* tmp_trace_files[MAX_NUM_PROCS] = {
     CBP_TRACE_R0,  CBP_TRACE_R1,  CBP_TRACE_R2,  CBP_TRACE_R3,  CBP_TRACE_R4,
@@ -213,31 +379,12 @@ void memtrace_setup(uns proc_id) {
   std::string trace(path);
   std::string binaries(MEMTRACE_MODULES_LOG);
 
-  trace_readers[proc_id] = new TraceReaderMemtrace(trace, binaries, 1);
-
-  // FFWD
-  const InstInfo* insi = trace_readers[proc_id]->nextInstruction();
-
-  if(FAST_FORWARD) {
-    std::cout << "Enter fast forward " << ins_id << std::endl;
-  }
-
-  while(!insi->valid || ffwd(insi->ins)) {
-    insi = trace_readers[proc_id]->nextInstruction();
-    ins_id++;
-    if((ins_id % 10000000) == 0)
-      std::cout << "Fast forwarded " << ins_id << " instructions." << std::endl;
-  }
-
-  if(FAST_FORWARD) {
-    std::cout << "Exit fast forward " << ins_id << std::endl;
-  }
-
-  prior_pid = insi->pid;
-  prior_tid = insi->tid;
-  assert(prior_tid);
-  assert(prior_pid);
-  memtrace_trace_read(proc_id, &next_pi[proc_id]);
+  // The readers are created here, one at a time, and only used by their
+  // prefetch thread afterwards
+  delete trace_cores[proc_id];
+  trace_cores[proc_id] = new Memtrace_Core(
+    proc_id, new TraceReaderMemtrace(trace, binaries, 1));
+  trace_cores[proc_id]->read(&next_pi[proc_id]);
 }
 
 /**************************************************************************************/
@@ -253,18 +400,20 @@ Addr memtrace_next_fetch_addr(uns proc_id) {
 void memtrace_done() {
   uns proc_id;
   for(proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    // delete trace_readers[proc_id];
+    delete trace_cores[proc_id];
+    trace_cores[proc_id] = NULL;
   }
+  TraceReader::saveInstCache();
   printf("done\n");
 }
 
 void memtrace_close_trace_file(uns proc_id) {
-  // delete trace_readers[proc_id];
+  delete trace_cores[proc_id];
+  trace_cores[proc_id] = NULL;
   printf("close\n");
 }
 
 Flag memtrace_can_fetch_op(uns proc_id) {
-  assert(proc_id == 0);
   return !(uop_generator_get_eom(proc_id) && trace_read_done[proc_id]);
 }
 
@@ -277,12 +426,13 @@ void memtrace_fetch_op(uns proc_id, Op* op) {
   }
 
   if(uop_generator_get_eom(proc_id)) {
-    int        success = memtrace_trace_read(proc_id, &next_pi[proc_id]);
-    static int ins     = 0;
-    ins++;
+    int success = trace_cores[proc_id]->read(&next_pi[proc_id]);
     if(!success) {
       trace_read_done[proc_id] = TRUE;
       reached_exit[proc_id]    = TRUE;
+      /* as in the pin trace frontend, the last op must exit or the core never
+       * finishes, at the end of the trace or of the ROI */
+      op->exit = TRUE;
       std::cout << "Reached end of trace" << std::endl;
     }
   }
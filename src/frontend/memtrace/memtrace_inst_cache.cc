@@ -0,0 +1,201 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/memtrace_inst_cache.cc
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Persistent cache of decoded static instructions for the
+ *                memtrace frontend.
+ ***************************************************************************************/
+
+#include "frontend/memtrace/memtrace_inst_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+#include "xed-interface.h"
+}
+
+#define warn(...) printf(__VA_ARGS__)
+
+// Bump whenever the record layout or the way records are built changes
+#define MEMTRACE_INST_CACHE_MAGIC "SCRBMIC1"
+#define MEMTRACE_INST_CACHE_VERSION 1
+
+struct MemtraceInstCacheHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t record_size;
+  uint64_t decoder;  // hash of the XED version the records were decoded with
+  uint64_t count;
+};
+
+static uint64_t decoderId() {
+  uint64_t    hash = 14695981039346656037ULL;  // FNV-1a
+  const char* str  = xed_get_version();
+  for(; *str; str++)
+    hash = (hash ^ (uint8_t)*str) * 1099511628211ULL;
+  return hash;
+}
+
+static bool recordLess(const MemtraceInstRecord& _a,
+                       const MemtraceInstRecord& _b) {
+  return _a.module < _b.module ||
+         (_a.module == _b.module && _a.offset < _b.offset);
+}
+
+MemtraceInstCache::MemtraceInstCache(const std::string& _path) :
+    path_(_path), loaded_(nullptr), num_loaded_(0), map_size_(0) {
+  int fd = open(path_.c_str(), O_RDONLY);
+  if(fd == -1) {
+    if(errno != ENOENT)
+      warn("Could not open instruction cache '%s': %s\n", path_.c_str(),
+           strerror(errno));
+    return;
+  }
+  struct stat sb;
+  if(fstat(fd, &sb) == -1 ||
+     (uint64_t)sb.st_size < sizeof(MemtraceInstCacheHeader)) {
+    close(fd);
+    return;
+  }
+  void* map = mmap(nullptr, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED) {
+    warn("mmap of instruction cache '%s' failed: %s\n", path_.c_str(),
+         strerror(errno));
+    return;
+  }
+
+  const MemtraceInstCacheHeader* hdr = (const MemtraceInstCacheHeader*)map;
+  if(memcmp(hdr->magic, MEMTRACE_INST_CACHE_MAGIC, sizeof(hdr->magic)) ||
+     hdr->version != MEMTRACE_INST_CACHE_VERSION ||
+     hdr->record_size != sizeof(MemtraceInstRecord) ||
+     hdr->decoder != decoderId() ||
+     (uint64_t)sb.st_size !=
+       sizeof(*hdr) + hdr->count * sizeof(MemtraceInstRecord)) {
+    warn("Ignoring stale instruction cache '%s'\n", path_.c_str());
+    munmap(map, sb.st_size);
+    return;
+  }
+  map_size_   = sb.st_size;
+  loaded_     = (const MemtraceInstRecord*)(hdr + 1);
+  num_loaded_ = hdr->count;
+}
+
+MemtraceInstCache::~MemtraceInstCache() {
+  if(loaded_)
+    munmap((void*)((const MemtraceInstCacheHeader*)loaded_ - 1), map_size_);
+}
+
+const MemtraceInstRecord* MemtraceInstCache::findLoaded(uint64_t _module,
+                                                        uint64_t _offset) {
+  MemtraceInstRecord key;
+  key.module = _module;
+  key.offset = _offset;
+  const MemtraceInstRecord* rec = std::lower_bound(
+    loaded_, loaded_ + num_loaded_, key, recordLess);
+  if(rec != loaded_ + num_loaded_ && rec->module == _module &&
+     rec->offset == _offset)
+    return rec;
+  return nullptr;
+}
+
+const MemtraceInstRecord* MemtraceInstCache::find(uint64_t       _module,
+                                                  uint64_t       _offset,
+                                                  const uint8_t* _loc,
+                                                  uint64_t       _size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const MemtraceInstRecord*   rec = nullptr;
+  auto                        it  = added_index_.find(Key(_module, _offset));
+  if(it != added_index_.end())
+    rec = it->second;
+  else
+    rec = findLoaded(_module, _offset);
+
+  if(rec && rec->length <= _size && !memcmp(rec->bytes, _loc, rec->length))
+    return rec;
+  return nullptr;
+}
+
+const MemtraceInstRecord* MemtraceInstCache::insert(
+  const MemtraceInstRecord& _rec) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  added_.push_back(_rec);
+  added_index_[Key(_rec.module, _rec.offset)] = &added_.back();
+  return &added_.back();
+}
+
+void MemtraceInstCache::save() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if(added_index_.empty())
+    return;
+
+  // Merge the two sorted sets; added records replace loaded ones
+  std::string tmp_path = path_ + ".tmp." + std::to_string(getpid());
+  FILE*       file     = fopen(tmp_path.c_str(), "w");
+  if(!file) {
+    warn("Could not write instruction cache '%s': %s\n", tmp_path.c_str(),
+         strerror(errno));
+    return;
+  }
+  MemtraceInstCacheHeader hdr;
+  memcpy(hdr.magic, MEMTRACE_INST_CACHE_MAGIC, sizeof(hdr.magic));
+  hdr.version     = MEMTRACE_INST_CACHE_VERSION;
+  hdr.record_size = sizeof(MemtraceInstRecord);
+  hdr.decoder     = decoderId();
+  hdr.count       = 0;
+  fwrite(&hdr, sizeof(hdr), 1, file);
+
+  const MemtraceInstRecord* loaded = loaded_;
+  const MemtraceInstRecord* end    = loaded_ + num_loaded_;
+  auto                      added  = added_index_.begin();
+  while(loaded != end || added != added_index_.end()) {
+    const MemtraceInstRecord* rec;
+    if(added == added_index_.end() ||
+       (loaded != end && recordLess(*loaded, *added->second))) {
+      rec = loaded++;
+    } else {
+      rec = (added++)->second;
+      if(loaded != end && !recordLess(*rec, *loaded))
+        loaded++;  // same key, replaced
+    }
+    fwrite(rec, sizeof(*rec), 1, file);
+    hdr.count++;
+  }
+  fseek(file, 0, SEEK_SET);
+  fwrite(&hdr, sizeof(hdr), 1, file);
+
+  // rename() is atomic, so concurrent runs never see a partial file. The last
+  // one to finish wins; the records it lacks are rebuilt by a later run.
+  if(fclose(file) || rename(tmp_path.c_str(), path_.c_str())) {
+    warn("Could not write instruction cache '%s': %s\n", path_.c_str(),
+         strerror(errno));
+    unlink(tmp_path.c_str());
+  }
+}
@@ -0,0 +1,95 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/memtrace_inst_cache.h
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Persistent cache of decoded static instructions for the
+ *                memtrace frontend. Records are keyed by module and offset, so
+ *                every trace of the same binaries can share them. Each one holds
+ *                the static fields of the ctype_pin_inst and what the trace
+ *                reader needs to know about the XED decode. The file is a
+ *                sorted array of records that later runs mmap; records added
+ *                during a run are merged into it by save().
+ ***************************************************************************************/
+#ifndef MEMTRACE_INST_CACHE_H
+#define MEMTRACE_INST_CACHE_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "ctype_pin_inst.h"
+
+// MemtraceInstRecord flags
+static constexpr uint8_t REC_UNKNOWN = 0x01;  // no decode info, a NOP
+static constexpr uint8_t REC_COND    = 0x02;  // conditional branch
+static constexpr uint8_t REC_REP     = 0x04;  // 'rep' prefixed
+static constexpr uint8_t REC_RET     = 0x08;  // return
+static constexpr uint8_t REC_ROI     = 0x10;  // 'xchg rcx, rcx' ROI marker
+static constexpr uint8_t REC_DECODE  = 0x20;  // needs its XED decode for every
+                                              // instance (gather/scatter)
+
+struct MemtraceInstRecord {
+  uint64_t module;          // module id, see TraceReader::moduleOffsetForVAddr
+  uint64_t offset;          // offset of the instruction in the module
+  uint8_t  bytes[15];       // instruction bytes, to detect a changed binary
+  uint8_t  length;          // number of valid bytes
+  uint8_t  flags;           // REC_*
+  uint8_t  mem_ops;         // memory records that follow it in the trace
+  uint8_t  n_mem_operands;  // XED memory operands
+  uint8_t  mem_read;        // bitmask of the memory operands that are read
+  uint8_t  mem_written;     // bitmask of the memory operands that are written
+  ctype_pin_inst info;      // static fields only
+} __attribute__((packed));
+
+class MemtraceInstCache {
+ public:
+  explicit MemtraceInstCache(const std::string& _path);
+  ~MemtraceInstCache();
+
+  // The record for module+offset if its bytes match _loc, otherwise nullptr
+  const MemtraceInstRecord* find(uint64_t _module, uint64_t _offset,
+                                 const uint8_t* _loc, uint64_t _size);
+  // Adds (or replaces) a record and returns the stored copy
+  const MemtraceInstRecord* insert(const MemtraceInstRecord& _rec);
+  // Writes the loaded and the added records back to the file
+  void save();
+
+ private:
+  using Key = std::pair<uint64_t, uint64_t>;
+
+  std::string                                path_;
+  const MemtraceInstRecord*                  loaded_;  // mmapped and sorted
+  uint64_t                                   num_loaded_;
+  uint64_t                                   map_size_;
+  std::deque<MemtraceInstRecord>             added_;
+  std::map<Key, const MemtraceInstRecord*>   added_index_;
+  std::mutex                                 mutex_;
+
+  const MemtraceInstRecord* findLoaded(uint64_t _module, uint64_t _offset);
+};
+
+#endif
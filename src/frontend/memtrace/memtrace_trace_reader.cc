@@ -54,8 +54,9 @@ using std::make_pair;
 using std::tie;
 using std::unique_ptr;
 
-static bool       xedInitDone = false;
-static std::mutex initMutex;
+static bool                               xedInitDone = false;
+static std::mutex                         initMutex;
+static std::unique_ptr<MemtraceInstCache> instCache;
 
 // A non-reader
 TraceReader::TraceReader() :
@@ -106,6 +107,7 @@ void TraceReader::init(const std::string& _trace) {
   // Clear the 'invalid' record (memset() would do too)
   invalid_info_.pc           = 0;
   invalid_info_.ins          = nullptr;
+  invalid_info_.rec          = nullptr;
   invalid_info_.pid          = 0;
   invalid_info_.tid          = 0;
   invalid_info_.target       = 0;
@@ -123,6 +125,16 @@ void TraceReader::init(const std::string& _trace) {
   init_buffer();
 }
 
+void TraceReader::instCacheIs(const std::string& _path) {
+  instCache = make_unique<MemtraceInstCache>(_path);
+}
+
+void TraceReader::saveInstCache() {
+  if(instCache) {
+    instCache->save();
+  }
+}
+
 void TraceReader::traceFileIs(const std::string& _trace) {
   trace_       = _trace;
   trace_ready_ = initTrace();
@@ -221,9 +233,27 @@ void TraceReader::fillCache(uint64_t _vAddr, uint8_t _reported_size,
                             uint8_t* inst_bytes) {
   uint64_t size;
   uint8_t* loc;
+  uint64_t module, offset;
   if(inst_bytes != NULL || locationForVAddr(_vAddr, &loc, &size)) {
+    // Use the record of an earlier run if there is one
+    bool cacheable = inst_bytes == NULL && instCache &&
+                     moduleOffsetForVAddr(_vAddr, &module, &offset);
+    if(cacheable) {
+      const MemtraceInstRecord* rec = instCache->find(module, offset, loc,
+                                                      size);
+      if(rec) {
+        xed_map_.emplace(_vAddr,
+                         make_tuple((int)rec->mem_ops, false,
+                                    (rec->flags & REC_COND) != 0,
+                                    (rec->flags & REC_REP) != 0,
+                                    unique_ptr<xed_decoded_inst_t>(), rec));
+        return;
+      }
+    }
+
     xed_map_.emplace(_vAddr, make_tuple(0, false, false, false,
-                                        make_unique<xed_decoded_inst_t>()));
+                                        make_unique<xed_decoded_inst_t>(),
+                                        nullptr));
     xed_decoded_inst_t* ins = get<MAP_XED>(xed_map_.at(_vAddr)).get();
     xed_decoded_inst_zero_set_mode(ins, &xed_state_);
     if(inst_bytes != NULL) {
@@ -275,6 +305,21 @@ void TraceReader::fillCache(uint64_t _vAddr, uint8_t _reported_size,
     // variable number of memory records for input formats like memtrace
     bool is_rep = xed_decoded_inst_get_attribute(ins, XED_ATTRIBUTE_REP) > 0;
     get<MAP_REP>(xed_tuple) = is_rep;
+
+    // Build the static record, and keep it for later runs if the code could
+    // be identified and decoded
+    MemtraceInstRecord rec = makeRecord(_vAddr, ins, get<MAP_MEMOPS>(xed_tuple),
+                                        false);
+    if(cacheable && res == XED_ERROR_NONE && !(rec.flags & REC_DECODE)) {
+      rec.module = module;
+      rec.offset = offset;
+      rec.length = xed_decoded_inst_get_length(ins);
+      memcpy(rec.bytes, loc, rec.length);
+      get<MAP_RECORD>(xed_tuple) = instCache->insert(rec);
+    } else {
+      records_.push_back(rec);
+      get<MAP_RECORD>(xed_tuple) = &records_.back();
+    }
   } else {
     if(warn_not_found_ > 0) {
       warn_not_found_ -= 1;
@@ -289,11 +334,69 @@ void TraceReader::fillCache(uint64_t _vAddr, uint8_t _reported_size,
     // Replace the unknown instruction with a NOP
     // NOTE: Unknown memory records are skipped, so 'rep' needs no special
     // handling here
-    xed_map_.emplace(
-      _vAddr, make_tuple(0, true, false, false, makeNop(_reported_size)));
+    xed_map_.emplace(_vAddr, make_tuple(0, true, false, false,
+                                        makeNop(_reported_size), nullptr));
+    auto& xed_tuple = xed_map_[_vAddr];
+    records_.push_back(
+      makeRecord(_vAddr, get<MAP_XED>(xed_tuple).get(), 0, true));
+    get<MAP_RECORD>(xed_tuple) = &records_.back();
   }
 }
 
+// Everything the frontend needs to know about a static instruction, so that
+// instructions from the cache need no XED decode at all
+MemtraceInstRecord TraceReader::makeRecord(uint64_t                  _vAddr,
+                                           const xed_decoded_inst_t* _ins,
+                                           int _mem_ops, bool _unknown) {
+  MemtraceInstRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.mem_ops = _mem_ops;
+  if(_unknown) {
+    rec.flags |= REC_UNKNOWN;
+  }
+  if(xed_decoded_inst_get_category(_ins) == XED_CATEGORY_COND_BR) {
+    rec.flags |= REC_COND;
+  }
+  if(xed_decoded_inst_get_attribute(_ins, XED_ATTRIBUTE_REP) > 0) {
+    rec.flags |= REC_REP;
+  }
+  xed_iclass_enum_t iclass = xed_decoded_inst_get_iclass(_ins);
+  if(iclass == XED_ICLASS_RET_FAR || iclass == XED_ICLASS_RET_NEAR) {
+    rec.flags |= REC_RET;
+  }
+  if(iclass == XED_ICLASS_XCHG && XED_INS_OperandReg(_ins, 0) == XED_REG_RCX &&
+     XED_INS_OperandReg(_ins, 1) == XED_REG_RCX) {
+    rec.flags |= REC_ROI;
+  }
+
+  rec.n_mem_operands = xed_decoded_inst_number_of_memory_operands(_ins);
+  for(uint32_t op = 0; op < rec.n_mem_operands && op < 8; op++) {
+    if(xed_decoded_inst_mem_read(_ins, op)) {
+      rec.mem_read |= 1 << op;
+    }
+    if(xed_decoded_inst_mem_written(_ins, op)) {
+      rec.mem_written |= 1 << op;
+    }
+  }
+
+  if(XED_INS_IsVgather(_ins) || XED_INS_IsVscatter(_ins)) {
+    // The gather/scatter bookkeeping is done on every instance
+    rec.flags |= REC_DECODE;
+    return rec;
+  }
+
+  ctype_pin_inst* info   = &rec.info;
+  info->instruction_addr = _vAddr;
+  fill_in_basic_info(info, _ins);
+  uint32_t max_op_width = add_dependency_info(info, _ins);
+  fill_in_simd_info(info, _ins, max_op_width);
+  apply_x87_bug_workaround(info, _ins);
+  fill_in_cf_info(info, _ins);
+  print_err_if_invalid(info, _ins);
+  info->instruction_addr = 0;
+  return rec;
+}
+
 unique_ptr<xed_decoded_inst_t> TraceReader::makeNop(uint8_t _length) {
   // A 10-to-15-byte NOP instruction (direct XED support is only up to 9)
   static const char* nop15 =
@@ -340,6 +443,34 @@ const InstInfo* TraceReader::nextInstruction() {
   return &ins_buffer.front();
 }
 
+uint64_t TraceReader::skipInstructions(uint64_t _count, bool _stop_at_roi) {
+  auto stop = [_stop_at_roi](const InstInfo& _info) {
+    return !_info.valid ||
+           (_stop_at_roi && _info.rec && (_info.rec->flags & REC_ROI));
+  };
+  uint64_t skipped = 0;
+
+  // The front entry was already returned, the ones behind it come next
+  while(skipped < _count && ins_buffer.size() > 1) {
+    if(stop(ins_buffer[1]))
+      return skipped;
+    ins_buffer.erase(ins_buffer.begin() + 1);
+    skipped++;
+  }
+  while(skipped < _count) {
+    const InstInfo* next = getNextInstruction();
+    if(stop(*next)) {
+      ins_buffer.emplace_back(*next);
+      break;
+    }
+    skipped++;
+  }
+  while(ins_buffer.size() < buf_size_ + 1) {
+    ins_buffer.emplace_back(*getNextInstruction());
+  }
+  return skipped;
+}
+
 // Find the next buffer entry, starting from ref, that matches the given PC
 const TraceReader::returnValue TraceReader::findPC(bufferEntry& ref,
                                                    uint64_t     _pc) {
@@ -40,6 +40,7 @@
 
 #define DR_DO_NOT_DEFINE_int64
 #include "./pin/pin_lib/x86_decoder.h"
+#include "frontend/memtrace/memtrace_inst_cache.h"
 
 extern "C" {
 #include "xed-interface.h"
@@ -60,6 +61,7 @@ static constexpr int MAP_UNKNOWN = 1;
 static constexpr int MAP_COND    = 2;
 static constexpr int MAP_REP     = 3;
 static constexpr int MAP_XED     = 4;
+static constexpr int MAP_RECORD  = 5;
 
 class TraceReader {
  public:
@@ -84,23 +86,41 @@ class TraceReader {
   // A constructor that fails will cause operator! to return true
   bool              operator!();
   const InstInfo*   nextInstruction();
+  // Skips up to _count instructions without going through the lookahead
+  // buffer, stopping in front of an invalid entry or, if _stop_at_roi, an ROI
+  // marker. Returns the number skipped.
+  uint64_t skipInstructions(uint64_t _count, bool _stop_at_roi);
   const returnValue findPCInSegment(bufferEntry& ref, uint64_t _pc,
                                     uint64_t _termination_pc);
   const returnValue findPC(bufferEntry& ref, uint64_t _pc);
   const returnValue peekInstructionAtIndex(uint32_t idx, bufferEntry& ref);
   bufferEntry       bufferStart();
 
+  // Use (and later update) the decoded-instruction cache at _path. Shared by
+  // all readers; call before the first reader is created.
+  static void instCacheIs(const std::string& _path);
+  static void saveInstCache();
+
  private:
   virtual const InstInfo* getNextInstruction()                        = 0;
   virtual void            binaryGroupPathIs(const std::string& _path) = 0;
   virtual bool            initTrace()                                 = 0;
   virtual bool            locationForVAddr(uint64_t _vaddr, uint8_t** _loc,
                                            uint64_t* _size)           = 0;
+  // Identifies the code at _vaddr independently of where it was loaded, for
+  // the instruction cache. Readers that cannot do this are not cached.
+  virtual bool moduleOffsetForVAddr(uint64_t _vaddr, uint64_t* _module,
+                                    uint64_t* _offset) {
+    return false;
+  }
 
   void init_buffer();
   void binaryFileIs(const std::string& _binary, uint64_t _offset);
 
   std::unique_ptr<xed_decoded_inst_t> makeNop(uint8_t _length);
+  MemtraceInstRecord                  makeRecord(uint64_t _vAddr,
+                                                 const xed_decoded_inst_t* _ins,
+                                                 int _mem_ops, bool _unknown);
 
  protected:
   std::string                                                    trace_;
@@ -112,8 +132,10 @@ class TraceReader {
   std::unordered_map<std::string, std::pair<uint8_t*, uint64_t>> binaries_;
   std::vector<std::tuple<uint64_t, uint64_t, uint8_t*>>          sections_;
   std::unordered_map<uint64_t, std::tuple<int, bool, bool, bool,
-                                          std::unique_ptr<xed_decoded_inst_t>>>
-                       xed_map_;
+                                          std::unique_ptr<xed_decoded_inst_t>,
+                                          const MemtraceInstRecord*>>
+                                 xed_map_;
+  std::deque<MemtraceInstRecord> records_;  // the ones not in the cache
   int                  warn_not_found_;
   uint64_t             skipped_;
   uint32_t             buf_size_;
@@ -116,7 +116,7 @@ void TraceReaderMemtrace::binaryGroupPathIs(const std::string& _path) {
 #endif
                                              nullptr, nullptr, nullptr,
                                              knob_verbose_);
-    module_mapper_->get_loaded_modules();
+    const std::vector<module_t>& modules = module_mapper_->get_loaded_modules();
     error = module_mapper_->get_last_error();
     if(!error.empty()) {
       panic("Failed to load binaries: %s Check that module.log references the "
@@ -124,6 +124,16 @@ void TraceReaderMemtrace::binaryGroupPathIs(const std::string& _path) {
             error.c_str());
       return;
     }
+    // Name the segments after their module's path, so that the instruction
+    // cache can be shared by traces that loaded it at different addresses
+    std::unordered_map<uint64_t, uint64_t> num_segments;
+    for(const module_t& module : modules) {
+      uint64_t    hash = 14695981039346656037ULL;  // FNV-1a
+      const char* path = module.path ? module.path : "";
+      for(; *path; path++)
+        hash = (hash ^ (uint8_t)*path) * 1099511628211ULL;
+      module_ids_.emplace(module.map_seg_base, hash + num_segments[hash]++);
+    }
     binary_ready_ = true;
   }
 }
@@ -297,6 +307,7 @@ void TraceReaderMemtrace::processInst(InstInfo* _info) {
   xed_ins          = std::get<MAP_XED>(xed_tuple).get();
   _info->pc        = mt_ref_.instr.addr;
   _info->ins       = xed_ins;
+  _info->rec       = std::get<MAP_RECORD>(xed_tuple);
   _info->pid       = mt_ref_.instr.pid;
   _info->tid       = mt_ref_.instr.tid;
   _info->target    = 0;        // Set when the next instruction is evaluated
@@ -341,3 +352,20 @@ bool TraceReaderMemtrace::locationForVAddr(uint64_t _vaddr, uint8_t** _loc,
   }
   return true;
 }
+
+bool TraceReaderMemtrace::moduleOffsetForVAddr(uint64_t  _vaddr,
+                                               uint64_t* _module,
+                                               uint64_t* _offset) {
+  app_pc module_start;
+  size_t module_size;
+
+  app_pc loc = module_mapper_->find_mapped_trace_bounds(
+    reinterpret_cast<app_pc>(_vaddr), &module_start, &module_size);
+  auto it = module_ids_.find(module_start);
+  if(!module_mapper_->get_last_error().empty() || it == module_ids_.end()) {
+    return false;
+  }
+  *_module = it->second;
+  *_offset = loc - module_start;
+  return true;
+}
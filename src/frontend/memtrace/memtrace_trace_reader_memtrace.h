@@ -49,6 +49,8 @@ class TraceReaderMemtrace : public TraceReader {
   bool               initTrace() override;
   bool               locationForVAddr(uint64_t _vaddr, uint8_t** _loc,
                                       uint64_t* _size) override;
+  bool               moduleOffsetForVAddr(uint64_t _vaddr, uint64_t* _module,
+                                          uint64_t* _offset) override;
   void               init(const std::string& _trace);
   static const char* parse_buildid_string(const char* src, OUT void** data);
   bool               getNextInstruction__(InstInfo* _info, InstInfo* _prior);
@@ -56,6 +58,8 @@ class TraceReaderMemtrace : public TraceReader {
   bool               typeIsMem(trace_type_t _type);
 
   std::unique_ptr<module_mapper_t> module_mapper_;
+  // mapped segment base -> id of the segment (module path and segment index)
+  std::unordered_map<app_pc, uint64_t> module_ids_;
   raw2trace_directory_t            directory_;
   void*                            dcontext_;
   unsigned int                     knob_verbose_;
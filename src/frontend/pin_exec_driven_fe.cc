@@ -40,6 +40,7 @@ extern "C" {
 
 #include "frontend/pin_exec_driven_fe.h"
 #include "pin/pin_lib/message_queue_interface_lib.h"
+#include "pin/pin_lib/op_ring.h"
 #include "pin/pin_lib/pin_scarab_common_lib.h"
 #include "pin/pin_lib/uop_generator.h"
 
@@ -50,7 +51,14 @@ extern "C" {
 Server*                          server;
 std::vector<ScarabOpBuffer_type> cached_cop_buffers;
 
+/* Shared-memory transport (PIN_EXEC_DRIVEN_FE_RING), NULL otherwise */
+std::vector<Op_Ring*> op_rings;
+std::vector<uint32_t> ring_epochs;      // redirects + recoveries sent to PIN
+std::vector<uint64_t> ring_fetch_tail;  // op_tail when FE_FETCH_OP was sent
+
 void get_next_op_buffer_from_pin(uns proc_id);
+void get_next_op_buffer_from_ring(uns proc_id);
+void send_cmd_to_pin(uns proc_id, Scarab_To_Pin_Msg msg);
 void update_op_buffer_if_empty(uns proc_id);
 void invalidate_op_buffer(uns proc_id);
 
@@ -59,6 +67,11 @@ void invalidate_op_buffer(uns proc_id);
  * Cached Op interface
  **********************************************************/
 void get_next_op_buffer_from_pin(uns proc_id) {
+  if(op_rings[proc_id]) {
+    get_next_op_buffer_from_ring(proc_id);
+    return;
+  }
+
   Scarab_To_Pin_Msg msg;
   msg.type      = FE_FETCH_OP;
   msg.inst_addr = 0;
@@ -69,6 +82,50 @@ void get_next_op_buffer_from_pin(uns proc_id) {
     proc_id);  // blocking
 }
 
+/* PIN keeps filling the op ring on its predicted path, so fetching is usually
+   just a copy out of the next slot. Slots built before the last redirect or
+   recovery are dropped. PIN only stops running ahead at syscalls, exceptions,
+   and the end of the program; it then waits for an explicit FE_FETCH_OP. */
+void get_next_op_buffer_from_ring(uns proc_id) {
+  Op_Ring* ring  = op_rings[proc_id];
+  uint32_t spins = 0;
+
+  while(TRUE) {
+    uint64_t tail = ring->op_tail;
+    if(op_ring_load(&ring->op_head) != tail) {
+      Op_Ring_Slot* slot  = &ring->ops[tail % OP_RING_SLOTS];
+      Flag          valid = slot->epoch == ring_epochs[proc_id];
+      if(valid)
+        cached_cop_buffers[proc_id].assign(slot->ops, slot->ops + slot->count);
+      op_ring_store(&ring->op_tail, tail + 1);
+      if(valid)
+        return;
+      spins = 0;
+      continue;
+    }
+    if(ring_fetch_tail[proc_id] != tail) {
+      Scarab_To_Pin_Msg msg;
+      msg.type      = FE_FETCH_OP;
+      msg.inst_addr = 0;
+      msg.inst_uid  = tail;
+      op_ring_push_cmd(ring, msg);
+      ring_fetch_tail[proc_id] = tail;
+    }
+    op_ring_wait(&spins);
+  }
+}
+
+void send_cmd_to_pin(uns proc_id, Scarab_To_Pin_Msg msg) {
+  if(op_rings[proc_id]) {
+    if(msg.type == FE_REDIRECT || msg.type == FE_RECOVER_BEFORE ||
+       msg.type == FE_RECOVER_AFTER)
+      ring_epochs[proc_id]++;
+    op_ring_push_cmd(op_rings[proc_id], msg);
+  } else {
+    server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);  // blocking
+  }
+}
+
 void update_op_buffer_if_empty(uns proc_id) {
   if(cached_cop_buffers[proc_id].size() == 0) {
     DEBUG(proc_id, "Calling FETCH_OP to PIN\n");
@@ -88,6 +145,18 @@ Addr get_fetch_address(uns proc_id, compressed_op* cop) {
  * PIN Exec Driven Interface Functions
  **********************************************************/
 void pin_exec_driven_init(uns numProcs) {
+  // The rings must exist before the clients connect and look for them
+  op_rings.assign(numProcs, NULL);
+  ring_epochs.assign(numProcs, 0);
+  ring_fetch_tail.assign(numProcs, (uint64_t)-1);
+  if(PIN_EXEC_DRIVEN_FE_RING) {
+    for(uns proc_id = 0; proc_id < numProcs; proc_id++) {
+      std::string path = op_ring_path(PIN_EXEC_DRIVEN_FE_SOCKET, proc_id);
+      op_rings[proc_id] = op_ring_map(path, true);
+      ASSERTM(proc_id, op_rings[proc_id], "Could not create op ring %s\n",
+              path.c_str());
+    }
+  }
   server = new Server(PIN_EXEC_DRIVEN_FE_SOCKET, numProcs);
   cached_cop_buffers.resize(numProcs);
   uop_generator_init(numProcs);
@@ -107,6 +176,13 @@ void pin_exec_driven_done(Flag* retired_exit) {
     server->wait_for_client_to_close(i);
   }
   delete server;
+
+  for(uns proc_id = 0; proc_id < op_rings.size(); proc_id++) {
+    if(op_rings[proc_id]) {
+      op_ring_unmap(op_rings[proc_id]);
+      unlink(op_ring_path(PIN_EXEC_DRIVEN_FE_SOCKET, proc_id).c_str());
+    }
+  }
 }
 
 
@@ -150,7 +226,7 @@ void pin_exec_driven_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr) {
   msg.inst_uid  = inst_uid;
   uop_generator_recover(proc_id);
 
-  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);  // blocking
+  send_cmd_to_pin(proc_id, msg);
   invalidate_op_buffer(proc_id);
   DEBUG(proc_id, "Fetch Redirect end: %llx\n", fetch_addr);
 }
@@ -165,7 +241,7 @@ void pin_exec_driven_recover(uns proc_id, uns64 inst_uid) {
   msg.inst_uid  = inst_uid;
   uop_generator_recover(proc_id);
 
-  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);  // blocking
+  send_cmd_to_pin(proc_id, msg);
   invalidate_op_buffer(proc_id);
   DEBUG(proc_id, "Fetch Recover end: %llu\n", inst_uid);
 }
@@ -177,6 +253,6 @@ void pin_exec_driven_retire(uns proc_id, uns64 inst_uid) {
   msg.inst_addr = inst_uid == (uns64)-1;
   msg.inst_uid  = inst_uid;
 
-  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);  // blocking
+  send_cmd_to_pin(proc_id, msg);
   DEBUG(proc_id, "Fetch Retire end: %llu\n", inst_uid);
 }
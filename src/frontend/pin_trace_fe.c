@@ -25,6 +25,7 @@
  * Date         : 10/28/2006
  * Description  :
  ***************************************************************************************/
+#include <string.h>
 #include "debug/debug.param.h"
 #include "debug/debug_macros.h"
 #include "globals/assert.h"
@@ -41,6 +42,7 @@
 #include "ctype_pin_inst.h"
 #include "frontend/pin_trace_fe.h"
 #include "frontend/pin_trace_read.h"
+#include "general.param.h"
 #include "isa/isa.h"
 
 /**************************************************************************************/
@@ -54,7 +56,8 @@
 
 char* trace_files[MAX_NUM_PROCS];
 
-ctype_pin_inst* next_pi;
+/* next record of each core, owned by the trace reader (see pin_trace_next) */
+ctype_pin_inst** next_pi;
 
 /**************************************************************************************/
 /* trace_init() */
@@ -66,7 +69,7 @@ void trace_init() {
 
   uop_generator_init(NUM_CORES);
 
-  next_pi = (ctype_pin_inst*)malloc(NUM_CORES * sizeof(ctype_pin_inst));
+  next_pi = (ctype_pin_inst**)calloc(NUM_CORES, sizeof(ctype_pin_inst*));
 
   pin_trace_file_pointer_init(NUM_CORES);
 
@@ -99,15 +102,57 @@ void trace_init() {
 }
 
 void trace_setup(uns proc_id) {
-  pin_trace_open(proc_id, trace_files[proc_id]);
-  pin_trace_read(proc_id, &next_pi[proc_id]);
+  if(FAST_FORWARD) {
+    uns64 first = pin_trace_open_at(proc_id, trace_files[proc_id],
+                                    FAST_FORWARD_TRACE_INS, FAST_FORWARD_ROI);
+    printf("Fast forwarded core %u to trace instruction %llu\n", proc_id,
+           (unsigned long long)first);
+  } else {
+    pin_trace_open(proc_id, trace_files[proc_id]);
+  }
+  next_pi[proc_id] = pin_trace_next(proc_id);
+  if(!next_pi[proc_id])
+    FATAL_ERROR(proc_id, "Trace %s has no instructions\n",
+                trace_files[proc_id]);
+}
+
+/**************************************************************************************/
+/* trace_ckpt: Saves the trace record each core fetches next, or reopens the
+   traces at the saved records. The traces are matched by file name only, so
+   that a checkpoint still works after they are moved. */
+
+void trace_ckpt(Ckpt* ckpt) {
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    const char* base = strrchr(trace_files[proc_id], '/');
+    char        name[MAX_STR_LENGTH + 1];
+    uns64       pos = pin_trace_position(proc_id) - 1;  // next_pi
+
+    base = base ? base + 1 : trace_files[proc_id];
+    memset(name, 0, sizeof(name));
+    strncpy(name, base, MAX_STR_LENGTH);
+    ckpt_region(ckpt, "trace name", name, sizeof(name));
+    if(strncmp(name, base, MAX_STR_LENGTH))
+      FATAL_ERROR(proc_id, "Checkpoint %s was saved with trace %s, not %s\n",
+                  ckpt->file_name, name, base);
+    ckpt_region(ckpt, "trace position", &pos, sizeof(pos));
+
+    if(ckpt->restoring && pos != pin_trace_position(proc_id) - 1) {
+      pin_trace_close(proc_id);
+      if(pin_trace_open_at(proc_id, trace_files[proc_id], pos, 0) != pos ||
+         !(next_pi[proc_id] = pin_trace_next(proc_id)))
+        FATAL_ERROR(proc_id, "Trace %s ends before record %llu\n",
+                    trace_files[proc_id], pos);
+    }
+  }
 }
 
 /**************************************************************************************/
 /* trace_next_fetch_addr */
 
 Addr trace_next_fetch_addr(uns proc_id) {
-  return convert_to_cmp_addr(proc_id, next_pi[proc_id].instruction_addr);
+  if(!next_pi[proc_id])
+    return 0;
+  return convert_to_cmp_addr(proc_id, next_pi[proc_id]->instruction_addr);
 }
 
 /**************************************************************************************/
@@ -131,14 +176,14 @@ Flag trace_can_fetch_op(uns proc_id) {
 void trace_fetch_op(uns proc_id, Op* op) {
   if(uop_generator_get_bom(proc_id)) {
     ASSERT(proc_id, !trace_read_done[proc_id] && !reached_exit[proc_id]);
-    uop_generator_get_uop(proc_id, op, &next_pi[proc_id]);
+    uop_generator_get_uop(proc_id, op, next_pi[proc_id]);
   } else {
     uop_generator_get_uop(proc_id, op, NULL);
   }
 
   if(uop_generator_get_eom(proc_id)) {
-    int success = pin_trace_read(proc_id, &next_pi[proc_id]);
-    if(!success) {
+    next_pi[proc_id] = pin_trace_next(proc_id);
+    if(!next_pi[proc_id]) {
       trace_read_done[proc_id] = TRUE;
       reached_exit[proc_id]    = TRUE;
       /* this flag is supposed to be set in uop_generator_get_uop() but there
@@ -30,6 +30,7 @@
 #define __PIN_TRACE_FE_H__
 
 #include "globals/global_types.h"
+#include "libs/ckpt_lib.h"
 
 /**************************************************************************************/
 /* Forward Declarations */
@@ -56,4 +57,7 @@ void trace_done(void);
 void trace_close_trace_file(uns proc_id);
 void trace_setup(uns proc_id);
 
+/* For warmup checkpoints */
+void trace_ckpt(Ckpt* ckpt);
+
 #endif
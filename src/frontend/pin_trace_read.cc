@@ -23,51 +23,971 @@
  * File         : frontend/pin_trace_read.cc
  * Author       : HPS Research Group
  * Date         :
- * Description  :
+ * Description  : Reads ctype_pin_inst records from a (compressed) trace file.
+ *                Each trace is decompressed in-process by a background thread
+ *                into a small ring of large blocks; the simulator consumes
+ *                records straight out of those blocks. The container format
+ *                (bzip2, zstd, lz4 frame, or uncompressed) is detected from
+ *                the magic bytes at the start of the file. The decompressed
+ *                stream is either packed ctype_pin_inst records or the compact
+ *                encoding from pin/pin_lib/compact_trace.h, which the
+ *                decompressor thread expands back into records.
+ *
+ *                A trace can be opened at a record number, or after an ROI
+ *                marker. When the generator left an index next to the trace
+ *                (pin/pin_lib/trace_index.h), the reader jumps to the closest
+ *                preceding block and only decodes the records after it.
+ *
+ *                With TRACE_FANOUT, several Scarab processes share one
+ *                decompression of each trace: the first process to open the
+ *                shared-memory ring of a core (the producer) decodes the trace
+ *                into it, and every process, including the producer, reads
+ *                the records back with its own cursor. A block is reused only
+ *                once every reader is done with it, so the readers run at
+ *                most FANOUT_RING_BLOCKS blocks apart.
  ****************************************************************************************/
+#include <bzlib.h>
+#include <condition_variable>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <inttypes.h>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef SCARAB_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef SCARAB_HAVE_LZ4
+#include <lz4frame.h>
+#endif
 
 #include "frontend/pin_trace_read.h"
 #include "isa/isa.h"
+#include "pin/pin_lib/compact_trace.h"
+#include "pin/pin_lib/trace_index.h"
 
 extern "C" {
+#include "core.param.h"
 #include "globals/utils.h"
 }
 
 #define CMP_ADDR_MASK (((uint64_t)-1) << 58)
 
-FILE** pin_file;
+#define TRACE_BLOCK_INSTS 65536   // records per decompressed block
+#define TRACE_RING_BLOCKS 4       // blocks in flight per trace
+#define TRACE_INPUT_BYTES 1048576 // compressed bytes per fread
+
+#define FANOUT_MAGIC "SCRBFAN1"
+#define FANOUT_MAGIC_LEN 8
+#define FANOUT_BLOCK_INSTS 16384  // records per shared block
+#define FANOUT_RING_BLOCKS 8      // shared blocks, bounds the reader skew
+#define FANOUT_MAX_READERS 256
+#define FANOUT_ATTACH_SECS 60     // how long a reader waits for the producer
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Trace_Format_enum {
+  TRACE_FORMAT_RAW,
+  TRACE_FORMAT_BZIP2,
+  TRACE_FORMAT_ZSTD,
+  TRACE_FORMAT_LZ4,
+} Trace_Format;
+
+class Trace_Source {
+ public:
+  virtual ~Trace_Source() {}
+
+  /* Returns the next record, or NULL at the end of the trace. The record is
+     the caller's to modify, and only valid until the next call. */
+  virtual ctype_pin_inst* next() = 0;
+
+  /* Record number (from the start of the trace) of the first record */
+  uint64_t first_inst() const { return first; }
+
+ protected:
+  uint64_t first = 0;
+};
+
+class Trace_Reader : public Trace_Source {
+ public:
+  Trace_Reader(unsigned char proc_id, const char* name, uint64_t start,
+               uint32_t roi);
+  ~Trace_Reader();
+
+  ctype_pin_inst* next() override;
+
+ private:
+  struct Block {
+    std::vector<ctype_pin_inst> insts;
+    size_t                      count;
+  };
+
+  void     decompress_loop();
+  size_t   fill_block(Block* block);
+  uint64_t seek(uint64_t start, uint32_t roi);
+  bool     load_index(std::vector<Trace_Index_Entry>* index);
+  void     jump_to(uint64_t offset);
+  bool     read_record(ctype_pin_inst* inst);
+  template <typename Read>
+  bool     read_compact(Read& get, ctype_pin_inst* inst);
+  bool     read_bytes(void* dst, size_t size);
+  size_t decompress(char* dst, size_t size);
+  bool   refill_input();
+  void   detect_format();
+  void   detect_compact();
+  void   init_decoder();
+  void   close_decoder();
+
+  unsigned char     proc_id;
+  std::string       name;
+  FILE*             file;
+  Trace_Format      format;
+  std::vector<char> in_buf;
+  size_t            in_pos;
+  size_t            in_len;
+  bool              in_eof;
+  bool              out_eof;
+  bool              mid_frame; /* the decoder is inside a stream/frame */
+
+  bz_stream bz;
+#ifdef SCARAB_HAVE_ZSTD
+  ZSTD_DStream* zstd;
+#endif
+#ifdef SCARAB_HAVE_LZ4
+  LZ4F_dctx* lz4;
+#endif
+
+  /* decompressed bytes not yet turned into records */
+  std::vector<char>    stage;
+  size_t               stage_pos;
+  size_t               stage_len;
+  bool                 compact;
+  Compact_Trace_Reader compact_reader;
+
+  /* ring of decompressed blocks, produced by the decompressor thread */
+  Block                   blocks[TRACE_RING_BLOCKS];
+  uint64_t                produced;
+  uint64_t                consumed;
+  bool                    done;
+  bool                    stop;
+  std::mutex              lock;
+  std::condition_variable not_full;
+  std::condition_variable not_empty;
+  std::thread             thread;
+
+  /* consumer side, only touched by the simulator thread */
+  Block* cur_block;
+  size_t cur_idx;
+};
+
+/* Shared-memory ring of one core's trace, mapped by every reader */
+struct Fanout_Ring {
+  char            magic[FANOUT_MAGIC_LEN]; /* written last by the producer */
+  char            trace[MAX_STR_LENGTH + 1];
+  uint64_t        start; /* where the readers asked to open the trace */
+  uint32_t        roi;
+  uint64_t        first; /* record number of the first record */
+  uint32_t        num_readers; /* readers that may still attach */
+  uint32_t        attached;
+  pthread_mutex_t lock;
+  pthread_cond_t  not_full;
+  pthread_cond_t  not_empty;
+  uint64_t        produced;
+  bool            done;
+  pid_t           producer; /* process that decompresses the trace */
+  pid_t           pid[FANOUT_MAX_READERS];
+  uint64_t        consumed[FANOUT_MAX_READERS];
+  bool            detached[FANOUT_MAX_READERS];
+  uint32_t        count[FANOUT_RING_BLOCKS];
+  ctype_pin_inst  insts[FANOUT_RING_BLOCKS][FANOUT_BLOCK_INSTS];
+};
+
+class Fanout_Reader : public Trace_Source {
+ public:
+  Fanout_Reader(unsigned char proc_id, const char* name, uint64_t start,
+                uint32_t roi);
+  ~Fanout_Reader();
+
+  ctype_pin_inst* next() override;
+
+ private:
+  void     create_ring(int fd, const char* name, uint64_t start,
+                       uint32_t roi);
+  void     attach_ring();
+  void     produce_loop();
+  uint64_t slowest_reader();
+  bool     readers_left();
+  void     reap_readers();
+
+  unsigned char proc_id;
+  std::string   shm_name;
+  Fanout_Ring*  ring;
+  uint32_t      me;
+
+  /* producer only */
+  Trace_Reader* source;
+  std::thread   thread;
+
+  /* block being read, only touched by the simulator thread */
+  bool     have_block;
+  uint64_t cur_block;
+  uint32_t cur_idx;
+
+  /* the other readers share the ring, so records are handed out from here */
+  ctype_pin_inst inst;
+};
+
+/**************************************************************************************/
+/* Global Variables */
+
+static std::vector<Trace_Source*> trace_readers;
+/* record number of the record each core's reader returns next */
+static std::vector<uint64_t> trace_positions;
+
+/**************************************************************************************/
+/* Trace_Reader */
+
+Trace_Reader::Trace_Reader(unsigned char proc_id, const char* name,
+                           uint64_t start, uint32_t roi) :
+    proc_id(proc_id), name(name), in_buf(TRACE_INPUT_BYTES), in_pos(0),
+    in_len(0), in_eof(false), out_eof(false), mid_frame(false),
+    stage(TRACE_INPUT_BYTES),
+    stage_pos(0), stage_len(0), compact(false), produced(0), consumed(0),
+    done(false), stop(false), cur_block(NULL), cur_idx(0) {
+  file = fopen(name, "rb");
+  if(!file) {
+    printf("Cannot open trace file: %s\n", name);
+    exit(1);
+  }
+  for(int ii = 0; ii < TRACE_RING_BLOCKS; ii++) {
+    blocks[ii].insts.resize(TRACE_BLOCK_INSTS);
+    blocks[ii].count = 0;
+  }
+  refill_input();
+  detect_format();
+  init_decoder();
+  detect_compact();
+  if(start || roi)
+    first = seek(start, roi);
+  thread = std::thread(&Trace_Reader::decompress_loop, this);
+}
+
+Trace_Reader::~Trace_Reader() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stop = true;
+  }
+  not_full.notify_all();
+  thread.join();
+  close_decoder();
+  fclose(file);
+}
+
+ctype_pin_inst* Trace_Reader::next() {
+  if(cur_block && cur_idx < cur_block->count)
+    return &cur_block->insts[cur_idx++];
+
+  std::unique_lock<std::mutex> guard(lock);
+  if(cur_block) {
+    consumed++;
+    cur_block = NULL;
+    not_full.notify_one();
+  }
+  while(true) {
+    not_empty.wait(guard, [this] { return produced > consumed || done; });
+    if(produced == consumed)
+      return NULL;
+    Block* block = &blocks[consumed % TRACE_RING_BLOCKS];
+    if(block->count) {
+      cur_block = block;
+      cur_idx   = 1;
+      return &block->insts[0];
+    }
+    consumed++;  // skip an empty tail block
+  }
+}
+
+void Trace_Reader::decompress_loop() {
+  while(true) {
+    Block* block;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      not_full.wait(guard, [this] {
+        return produced - consumed < TRACE_RING_BLOCKS || stop;
+      });
+      if(stop)
+        return;
+      block = &blocks[produced % TRACE_RING_BLOCKS];
+    }
+
+    /* the block is owned by this thread until produced is bumped */
+    block->count = fill_block(block);
+    bool last    = block->count < TRACE_BLOCK_INSTS;
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      produced++;
+      done = last;
+    }
+    not_empty.notify_one();
+    if(last)
+      return;
+  }
+}
+
+/* Fills a block with records and returns how many were written. Packed
+   records are decompressed straight into the block. */
+size_t Trace_Reader::fill_block(Block* block) {
+  if(compact) {
+    auto   get = [this](void* dst, size_t size) { return read_bytes(dst, size); };
+    size_t count;
+    for(count = 0; count < TRACE_BLOCK_INSTS; count++) {
+      if(!read_compact(get, &block->insts[count]))
+        break;
+    }
+    return count;
+  }
+
+  const size_t block_bytes = TRACE_BLOCK_INSTS * sizeof(ctype_pin_inst);
+  char*        dst         = (char*)block->insts.data();
+  size_t       bytes       = MIN2(stage_len - stage_pos, block_bytes);
+
+  memcpy(dst, stage.data() + stage_pos, bytes);
+  stage_pos += bytes;
+  bytes += decompress(dst + bytes, block_bytes - bytes);
+  if(bytes % sizeof(ctype_pin_inst)) {
+    FATAL_ERROR(proc_id, "Trace file %s ends with a partial record (%zu "
+                         "bytes)\n",
+                name.c_str(), bytes % sizeof(ctype_pin_inst));
+  }
+  return bytes / sizeof(ctype_pin_inst);
+}
+
+/* Positions the trace at record start, or at the record after the roi-th
+   (from 1) ROI marker if roi is set. Returns the record actually reached,
+   which is short of start only if the trace ends first. */
+uint64_t Trace_Reader::seek(uint64_t start, uint32_t roi) {
+  std::vector<Trace_Index_Entry> index;
+  bool                           have_index = load_index(&index);
+  uint64_t                       pos        = 0;
+  ctype_pin_inst                 inst;
+
+  if(roi) {
+    if(!have_index)
+      FATAL_ERROR(proc_id,
+                  "Seeking to an ROI marker of %s needs its trace index %s%s\n",
+                  name.c_str(), name.c_str(), TRACE_INDEX_SUFFIX);
+    uint32_t seen = 0;
+    for(const Trace_Index_Entry& entry : index) {
+      if(entry.kind == TRACE_INDEX_ROI && ++seen == roi) {
+        start = entry.inst + 1;
+        break;
+      }
+    }
+    if(seen < roi)
+      FATAL_ERROR(proc_id, "Trace %s has only %u ROI markers\n", name.c_str(),
+                  seen);
+  }
+
+  if(have_index) {
+    const Trace_Index_Entry* block = NULL;
+    for(const Trace_Index_Entry& entry : index) {
+      if(entry.kind == TRACE_INDEX_BLOCK && entry.inst > pos &&
+         entry.inst <= start) {
+        block = &entry;
+        pos   = entry.inst;
+      }
+    }
+    if(block)
+      jump_to(block->offset);
+  }
+
+  for(; pos < start; pos++) {
+    if(!read_record(&inst))
+      break;
+  }
+  return pos;
+}
+
+/* Reads <trace>.idx if it exists and matches the trace file. */
+bool Trace_Reader::load_index(std::vector<Trace_Index_Entry>* index) {
+  std::string        index_name = name + TRACE_INDEX_SUFFIX;
+  Trace_Index_Header header;
+  struct stat        st;
+  FILE*              index_file = fopen(index_name.c_str(), "rb");
+
+  if(!index_file)
+    return false;
+  bool ok = fread(&header, sizeof(header), 1, index_file) == 1 &&
+            !memcmp(header.magic, TRACE_INDEX_MAGIC, TRACE_INDEX_MAGIC_LEN) &&
+            !fstat(fileno(index_file), &st) &&
+            (uint64_t)st.st_size ==
+              sizeof(header) + header.count * sizeof(Trace_Index_Entry);
+  if(ok) {
+    index->resize(header.count);
+    ok = fread(index->data(), sizeof(Trace_Index_Entry), header.count,
+               index_file) == header.count;
+  }
+  fclose(index_file);
+
+  if(!ok) {
+    printf("Ignoring malformed trace index %s\n", index_name.c_str());
+    return false;
+  }
+  if(fstat(fileno(file), &st) || (uint64_t)st.st_size != header.trace_size) {
+    printf("Ignoring trace index %s, it does not match the size of %s\n",
+           index_name.c_str(), name.c_str());
+    return false;
+  }
+  return true;
+}
+
+/* Restarts decompression at offset, the start of an index block. */
+void Trace_Reader::jump_to(uint64_t offset) {
+  if(fseeko(file, offset, SEEK_SET))
+    FATAL_ERROR(proc_id, "Cannot seek in trace file %s\n", name.c_str());
+  in_pos    = 0;
+  in_len    = 0;
+  in_eof    = false;
+  out_eof   = false;
+  stage_pos = 0;
+  stage_len = 0;
+  close_decoder();
+  init_decoder();
+}
+
+bool Trace_Reader::read_record(ctype_pin_inst* inst) {
+  if(compact) {
+    auto get = [this](void* dst, size_t size) { return read_bytes(dst, size); };
+    return read_compact(get, inst);
+  }
+  return read_bytes(inst, sizeof(*inst));
+}
+
+/* Decodes one compact record. Returns false at the end of the trace; a record
+   that cannot be decoded is fatal. */
+template <typename Read>
+bool Trace_Reader::read_compact(Read& get, ctype_pin_inst* inst) {
+  if(compact_reader.read(get, inst))
+    return true;
+  if(compact_reader.error)
+    FATAL_ERROR(proc_id, "Cannot decode compact trace %s: %s\n", name.c_str(),
+                compact_reader.error);
+  return false;
+}
+
+/* Copies size decompressed bytes into dst through the staging buffer. Returns
+   false if the trace ends before the first byte; ending after it is fatal. */
+bool Trace_Reader::read_bytes(void* dst, size_t size) {
+  char* out = (char*)dst;
+
+  while(size) {
+    if(stage_pos == stage_len) {
+      stage_pos = 0;
+      stage_len = decompress(stage.data(), stage.size());
+      if(!stage_len && out == (char*)dst)
+        return false;
+      if(!stage_len)
+        FATAL_ERROR(proc_id, "Trace file %s ends in the middle of a record\n",
+                    name.c_str());
+    }
+    size_t n = MIN2(stage_len - stage_pos, size);
+    memcpy(out, stage.data() + stage_pos, n);
+    stage_pos += n;
+    out += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool Trace_Reader::refill_input() {
+  if(in_pos < in_len)
+    return true;
+  if(in_eof)
+    return false;
+  in_pos = 0;
+  in_len = fread(in_buf.data(), 1, in_buf.size(), file);
+  if(in_len < in_buf.size()) {
+    if(ferror(file))
+      FATAL_ERROR(proc_id, "Error reading trace file %s\n", name.c_str());
+    in_eof = true;
+  }
+  return in_len > 0;
+}
+
+void Trace_Reader::detect_format() {
+  const unsigned char* magic = (const unsigned char*)in_buf.data();
+
+  if(in_len >= 3 && !memcmp(magic, "BZh", 3))
+    format = TRACE_FORMAT_BZIP2;
+  else if(in_len >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 &&
+          magic[2] == 0x2F && magic[3] == 0xFD)
+    format = TRACE_FORMAT_ZSTD;
+  else if(in_len >= 4 && magic[0] == 0x04 && magic[1] == 0x22 &&
+          magic[2] == 0x4D && magic[3] == 0x18)
+    format = TRACE_FORMAT_LZ4;
+  else
+    format = TRACE_FORMAT_RAW;
+}
+
+/* Decompresses the first bytes of the trace to tell the compact encoding
+   from packed records. */
+void Trace_Reader::detect_compact() {
+  stage_len = decompress(stage.data(), stage.size());
+  if(stage_len >= COMPACT_TRACE_MAGIC_LEN &&
+     !memcmp(stage.data(), COMPACT_TRACE_MAGIC, COMPACT_TRACE_ID_LEN)) {
+    char version = stage[COMPACT_TRACE_ID_LEN];
+    if(version != COMPACT_TRACE_VERSION)
+      FATAL_ERROR(proc_id,
+                  "Trace %s uses version %c of the compact trace format, but "
+                  "this Scarab only reads version %c\n",
+                  name.c_str(), version, COMPACT_TRACE_VERSION);
+    compact   = true;
+    stage_pos = COMPACT_TRACE_MAGIC_LEN;
+  }
+}
+
+void Trace_Reader::init_decoder() {
+  mid_frame = false;
+  switch(format) {
+    case TRACE_FORMAT_RAW:
+      break;
+    case TRACE_FORMAT_BZIP2:
+      memset(&bz, 0, sizeof(bz));
+      if(BZ2_bzDecompressInit(&bz, 0, 0) != BZ_OK)
+        FATAL_ERROR(proc_id, "Cannot initialize bzip2 for %s\n", name.c_str());
+      break;
+    case TRACE_FORMAT_ZSTD:
+#ifdef SCARAB_HAVE_ZSTD
+      zstd = ZSTD_createDStream();
+      if(!zstd || ZSTD_isError(ZSTD_initDStream(zstd)))
+        FATAL_ERROR(proc_id, "Cannot initialize zstd for %s\n", name.c_str());
+#else
+      FATAL_ERROR(proc_id, "%s is zstd compressed, but Scarab was built "
+                           "without libzstd\n", name.c_str());
+#endif
+      break;
+    case TRACE_FORMAT_LZ4:
+#ifdef SCARAB_HAVE_LZ4
+      if(LZ4F_isError(LZ4F_createDecompressionContext(&lz4, LZ4F_VERSION)))
+        FATAL_ERROR(proc_id, "Cannot initialize lz4 for %s\n", name.c_str());
+#else
+      FATAL_ERROR(proc_id, "%s is lz4 compressed, but Scarab was built "
+                           "without liblz4\n", name.c_str());
+#endif
+      break;
+  }
+}
+
+void Trace_Reader::close_decoder() {
+  switch(format) {
+    case TRACE_FORMAT_RAW:
+      break;
+    case TRACE_FORMAT_BZIP2:
+      BZ2_bzDecompressEnd(&bz);
+      break;
+    case TRACE_FORMAT_ZSTD:
+#ifdef SCARAB_HAVE_ZSTD
+      ZSTD_freeDStream(zstd);
+#endif
+      break;
+    case TRACE_FORMAT_LZ4:
+#ifdef SCARAB_HAVE_LZ4
+      LZ4F_freeDecompressionContext(lz4);
+#endif
+      break;
+  }
+}
+
+/* Decompresses up to size bytes into dst. Returns fewer bytes only at the end
+   of the trace. Concatenated streams/frames (e.g. from pbzip2) are followed.
+   A corrupt or truncated trace is fatal. */
+size_t Trace_Reader::decompress(char* dst, size_t size) {
+  size_t written = 0;
+
+  while(written < size && !out_eof) {
+    /* without input, a decoder inside a frame may still have output to give */
+    bool have_input = refill_input();
+    if(!have_input && !mid_frame) {
+      out_eof = true;
+      break;
+    }
+    size_t before    = written;
+    char*  src       = in_buf.data() + in_pos;
+    size_t src_avail = in_len - in_pos;
+    size_t dst_avail = size - written;
+
+    switch(format) {
+      case TRACE_FORMAT_RAW: {
+        size_t n = MIN2(src_avail, dst_avail);
+        memcpy(dst + written, src, n);
+        in_pos += n;
+        written += n;
+        break;
+      }
+      case TRACE_FORMAT_BZIP2: {
+        bz.next_in   = src;
+        bz.avail_in  = src_avail;
+        bz.next_out  = dst + written;
+        bz.avail_out = dst_avail;
+        int ret      = BZ2_bzDecompress(&bz);
+        in_pos += src_avail - bz.avail_in;
+        written += dst_avail - bz.avail_out;
+        if(ret == BZ_STREAM_END) {
+          close_decoder();
+          init_decoder();
+        } else if(ret == BZ_OK) {
+          mid_frame = true;
+        } else {
+          FATAL_ERROR(proc_id, "bzip2 error %d while reading %s\n", ret,
+                      name.c_str());
+        }
+        break;
+      }
+      case TRACE_FORMAT_ZSTD: {
+#ifdef SCARAB_HAVE_ZSTD
+        ZSTD_inBuffer  in  = {src, src_avail, 0};
+        ZSTD_outBuffer out = {dst + written, dst_avail, 0};
+        size_t         ret = ZSTD_decompressStream(zstd, &out, &in);
+        if(ZSTD_isError(ret)) {
+          FATAL_ERROR(proc_id, "zstd error '%s' while reading %s\n",
+                      ZSTD_getErrorName(ret), name.c_str());
+        }
+        in_pos += in.pos;
+        written += out.pos;
+        mid_frame = ret != 0;
+#endif
+        break;
+      }
+      case TRACE_FORMAT_LZ4: {
+#ifdef SCARAB_HAVE_LZ4
+        size_t src_size = src_avail;
+        size_t dst_size = dst_avail;
+        size_t ret = LZ4F_decompress(lz4, dst + written, &dst_size, src,
+                                     &src_size, NULL);
+        if(LZ4F_isError(ret)) {
+          FATAL_ERROR(proc_id, "lz4 error '%s' while reading %s\n",
+                      LZ4F_getErrorName(ret), name.c_str());
+        }
+        in_pos += src_size;
+        written += dst_size;
+        mid_frame = ret != 0;
+#endif
+        break;
+      }
+    }
+    if(!have_input && written == before && mid_frame)
+      FATAL_ERROR(proc_id, "Trace file %s is truncated\n", name.c_str());
+  }
+
+  return written;
+}
+
+/**************************************************************************************/
+/* Fanout_Reader */
+
+Fanout_Reader::Fanout_Reader(unsigned char proc_id, const char* name,
+                             uint64_t start, uint32_t roi) :
+    proc_id(proc_id), ring(NULL), source(NULL), have_block(false),
+    cur_block(0), cur_idx(0) {
+  bool last;
+
+  if(!TRACE_FANOUT_READERS || TRACE_FANOUT_READERS > FANOUT_MAX_READERS)
+    FATAL_ERROR(proc_id, "TRACE_FANOUT_READERS must be between 1 and %d\n",
+                FANOUT_MAX_READERS);
+  shm_name = std::string("/") + TRACE_FANOUT + "." + std::to_string(proc_id);
+
+  int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if(fd >= 0)
+    create_ring(fd, name, start, roi);
+  else if(errno == EEXIST)
+    attach_ring();
+  else
+    FATAL_ERROR(proc_id, "Cannot create trace fan-out ring %s\n",
+                shm_name.c_str());
+
+  if(strncmp(ring->trace, name, MAX_STR_LENGTH))
+    FATAL_ERROR(proc_id, "Trace fan-out ring %s reads %s, not %s\n",
+                shm_name.c_str(), ring->trace, name);
+  if(ring->start != start || ring->roi != roi)
+    FATAL_ERROR(proc_id,
+                "Trace fan-out ring %s starts the trace at a different "
+                "instruction or ROI marker\n",
+                shm_name.c_str());
+  first = ring->first;
+
+  pthread_mutex_lock(&ring->lock);
+  if(ring->attached >= ring->num_readers) {
+    pthread_mutex_unlock(&ring->lock);
+    FATAL_ERROR(proc_id,
+                "Trace fan-out ring %s already has all of its readers (stale "
+                "ring from an earlier run?)\n",
+                shm_name.c_str());
+  }
+  me            = ring->attached++;
+  ring->pid[me] = getpid();
+  last          = ring->attached == ring->num_readers;
+  pthread_mutex_unlock(&ring->lock);
+
+  /* everyone has it mapped, the name is not needed anymore */
+  if(last)
+    shm_unlink(shm_name.c_str());
+
+  if(source)
+    thread = std::thread(&Fanout_Reader::produce_loop, this);
+}
+
+Fanout_Reader::~Fanout_Reader() {
+  pthread_mutex_lock(&ring->lock);
+  ring->detached[me] = true;
+  if(ring->attached < ring->num_readers) {
+    /* don't wait for readers that never showed up */
+    ring->num_readers = ring->attached;
+    shm_unlink(shm_name.c_str());
+  }
+  pthread_cond_broadcast(&ring->not_full);
+  pthread_mutex_unlock(&ring->lock);
+
+  /* the producer keeps filling the ring until the other readers are done */
+  if(source) {
+    thread.join();
+    delete source;
+  }
+  munmap(ring, sizeof(Fanout_Ring));
+}
+
+void Fanout_Reader::create_ring(int fd, const char* name, uint64_t start,
+                                uint32_t roi) {
+  pthread_mutexattr_t mutex_attr;
+  pthread_condattr_t  cond_attr;
+
+  if(ftruncate(fd, sizeof(Fanout_Ring)))
+    FATAL_ERROR(proc_id, "Cannot size trace fan-out ring %s\n",
+                shm_name.c_str());
+  ring = (Fanout_Ring*)mmap(NULL, sizeof(Fanout_Ring), PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+  close(fd);
+  if(ring == MAP_FAILED)
+    FATAL_ERROR(proc_id, "Cannot map trace fan-out ring %s\n",
+                shm_name.c_str());
+
+  pthread_mutexattr_init(&mutex_attr);
+  pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutex_init(&ring->lock, &mutex_attr);
+  pthread_condattr_init(&cond_attr);
+  pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+  pthread_cond_init(&ring->not_full, &cond_attr);
+  pthread_cond_init(&ring->not_empty, &cond_attr);
+
+  strncpy(ring->trace, name, MAX_STR_LENGTH);
+  ring->num_readers = TRACE_FANOUT_READERS;
+  ring->producer    = getpid();
+  ring->start       = start;
+  ring->roi         = roi;
+  source            = new Trace_Reader(proc_id, name, start, roi);
+  ring->first       = source->first_inst();
+
+  __sync_synchronize();
+  memcpy(ring->magic, FANOUT_MAGIC, FANOUT_MAGIC_LEN);
+}
+
+/* Waits for the producer to create and initialize the ring. */
+void Fanout_Reader::attach_ring() {
+  struct stat st;
+  time_t      start = time(NULL);
+
+  while(true) {
+    int fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+    if(fd >= 0 && !fstat(fd, &st) && st.st_size == sizeof(Fanout_Ring)) {
+      ring = (Fanout_Ring*)mmap(NULL, sizeof(Fanout_Ring),
+                                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if(ring == MAP_FAILED)
+        FATAL_ERROR(proc_id, "Cannot map trace fan-out ring %s\n",
+                    shm_name.c_str());
+      while(memcmp((const char*)ring->magic, FANOUT_MAGIC, FANOUT_MAGIC_LEN)) {
+        if(time(NULL) - start > FANOUT_ATTACH_SECS)
+          FATAL_ERROR(proc_id, "Trace fan-out ring %s was never initialized\n",
+                      shm_name.c_str());
+        usleep(1000);
+      }
+      __sync_synchronize();
+      if(ring->num_readers > TRACE_FANOUT_READERS)
+        FATAL_ERROR(proc_id, "Trace fan-out ring %s expects %u readers, not %u\n",
+                    shm_name.c_str(), ring->num_readers, TRACE_FANOUT_READERS);
+      return;
+    }
+    if(fd >= 0)
+      close(fd);
+    if(time(NULL) - start > FANOUT_ATTACH_SECS)
+      FATAL_ERROR(proc_id, "Cannot attach to trace fan-out ring %s\n",
+                  shm_name.c_str());
+    usleep(1000);
+  }
+}
+
+/* Block index the slowest attached (or not yet attached) reader is on. Called
+   with the ring locked. */
+uint64_t Fanout_Reader::slowest_reader() {
+  uint64_t slowest = ring->produced;
+  for(uint32_t ii = 0; ii < ring->num_readers; ii++) {
+    if(!ring->detached[ii])
+      slowest = MIN2(slowest, ring->consumed[ii]);
+  }
+  return slowest;
+}
+
+/* Called with the ring locked. */
+bool Fanout_Reader::readers_left() {
+  for(uint32_t ii = 0; ii < ring->num_readers; ii++) {
+    if(!ring->detached[ii])
+      return true;
+  }
+  return false;
+}
+
+/* Detaches readers whose process died, so that they don't stall the ring
+   forever. Called with the ring locked. */
+void Fanout_Reader::reap_readers() {
+  for(uint32_t ii = 0; ii < ring->attached; ii++) {
+    if(!ring->detached[ii] && getpgid(ring->pid[ii]) < 0 && errno == ESRCH) {
+      printf("Trace fan-out reader %u of %s exited without detaching\n", ii,
+             shm_name.c_str());
+      ring->detached[ii] = true;
+    }
+  }
+}
+
+void Fanout_Reader::produce_loop() {
+  while(true) {
+    pthread_mutex_lock(&ring->lock);
+    while(ring->produced - slowest_reader() >= FANOUT_RING_BLOCKS &&
+          readers_left()) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += 1;
+      if(pthread_cond_timedwait(&ring->not_full, &ring->lock, &deadline) ==
+         ETIMEDOUT)
+        reap_readers();
+    }
+    bool     stop  = !readers_left();
+    uint64_t block = ring->produced % FANOUT_RING_BLOCKS;
+    pthread_mutex_unlock(&ring->lock);
+    if(stop)
+      return;
+
+    /* the block is owned by this thread until produced is bumped */
+    uint32_t              count = 0;
+    const ctype_pin_inst* rec;
+    while(count < FANOUT_BLOCK_INSTS && (rec = source->next()))
+      ring->insts[block][count++] = *rec;
+
+    pthread_mutex_lock(&ring->lock);
+    ring->count[block] = count;
+    ring->produced++;
+    ring->done = count < FANOUT_BLOCK_INSTS;
+    pthread_cond_broadcast(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+    if(count < FANOUT_BLOCK_INSTS)
+      return;
+  }
+}
+
+ctype_pin_inst* Fanout_Reader::next() {
+  uint64_t block = cur_block % FANOUT_RING_BLOCKS;
+  if(have_block && cur_idx < ring->count[block]) {
+    inst = ring->insts[block][cur_idx++];
+    return &inst;
+  }
+
+  pthread_mutex_lock(&ring->lock);
+  if(have_block) {
+    ring->consumed[me]++;
+    have_block = false;
+    pthread_cond_broadcast(&ring->not_full);
+  }
+  while(ring->produced == ring->consumed[me] && !ring->done) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 1;
+    if(pthread_cond_timedwait(&ring->not_empty, &ring->lock, &deadline) ==
+         ETIMEDOUT &&
+       !source && getpgid(ring->producer) < 0 && errno == ESRCH) {
+      pthread_mutex_unlock(&ring->lock);
+      FATAL_ERROR(proc_id,
+                  "Producer (pid %d) of trace fan-out ring %s exited before "
+                  "the end of the trace\n",
+                  ring->producer, shm_name.c_str());
+    }
+  }
+  cur_block  = ring->consumed[me];
+  have_block = ring->produced > cur_block;
+  pthread_mutex_unlock(&ring->lock);
+
+  block = cur_block % FANOUT_RING_BLOCKS;
+  if(!have_block || !ring->count[block])
+    return NULL;
+  cur_idx = 1;
+  inst    = ring->insts[block][0];
+  return &inst;
+}
+
+/**************************************************************************************/
+/* Interface */
 
 // static Reg_Id convert_pin_reg_to_scarab_reg(uns pin_reg);
 void pin_trace_file_pointer_init(unsigned char num_cores) {
-  pin_file = (FILE**)malloc(num_cores * sizeof(FILE*));
+  trace_readers.assign(num_cores, NULL);
+  trace_positions.assign(num_cores, 0);
 }
 
 void pin_trace_open(unsigned char proc_id, const char* name) {
-  char cmdline[1024];
-  sprintf(cmdline, "bzip2 -dc %s", name);
-  pin_file[proc_id] = popen(cmdline, "r");
+  pin_trace_open_at(proc_id, name, 0, 0);
+}
+
+uint64_t pin_trace_open_at(unsigned char proc_id, const char* name,
+                           uint64_t start, uint32_t roi) {
+  if(TRACE_FANOUT)
+    trace_readers[proc_id] = new Fanout_Reader(proc_id, name, start, roi);
+  else
+    trace_readers[proc_id] = new Trace_Reader(proc_id, name, start, roi);
   printf("pin trace should be opened now for core %u: %s \n", proc_id, name);
-  if(!pin_file[proc_id]) {
-    printf("Cannot open trace file: %s\n", name);
-    exit(1);
-  }
+  trace_positions[proc_id] = trace_readers[proc_id]->first_inst();
+  return trace_positions[proc_id];
 }
 
 void pin_trace_close(unsigned char proc_id) {
-  pclose(pin_file[proc_id]);
+  delete trace_readers[proc_id];
+  trace_readers[proc_id] = NULL;
 }
 
 int pin_trace_read(unsigned char proc_id, ctype_pin_inst* pi) {
-  int read_size;
+  const ctype_pin_inst* next = trace_readers[proc_id]->next();
 
-  read_size = fread(pi, sizeof(ctype_pin_inst), 1, pin_file[proc_id]);
-  if(read_size != 1) {
+  if(!next) {
     return 0;
   }
+  trace_positions[proc_id]++;
+  *pi = *next;
   return 1;
 }
+
+ctype_pin_inst* pin_trace_next(unsigned char proc_id) {
+  ctype_pin_inst* next = trace_readers[proc_id]->next();
+  trace_positions[proc_id] += next != NULL;
+  return next;
+}
+
+uint64_t pin_trace_position(unsigned char proc_id) {
+  return trace_positions[proc_id];
+}
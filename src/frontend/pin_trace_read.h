@@ -40,6 +40,18 @@ int  pin_trace_read(unsigned char, ctype_pin_inst*);
 void pin_trace_open(unsigned char, const char*);
 void pin_trace_close(unsigned char);
 
+/* Like pin_trace_read, without the copy. Returns NULL at the end of the trace.
+   The record may be modified in place, and is only valid until the next
+   call. */
+ctype_pin_inst* pin_trace_next(unsigned char);
+
+/* Opens the trace at a record number, or after the Nth (from 1) ROI marker if
+   the last argument is set. Returns the record number reached. */
+uint64_t pin_trace_open_at(unsigned char, const char*, uint64_t, uint32_t);
+
+/* Record number of the record the next read returns. */
+uint64_t pin_trace_position(unsigned char);
+
 #ifdef __cplusplus
 }
 #endif
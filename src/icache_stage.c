@@ -447,6 +447,41 @@ void update_icache_stage() {
 }
 
 
+/**************************************************************************************/
+/* icache_stage_next_event: Returns the first cycle at which
+   update_icache_stage can do more than collect stats: cycle_count if it
+   fetches or changes state this cycle, MAX_CTR if it is waiting for an
+   outside event (a fill, a redirect, or a retirement). */
+
+Counter icache_stage_next_event(void) {
+  if(ic->state != ic->next_state)
+    return cycle_count;
+
+  if(ic->sd.op_count)
+    return MAX_CTR;  // stalled on the decode stage
+
+  switch(ic->state) {
+    case IC_FETCH:
+      if(!FETCH_OFF_PATH_OPS && ic->off_path && !ic->back_on_path)
+        return MAX_CTR;
+      return cycle_count;
+
+    case IC_WAIT_FOR_MISS:
+    case IC_WAIT_FOR_REDIRECT:
+      return MAX_CTR;
+
+    case IC_WAIT_FOR_EMPTY_ROB:
+      return td->seq_op_list.count ? MAX_CTR : cycle_count;
+
+    case IC_WAIT_FOR_TIMER:
+      return MAX2(ic->timer_cycle, cycle_count);
+
+    default:
+      return cycle_count;
+  }
+}
+
+
 /**************************************************************************************/
 /* icache_issue_ops: On a cache hit, select ops to pass down to the decode
    stage.  Each op that gets issued is executed by the oracle. It will only
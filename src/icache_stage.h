@@ -129,6 +129,8 @@ void wp_process_icache_hit(Icache_Data* line, Addr fetch_addr);
 void wp_process_icache_fill(Icache_Data* line, Mem_Req* req);
 Flag icache_off_path(void);
 
+Counter icache_stage_next_event(void);
+
 /**************************************************************************************/
 
 #endif /* #ifndef __ICACHE_STAGE_H__ */
@@ -38,6 +38,7 @@
 #include "debug/debug.param.h"
 #include "general.param.h"
 #include "libs/cache_lib.h"
+#include "libs/cache_repl.h"
 #include "memory/memory.param.h"
 
 // DeleteMe
@@ -48,6 +49,8 @@
 
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_CACHE_LIB, ##args)
 
+#define CACHE_TAG_CHUNK 8 /* ways compared per step of a tag search */
+
 
 /**************************************************************************************/
 /* Static Prototypes */
@@ -56,6 +59,10 @@ static inline uns  cache_index(Cache* cache, Addr addr, Addr* tag,
                                Addr* line_addr);
 static inline void update_repl_policy(Cache*, Cache_Entry*, uns, uns, Flag);
 static inline Cache_Entry* find_repl_entry(Cache*, uns8, uns, uns*);
+static inline void         cache_sync_tag(Cache*, uns, Cache_Entry*);
+static inline int          scan_tags(Cache*, uns, Addr, uns);
+static inline int          cache_find_way(Cache*, uns, Addr, uns);
+static inline int          cache_find_invalid_way(Cache*, uns);
 
 /* for ideal replacement */
 static inline void*        access_unsure_lines(Cache*, uns, Addr, Flag);
@@ -82,6 +89,77 @@ uns ext_cache_index(Cache* cache, Addr addr, Addr* tag, Addr* line_addr) {
 }
 
 
+/**************************************************************************************/
+/* cache_sync_tag: Copies the valid bit and tag of a line into the packed tag
+   array. Must be called whenever either changes. Lines that are not part of
+   the main entries (e.g. shadow entries) are ignored. */
+
+static inline void cache_sync_tag(Cache* cache, uns set, Cache_Entry* line) {
+  uns way = line - cache->entries[set];
+  if(line < cache->entries[set] || way >= cache->assoc)
+    return;
+  cache->tags[set * cache->assoc + way] = line->valid ? line->tag :
+                                                        CACHE_INVALID_TAG;
+}
+
+
+/**************************************************************************************/
+/* scan_tags: Returns the first way at or after start whose packed tag is tag,
+   or -1. The tags are compared CACHE_TAG_CHUNK at a time into a match mask,
+   which the compiler turns into vector compares. */
+
+static inline int scan_tags(Cache* cache, uns set, Addr tag, uns start) {
+  const Addr* tags = &cache->tags[set * cache->assoc];
+  uns         ii   = start;
+
+  for(; ii + CACHE_TAG_CHUNK <= cache->assoc; ii += CACHE_TAG_CHUNK) {
+    uns mask = 0;
+    uns jj;
+    for(jj = 0; jj < CACHE_TAG_CHUNK; jj++)
+      mask |= (uns)(tags[ii + jj] == tag) << jj;
+    if(mask)
+      return ii + __builtin_ctz(mask);
+  }
+  for(; ii < cache->assoc; ii++) {
+    if(tags[ii] == tag)
+      return ii;
+  }
+  return -1;
+}
+
+
+/**************************************************************************************/
+/* cache_find_way: Returns the first way at or after start that holds a valid
+   line with the given tag, or -1. */
+
+static inline int cache_find_way(Cache* cache, uns set, Addr tag, uns start) {
+  uns ii;
+
+  if(tag != CACHE_INVALID_TAG)
+    return scan_tags(cache, set, tag, start);
+
+  /* a valid line with this tag looks invalid in the packed array */
+  for(ii = start; ii < cache->assoc; ii++) {
+    Cache_Entry* line = &cache->entries[set][ii];
+    if(line->valid && line->tag == tag)
+      return ii;
+  }
+  return -1;
+}
+
+
+/**************************************************************************************/
+/* cache_find_invalid_way: Returns the first invalid way in the set, or -1. */
+
+static inline int cache_find_invalid_way(Cache* cache, uns set) {
+  int way = scan_tags(cache, set, CACHE_INVALID_TAG, 0);
+
+  while(way >= 0 && cache->entries[set][way].valid)
+    way = scan_tags(cache, set, CACHE_INVALID_TAG, way + 1);
+  return way;
+}
+
+
 /**************************************************************************************/
 /* init_cache: */
 
@@ -114,6 +192,7 @@ void init_cache(Cache* cache, const char* name, uns cache_size, uns assoc,
 
   /* allocate memory for all the sets (pointers to line arrays)  */
   cache->entries = (Cache_Entry**)malloc(sizeof(Cache_Entry*) * num_sets);
+  cache->tags    = (Addr*)malloc(sizeof(Addr) * num_sets * assoc);
 
   /* allocate memory for the unsure lists (if necessary) */
   if(cache->repl_policy == REPL_IDEAL)
@@ -124,7 +203,8 @@ void init_cache(Cache* cache, const char* name, uns cache_size, uns assoc,
     cache->entries[ii] = (Cache_Entry*)malloc(sizeof(Cache_Entry) * assoc);
     /* allocate memory for all of the data elements in each line */
     for(jj = 0; jj < assoc; jj++) {
-      cache->entries[ii][jj].valid = FALSE;
+      cache->entries[ii][jj].valid  = FALSE;
+      cache->tags[ii * assoc + jj] = CACHE_INVALID_TAG;
       if(data_size) {
         cache->entries[ii][jj].data = (void*)malloc(data_size);
         memset(cache->entries[ii][jj].data, 0, data_size);
@@ -153,6 +233,9 @@ void init_cache(Cache* cache, const char* name, uns cache_size, uns assoc,
     cache->num_ways_occupied_core = (uns*)malloc(sizeof(uns) * NUM_CORES);
     cache->lru_index_core         = (uns*)malloc(sizeof(uns) * NUM_CORES);
     cache->lru_time_core = (Counter*)malloc(sizeof(Counter) * NUM_CORES);
+    cache->extra_sets_core      = (uns*)calloc(NUM_CORES, sizeof(uns));
+    cache->extra_set_start_core = (uns*)calloc(NUM_CORES, sizeof(uns));
+    cache->set_ways_core        = (uns*)malloc(sizeof(uns) * NUM_CORES);
   }
 
   /* allocate memory for the back-up lists (if necessary) */
@@ -195,6 +278,13 @@ void init_cache(Cache* cache, const char* name, uns cache_size, uns assoc,
       cache->queue_end[ii] = 0;
     }
   }
+
+  /* policies from cache_repl_table.def allocate their own metadata */
+  cache->repl_impl = cache_repl_impl(repl_policy);
+  cache->repl_data = NULL;
+  cache->repl_pc   = 0;
+  if(cache->repl_impl)
+    cache->repl_impl->init(cache);
 }
 
 /**************************************************************************************/
@@ -204,32 +294,36 @@ void init_cache(Cache* cache, const char* name, uns cache_size, uns assoc,
 void* cache_access(Cache* cache, Addr addr, Addr* line_addr, Flag update_repl) {
   Addr tag;
   uns  set = cache_index(cache, addr, &tag, line_addr);
-  uns  ii;
+  int  ii;
 
   if(cache->repl_policy == REPL_IDEAL_STORAGE) {
     return access_ideal_storage(cache, set, tag, addr);
   }
 
-  for(ii = 0; ii < cache->assoc; ii++) {
+  ii = cache_find_way(cache, set, tag, 0);
+  if(ii >= 0) {
     Cache_Entry* line = &cache->entries[set][ii];
 
-    if(line->valid && line->tag == tag) {
-      /* update replacement state if necessary */
-      ASSERT(0, line->data);
-      DEBUG(0, "Found line in cache '%s' at (set %u, way %u, base 0x%s)\n",
-            cache->name, set, ii, hexstr64s(line->base));
+    /* update replacement state if necessary */
+    ASSERT(0, line->data);
+    DEBUG(0, "Found line in cache '%s' at (set %u, way %u, base 0x%s)\n",
+          cache->name, set, ii, hexstr64s(line->base));
 
-      if(update_repl) {
-        if(line->pref) {
-          line->pref = FALSE;
-        }
-        cache->num_demand_access++;
-        update_repl_policy(cache, line, set, ii, FALSE);
+    if(update_repl) {
+      if(line->pref) {
+        line->pref = FALSE;
       }
-
-      return line->data;
+      cache->num_demand_access++;
+      if(cache->repl_impl)
+        cache->repl_impl->hit(cache, set, ii, line->base);
+      else
+        update_repl_policy(cache, line, set, ii, FALSE);
     }
+
+    cache->repl_pc = 0;
+    return line->data;
   }
+  cache->repl_pc = 0;
   /* if it's a miss and we're doing ideal replacement, look in the unsure list
    */
   if(cache->repl_policy == REPL_IDEAL) {
@@ -308,9 +402,17 @@ void* cache_insert_replpos(Cache* cache, uns8 proc_id, Addr addr,
   new_line->base             = *line_addr;
   new_line->last_access_time = sim_time;  // FIXME: this fixes valgrind warnings
                                           // in update_prf_
+  cache_sync_tag(cache, set, new_line);
 
   new_line->pref = isPrefetch;
 
+  if(cache->repl_impl) {
+    cache->repl_impl->insert(cache, proc_id, set, repl_index, *line_addr,
+                             insert_repl_policy, isPrefetch);
+    cache->repl_pc = 0;
+    return new_line->data;
+  }
+
   switch(insert_repl_policy) {
     case INSERT_REPL_DEFAULT:
       update_repl_policy(cache, new_line, set, repl_index, TRUE);
@@ -367,17 +469,17 @@ void* cache_insert_replpos(Cache* cache, uns8 proc_id, Addr addr,
       Counter      lru_time = MAX_CTR;
       Cache_Entry* main_line;
       uns          ii;
+      int          way;
 
       /* first cache access */
-      for(ii = 0; ii < cache->assoc; ii++) {
-        Cache_Entry* line = &cache->entries[set][ii];
-
-        if(line->tag == tag && line->valid) {
-          /* update replacement state if necessary */
-          ASSERT(0, line->data);
-          line->last_access_time = sim_time;
-          return new_line->data;
-        }
+      way = cache_find_way(cache, set, tag, 0);
+      if(way >= 0) {
+        Cache_Entry* line = &cache->entries[set][way];
+
+        /* update replacement state if necessary */
+        ASSERT(0, line->data);
+        line->last_access_time = sim_time;
+        return new_line->data;
       }
       /* looking for lru */
       for(ii = 0; ii < cache->assoc; ii++) {
@@ -396,6 +498,7 @@ void* cache_insert_replpos(Cache* cache, uns8 proc_id, Addr addr,
       main_line->tag              = tag;
       main_line->base             = *line_addr;
       main_line->last_access_time = sim_time;
+      cache_sync_tag(cache, set, main_line);
     }
   }
   return new_line->data;
@@ -409,15 +512,17 @@ void* cache_insert_replpos(Cache* cache, uns8 proc_id, Addr addr,
 void cache_invalidate(Cache* cache, Addr addr, Addr* line_addr) {
   Addr tag;
   uns  set = cache_index(cache, addr, &tag, line_addr);
-  uns  ii;
+  int  ii;
 
-  for(ii = 0; ii < cache->assoc; ii++) {
+  for(ii = cache_find_way(cache, set, tag, 0); ii >= 0;
+      ii = cache_find_way(cache, set, tag, ii + 1)) {
     Cache_Entry* line = &cache->entries[set][ii];
-    if(line->tag == tag && line->valid) {
-      line->tag   = 0;
-      line->valid = FALSE;
-      line->base  = 0;
-    }
+    line->tag         = 0;
+    line->valid       = FALSE;
+    line->base        = 0;
+    cache_sync_tag(cache, set, line);
+    if(cache->repl_impl)
+      cache->repl_impl->invalidate(cache, set, ii);
   }
 
   if(cache->repl_policy == REPL_IDEAL)
@@ -461,17 +566,26 @@ void* get_next_repl_line(Cache* cache, uns8 proc_id, Addr addr,
  */
 Cache_Entry* find_repl_entry(Cache* cache, uns8 proc_id, uns set, uns* way) {
   int ii;
+
+  if(cache->repl_impl) {
+    int inv_ind = cache_find_invalid_way(cache, set);
+    *way = inv_ind >= 0 ? inv_ind :
+                          cache->repl_impl->victim(cache, proc_id, set);
+    return &cache->entries[set][*way];
+  }
+
   switch(cache->repl_policy) {
     case REPL_SHADOW_IDEAL:
     case REPL_TRUE_LRU: {
       uns     lru_ind  = 0;
       Counter lru_time = MAX_CTR;
+      int     inv_ind  = cache_find_invalid_way(cache, set);
+      if(inv_ind >= 0) {
+        *way = inv_ind;
+        return &cache->entries[set][inv_ind];
+      }
       for(ii = 0; ii < cache->assoc; ii++) {
         Cache_Entry* entry = &cache->entries[set][ii];
-        if(!entry->valid) {
-          lru_ind = ii;
-          break;
-        }
         if(entry->last_access_time < lru_time) {
           lru_ind  = ii;
           lru_time = cache->entries[set][ii].last_access_time;
@@ -519,11 +633,20 @@ Cache_Entry* find_repl_entry(Cache* cache, uns8 proc_id, uns set, uns* way) {
       uns  lru_ind             = 0;
       uns  total_assigned_ways = 0;
 
+      /* A core's ways in this set: its whole ways, plus one if the set is
+         among the sets of its way-plus-set remainder */
+      uns* set_ways = cache->set_ways_core;
       for(way_proc_id = 0; way_proc_id < NUM_CORES; way_proc_id++) {
         cache->num_ways_occupied_core[way_proc_id] = 0;
         cache->lru_time_core[way_proc_id]          = MAX_CTR;
         ASSERT(way_proc_id, cache->num_ways_allocted_core[way_proc_id]);
-        total_assigned_ways += cache->num_ways_allocted_core[way_proc_id];
+        uns set_offset = (set + cache->num_sets -
+                          cache->extra_set_start_core[way_proc_id]) %
+                         cache->num_sets;
+        set_ways[way_proc_id] = cache->num_ways_allocted_core[way_proc_id] +
+                                (set_offset <
+                                 cache->extra_sets_core[way_proc_id]);
+        total_assigned_ways += set_ways[way_proc_id];
       }
 
       ASSERT(proc_id, total_assigned_ways <= cache->assoc);
@@ -549,10 +672,10 @@ Cache_Entry* find_repl_entry(Cache* cache, uns8 proc_id, uns set, uns* way) {
       int max_extra_occ = 0;
       int repl_proc_id  = -1;
       for(way_proc_id = 0; way_proc_id < NUM_CORES; way_proc_id++) {
-        if(cache->num_ways_allocted_core[way_proc_id] <
+        if(set_ways[way_proc_id] <
            cache->num_ways_occupied_core[way_proc_id]) {
           int extra_occ = cache->num_ways_occupied_core[way_proc_id] -
-                          cache->num_ways_allocted_core[way_proc_id];
+                          set_ways[way_proc_id];
           if(extra_occ > max_extra_occ) {
             max_extra_occ = extra_occ;
             repl_proc_id  = way_proc_id;
@@ -561,10 +684,9 @@ Cache_Entry* find_repl_entry(Cache* cache, uns8 proc_id, uns set, uns* way) {
       }
 
       int proc_id_extra_occ = cache->num_ways_occupied_core[proc_id] -
-                              cache->num_ways_allocted_core[proc_id];
+                              set_ways[proc_id];
 
-      if(cache->num_ways_allocted_core[proc_id] >
-           cache->num_ways_occupied_core[proc_id] ||
+      if(set_ways[proc_id] > cache->num_ways_occupied_core[proc_id] ||
          max_extra_occ > proc_id_extra_occ + 1 ||
          ((max_extra_occ > proc_id_extra_occ) &&
           ((proc_id + set) % NUM_CORES > (repl_proc_id + set) % NUM_CORES))) {
@@ -671,6 +793,7 @@ static inline void* access_unsure_lines(Cache* cache, uns set, Addr tag,
         if(!cache->entries[set][ii].valid) {
           void* data = cache->entries[set][ii].data;
           memcpy(&cache->entries[set][ii], temp, sizeof(Cache_Entry));
+          cache_sync_tag(cache, set, &cache->entries[set][ii]);
           temp->data = data;
           ASSERT(0, dl_list_remove_current(list) == temp);
           ASSERT(0, ++cache->repl_ctrs[set] <=
@@ -708,6 +831,7 @@ static inline Cache_Entry* insert_sure_line(Cache* cache, uns set, Addr tag) {
         temp->data = malloc(sizeof(cache->data_size));
         memcpy(entry->data, temp->data, sizeof(cache->data_size));
         entry->valid = FALSE;
+        cache_sync_tag(cache, set, entry);
         count++;
       }
     }
@@ -793,6 +917,7 @@ void* access_shadow_lines(Cache* cache, uns set, Addr tag) {
         line->last_access_time =
           (cache->entries[set][lru_ind]).last_access_time;
         (cache->entries[set][lru_ind]).last_access_time = sim_time;
+        cache_sync_tag(cache, set, &cache->entries[set][lru_ind]);
         DEBUG(0,
               "shadow cache line is swaped\n cache->addr:0x%s "
               "cache->lru_time:%lld  shadow_tag:0x%s shadow_insert:%lld \n",
@@ -859,13 +984,12 @@ void* access_ideal_storage(Cache* cache, uns set, Addr tag, Addr addr) {
   uns          valid_start = 0;
   Cache_Entry* new_line;
   int          main_entry_found = FALSE;
+  int          way;
 
-  for(ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* line = &cache->entries[set][ii];
-    if(line->tag == tag && line->valid) {
-      line->last_access_time = sim_time;
-      main_entry_found       = TRUE;
-    }
+  for(way = cache_find_way(cache, set, tag, 0); way >= 0;
+      way = cache_find_way(cache, set, tag, way + 1)) {
+    cache->entries[set][way].last_access_time = sim_time;
+    main_entry_found                          = TRUE;
   }
 
   for(ii = 0; ii < ideal_num_entries; ii++) {
@@ -978,6 +1102,13 @@ void* cache_insert_lru(Cache* cache, uns8 proc_id, Addr addr, Addr* line_addr,
   new_line->valid   = TRUE;
   new_line->tag     = tag;
   new_line->base    = *line_addr;
+  cache_sync_tag(cache, set, new_line);
+  if(cache->repl_impl) {
+    cache->repl_impl->insert(cache, proc_id, set, repl_index, *line_addr,
+                             INSERT_REPL_LRU, FALSE);
+    cache->repl_pc = 0;
+    return new_line->data;
+  }
   update_repl_policy(cache, new_line, set, repl_index, TRUE);
   if(cache->repl_policy == REPL_TRUE_LRU)
     new_line->last_access_time = 137;
@@ -991,17 +1122,17 @@ void* cache_insert_lru(Cache* cache, uns8 proc_id, Addr addr, Addr* line_addr,
       Counter      lru_time = MAX_CTR;
       Cache_Entry* main_line;
       uns          ii;
+      int          way;
 
       /* first cache access */
-      for(ii = 0; ii < cache->assoc; ii++) {
-        Cache_Entry* line = &cache->entries[set][ii];
-
-        if(line->tag == tag && line->valid) {
-          /* update replacement state if necessary */
-          ASSERT(0, line->data);
-          line->last_access_time = sim_time;
-          return new_line->data;
-        }
+      way = cache_find_way(cache, set, tag, 0);
+      if(way >= 0) {
+        Cache_Entry* line = &cache->entries[set][way];
+
+        /* update replacement state if necessary */
+        ASSERT(0, line->data);
+        line->last_access_time = sim_time;
+        return new_line->data;
       }
       /* looking for lru */
       for(ii = 0; ii < cache->assoc; ii++) {
@@ -1020,6 +1151,7 @@ void* cache_insert_lru(Cache* cache, uns8 proc_id, Addr addr, Addr* line_addr,
       main_line->tag              = tag;
       main_line->base             = *line_addr;
       main_line->last_access_time = sim_time;
+      cache_sync_tag(cache, set, main_line);
     }
   }
   return new_line->data;
@@ -1033,7 +1165,10 @@ void reset_cache(Cache* cache) {
 
   for(ii = 0; ii < cache->num_sets; ii++) {
     for(jj = 0; jj < cache->assoc; jj++) {
-      cache->entries[ii][jj].valid = FALSE;
+      cache->entries[ii][jj].valid        = FALSE;
+      cache->tags[ii * cache->assoc + jj] = CACHE_INVALID_TAG;
+      if(cache->repl_impl)
+        cache->repl_impl->invalidate(cache, ii, jj);
     }
   }
 }
@@ -1051,22 +1186,13 @@ int cache_find_pos_in_lru_stack(Cache* cache, uns8 proc_id, Addr addr,
   uns          set = cache_index(cache, addr, &tag, line_addr);
   uns          ii;
   int          position;
-  Cache_Entry* hit_line = NULL;
-  Flag         hit      = FALSE;
-
-  for(ii = 0; ii < cache->assoc; ii++) {
-    hit_line = &cache->entries[set][ii];
+  int          way = cache_find_way(cache, set, tag, 0);
+  Cache_Entry* hit_line;
 
-    if(hit_line->valid && hit_line->tag == tag) {
-      hit = TRUE;
-      break;
-    }
-  }
-
-  if(!hit)
+  if(way < 0)
     return -1;
 
-  ASSERT(0, hit_line);
+  hit_line = &cache->entries[set][way];
   ASSERT(0, hit_line->proc_id == proc_id);
   position = 0;
   for(ii = 0; ii < cache->assoc; ii++) {
@@ -1088,8 +1214,95 @@ void set_partition_allocate(Cache* cache, uns8 proc_id, uns num_ways) {
 }
 
 
+/* Give the core one more way in extra_sets consecutive sets, starting at
+   start_set and wrapping around. Together with the whole ways, the
+   allocations of all cores must add up to at most assoc in every set. */
+void set_partition_allocate_sets(Cache* cache, uns8 proc_id, uns extra_sets,
+                                 uns start_set) {
+  ASSERT(proc_id, L1_PART_ON);
+  ASSERT(proc_id, cache->extra_sets_core);
+  ASSERT(proc_id, extra_sets < cache->num_sets && start_set < cache->num_sets);
+  cache->extra_sets_core[proc_id]      = extra_sets;
+  cache->extra_set_start_core[proc_id] = start_set;
+}
+
+
 uns get_partition_allocated(Cache* cache, uns8 proc_id) {
   ASSERT(proc_id, cache->repl_policy == REPL_PARTITION);
   ASSERT(proc_id, cache->num_ways_allocted_core);
   return cache->num_ways_allocted_core[proc_id];
 }
+
+
+/**************************************************************************************/
+/* cache_ckpt_check: Stops the simulation if cache_ckpt can't handle the cache.
+   Called at init, so that the error doesn't come after the warmup. */
+
+void cache_ckpt_check(Cache* cache) {
+  if(cache->repl_policy == REPL_IDEAL ||
+     cache->repl_policy == REPL_SHADOW_IDEAL ||
+     cache->repl_policy == REPL_IDEAL_STORAGE)
+    FATAL_ERROR(0, "Cache '%s': ideal replacement policies can't be "
+                   "checkpointed\n",
+                cache->name);
+}
+
+/**************************************************************************************/
+/* cache_ckpt: Saves or restores the lines, line data and replacement state of
+   a cache. The data pointers of the lines are kept; only what they point to
+   is checkpointed. */
+
+void cache_ckpt(Cache* cache, Ckpt* ckpt) {
+  uns          num_lines = cache->num_sets * cache->assoc;
+  Cache_Entry* lines     = (Cache_Entry*)calloc(num_lines, sizeof(Cache_Entry));
+  char*        data      = (char*)malloc((size_t)num_lines * cache->data_size);
+  uns          ii, jj;
+
+  cache_ckpt_check(cache);
+
+  if(!ckpt->restoring) {
+    for(ii = 0; ii < cache->num_sets; ii++) {
+      for(jj = 0; jj < cache->assoc; jj++) {
+        Cache_Entry* line = &lines[ii * cache->assoc + jj];
+        *line             = cache->entries[ii][jj];
+        line->data        = NULL;
+        if(cache->data_size)
+          memcpy(data + (ii * cache->assoc + jj) * cache->data_size,
+                 cache->entries[ii][jj].data, cache->data_size);
+      }
+    }
+  }
+
+  ckpt_region(ckpt, cache->name, lines, sizeof(Cache_Entry) * num_lines);
+  ckpt_region(ckpt, "cache data", data, (uns64)num_lines * cache->data_size);
+  ckpt_region(ckpt, "cache repl_ctrs", cache->repl_ctrs,
+              sizeof(uns) * cache->num_sets);
+  if(cache->repl_policy == REPL_PARTITION) {
+    ckpt_region(ckpt, "cache partition", cache->num_ways_allocted_core,
+                sizeof(uns) * NUM_CORES);
+    ckpt_region(ckpt, "cache partition sets", cache->extra_sets_core,
+                sizeof(uns) * NUM_CORES);
+    ckpt_region(ckpt, "cache partition set start",
+                cache->extra_set_start_core, sizeof(uns) * NUM_CORES);
+  }
+  if(cache->repl_impl)
+    cache->repl_impl->ckpt(cache, ckpt);
+
+  if(ckpt->restoring) {
+    for(ii = 0; ii < cache->num_sets; ii++) {
+      for(jj = 0; jj < cache->assoc; jj++) {
+        Cache_Entry* line      = &cache->entries[ii][jj];
+        void*        line_data = line->data;
+        *line                  = lines[ii * cache->assoc + jj];
+        line->data             = line_data;
+        if(cache->data_size)
+          memcpy(line_data, data + (ii * cache->assoc + jj) * cache->data_size,
+                 cache->data_size);
+        cache_sync_tag(cache, ii, line);
+      }
+    }
+  }
+
+  free(lines);
+  free(data);
+}
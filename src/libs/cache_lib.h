@@ -30,6 +30,7 @@
 #define __CACHE_LIB_H__
 
 #include "globals/global_defs.h"
+#include "libs/ckpt_lib.h"
 #include "libs/list_lib.h"
 
 
@@ -38,6 +39,8 @@
 #define INIT_CACHE_DATA_VALUE \
   ((void*)0x8badbeef) /* set data pointers to this initially */
 
+#define CACHE_INVALID_TAG ((Addr)-1) /* packed tag of an invalid way */
+
 
 /**************************************************************************************/
 
@@ -54,9 +57,17 @@ typedef enum Repl_Policy_enum {
                          isn't stored at the cache */
   REPL_MLP,           /* mlp based replacement  -- uses MLP_REPL_POLICY */
   REPL_PARTITION,     /* Based on the partition*/
+/* policies registered in libs/cache_repl_table.def */
+#define CACHE_REPL_IMPL(id, name, prefix) REPL_##id,
+#include "libs/cache_repl_table.def"
+#undef CACHE_REPL_IMPL
   NUM_REPL
 } Repl_Policy;
 
+#define REPL_TABLE_START (REPL_PARTITION + 1) /* first table-based policy */
+
+struct Cache_Repl_Impl_struct;
+
 typedef struct Cache_Entry_struct {
   uns8    proc_id;
   Flag    valid;            /* valid bit for the line */
@@ -104,6 +115,9 @@ typedef struct Cache_struct {
   Cache_Entry** entries;   /* A dynamically allocated array of all
                               of the cache entries. The array is
                               two-dimensional, sets are row major. */
+  Addr* tags;              /* Packed copy of the tags in entries (num_sets *
+                              assoc, sets are row major) that lookups scan.
+                              Invalid ways hold CACHE_INVALID_TAG. */
   List* unsure_lists;      /* A linked list for each set in the cache that
                               is used when simulating ideal replacement policies */
   Flag perfect;            /* is the cache perfect (for henry mem system) */
@@ -119,6 +133,18 @@ typedef struct Cache_struct {
   uns*     num_ways_occupied_core; /* For cache partitioning */
   uns*     lru_index_core;         /* For cache partitioning */
   Counter* lru_time_core;          /* For cache partitioning */
+  uns*     extra_sets_core;        /* For way-plus-set partitioning: sets in
+                                      which the core gets one more way */
+  uns*     extra_set_start_core;   /* For way-plus-set partitioning: first of
+                                      those sets (they wrap around) */
+  uns*     set_ways_core;          /* For way-plus-set partitioning: scratch */
+
+  const struct Cache_Repl_Impl_struct* repl_impl; /* table-based replacement
+                                                     policy (NULL for the
+                                                     built-in ones) */
+  void* repl_data; /* replacement metadata owned by repl_impl */
+  Addr  repl_pc;   /* PC of the access being made, for PC-indexed replacement
+                      policies (0 if unknown) */
 } Cache;
 
 
@@ -146,7 +172,11 @@ void  reset_cache(Cache*);
 int   cache_find_pos_in_lru_stack(Cache* cache, uns8 proc_id, Addr addr,
                                   Addr* line_addr);
 void  set_partition_allocate(Cache* cache, uns8 proc_id, uns num_ways);
+void  set_partition_allocate_sets(Cache* cache, uns8 proc_id, uns extra_sets,
+                                  uns start_set);
 uns   get_partition_allocated(Cache* cache, uns8 proc_id);
+void  cache_ckpt_check(Cache* cache);
+void  cache_ckpt(Cache* cache, Ckpt* ckpt);
 /**************************************************************************************/
 
 
@@ -0,0 +1,91 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/cache_repl.c
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Registry of the table-based cache replacement policies.
+ ***************************************************************************************/
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+#include "libs/cache_repl.h"
+
+
+/**************************************************************************************/
+/* Global Variables */
+
+static const Cache_Repl_Impl cache_repl_table[] = {
+#define CACHE_REPL_IMPL(id, name, prefix)                               \
+  {name, prefix##_init, prefix##_victim, prefix##_insert, prefix##_hit, \
+   prefix##_invalidate, prefix##_ckpt},
+#include "libs/cache_repl_table.def"
+#undef CACHE_REPL_IMPL
+};
+
+
+/**************************************************************************************/
+/* cache_repl_impl: Returns the hooks of a table-based policy, or NULL for the
+   policies implemented inside cache_lib.c. */
+
+const Cache_Repl_Impl* cache_repl_impl(Repl_Policy policy) {
+  if(policy < REPL_TABLE_START)
+    return NULL;
+  ASSERTM(0, policy < NUM_REPL, "Unknown cache replacement policy %d\n",
+          policy);
+  return &cache_repl_table[policy - REPL_TABLE_START];
+}
+
+
+/**************************************************************************************/
+/* rrip_victim: Returns the first way with the largest RRPV. This is the way
+   RRIP would pick after aging the set until some line reaches the maximum. */
+
+uns rrip_victim(const uns8* rrpv, uns assoc) {
+  uns way = 0;
+  uns ii;
+
+  for(ii = 1; ii < assoc; ii++) {
+    if(rrpv[ii] > rrpv[way])
+      way = ii;
+  }
+  return way;
+}
+
+
+/**************************************************************************************/
+/* rrip_age: Ages the set so that its most distant line has the maximum RRPV,
+   as if the RRIP victim search had run. Called when a line is replaced. */
+
+void rrip_age(uns8* rrpv, uns assoc, uns8 max_rrpv) {
+  uns8 max = 0;
+  uns  ii;
+
+  for(ii = 0; ii < assoc; ii++)
+    max = MAX2(max, rrpv[ii]);
+  if(max < max_rrpv) {
+    for(ii = 0; ii < assoc; ii++)
+      rrpv[ii] += max_rrpv - max;
+  }
+}
@@ -0,0 +1,80 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/cache_repl.h
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Interface between cache_lib and the table-based replacement
+ *                policies registered in libs/cache_repl_table.def.
+ ***************************************************************************************/
+
+#ifndef __CACHE_REPL_H__
+#define __CACHE_REPL_H__
+
+#include "globals/global_types.h"
+#include "libs/cache_lib.h"
+
+
+/**************************************************************************************/
+/* Types */
+
+/* Hooks a replacement policy provides. cache_lib fills invalid ways on its
+   own, so victim is only asked about full sets and must not change any
+   state (get_next_repl_line peeks with it). insert is called after the new
+   line has been written to the way; the policy tracks whatever it needs about
+   the previous occupant itself. The PC of the access, if the caller supplied
+   one, is in cache->repl_pc during insert and hit. */
+typedef struct Cache_Repl_Impl_struct {
+  const char* name;
+  void (*init)(Cache* cache);
+  uns (*victim)(Cache* cache, uns8 proc_id, uns set);
+  void (*insert)(Cache* cache, uns8 proc_id, uns set, uns way, Addr line_addr,
+                 Cache_Insert_Repl pos, Flag pref);
+  void (*hit)(Cache* cache, uns set, uns way, Addr line_addr);
+  void (*invalidate)(Cache* cache, uns set, uns way);
+  void (*ckpt)(Cache* cache, Ckpt* ckpt); /* save/restore repl_data */
+} Cache_Repl_Impl;
+
+
+/**************************************************************************************/
+/* Prototypes */
+
+const Cache_Repl_Impl* cache_repl_impl(Repl_Policy policy);
+
+/* RRPV helpers shared by the RRIP-based policies. rrpv points at one set. */
+uns  rrip_victim(const uns8* rrpv, uns assoc);
+void rrip_age(uns8* rrpv, uns assoc, uns8 max_rrpv);
+
+#define CACHE_REPL_IMPL(id, name, prefix)                                 \
+  void prefix##_init(Cache*);                                             \
+  uns  prefix##_victim(Cache*, uns8, uns);                                \
+  void prefix##_insert(Cache*, uns8, uns, uns, Addr, Cache_Insert_Repl, \
+                       Flag);                                             \
+  void prefix##_hit(Cache*, uns, uns, Addr);                              \
+  void prefix##_invalidate(Cache*, uns, uns);                            \
+  void prefix##_ckpt(Cache*, Ckpt*);
+#include "libs/cache_repl_table.def"
+#undef CACHE_REPL_IMPL
+
+/**************************************************************************************/
+
+#endif /* #ifndef __CACHE_REPL_H__ */
@@ -0,0 +1,144 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/ckpt_lib.c
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Checkpoint file library (see libs/ckpt_lib.h).
+ ***************************************************************************************/
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/utils.h"
+
+#include "libs/ckpt_lib.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define CKPT_ALIGN(size) (((size) + 7) & ~(uns64)7)
+
+
+/**************************************************************************************/
+/* ckpt_open_save: */
+
+void ckpt_open_save(Ckpt* ckpt, const char* file_name) {
+  memset(ckpt, 0, sizeof(Ckpt));
+  strncpy(ckpt->file_name, file_name, MAX_STR_LENGTH);
+  ckpt->restoring = FALSE;
+  ckpt->file      = fopen(file_name, "wb");
+  if(!ckpt->file)
+    FATAL_ERROR(0, "Cannot create checkpoint file %s\n", file_name);
+  if(fwrite(CKPT_MAGIC, CKPT_MAGIC_LEN, 1, ckpt->file) != 1)
+    FATAL_ERROR(0, "Error writing checkpoint file %s\n", file_name);
+  ckpt->pos = CKPT_MAGIC_LEN;
+}
+
+
+/**************************************************************************************/
+/* ckpt_open_restore: Maps the whole checkpoint; sections are copied out of the
+   mapping by ckpt_region(). */
+
+void ckpt_open_restore(Ckpt* ckpt, const char* file_name) {
+  struct stat st;
+  int         fd;
+
+  memset(ckpt, 0, sizeof(Ckpt));
+  strncpy(ckpt->file_name, file_name, MAX_STR_LENGTH);
+  ckpt->restoring = TRUE;
+
+  fd = open(file_name, O_RDONLY);
+  if(fd < 0 || fstat(fd, &st))
+    FATAL_ERROR(0, "Cannot open checkpoint file %s\n", file_name);
+  ckpt->map_size = st.st_size;
+  ckpt->map = (char*)mmap(NULL, ckpt->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(ckpt->map == MAP_FAILED)
+    FATAL_ERROR(0, "Cannot map checkpoint file %s\n", file_name);
+  madvise(ckpt->map, ckpt->map_size, MADV_SEQUENTIAL);
+
+  if(ckpt->map_size < CKPT_MAGIC_LEN ||
+     memcmp(ckpt->map, CKPT_MAGIC, CKPT_MAGIC_LEN))
+    FATAL_ERROR(0, "%s is not a Scarab checkpoint\n", file_name);
+  ckpt->pos = CKPT_MAGIC_LEN;
+}
+
+
+/**************************************************************************************/
+/* ckpt_close: */
+
+void ckpt_close(Ckpt* ckpt) {
+  if(ckpt->restoring) {
+    if(ckpt->pos != ckpt->map_size)
+      FATAL_ERROR(0, "Checkpoint %s has %llu bytes of unused state\n",
+                  ckpt->file_name, ckpt->map_size - ckpt->pos);
+    munmap(ckpt->map, ckpt->map_size);
+  } else {
+    if(fclose(ckpt->file))
+      FATAL_ERROR(0, "Error writing checkpoint file %s\n", ckpt->file_name);
+  }
+}
+
+
+/**************************************************************************************/
+/* ckpt_region: Saves or restores size bytes at ptr. Restoring fails if the
+   checkpoint was written by a configuration whose state has a different
+   layout, which shows up as a section name or size mismatch. */
+
+void ckpt_region(Ckpt* ckpt, const char* name, void* ptr, uns64 size) {
+  static const char pad[8] = {0};
+  Ckpt_Section      section;
+
+  if(ckpt->restoring) {
+    if(ckpt->pos + sizeof(Ckpt_Section) > ckpt->map_size)
+      FATAL_ERROR(0, "Checkpoint %s ends before section '%s'\n",
+                  ckpt->file_name, name);
+    memcpy(&section, ckpt->map + ckpt->pos, sizeof(Ckpt_Section));
+    if(strncmp(section.name, name, CKPT_NAME_LEN - 1) || section.size != size)
+      FATAL_ERROR(0,
+                  "Checkpoint %s does not match this configuration: expected "
+                  "section '%.*s' of %llu bytes, found '%.*s' of %llu bytes\n",
+                  ckpt->file_name, CKPT_NAME_LEN - 1, name, size,
+                  CKPT_NAME_LEN - 1, section.name, section.size);
+    ckpt->pos += sizeof(Ckpt_Section);
+    if(ckpt->pos + size > ckpt->map_size)
+      FATAL_ERROR(0, "Checkpoint %s is truncated\n", ckpt->file_name);
+    memcpy(ptr, ckpt->map + ckpt->pos, size);
+    ckpt->pos += CKPT_ALIGN(size);
+  } else {
+    memset(&section, 0, sizeof(Ckpt_Section));
+    strncpy(section.name, name, CKPT_NAME_LEN - 1);
+    section.size = size;
+    if(fwrite(&section, sizeof(Ckpt_Section), 1, ckpt->file) != 1 ||
+       (size && fwrite(ptr, size, 1, ckpt->file) != 1) ||
+       (CKPT_ALIGN(size) != size &&
+        fwrite(pad, CKPT_ALIGN(size) - size, 1, ckpt->file) != 1))
+      FATAL_ERROR(0, "Error writing checkpoint file %s\n", ckpt->file_name);
+    ckpt->pos += sizeof(Ckpt_Section) + CKPT_ALIGN(size);
+  }
+}
@@ -0,0 +1,76 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/ckpt_lib.h
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Checkpoint files of simulator state. A checkpoint is a flat
+ *                sequence of named, 8-byte aligned sections. The same code path
+ *                writes and reads it: every module hands each piece of its
+ *                state to ckpt_region() in a fixed order, which either appends
+ *                it to the file or copies it back out of the mmapped file.
+ ***************************************************************************************/
+
+#ifndef __CKPT_LIB_H__
+#define __CKPT_LIB_H__
+
+#include <stdio.h>
+#include "globals/global_defs.h"
+
+
+/**************************************************************************************/
+/* Defines */
+
+#define CKPT_MAGIC "SCRBWCK1"
+#define CKPT_MAGIC_LEN 8
+#define CKPT_NAME_LEN 32
+
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Ckpt_Section_struct {
+  char  name[CKPT_NAME_LEN]; /* what the section holds (checked on restore) */
+  uns64 size;                /* bytes of data following the header */
+} Ckpt_Section;
+
+typedef struct Ckpt_struct {
+  char  file_name[MAX_STR_LENGTH + 1];
+  Flag  restoring; /* reading state back instead of saving it */
+  FILE* file;      /* when saving */
+  char* map;       /* when restoring, the whole file */
+  uns64 map_size;
+  uns64 pos;       /* offset of the next section */
+} Ckpt;
+
+
+/**************************************************************************************/
+/* Prototypes */
+
+void ckpt_open_save(Ckpt* ckpt, const char* file_name);
+void ckpt_open_restore(Ckpt* ckpt, const char* file_name);
+void ckpt_close(Ckpt* ckpt);
+void ckpt_region(Ckpt* ckpt, const char* name, void* ptr, uns64 size);
+
+/**************************************************************************************/
+
+#endif /* #ifndef __CKPT_LIB_H__ */
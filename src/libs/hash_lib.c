@@ -24,9 +24,15 @@
  * Author       : HPS Research Group
  * Date         : 9/22/1998
  * Description  : A hash table library.
+ *
+ * The table uses open addressing with linear probing over a power-of-two slot
+ * array that doubles once it is HASH_TABLE_MAX_LOAD full. Deletion shifts the
+ * rest of the probe run back instead of leaving tombstones. Entry data is
+ * allocated from per-table arena chunks and recycled through a free list.
  ***************************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 #include "debug/debug_macros.h"
 #include "globals/assert.h"
 #include "globals/global_defs.h"
@@ -34,7 +40,6 @@
 #include "globals/global_vars.h"
 
 #include "libs/hash_lib.h"
-#include "libs/malloc_lib.h"
 
 #include "debug/debug.param.h"
 
@@ -44,15 +49,32 @@
 
 #define DEBUG(args...) _DEBUG(DEBUG_HASH_LIB, ##args)
 
-#define HASH_INDEX(table, key) (((uns)(key)) % (table)->buckets)
+#define HASH_TABLE_MIN_BUCKETS 8
+#define HASH_TABLE_MAX_LOAD(buckets) ((buckets) / 2 + (buckets) / 4)
+#define HASH_TABLE_ARENA_BYTES (64 * 1024)
+
+// Keys that are close together (e.g. the PCs of a loop) land in nearby slots;
+// the folded upper bits spread out keys that are aligned to a line or a page.
+#define HASH_INDEX(table, key)                                       \
+  ((uns)(((uns64)(key) ^ ((uns64)(key) >> 6) ^ ((uns64)(key) >> 20)) & \
+         ((table)->buckets - 1)))
+#define HASH_NEXT(table, index) (((index) + 1) & ((table)->buckets - 1))
+
+// data slots are 8-byte aligned and big enough to hold the free list link
+#define HASH_TABLE_SLOT_SIZE(table) \
+  ((MAX2((table)->data_size, sizeof(void*)) + 7) & ~(uns)7)
 
 
 /**************************************************************************************/
-// Global variables
+/* Prototypes */
 
-#define NUM_HASH_TABLE_PRIMES 12
-static uns const hash_table_primes[NUM_HASH_TABLE_PRIMES] = {
-  1, 5, 11, 23, 47, 101, 211, 401, 811, 1601, 3209, 6373};
+static void              hash_table_resize(Hash_Table*, uns);
+static Hash_Table_Entry* hash_table_find(Hash_Table const*, int64,
+                                         void const*);
+static void*             hash_table_insert(Hash_Table*, int64, void*);
+static void              hash_table_remove(Hash_Table*, Hash_Table_Entry*);
+static void*             hash_table_new_data(Hash_Table*);
+static void              hash_table_free_data(Hash_Table*, void*);
 
 
 /**************************************************************************************/
@@ -66,13 +88,145 @@ void init_hash_table(Hash_Table* table, const char* name, uns buckets,
 void init_complex_hash_table(Hash_Table* table, const char* name, uns buckets,
                              uns data_size,
                              Flag (*eq_func)(void const*, void const*)) {
-  table->name      = strdup(name);
-  table->buckets   = buckets;
-  table->data_size = data_size;
-  table->count     = 0;
-  table->entries   = (Hash_Table_Entry**)calloc(buckets,
-                                              sizeof(Hash_Table_Entry*));
-  table->eq_func   = eq_func;
+  table->name       = strdup(name);
+  table->buckets    = 0;
+  table->data_size  = data_size;
+  table->count      = 0;
+  table->entries    = NULL;
+  table->eq_func    = eq_func;
+  table->arena      = NULL;
+  table->arena_left = 0;
+  table->free_data  = NULL;
+  hash_table_resize(table, buckets);
+}
+
+
+/**************************************************************************************/
+/* hash_table_resize: allocate a slot array of at least 'buckets' slots (rounded
+   up to a power of two) and move the existing entries into it. The data
+   pointers do not move. */
+
+static void hash_table_resize(Hash_Table* table, uns buckets) {
+  Hash_Table_Entry* old_entries = table->entries;
+  uns               old_buckets = table->buckets;
+  uns               new_buckets = HASH_TABLE_MIN_BUCKETS;
+  uns               ii;
+
+  while(new_buckets < buckets ||
+        HASH_TABLE_MAX_LOAD(new_buckets) < (uns)table->count)
+    new_buckets <<= 1;
+
+  table->buckets = new_buckets;
+  table->entries = (Hash_Table_Entry*)calloc(new_buckets,
+                                             sizeof(Hash_Table_Entry));
+  ASSERT(0, table->entries);
+
+  for(ii = 0; ii < old_buckets; ii++) {
+    if(old_entries[ii].data) {
+      uns index = HASH_INDEX(table, old_entries[ii].key);
+      while(table->entries[index].data)
+        index = HASH_NEXT(table, index);
+      table->entries[index] = old_entries[ii];
+    }
+  }
+  free(old_entries);
+
+  DEBUG(0, "Resized %s from %d to %d buckets (%d entries)\n", table->name,
+        old_buckets, new_buckets, table->count);
+}
+
+
+/**************************************************************************************/
+/* hash_table_find: return the slot holding key, or NULL. If data is not NULL,
+   the slot must also satisfy the table's eq_func. */
+
+static Hash_Table_Entry* hash_table_find(Hash_Table const* table, int64 key,
+                                         void const* data) {
+  uns index = HASH_INDEX(table, key);
+
+  for(; table->entries[index].data; index = HASH_NEXT(table, index)) {
+    Hash_Table_Entry* entry = &table->entries[index];
+    if(entry->key == key && (!data || table->eq_func(entry->data, data)))
+      return entry;
+  }
+  return NULL;
+}
+
+
+/**************************************************************************************/
+/* hash_table_insert: add a new entry for key (that is known not to be in the
+   table), growing the table first if it is too full */
+
+static void* hash_table_insert(Hash_Table* table, int64 key, void* data) {
+  uns index;
+
+  ASSERT(0, data);
+  if((uns)table->count + 1 > HASH_TABLE_MAX_LOAD(table->buckets))
+    hash_table_resize(table, table->buckets * 2);
+
+  index = HASH_INDEX(table, key);
+  while(table->entries[index].data)
+    index = HASH_NEXT(table, index);
+  table->entries[index].key  = key;
+  table->entries[index].data = data;
+  table->count++;
+  return data;
+}
+
+
+/**************************************************************************************/
+/* hash_table_remove: empty a slot and shift the rest of its probe run back so
+   that every remaining entry is still reachable from its home slot */
+
+static void hash_table_remove(Hash_Table* table, Hash_Table_Entry* entry) {
+  uns hole  = entry - table->entries;
+  uns index = HASH_NEXT(table, hole);
+
+  for(; table->entries[index].data; index = HASH_NEXT(table, index)) {
+    uns home = HASH_INDEX(table, table->entries[index].key);
+    // move the entry into the hole unless its home lies in (hole, index]
+    if(((index - home) & (table->buckets - 1)) >=
+       ((index - hole) & (table->buckets - 1))) {
+      table->entries[hole] = table->entries[index];
+      hole                 = index;
+    }
+  }
+  table->entries[hole].data = NULL;
+  table->count--;
+  ASSERT(0, table->count >= 0);
+}
+
+
+/**************************************************************************************/
+/* hash_table_new_data: hand out a data slot, from the free list if possible */
+
+static void* hash_table_new_data(Hash_Table* table) {
+  uns   slot_size = HASH_TABLE_SLOT_SIZE(table);
+  void* data;
+
+  if(table->free_data) {
+    data             = table->free_data;
+    table->free_data = *(void**)data;
+    return data;
+  }
+
+  if(table->arena_left == 0) {
+    table->arena_left = MAX2(HASH_TABLE_ARENA_BYTES / slot_size, 1);
+    table->arena      = (char*)malloc(table->arena_left * slot_size);
+    ASSERT(0, table->arena);
+    _DEBUGA(0, 0, "malloc'd %ld bytes for %s (%d entries)\n",
+            (unsigned long int)table->arena_left * slot_size, table->name,
+            table->count);
+  }
+  data = table->arena;
+  table->arena += slot_size;
+  table->arena_left--;
+  return data;
+}
+
+static void hash_table_free_data(Hash_Table* table, void* data) {
+  *(void**)data    = table->free_data;
+  table->free_data = data;
 }
 
 
@@ -83,33 +237,21 @@ void init_complex_hash_table(Hash_Table* table, const char* name, uns buckets,
 
 void* hash_table_access(Hash_Table const* table, int64 key) {
   // {{{ access hash table using simple key compare
-  uns               index  = HASH_INDEX(table, key);
-  Hash_Table_Entry* bucket = table->entries[index];
-  Hash_Table_Entry* temp;
-
-  for(temp = bucket; temp != NULL; temp = temp->next)
-    if(temp->key == key)
-      return temp->data;
-
-  return NULL;
+  Hash_Table_Entry* entry = hash_table_find(table, key, NULL);
+  return entry ? entry->data : NULL;
   // }}}
 }
 
 void* complex_hash_table_access(Hash_Table const* table, int64 key,
                                 void const* data) {
   // {{{ access hash table using a complex comparison
-  uns               index  = HASH_INDEX(table, key);
-  Hash_Table_Entry* bucket = table->entries[index];
-  Hash_Table_Entry* temp;
+  Hash_Table_Entry* entry;
 
   ASSERT(0, table->eq_func);
   ASSERT(0, data);
 
-  for(temp = bucket; temp != NULL; temp = temp->next)
-    if(temp->key == key && table->eq_func(temp->data, data))
-      return temp->data;
-
-  return NULL;
+  entry = hash_table_find(table, key, data);
+  return entry ? entry->data : NULL;
   // }}}
 }
 
@@ -121,81 +263,28 @@ void* complex_hash_table_access(Hash_Table const* table, int64 key,
 
 void* hash_table_access_create(Hash_Table* table, int64 key, Flag* new_entry) {
   // {{{ access hash table using simple key compare
-  uns               index    = HASH_INDEX(table, key);
-  Hash_Table_Entry* bucket   = table->entries[index];
-  Hash_Table_Entry* new_hash = NULL;
-  Hash_Table_Entry* temp;
-  Hash_Table_Entry* prev = NULL;
-
-  *new_entry = FALSE;
-  ASSERT(0, index < table->buckets);
-  for(temp = bucket; temp != NULL; temp = temp->next) {
-    if(temp->key == key)
-      return temp->data;
-    else
-      prev = temp;
-  }
-  table->count++;
-  *new_entry = TRUE;
-  new_hash   = (Hash_Table_Entry*)smalloc(sizeof(Hash_Table_Entry));
-  ASSERT(0, new_hash);
-  new_hash->key  = key;
-  new_hash->next = NULL;
-  new_hash->data = (void*)smalloc(table->data_size);
-  ASSERT(0, new_hash->data);
-
-  if(prev)
-    prev->next = new_hash;
-  else
-    table->entries[index] = new_hash;
-
-  _DEBUGA(0, 0, "smalloc'd %ld bytes for %s (%d entries)\n",
-          (unsigned long int)sizeof(Hash_Table_Entry) + table->data_size,
-          table->name, table->count);
-
-  return new_hash->data;
+  Hash_Table_Entry* entry = hash_table_find(table, key, NULL);
+
+  *new_entry = entry == NULL;
+  if(entry)
+    return entry->data;
+  return hash_table_insert(table, key, hash_table_new_data(table));
   // }}}
 }
 
 void* complex_hash_table_access_create(Hash_Table* table, int64 key,
                                        void const* data, Flag* new_entry) {
   // {{{ access hash table using a complex comparison
-  uns               index    = HASH_INDEX(table, key);
-  Hash_Table_Entry* bucket   = table->entries[index];
-  Hash_Table_Entry* new_hash = NULL;
-  Hash_Table_Entry* temp;
-  Hash_Table_Entry* prev = NULL;
+  Hash_Table_Entry* entry;
 
   ASSERT(0, table->eq_func);
   ASSERT(0, data);
 
-  *new_entry = FALSE;
-  ASSERT(0, index < table->buckets);
-  for(temp = bucket; temp != NULL; temp = temp->next) {
-    if(temp->key == key && table->eq_func(temp->data, data))
-      return temp->data;
-    else
-      prev = temp;
-  }
-  table->count++;
-  *new_entry = TRUE;
-  new_hash   = (Hash_Table_Entry*)smalloc(sizeof(Hash_Table_Entry));
-  ASSERT(0, new_hash);
-  new_hash->key  = key;
-  new_hash->next = NULL;
-  new_hash->data = (void*)smalloc(table->data_size);
-  ASSERT(0, new_hash->data);
-
-  if(prev)
-    prev->next = new_hash;
-  else
-    table->entries[index] = new_hash;
-
-  _DEBUGA(0, 0, "smalloc'd %ld bytes for %s (%d entries)\n",
-          (unsigned long int)sizeof(Hash_Table_Entry) + table->data_size,
-          table->name, table->count);
-
-  return new_hash->data;
+  entry      = hash_table_find(table, key, data);
+  *new_entry = entry == NULL;
+  if(entry)
+    return entry->data;
+  return hash_table_insert(table, key, hash_table_new_data(table));
   // }}}
 }
 
@@ -206,59 +295,30 @@ void* complex_hash_table_access_create(Hash_Table* table, int64 key,
 
 Flag hash_table_access_delete(Hash_Table* table, int64 key) {
   // {{{ access hash table using simple key compare
-  uns               index  = HASH_INDEX(table, key);
-  Hash_Table_Entry* bucket = table->entries[index];
-  Hash_Table_Entry* temp;
-  Hash_Table_Entry* prev = NULL;
-
-  for(temp = bucket; temp != NULL; temp = temp->next) {
-    if(temp->key == key) {
-      Hash_Table_Entry* next_ptr = temp->next;
-      sfree(table->data_size, temp->data);
-      sfree(sizeof(Hash_Table_Entry), temp);
-      if(prev)
-        prev->next = next_ptr;
-      else
-        table->entries[index] = next_ptr;
-      table->count--;
-      ASSERT(0, table->count >= 0);
-      return TRUE;
-    } else
-      prev = temp;
-  }
+  Hash_Table_Entry* entry = hash_table_find(table, key, NULL);
 
-  return FALSE;
+  if(!entry)
+    return FALSE;
+  hash_table_free_data(table, entry->data);
+  hash_table_remove(table, entry);
+  return TRUE;
   // }}}
 }
 
 Flag complex_hash_table_access_delete(Hash_Table* table, int64 key,
                                       void const* data) {
   // {{{ access hash table using a complex comparison
-  uns               index  = HASH_INDEX(table, key);
-  Hash_Table_Entry* bucket = table->entries[index];
-  Hash_Table_Entry* temp;
-  Hash_Table_Entry* prev = NULL;
+  Hash_Table_Entry* entry;
 
   ASSERT(0, table->eq_func);
   ASSERT(0, data);
 
-  for(temp = bucket; temp != NULL; temp = temp->next) {
-    if(temp->key == key && table->eq_func(temp->data, data)) {
-      Hash_Table_Entry* next_ptr = temp->next;
-      sfree(table->data_size, temp->data);
-      sfree(sizeof(Hash_Table_Entry), temp);
-      if(prev)
-        prev->next = next_ptr;
-      else
-        table->entries[index] = next_ptr;
-      table->count--;
-      ASSERT(0, table->count >= 0);
-      return TRUE;
-    } else
-      prev = temp;
-  }
-
-  return FALSE;
+  entry = hash_table_find(table, key, data);
+  if(!entry)
+    return FALSE;
+  hash_table_free_data(table, entry->data);
+  hash_table_remove(table, entry);
+  return TRUE;
   // }}}
 }
 
@@ -267,21 +327,15 @@ Flag complex_hash_table_access_delete(Hash_Table* table, int64 key,
 /* hash_table_clear: */
 
 void hash_table_clear(Hash_Table* table) {
-  Hash_Table_Entry* temp0;
-  Hash_Table_Entry* temp1;
-  uns               count = 0;
-  int               ii;
+  uns count = 0;
+  uns ii;
 
   for(ii = 0; ii < table->buckets; ii++) {
-    temp0 = table->entries[ii];
-    while(temp0) {
-      temp1 = temp0->next;
-      sfree(table->data_size, temp0->data);
-      sfree(sizeof(Hash_Table_Entry), temp0);
-      temp0 = temp1;
+    if(table->entries[ii].data) {
+      hash_table_free_data(table, table->entries[ii].data);
+      table->entries[ii].data = NULL;
       count++;
     }
-    table->entries[ii] = NULL;
   }
   ASSERT(0, count == table->count);
   table->count = 0;
@@ -294,10 +348,9 @@ void hash_table_clear(Hash_Table* table) {
  */
 
 void** hash_table_flatten(Hash_Table* table, void** reuse_array) {
-  Hash_Table_Entry* temp;
-  void**            new_array;
-  uns               count = 0;
-  int               ii;
+  void** new_array;
+  uns    count = 0;
+  uns    ii;
 
   if(table->count == 0)
     return NULL;
@@ -310,14 +363,9 @@ void** hash_table_flatten(Hash_Table* table, void** reuse_array) {
   }
 
   /* write into the new array */
-  count = 0;
-  for(ii = 0; ii < table->buckets; ii++) {
-    temp = table->entries[ii];
-    while(temp) {
-      new_array[count++] = temp->data;
-      temp               = temp->next;
-    }
-  }
+  for(ii = 0; ii < table->buckets; ii++)
+    if(table->entries[ii].data)
+      new_array[count++] = table->entries[ii].data;
 
   ASSERTM(0, count == table->count, "%d %d\n", count, table->count);
   ASSERTM(0, count > 0, "%d %d\n", count, table->count);
@@ -332,9 +380,8 @@ void** hash_table_flatten(Hash_Table* table, void** reuse_array) {
 
 void hash_table_scan(Hash_Table* table, void (*scan_func)(void*, void*),
                      void*       arg) {
-  int               count = 0;
-  Hash_Table_Entry* temp;
-  int               ii;
+  int count = 0;
+  uns ii;
 
   ASSERT(0, scan_func);
 
@@ -342,11 +389,9 @@ void hash_table_scan(Hash_Table* table, void (*scan_func)(void*, void*),
     return;
 
   for(ii = 0; ii < table->buckets; ii++) {
-    temp = table->entries[ii];
-    while(temp) {
+    if(table->entries[ii].data) {
       count++;
-      scan_func(temp->data, arg);
-      temp = temp->next;
+      scan_func(table->entries[ii].data, arg);
     }
   }
   ASSERT(0, count == table->count);
@@ -354,55 +399,15 @@ void hash_table_scan(Hash_Table* table, void (*scan_func)(void*, void*),
 
 
 /**************************************************************************************/
-// hash_table_rehash: expand or contract the hash table
-// WARNING: this hasn't really been tested
+// hash_table_rehash: expand or contract the hash table. The table grows on its
+// own, so this is only needed to presize it. 0 doubles the number of buckets.
+// The table never shrinks below what its entries need.
 
 void hash_table_rehash(Hash_Table* table, int new_buckets) {
-  Hash_Table_Entry** new_entries;
-  Hash_Table_Entry** flat_entries;
-  Hash_Table_Entry** old_entries = table->entries;
-  uns                old_buckets = table->buckets;
-  Hash_Table_Entry*  temp;
-  uns                ii, jj;
-
   ASSERT(0, new_buckets >= 0);
-  if(new_buckets == 0) {  // use next prime
-    new_buckets = table->buckets;
-    for(ii = 0; ii < NUM_HASH_TABLE_PRIMES - 1; ii++)
-      if(hash_table_primes[ii] == old_buckets) {
-        new_buckets = hash_table_primes[ii + 1];
-        break;
-      }
-  }
-  if(new_buckets == old_buckets)
-    return;
-
-  // flatten hash table into an array of entries
-  flat_entries = (Hash_Table_Entry**)malloc(table->count *
-                                            sizeof(Hash_Table_Entry*));
-  for(ii = 0, jj = 0; ii < old_buckets; ii++)
-    for(temp = old_entries[ii]; temp; temp = temp->next)
-      flat_entries[jj++] = temp;
-  ASSERT(0, jj == table->count);
-
-  // replace old with new and free the old entry array
-  new_entries = (Hash_Table_Entry**)calloc(new_buckets,
-                                           sizeof(Hash_Table_Entry*));
-  ASSERT(0, new_entries);
-  ASSERT(0, new_buckets > 0 && new_buckets < 100000);
-  table->buckets = new_buckets;
-  table->entries = new_entries;
-  free(old_entries);
-
-  // insert each element
-  for(ii = 0; ii < table->count; ii++) {
-    Hash_Table_Entry* temp  = flat_entries[ii];
-    uns               index = HASH_INDEX(table, temp->key);
-    temp->next              = table->entries[index];
-    table->entries[index]   = temp;
-  }
-
-  free(flat_entries);
+  if(new_buckets == 0)
+    new_buckets = table->buckets * 2;
+  hash_table_resize(table, new_buckets);
 }
 
 /**************************************************************************************/
@@ -412,41 +417,16 @@ void hash_table_rehash(Hash_Table* table, int new_buckets) {
 void hash_table_access_replace(Hash_Table* table, int64 key,
                                void* replacement) {
   // {{{ access hash table using simple key compare
-  uns               index    = HASH_INDEX(table, key);
-  Hash_Table_Entry* bucket   = table->entries[index];
-  Hash_Table_Entry* new_hash = NULL;
-  Hash_Table_Entry* temp;
-  Hash_Table_Entry* prev      = NULL;
-  Flag              new_entry = FALSE;
-  UNUSED(new_entry);
+  Hash_Table_Entry* entry = hash_table_find(table, key, NULL);
+
   ASSERT(0, replacement);
-  ASSERT(0, index < table->buckets);
-  for(temp = bucket; temp != NULL; temp = temp->next) {
-    if(temp->key == key) {
-      /* May not want to free the memory in case there are other valid pointers
-         to it. ASSERT(0,temp->data); free(table->data_size, temp->data);
-      */
-      temp->data = replacement;
-      return;
-    } else {
-      prev = temp;
-    }
+  if(entry) {
+    /* May not want to free the memory in case there are other valid pointers
+       to it. ASSERT(0,temp->data); free(table->data_size, temp->data);
+    */
+    entry->data = replacement;
+    return;
   }
-  table->count++;
-  new_entry = TRUE;
-  new_hash  = (Hash_Table_Entry*)smalloc(sizeof(Hash_Table_Entry));
-  ASSERT(0, new_hash);
-  new_hash->key  = key;
-  new_hash->next = NULL;
-  new_hash->data = replacement;
-
-  if(prev)
-    prev->next = new_hash;
-  else
-    table->entries[index] = new_hash;
-
-  _DEBUGA(0, 0, "smalloc'd %ld bytes for %s (%d entries)\n",
-          (unsigned long int)sizeof(Hash_Table_Entry), table->name,
-          table->count);
+  hash_table_insert(table, key, replacement);
   // }}}
 }
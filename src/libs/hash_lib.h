@@ -35,19 +35,26 @@
 /**************************************************************************************/
 /* Types */
 
+/* Open addressing with linear probing. Keys live inline in the slot array; the
+   data of each entry is carved out of a per-table arena and never moves, so
+   pointers returned by the access functions stay valid until the entry is
+   deleted. */
 typedef struct Hash_Table_Entry_struct {
-  int64                           key;
-  void*                           data;
-  struct Hash_Table_Entry_struct* next;
+  int64 key;
+  void* data;  // NULL if the slot is empty
 } Hash_Table_Entry;
 
 typedef struct Hash_Table_struct {
-  char*              name;
-  uns                buckets;
-  uns                data_size;
-  int                count;  // total number of elements in the hash table
-  Hash_Table_Entry** entries;
+  char*             name;
+  uns               buckets;  // number of slots, a power of two
+  uns               data_size;
+  int               count;  // total number of elements in the hash table
+  Hash_Table_Entry* entries;
   Flag (*eq_func)(void const* const, void const* const);
+
+  char* arena;       // unused part of the current arena chunk
+  uns   arena_left;  // data slots left in the current arena chunk
+  void* free_data;   // deleted data slots, linked through their first word
 } Hash_Table;
 
 
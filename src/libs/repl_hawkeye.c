@@ -0,0 +1,269 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/repl_hawkeye.c
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Hawkeye replacement (Jain and Lin, ISCA 2016). A few sampled
+ *                sets replay their access stream through OPTgen, which decides
+ *                whether Belady's algorithm would have hit on each reuse. The
+ *                answers train a table of counters indexed by the signature of
+ *                the PC (cache->repl_pc, or the memory region when the caller
+ *                gives no PC) that last touched the line. Lines from
+ *                cache-friendly signatures are kept with RRIP-style aging;
+ *                lines from cache-averse ones are inserted for eviction.
+ ***************************************************************************************/
+
+#include <stdlib.h>
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/utils.h"
+
+#include "libs/cache_repl.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define HAWKEYE_MAX_RRPV 7       /* 3-bit RRPVs */
+#define HAWKEYE_PRED_BITS 13     /* predictor entries */
+#define HAWKEYE_PRED_MAX 7       /* 3-bit counters, friendly if >= half */
+#define HAWKEYE_SAMPLED_SETS 64  /* sets tracked by OPTgen */
+#define HAWKEYE_HISTORY_MULT 8   /* OPTgen window, in multiples of assoc */
+#define HAWKEYE_REGION_SHIFT 14  /* region size for signatures without a PC */
+#define HAWKEYE_SIG_MASK N_BIT_MASK(HAWKEYE_PRED_BITS)
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Hawkeye_Line_struct {
+  uns16 sig;   /* signature of the last access */
+  Flag  valid; /* the way holds a line the policy knows about */
+} Hawkeye_Line;
+
+/* An entry of a sampled set's access history */
+typedef struct Hawkeye_Sample_struct {
+  Addr    line_addr;
+  Counter last_time; /* set-local time of the last access */
+  uns16   sig;       /* signature of the last access */
+  Flag    valid;
+} Hawkeye_Sample;
+
+typedef struct Hawkeye_Data_struct {
+  uns8*         rrpv;  /* num_sets * assoc */
+  Hawkeye_Line* lines; /* num_sets * assoc */
+  uns8*         pred;  /* signature -> reuse counter */
+
+  uns             sample_stride; /* every sample_stride-th set is sampled */
+  uns             num_sampled;   /* number of sampled sets */
+  uns             history_len;   /* OPTgen window, in accesses to the set */
+  Counter*        set_time;      /* per sampled set */
+  uns16*          occupancy;     /* per sampled set, history_len slots */
+  Hawkeye_Sample* samples;       /* per sampled set, history_len entries */
+} Hawkeye_Data;
+
+
+/**************************************************************************************/
+/* hawkeye_signature: */
+
+static inline uns16 hawkeye_signature(Cache* cache, Addr line_addr,
+                                      Flag pref) {
+  Addr key = cache->repl_pc ? cache->repl_pc :
+                              line_addr >> HAWKEYE_REGION_SHIFT;
+  Addr sig = key ^ (key >> HAWKEYE_PRED_BITS) ^ (key >> (2 * HAWKEYE_PRED_BITS));
+
+  return (sig ^ (pref ? 1 : 0)) & HAWKEYE_SIG_MASK;
+}
+
+static inline void hawkeye_train(Hawkeye_Data* data, uns16 sig, Flag hit) {
+  if(hit && data->pred[sig] < HAWKEYE_PRED_MAX)
+    data->pred[sig]++;
+  else if(!hit && data->pred[sig] > 0)
+    data->pred[sig]--;
+}
+
+static inline Flag hawkeye_friendly(Hawkeye_Data* data, uns16 sig) {
+  return data->pred[sig] > HAWKEYE_PRED_MAX / 2;
+}
+
+
+/**************************************************************************************/
+/* hawkeye_optgen: Replays an access to a sampled set. OPTgen keeps, for each
+   of the last history_len accesses to the set, how many lines Belady's
+   algorithm would be holding at that point. A reuse would have hit if the
+   cache had room over the whole interval since the previous access, in which
+   case the line occupies that interval. */
+
+static void hawkeye_optgen(Cache* cache, uns set, Addr line_addr, uns16 sig) {
+  Hawkeye_Data*   data    = (Hawkeye_Data*)cache->repl_data;
+  uns             sampled = set / data->sample_stride;
+  uns             len     = data->history_len;
+  uns16*          occ     = &data->occupancy[sampled * len];
+  Hawkeye_Sample* samples = &data->samples[sampled * len];
+  Counter         now     = data->set_time[sampled]++;
+  Hawkeye_Sample* entry   = NULL;
+  Hawkeye_Sample* lru     = &samples[0];
+  uns             ii;
+
+  occ[now % len] = 0;
+
+  for(ii = 0; ii < len; ii++) {
+    Hawkeye_Sample* sample = &samples[ii];
+    if(sample->valid && sample->line_addr == line_addr) {
+      entry = sample;
+      break;
+    }
+    if(!sample->valid || (lru->valid && sample->last_time < lru->last_time))
+      lru = sample;
+  }
+
+  if(entry) {
+    Flag    opt_hit = now - entry->last_time < len;
+    Counter tt;
+    for(tt = entry->last_time; opt_hit && tt < now; tt++) {
+      if(occ[tt % len] >= cache->assoc)
+        opt_hit = FALSE;
+    }
+    if(opt_hit) {
+      for(tt = entry->last_time; tt < now; tt++)
+        occ[tt % len]++;
+    }
+    hawkeye_train(data, entry->sig, opt_hit);
+  } else {
+    entry            = lru;
+    entry->valid     = TRUE;
+    entry->line_addr = line_addr;
+  }
+  entry->last_time = now;
+  entry->sig       = sig;
+}
+
+static inline Flag hawkeye_sampled(Hawkeye_Data* data, uns set) {
+  return set % data->sample_stride == 0;
+}
+
+
+/**************************************************************************************/
+/* hawkeye_update: Common part of fills and hits */
+
+static void hawkeye_update(Cache* cache, uns set, uns way, Addr line_addr,
+                           uns16 sig, Flag fill) {
+  Hawkeye_Data* data = (Hawkeye_Data*)cache->repl_data;
+  uns8*         rrpv = &data->rrpv[set * cache->assoc];
+  uns           ii;
+
+  if(hawkeye_sampled(data, set))
+    hawkeye_optgen(cache, set, line_addr, sig);
+
+  data->lines[set * cache->assoc + way].sig   = sig;
+  data->lines[set * cache->assoc + way].valid = TRUE;
+
+  if(!hawkeye_friendly(data, sig)) {
+    rrpv[way] = HAWKEYE_MAX_RRPV;
+    return;
+  }
+  if(fill) {
+    /* age the other friendly lines, leaving them short of averse */
+    for(ii = 0; ii < cache->assoc; ii++) {
+      if(ii != way && rrpv[ii] < HAWKEYE_MAX_RRPV - 1)
+        rrpv[ii]++;
+    }
+  }
+  rrpv[way] = 0;
+}
+
+
+/**************************************************************************************/
+/* Hooks */
+
+void hawkeye_init(Cache* cache) {
+  Hawkeye_Data* data  = (Hawkeye_Data*)malloc(sizeof(Hawkeye_Data));
+  uns           lines = cache->num_sets * cache->assoc;
+  uns           ii;
+
+  data->rrpv  = (uns8*)malloc(lines);
+  data->lines = (Hawkeye_Line*)calloc(lines, sizeof(Hawkeye_Line));
+  data->pred  = (uns8*)malloc(1 << HAWKEYE_PRED_BITS);
+  for(ii = 0; ii < lines; ii++)
+    data->rrpv[ii] = HAWKEYE_MAX_RRPV;
+  for(ii = 0; ii < (1 << HAWKEYE_PRED_BITS); ii++)
+    data->pred[ii] = (HAWKEYE_PRED_MAX + 1) / 2;
+
+  data->sample_stride = MAX2(cache->num_sets / HAWKEYE_SAMPLED_SETS, 1);
+  data->history_len   = HAWKEYE_HISTORY_MULT * cache->assoc;
+  data->num_sampled   = (cache->num_sets + data->sample_stride - 1) /
+                      data->sample_stride;
+  data->set_time      = (Counter*)calloc(data->num_sampled, sizeof(Counter));
+  data->occupancy     = (uns16*)calloc(data->num_sampled * data->history_len,
+                                   sizeof(uns16));
+  data->samples       = (Hawkeye_Sample*)calloc(
+    data->num_sampled * data->history_len, sizeof(Hawkeye_Sample));
+  cache->repl_data = data;
+}
+
+uns hawkeye_victim(Cache* cache, uns8 proc_id, uns set) {
+  Hawkeye_Data* data = (Hawkeye_Data*)cache->repl_data;
+  return rrip_victim(&data->rrpv[set * cache->assoc], cache->assoc);
+}
+
+void hawkeye_insert(Cache* cache, uns8 proc_id, uns set, uns way,
+                    Addr line_addr, Cache_Insert_Repl pos, Flag pref) {
+  Hawkeye_Data* data = (Hawkeye_Data*)cache->repl_data;
+  Hawkeye_Line* line = &data->lines[set * cache->assoc + way];
+
+  /* evicting a line that was predicted friendly: its signature was wrong */
+  if(line->valid && data->rrpv[set * cache->assoc + way] < HAWKEYE_MAX_RRPV)
+    hawkeye_train(data, line->sig, FALSE);
+
+  hawkeye_update(cache, set, way, line_addr,
+                 hawkeye_signature(cache, line_addr, pref), TRUE);
+  if(pos == INSERT_REPL_LRU)
+    data->rrpv[set * cache->assoc + way] = HAWKEYE_MAX_RRPV;
+}
+
+void hawkeye_hit(Cache* cache, uns set, uns way, Addr line_addr) {
+  hawkeye_update(cache, set, way, line_addr,
+                 hawkeye_signature(cache, line_addr, FALSE), FALSE);
+}
+
+void hawkeye_invalidate(Cache* cache, uns set, uns way) {
+  Hawkeye_Data* data = (Hawkeye_Data*)cache->repl_data;
+
+  data->lines[set * cache->assoc + way].valid = FALSE;
+  data->rrpv[set * cache->assoc + way]        = HAWKEYE_MAX_RRPV;
+}
+
+void hawkeye_ckpt(Cache* cache, Ckpt* ckpt) {
+  Hawkeye_Data* data    = (Hawkeye_Data*)cache->repl_data;
+  uns           lines   = cache->num_sets * cache->assoc;
+  uns           history = data->num_sampled * data->history_len;
+
+  ckpt_region(ckpt, "hawkeye rrpv", data->rrpv, lines);
+  ckpt_region(ckpt, "hawkeye lines", data->lines, lines * sizeof(Hawkeye_Line));
+  ckpt_region(ckpt, "hawkeye pred", data->pred, 1 << HAWKEYE_PRED_BITS);
+  ckpt_region(ckpt, "hawkeye set_time", data->set_time,
+              data->num_sampled * sizeof(Counter));
+  ckpt_region(ckpt, "hawkeye occupancy", data->occupancy,
+              history * sizeof(uns16));
+  ckpt_region(ckpt, "hawkeye samples", data->samples,
+              history * sizeof(Hawkeye_Sample));
+}
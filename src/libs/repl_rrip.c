@@ -0,0 +1,219 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/repl_rrip.c
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Re-reference interval prediction replacement (Jaleel et al.,
+ *                ISCA 2010): static (SRRIP-HP), bimodal (BRRIP) and dynamic
+ *                (DRRIP, set dueling between the two).
+ ***************************************************************************************/
+
+#include <stdlib.h>
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/utils.h"
+
+#include "libs/cache_repl.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define RRIP_MAX_RRPV 3        /* 2-bit RRPVs */
+#define BRRIP_LONG_INTERVAL 32 /* one in this many BRRIP fills is not distant */
+#define DRRIP_PSEL_MAX 1023    /* 10-bit policy selector */
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Rrip_Mode_enum {
+  RRIP_STATIC,
+  RRIP_BIMODAL,
+  RRIP_DYNAMIC,
+} Rrip_Mode;
+
+typedef struct Rrip_Data_struct {
+  Rrip_Mode mode;
+  uns8*     rrpv;      /* num_sets * assoc, sets are row major */
+  uns       fill_ctr;  /* throttles BRRIP's non-distant fills */
+  uns       psel;      /* DRRIP: above half means BRRIP is winning */
+} Rrip_Data;
+
+
+/**************************************************************************************/
+/* rrip_init: */
+
+static void rrip_init(Cache* cache, Rrip_Mode mode) {
+  Rrip_Data* data = (Rrip_Data*)malloc(sizeof(Rrip_Data));
+  uns        ii;
+
+  data->mode     = mode;
+  data->rrpv     = (uns8*)malloc(cache->num_sets * cache->assoc);
+  data->fill_ctr = 0;
+  data->psel     = (DRRIP_PSEL_MAX + 1) / 2;
+  for(ii = 0; ii < cache->num_sets * cache->assoc; ii++)
+    data->rrpv[ii] = RRIP_MAX_RRPV;
+  cache->repl_data = data;
+}
+
+void srrip_init(Cache* cache) {
+  rrip_init(cache, RRIP_STATIC);
+}
+
+void brrip_init(Cache* cache) {
+  rrip_init(cache, RRIP_BIMODAL);
+}
+
+void drrip_init(Cache* cache) {
+  rrip_init(cache, RRIP_DYNAMIC);
+}
+
+
+/**************************************************************************************/
+/* drrip_leader: DRRIP dedicates 32 of every 1024 sets to each of SRRIP and
+   BRRIP (complement select). Returns the policy the set is fixed to, or
+   RRIP_DYNAMIC for follower sets. */
+
+static inline Rrip_Mode drrip_leader(uns set) {
+  uns lo = set & 0x1f;
+  uns hi = (set >> 5) & 0x1f;
+
+  if(lo == hi)
+    return RRIP_STATIC;
+  if(lo == (~hi & 0x1f))
+    return RRIP_BIMODAL;
+  return RRIP_DYNAMIC;
+}
+
+
+/**************************************************************************************/
+/* rrip_insert: */
+
+static void rrip_insert(Cache* cache, uns set, uns way, Cache_Insert_Repl pos) {
+  Rrip_Data* data = (Rrip_Data*)cache->repl_data;
+  uns8*      rrpv = &data->rrpv[set * cache->assoc];
+  Rrip_Mode  mode = data->mode;
+
+  rrip_age(rrpv, cache->assoc, RRIP_MAX_RRPV);
+
+  if(mode == RRIP_DYNAMIC) {
+    /* a fill is a miss: leader sets vote against their own policy */
+    mode = drrip_leader(set);
+    if(mode == RRIP_STATIC && data->psel < DRRIP_PSEL_MAX)
+      data->psel++;
+    else if(mode == RRIP_BIMODAL && data->psel > 0)
+      data->psel--;
+    if(mode == RRIP_DYNAMIC)
+      mode = data->psel > DRRIP_PSEL_MAX / 2 ? RRIP_BIMODAL : RRIP_STATIC;
+  }
+
+  if(pos == INSERT_REPL_LRU)
+    rrpv[way] = RRIP_MAX_RRPV;
+  else if(pos == INSERT_REPL_MRU)
+    rrpv[way] = 0;
+  else if(mode == RRIP_BIMODAL &&
+          ++data->fill_ctr % BRRIP_LONG_INTERVAL != 0)
+    rrpv[way] = RRIP_MAX_RRPV;
+  else
+    rrpv[way] = RRIP_MAX_RRPV - 1;
+}
+
+void srrip_insert(Cache* cache, uns8 proc_id, uns set, uns way, Addr line_addr,
+                  Cache_Insert_Repl pos, Flag pref) {
+  rrip_insert(cache, set, way, pos);
+}
+
+void brrip_insert(Cache* cache, uns8 proc_id, uns set, uns way, Addr line_addr,
+                  Cache_Insert_Repl pos, Flag pref) {
+  rrip_insert(cache, set, way, pos);
+}
+
+void drrip_insert(Cache* cache, uns8 proc_id, uns set, uns way, Addr line_addr,
+                  Cache_Insert_Repl pos, Flag pref) {
+  rrip_insert(cache, set, way, pos);
+}
+
+
+/**************************************************************************************/
+/* Victim selection, hits and invalidations are the same for all three */
+
+static uns rrip_victim_way(Cache* cache, uns set) {
+  Rrip_Data* data = (Rrip_Data*)cache->repl_data;
+  return rrip_victim(&data->rrpv[set * cache->assoc], cache->assoc);
+}
+
+static void rrip_set_rrpv(Cache* cache, uns set, uns way, uns8 value) {
+  Rrip_Data* data = (Rrip_Data*)cache->repl_data;
+  data->rrpv[set * cache->assoc + way] = value;
+}
+
+uns srrip_victim(Cache* cache, uns8 proc_id, uns set) {
+  return rrip_victim_way(cache, set);
+}
+
+uns brrip_victim(Cache* cache, uns8 proc_id, uns set) {
+  return rrip_victim_way(cache, set);
+}
+
+uns drrip_victim(Cache* cache, uns8 proc_id, uns set) {
+  return rrip_victim_way(cache, set);
+}
+
+void srrip_hit(Cache* cache, uns set, uns way, Addr line_addr) {
+  rrip_set_rrpv(cache, set, way, 0);
+}
+
+void brrip_hit(Cache* cache, uns set, uns way, Addr line_addr) {
+  rrip_set_rrpv(cache, set, way, 0);
+}
+
+void drrip_hit(Cache* cache, uns set, uns way, Addr line_addr) {
+  rrip_set_rrpv(cache, set, way, 0);
+}
+
+void srrip_invalidate(Cache* cache, uns set, uns way) {
+  rrip_set_rrpv(cache, set, way, RRIP_MAX_RRPV);
+}
+
+void brrip_invalidate(Cache* cache, uns set, uns way) {
+  rrip_set_rrpv(cache, set, way, RRIP_MAX_RRPV);
+}
+
+void drrip_invalidate(Cache* cache, uns set, uns way) {
+  rrip_set_rrpv(cache, set, way, RRIP_MAX_RRPV);
+}
+
+void srrip_ckpt(Cache* cache, Ckpt* ckpt) {
+  Rrip_Data* data = (Rrip_Data*)cache->repl_data;
+  ckpt_region(ckpt, "rrip rrpv", data->rrpv, cache->num_sets * cache->assoc);
+  ckpt_region(ckpt, "rrip fill_ctr", &data->fill_ctr, sizeof(data->fill_ctr));
+  ckpt_region(ckpt, "rrip psel", &data->psel, sizeof(data->psel));
+}
+
+void brrip_ckpt(Cache* cache, Ckpt* ckpt) {
+  srrip_ckpt(cache, ckpt);
+}
+
+void drrip_ckpt(Cache* cache, Ckpt* ckpt) {
+  srrip_ckpt(cache, ckpt);
+}
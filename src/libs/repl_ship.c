@@ -0,0 +1,151 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/repl_ship.c
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Signature-based hit prediction replacement (SHiP, Wu et al.,
+ *                MICRO 2011) on top of SRRIP. Lines are tagged with a signature
+ *                of the PC that filled them (cache->repl_pc), or of their memory
+ *                region when the caller gives no PC. A table of counters learns
+ *                which signatures see reuse; fills from signatures that never
+ *                do are inserted with a distant re-reference prediction.
+ ***************************************************************************************/
+
+#include <stdlib.h>
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/utils.h"
+
+#include "libs/cache_repl.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define SHIP_MAX_RRPV 3          /* 2-bit RRPVs */
+#define SHIP_SHCT_BITS 14        /* signature history counter table entries */
+#define SHIP_SHCT_MAX 7          /* 3-bit counters */
+#define SHIP_REGION_SHIFT 14     /* region size for signatures without a PC */
+#define SHIP_SIG_MASK N_BIT_MASK(SHIP_SHCT_BITS)
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Ship_Line_struct {
+  uns16 sig;    /* signature of the fill */
+  Flag  valid;  /* the way holds a line the policy knows about */
+  Flag  reused; /* the line was hit since its fill */
+} Ship_Line;
+
+typedef struct Ship_Data_struct {
+  uns8*      rrpv;  /* num_sets * assoc */
+  Ship_Line* lines; /* num_sets * assoc */
+  uns8*      shct;  /* signature history counter table */
+} Ship_Data;
+
+
+/**************************************************************************************/
+/* ship_signature: */
+
+static inline uns16 ship_signature(Cache* cache, Addr line_addr, Flag pref) {
+  Addr key = cache->repl_pc ? cache->repl_pc : line_addr >> SHIP_REGION_SHIFT;
+  Addr sig = key ^ (key >> SHIP_SHCT_BITS) ^ (key >> (2 * SHIP_SHCT_BITS));
+
+  /* keep prefetch fills from training the demand signature of the same PC */
+  return (sig ^ (pref ? 1 : 0)) & SHIP_SIG_MASK;
+}
+
+
+/**************************************************************************************/
+/* Hooks */
+
+void ship_init(Cache* cache) {
+  Ship_Data* data  = (Ship_Data*)malloc(sizeof(Ship_Data));
+  uns        lines = cache->num_sets * cache->assoc;
+  uns        ii;
+
+  data->rrpv  = (uns8*)malloc(lines);
+  data->lines = (Ship_Line*)calloc(lines, sizeof(Ship_Line));
+  data->shct  = (uns8*)malloc(1 << SHIP_SHCT_BITS);
+  for(ii = 0; ii < lines; ii++)
+    data->rrpv[ii] = SHIP_MAX_RRPV;
+  /* start weakly in favor of reuse so that new signatures get a chance */
+  for(ii = 0; ii < (1 << SHIP_SHCT_BITS); ii++)
+    data->shct[ii] = 1;
+  cache->repl_data = data;
+}
+
+uns ship_victim(Cache* cache, uns8 proc_id, uns set) {
+  Ship_Data* data = (Ship_Data*)cache->repl_data;
+  return rrip_victim(&data->rrpv[set * cache->assoc], cache->assoc);
+}
+
+void ship_insert(Cache* cache, uns8 proc_id, uns set, uns way, Addr line_addr,
+                 Cache_Insert_Repl pos, Flag pref) {
+  Ship_Data* data = (Ship_Data*)cache->repl_data;
+  uns8*      rrpv = &data->rrpv[set * cache->assoc];
+  Ship_Line* line = &data->lines[set * cache->assoc + way];
+
+  /* the previous occupant is evicted without reuse: its signature is dead */
+  if(line->valid && !line->reused && data->shct[line->sig] > 0)
+    data->shct[line->sig]--;
+
+  rrip_age(rrpv, cache->assoc, SHIP_MAX_RRPV);
+
+  line->sig    = ship_signature(cache, line_addr, pref);
+  line->valid  = TRUE;
+  line->reused = FALSE;
+
+  if(pos == INSERT_REPL_LRU || data->shct[line->sig] == 0)
+    rrpv[way] = SHIP_MAX_RRPV;
+  else if(pos == INSERT_REPL_MRU)
+    rrpv[way] = 0;
+  else
+    rrpv[way] = SHIP_MAX_RRPV - 1;
+}
+
+void ship_hit(Cache* cache, uns set, uns way, Addr line_addr) {
+  Ship_Data* data = (Ship_Data*)cache->repl_data;
+  Ship_Line* line = &data->lines[set * cache->assoc + way];
+
+  if(line->valid && data->shct[line->sig] < SHIP_SHCT_MAX)
+    data->shct[line->sig]++;
+  line->reused                         = TRUE;
+  data->rrpv[set * cache->assoc + way] = 0;
+}
+
+void ship_invalidate(Cache* cache, uns set, uns way) {
+  Ship_Data* data = (Ship_Data*)cache->repl_data;
+
+  data->lines[set * cache->assoc + way].valid = FALSE;
+  data->rrpv[set * cache->assoc + way]        = SHIP_MAX_RRPV;
+}
+
+void ship_ckpt(Cache* cache, Ckpt* ckpt) {
+  Ship_Data* data  = (Ship_Data*)cache->repl_data;
+  uns        lines = cache->num_sets * cache->assoc;
+
+  ckpt_region(ckpt, "ship rrpv", data->rrpv, lines);
+  ckpt_region(ckpt, "ship lines", data->lines, lines * sizeof(Ship_Line));
+  ckpt_region(ckpt, "ship shct", data->shct, 1 << SHIP_SHCT_BITS);
+}
@@ -209,6 +209,26 @@ void update_map_stage(Stage_Data* src_sd) {
 }
 
 
+/**************************************************************************************/
+/* map_stage_next_event: Returns cycle_count if an op can move between the
+   map latches this cycle and MAX_CTR otherwise. With every latch either
+   stalled or empty, update_map_stage only swaps empty latches. */
+
+Counter map_stage_next_event(Stage_Data* src_sd) {
+  uns ii;
+
+  for(ii = 0; ii < STAGE_MAX_DEPTH - 1; ii++) {
+    if(map->sds[ii].op_count == 0 && map->sds[ii + 1].op_count > 0)
+      return cycle_count;
+  }
+
+  if(map->sds[STAGE_MAX_DEPTH - 1].op_count == 0 && src_sd->op_count > 0)
+    return cycle_count;
+
+  return MAX_CTR;
+}
+
+
 /**************************************************************************************/
 /* map_process_op: */
 
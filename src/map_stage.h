@@ -61,6 +61,8 @@ void recover_map_stage(void);
 void debug_map_stage(void);
 void update_map_stage(Stage_Data*);
 
+Counter map_stage_next_event(Stage_Data*);
+
 
 /**************************************************************************************/
 
@@ -52,13 +52,14 @@
 typedef struct Proc_Info_struct {
   Cache   shadow_cache;
   double* miss_rates;  // indexed by number of ways - 1
+  double* costs;       // cost of a partition, indexed by allocated units
+  double* perfs;       // predicted performance (gmean perf), same indexing
 } Proc_Info;
 
 typedef struct Shadow_Cache_Data_struct {
   Flag prefetched;
 } Shadow_Cache_Data;
 
-typedef double (*Metric_Func)(uns*);
 typedef void (*Search_Func)(void);
 
 /**************************************************************************************/
@@ -69,12 +70,16 @@ Trigger*   l1_part_start;  // indicates the L1 partition has been enabled
 Trigger* l1_part_trigger;  // external trigger for trigger repart (should not be
                            // set too often)
 Stat_Mon*   stat_mon;
-Metric_Func metric_func;
 Search_Func search_func;
-uns*        current_partition;  // actual enforced partition
+uns*        current_partition;  // actual enforced partition, in units
 uns*        new_partition;      // pre-allocated structure for new partition
-uns* temp_partition;  // pre-allocated structure for partition exploration
 uns  tie_breaker_proc_id;
+uns  total_units;         // L1_ASSOC * L1_PART_WAY_GRAIN
+uns  min_units;           // one way
+uns  max_units;           // all ways but one for every other core
+uns  shadow_sample_bits;  // set index bits dropped from shadow cache addresses
+double* opt_costs;    // [NUM_CORES + 1][total_units + 1], see search_bruteforce
+uns*    opt_choices;  // [NUM_CORES][total_units + 1], see search_bruteforce
 
 /**************************************************************************************/
 /* Enums */
@@ -86,12 +91,14 @@ DEFINE_ENUM(Cache_Part_Search, CACHE_PART_SEARCH_LIST);
 /* Local Prototypes */
 
 static Flag   in_shadow_cache(Addr addr);
-static double get_global_miss_rate(uns* partition);
-static double get_miss_rate_sum(uns* partition);
-static double get_gmean_perf(uns* partition);
+static Addr   shadow_cache_addr(Addr addr);
+static double get_miss_rate(Proc_Info* proc_info, uns units);
+static double get_partition_cost(uns* partition);
 static double get_best_marginal_utility(uns* partition, uns proc_id,
-                                        uns balance, uns* extra_ways);
+                                        uns balance, uns* extra_units);
+static double get_gmean_perf(uns* partition);
 static void   measure_miss_curves(void);
+static void   compute_costs(void);
 static void   search_lookahead(void);
 static void   search_bruteforce(void);
 static void   set_partition(void);
@@ -110,6 +117,21 @@ void cache_part_init(void) {
   ASSERTM(0, !PRIVATE_L1, "Cache partitioning works only on shared cache.\n");
   ASSERT(0, L1_CACHE_REPL_POLICY == REPL_PARTITION);
   ASSERT(0, L1_ASSOC <= 128);
+  ASSERT(0, L1_PART_WAY_GRAIN >= 1 &&
+              (L1_SIZE / L1_LINE_SIZE / L1_ASSOC) % L1_PART_WAY_GRAIN == 0);
+
+  total_units = L1_ASSOC * L1_PART_WAY_GRAIN;
+  min_units   = L1_PART_WAY_GRAIN;
+  max_units   = total_units - (NUM_CORES - 1) * min_units;
+
+  /* The shadow caches only see the sampled sets. With a power-of-two modulo
+     those are packed into a shadow cache that is smaller by the modulo. */
+  uns num_sets       = L1_SIZE / L1_LINE_SIZE / L1_ASSOC;
+  shadow_sample_bits = 0;
+  if(L1_SHADOW_TAGS_MODULO > 1 &&
+     (L1_SHADOW_TAGS_MODULO & (L1_SHADOW_TAGS_MODULO - 1)) == 0 &&
+     L1_SHADOW_TAGS_MODULO <= num_sets)
+    shadow_sample_bits = LOG2(L1_SHADOW_TAGS_MODULO);
 
   // create shadow cache for each core
   proc_infos = calloc(NUM_CORES, sizeof(Proc_Info));
@@ -117,9 +139,11 @@ void cache_part_init(void) {
     Proc_Info* proc_info = &proc_infos[proc_id];
     char       buf[MAX_STR_LENGTH + 1];
     sprintf(buf, "SHADOW L1[%d]", proc_id);
-    init_cache(&proc_info->shadow_cache, buf, L1_SIZE, L1_ASSOC, L1_LINE_SIZE,
-               sizeof(Shadow_Cache_Data), REPL_TRUE_LRU);
+    init_cache(&proc_info->shadow_cache, buf, L1_SIZE >> shadow_sample_bits,
+               L1_ASSOC, L1_LINE_SIZE, sizeof(L1_Data), REPL_TRUE_LRU);
     proc_info->miss_rates = calloc(L1_ASSOC, sizeof(double));
+    proc_info->costs      = calloc(total_units + 1, sizeof(double));
+    proc_info->perfs      = calloc(total_units + 1, sizeof(double));
   }
 
   l1_part_trigger = trigger_create("L1 PART TRIGGER", L1_PART_TRIGGER,
@@ -395,13 +419,8 @@ void cache_part_init(void) {
 
   switch(L1_PART_METRIC) {
     case CACHE_PART_METRIC_GLOBAL_MISS_RATE:
-      metric_func = &get_global_miss_rate;
-      break;
     case CACHE_PART_METRIC_MISS_RATE_SUM:
-      metric_func = &get_miss_rate_sum;
-      break;
     case CACHE_PART_METRIC_GMEAN_PERF:
-      metric_func = &get_gmean_perf;
       break;
     default:
       FATAL_ERROR(0, "Unknown metric %s\n",
@@ -425,14 +444,15 @@ void cache_part_init(void) {
   current_partition = calloc(NUM_CORES, sizeof(uns));
   ASSERT(0, L1_ASSOC % NUM_CORES == 0);
   for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    current_partition[proc_id] = L1_ASSOC / NUM_CORES;
+    current_partition[proc_id] = total_units / NUM_CORES;
     set_partition_allocate(&mem->uncores[0].l1->cache, proc_id,
-                           current_partition[proc_id]);
-    GET_STAT_EVENT(proc_id, NORESET_L1_PARTITION) = current_partition[proc_id];
+                           L1_ASSOC / NUM_CORES);
+    SET_STAT_EVENT(proc_id, NORESET_L1_PARTITION, L1_ASSOC / NUM_CORES);
   }
   new_partition       = calloc(NUM_CORES, sizeof(uns));
-  temp_partition      = calloc(NUM_CORES, sizeof(uns));
   tie_breaker_proc_id = 0;
+  opt_costs   = malloc((NUM_CORES + 1) * (total_units + 1) * sizeof(double));
+  opt_choices = malloc(NUM_CORES * (total_units + 1) * sizeof(uns));
 }
 
 
@@ -455,15 +475,16 @@ void cache_part_l1_access(Mem_Req* req) {
     return;
 
   Proc_Info* proc_info = &proc_infos[req->proc_id];
+  Addr       addr      = shadow_cache_addr(req->addr);
   Addr       dummy_line_addr;
   int  pos = cache_find_pos_in_lru_stack(&proc_info->shadow_cache, req->proc_id,
-                                        req->addr, &dummy_line_addr);
+                                        addr, &dummy_line_addr);
   Flag miss         = (pos == -1);
   Flag untimely_hit = FALSE;
   Flag stalling     = mem_req_type_is_stalling(req->type);
   Flag demand       = mem_req_type_is_demand(req->type);
   if(!miss && L1_PART_FILL_DELAY) {
-    L1_Data* data = (L1_Data*)cache_access(&proc_info->shadow_cache, req->addr,
+    L1_Data* data = (L1_Data*)cache_access(&proc_info->shadow_cache, addr,
                                            &dummy_line_addr, FALSE);
     ASSERT(req->proc_id, data);
     untimely_hit = data->fetch_cycle > freq_cycle_count(FREQ_DOMAIN_L1);
@@ -493,12 +514,12 @@ void cache_part_l1_access(Mem_Req* req) {
   // update shadow tag
   if(miss) {
     L1_Data* data     = cache_insert(&proc_info->shadow_cache, req->proc_id,
-                                 req->addr, &dummy_line_addr, &dummy_line_addr);
+                                 addr, &dummy_line_addr, &dummy_line_addr);
     data->fetch_cycle = freq_cycle_count(FREQ_DOMAIN_L1) +
                         (stalling || req->type == MRT_WB ? 0 :
                                                            L1_PART_FILL_DELAY);
   } else {
-    cache_access(&proc_info->shadow_cache, req->addr, &dummy_line_addr, TRUE);
+    cache_access(&proc_info->shadow_cache, addr, &dummy_line_addr, TRUE);
   }
 }
 
@@ -506,8 +527,12 @@ void cache_part_l1_access(Mem_Req* req) {
 /* cache_part_l1_warmup: */
 
 void cache_part_l1_warmup(uns proc_id, Addr addr) {
+  if(!in_shadow_cache(addr))
+    return;
+
   Proc_Info* proc_info = &proc_infos[proc_id];
   Addr       dummy_line_addr;
+  addr = shadow_cache_addr(addr);
   L1_Data*   data = (L1_Data*)cache_access(&proc_info->shadow_cache, addr,
                                          &dummy_line_addr, TRUE);
   if(!data) {
@@ -541,6 +566,7 @@ void cache_part_update(void) {
   DEBUG(0, "Cache partition triggered\n");
   if(trigger_on(l1_part_start)) {
     measure_miss_curves();
+    compute_costs();
     set_partition();
   }
 
@@ -556,11 +582,22 @@ void cache_part_update(void) {
 
 Flag in_shadow_cache(Addr addr) {
   Addr dummy_addr;
-  uns  set = ext_cache_index(&proc_infos[0].shadow_cache, addr, &dummy_addr,
+  uns  set = ext_cache_index(&mem->uncores[0].l1->cache, addr, &dummy_addr,
                             &dummy_addr);
   return set % L1_SHADOW_TAGS_MODULO == 0;
 }
 
+/**************************************************************************************/
+/* Address of a sampled line in the shadow caches: the set index bits that are
+   zero in every sampled set are dropped, so that sampled set s of the L1 maps
+   to set s / L1_SHADOW_TAGS_MODULO of the smaller shadow cache. */
+
+Addr shadow_cache_addr(Addr addr) {
+  uns line_bits = LOG2(L1_LINE_SIZE);
+  return (addr >> (line_bits + shadow_sample_bits) << line_bits) |
+         (addr & N_BIT_MASK(line_bits));
+}
+
 /**************************************************************************************/
 /* Measure miss curves from monitored statistics */
 
@@ -584,139 +621,252 @@ void measure_miss_curves(void) {
   }
 }
 
+/**************************************************************************************/
+/* Miss rate of a core given a partition of the specified number of units. A
+ * core with a fractional number of ways only gets the extra way in a fraction
+ * of the sets, so its miss rate is interpolated between the two neighboring
+ * points of the miss curve. */
+
+double get_miss_rate(Proc_Info* proc_info, uns units) {
+  uns    ways = units / L1_PART_WAY_GRAIN;
+  uns    frac = units % L1_PART_WAY_GRAIN;
+  double lo   = proc_info->miss_rates[MIN2(ways, L1_ASSOC - 1)];
+  double hi   = proc_info->miss_rates[MIN2(ways + 1, L1_ASSOC - 1)];
+  return lo + (hi - lo) * (double)frac / (double)L1_PART_WAY_GRAIN;
+}
+
+/**************************************************************************************/
+/* Fill in the per-core cost tables for the partition metric. All metrics are
+ * made additive across cores so that the searches only do table lookups:
+ *  - global miss rate: misses of each core
+ *  - miss rate sum:    miss rate of each core
+ *  - gmean perf:       negative log of the predicted performance of each core
+ *                      (minimizing the sum maximizes the product). The
+ *                      predicted performances are kept for the lookahead. */
+
+void compute_costs(void) {
+  uns access_stat = L1_PART_USE_STALLING ? L1_SHADOW_ACCESS_STALLING :
+                                           L1_SHADOW_ACCESS_DEMAND;
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Proc_Info* proc_info = &proc_infos[proc_id];
+    double     accesses = (double)stat_mon_get_count(stat_mon, proc_id,
+                                                 access_stat);
+    double     stall_frac = (double)stat_mon_get_count(stat_mon, proc_id,
+                                                   RET_BLOCKED_L1_MISS) /
+                        (double)stat_mon_get_count(stat_mon, proc_id,
+                                                   NODE_CYCLE);
+    double miss_rate0 = get_miss_rate(proc_info, current_partition[proc_id]);
+
+    for(uns units = min_units; units <= max_units; units++) {
+      double miss_rate = get_miss_rate(proc_info, units);
+      double cost;
+      switch(L1_PART_METRIC) {
+        case CACHE_PART_METRIC_GLOBAL_MISS_RATE:
+          cost = miss_rate * accesses;
+          break;
+        case CACHE_PART_METRIC_MISS_RATE_SUM:
+          cost = miss_rate;
+          break;
+        case CACHE_PART_METRIC_GMEAN_PERF: {
+          /* Assuming constant stall time per miss and constant compute time
+             per access:
+
+                stall time    misses      compute time       time
+                ---------- x --------  +  ------------  =  --------
+                  misses     accesses       accesses       accesses
+
+                stall time   miss rate    compute time       time
+                 per miss                   per miss      per access
+
+                 CONSTANT    VARIABLE       CONSTANT       VARIABLE
+
+             From this model, we can derive that normalized performance
+             given a new vs old miss rate is the *reciprocal* of:
+
+                     / new miss rate     \
+                 1 + | ------------- - 1 | x stall frac
+                     \ old miss rate     /
+          */
+          double pred_perf;
+          if(miss_rate0 == 0.0 || stall_frac == 0.0) {
+            // in case of zero misses or stall time make the smallest
+            // partition most attractive
+            pred_perf = units == min_units ? 1.0 : 0.0;
+          } else {
+            pred_perf = 1.0 / (1.0 + (miss_rate / miss_rate0 - 1) * stall_frac);
+          }
+          proc_info->perfs[units] = pred_perf;
+          cost = -log(MAX2(pred_perf, 1.0e-30));
+          break;
+        }
+        default:
+          FATAL_ERROR(0, "Unknown metric %s\n",
+                      Cache_Part_Metric_str(L1_PART_METRIC));
+          break;
+      }
+      proc_info->costs[units] = cost;
+    }
+  }
+}
+
+/**************************************************************************************/
+/* Metric of a whole partition (lower is better) */
+
+double get_partition_cost(uns* partition) {
+  double sum = 0.0;
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    sum += proc_infos[proc_id].costs[partition[proc_id]];
+  }
+  return sum;
+}
+
 /**************************************************************************************/
 /* Find best marginal utility using lookahead method (Algorithm 2) of Moin's
- * paper.
+ * paper. For gmean perf, the utility is taken on the product of the predicted
+ * performances rather than on the additive log costs: the lookahead is greedy,
+ * and its choices depend on which of the two it compares.
  * Qureshi, Moinuddin K., and Yale N. Patt. "Utility-based cache partitioning:
  * A low-overhead, high-performance, runtime mechanism to partition shared
  * caches." 2006 39th Annual IEEE/ACM International Symposium on
  * Microarchitecture (MICRO'06). IEEE, 2006.  */
 
 double get_best_marginal_utility(uns* partition, uns proc_id, uns balance,
-                                 uns* extra_ways) {
-  uns old_ways = partition[proc_id];
-  uns max_ways = old_ways + balance;
-  ASSERT(0, max_ways <= L1_ASSOC);
-  double cur_metric = metric_func(partition);
-  double best_mu    = 0.0;
-  uns    best_ways  = old_ways;
-  for(uns ways = old_ways + 1; ways <= max_ways; ways++) {
-    partition[proc_id] = ways;
-    double new_metric  = metric_func(partition);
-    double mu          = (new_metric - cur_metric) / (double)(ways - old_ways);
+                                 uns* extra_units) {
+  uns old_units = partition[proc_id];
+  uns last_units = old_units + balance;
+  ASSERT(0, last_units <= total_units);
+  double* costs      = proc_infos[proc_id].costs;
+  double  cur_perf   = L1_PART_METRIC == CACHE_PART_METRIC_GMEAN_PERF ?
+                         get_gmean_perf(partition) :
+                         0.0;
+  double  best_mu    = 0.0;
+  uns     best_units = old_units;
+  for(uns units = old_units + 1; units <= last_units; units++) {
+    double mu;
+    if(L1_PART_METRIC == CACHE_PART_METRIC_GMEAN_PERF) {
+      partition[proc_id] = units;
+      mu = (get_gmean_perf(partition) - cur_perf) / (double)(units - old_units);
+    } else {
+      mu = (costs[units] - costs[old_units]) / (double)(units - old_units);
+    }
     if(mu < best_mu) {
-      best_mu   = mu;
-      best_ways = ways;
+      best_mu    = mu;
+      best_units = units;
     }
   }
-  partition[proc_id] = old_ways;
-  *extra_ways        = best_ways - old_ways;
+  partition[proc_id] = old_units;
+  *extra_units       = best_units - old_units;
   return best_mu;
 }
 
 /**************************************************************************************/
-/* Use brute force method to estimate best partition */
+/* Negative product of the predicted performances of the cores (negative
+ * because the lookahead minimizes) */
 
-void search_bruteforce(void) {
-  uns* partition = new_partition;
-  Flag done      = FALSE;
+double get_gmean_perf(uns* partition) {
+  double product = 1.0;
   for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    partition[proc_id] = 1;
+    product *= proc_infos[proc_id].perfs[partition[proc_id]];
   }
-  if(NUM_CORES == L1_ASSOC)
-    return;
-  double best_metric    = 1.0e99;
-  uns*   best_partition = temp_partition;
-  while(!done) {
-    /* make sure partition is correct */
-    uns sum = 0;
-    for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      sum += partition[proc_id];
-    }
-    ASSERT(0, sum <= L1_ASSOC);
-    partition[NUM_CORES - 1] += L1_ASSOC - sum;
-
-    /* check the metric for the partition */
-    double metric = metric_func(partition);
-    if(ENABLE_GLOBAL_DEBUG_PRINT && DEBUG_RANGE_COND(0)) {
-      char  buf[MAX_STR_LENGTH + 1];
-      char* ptr = buf;
-      ptr += sprintf(buf, "{");
-      for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-        ptr += sprintf(ptr, " %d", partition[proc_id]);
+  return -product;
+}
+
+/**************************************************************************************/
+/* Find the partition with the best metric. Since the cost of a partition is a
+ * sum of per-core costs, the optimum is found by dynamic programming over
+ * (cores, units) instead of enumerating all partitions:
+ *
+ *   opt_costs[p][u] = best cost of giving u units to cores p..NUM_CORES-1 */
+
+void search_bruteforce(void) {
+  uns     stride = total_units + 1;
+  double* opt    = opt_costs;
+  uns*    choice = opt_choices;
+
+  for(uns units = 0; units <= total_units; units++) {
+    opt[NUM_CORES * stride + units] = units == 0 ? 0.0 : 1.0e99;
+  }
+  for(int proc_id = NUM_CORES - 1; proc_id >= 0; proc_id--) {
+    double* costs = proc_infos[proc_id].costs;
+    for(uns units = 0; units <= total_units; units++) {
+      double best_cost  = 1.0e99;
+      uns    best_units = 0;
+      for(uns mine = min_units; mine <= MIN2(units, max_units); mine++) {
+        double rest = opt[(proc_id + 1) * stride + units - mine];
+        if(rest == 1.0e99)
+          continue;
+        double cost = costs[mine] + rest;
+        if(cost < best_cost) {
+          best_cost  = cost;
+          best_units = mine;
+        }
       }
-      ptr += sprintf(ptr, "}: %.4f\n", metric);
-      DPRINTF("%s", buf);
-    }
-    if(metric < best_metric) {
-      best_metric = metric;
-      memcpy(best_partition, partition, NUM_CORES * sizeof(uns));
+      opt[proc_id * stride + units]    = best_cost;
+      choice[proc_id * stride + units] = best_units;
     }
+  }
+  ASSERT(0, opt[total_units] != 1.0e99);
 
-    /* generate next partition */
-    uns proc_id;
-    for(proc_id = NUM_CORES - 1; proc_id > 0; proc_id--) {
-      if(partition[proc_id] != 1)
-        break;
-    }
-    if(proc_id == 0) {
-      done = TRUE;
-    } else {
-      partition[proc_id] = 1;
-      partition[proc_id - 1]++;
-    }
+  uns units = total_units;
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    new_partition[proc_id] = choice[proc_id * stride + units];
+    units -= new_partition[proc_id];
   }
-  memcpy(partition, best_partition, NUM_CORES * sizeof(uns));
-  ASSERT(0, best_metric != 1.0e99);
+  ASSERT(0, units == 0);
 }
 
 /**************************************************************************************/
 /* Use lookahead method to estimate best partition */
 
 void search_lookahead(void) {
-  uns* partition            = new_partition;
-  uns  total_ways_allocated = 0;
+  uns* partition             = new_partition;
+  uns  total_units_allocated = 0;
   for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    partition[proc_id] = 1;
-    total_ways_allocated++;
+    partition[proc_id] = min_units;
+    total_units_allocated += min_units;
   }
 
-  while(total_ways_allocated < L1_ASSOC) {
-    uns    balance         = L1_ASSOC - total_ways_allocated;
-    double best_mu         = 1.0e99;
-    uns    best_proc_id    = NUM_CORES;
-    uns    best_extra_ways = 0;
+  while(total_units_allocated < total_units) {
+    uns    balance          = total_units - total_units_allocated;
+    double best_mu          = 1.0e99;
+    uns    best_proc_id     = NUM_CORES;
+    uns    best_extra_units = 0;
     DEBUG(0, "Balance %d\n", balance);
     for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      uns    extra_ways;
+      uns    extra_units;
       double mu = get_best_marginal_utility(partition, proc_id, balance,
-                                            &extra_ways);
-      DEBUG(0, "Marginal util of core %d: %.4f (%d ways)\n", proc_id, mu,
-            extra_ways);
+                                            &extra_units);
+      DEBUG(0, "Marginal util of core %d: %.4f (%d units)\n", proc_id, mu,
+            extra_units);
       if(mu < best_mu) {
-        best_proc_id    = proc_id;
-        best_mu         = mu;
-        best_extra_ways = extra_ways;
+        best_proc_id     = proc_id;
+        best_mu          = mu;
+        best_extra_units = extra_units;
       }
     }
     ASSERT(0, best_mu != 1.0e99);
-    if(best_extra_ways == 0) {
+    if(best_extra_units == 0) {
       best_proc_id        = tie_breaker_proc_id;
       tie_breaker_proc_id = (tie_breaker_proc_id + 1) % NUM_CORES;
-      best_extra_ways     = 1;
+      best_extra_units    = 1;
     }
     ASSERT(0, best_proc_id != NUM_CORES);
-    partition[best_proc_id] += best_extra_ways;
-    total_ways_allocated += best_extra_ways;
-    DEBUG(0, "Gave %d ways to core %d, marginal util: %.4f\n", best_extra_ways,
-          best_proc_id, best_mu);
+    partition[best_proc_id] += best_extra_units;
+    total_units_allocated += best_extra_units;
+    DEBUG(0, "Gave %d units to core %d, marginal util: %.4f\n",
+          best_extra_units, best_proc_id, best_mu);
   }
 }
 
 /**************************************************************************************/
-/* Set target partition */
+/* Set target partition. A partition of u units gives a core u /
+ * L1_PART_WAY_GRAIN ways in every set plus one more way in a (u %
+ * L1_PART_WAY_GRAIN) / L1_PART_WAY_GRAIN fraction of the sets. The extra sets
+ * of the cores are laid out back to back, so no set is over-allocated. */
 
 void set_partition(void) {
+  Cache* cache = &mem->uncores[0].l1->cache;
+
   // the one bind at config time (lookahead/brutal force)
   search_func();
 
@@ -725,11 +875,16 @@ void set_partition(void) {
   }
 
   /* set up the estimated best partition */
+  uns sets_per_unit = cache->num_sets / L1_PART_WAY_GRAIN;
+  uns start_set     = 0;
   for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    set_partition_allocate(&mem->uncores[0].l1->cache, proc_id,
-                           new_partition[proc_id]);
-    current_partition[proc_id]                    = new_partition[proc_id];
-    GET_STAT_EVENT(proc_id, NORESET_L1_PARTITION) = new_partition[proc_id];
+    uns units      = new_partition[proc_id];
+    uns extra_sets = (units % L1_PART_WAY_GRAIN) * sets_per_unit;
+    set_partition_allocate(cache, proc_id, units / L1_PART_WAY_GRAIN);
+    set_partition_allocate_sets(cache, proc_id, extra_sets, start_set);
+    start_set                  = (start_set + extra_sets) % cache->num_sets;
+    current_partition[proc_id] = units;
+    SET_STAT_EVENT(proc_id, NORESET_L1_PARTITION, units / L1_PART_WAY_GRAIN);
   }
   STAT_EVENT_ALL(L1_PARTITION_INTERVALS);
 }
@@ -752,83 +907,5 @@ void debug_cache_part(uns* old_partition, uns* new_partition) {
     DPRINTF("\n");
   }
   DPRINTF("New partition {%s}, metric %.4f -> %.4f\n", buf,
-          metric_func(old_partition), metric_func(new_partition));
-}
-
-/**************************************************************************************/
-/* get global miss rate */
-
-double get_global_miss_rate(uns* partition) {
-  double sum = 0.0;
-  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    Proc_Info* proc_info = &proc_infos[proc_id];
-    Counter    accesses  = stat_mon_get_count(stat_mon, proc_id,
-                                          L1_PART_USE_STALLING ?
-                                            L1_SHADOW_ACCESS_STALLING :
-                                            L1_SHADOW_ACCESS_DEMAND);
-    sum += proc_info->miss_rates[partition[proc_id]] * (double)accesses;
-  }
-  return sum;
-}
-
-/**************************************************************************************/
-/* get miss rate sum */
-
-double get_miss_rate_sum(uns* partition) {
-  double sum = 0.0;
-  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    Proc_Info* proc_info = &proc_infos[proc_id];
-    sum += proc_info->miss_rates[partition[proc_id]];
-  }
-  return sum;
-}
-
-/**************************************************************************************/
-/* get negative gmean of core performance (negative because we minimize the
- * metric) */
-
-double get_gmean_perf(uns* partition) {
-  double product = 1.0;
-  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    /* Assuming constant stall time per miss and constant compute time per
-       access:
-
-          stall time    misses      compute time       time
-          ---------- x --------  +  ------------  =  --------
-            misses     accesses       accesses       accesses
-
-          stall time   miss rate    compute time       time
-           per miss                   per miss      per access
-
-           CONSTANT    VARIABLE       CONSTANT       VARIABLE
-
-       From this model, we can derive that normalized performance
-       given a new vs old miss rate is the *reciprocal* of:
-
-               / new miss rate     \
-           1 + | ------------- - 1 | x stall frac
-               \ old miss rate     /
-    */
-    Proc_Info* proc_info  = &proc_infos[proc_id];
-    double     stall_frac = (double)stat_mon_get_count(stat_mon, proc_id,
-                                                   RET_BLOCKED_L1_MISS) /
-                        (double)stat_mon_get_count(stat_mon, proc_id,
-                                                   NODE_CYCLE);
-    double miss_rate0 = proc_info->miss_rates[current_partition[proc_id]];
-    double miss_rate  = proc_info->miss_rates[partition[proc_id]];
-    double pred_perf;
-    if(miss_rate0 == 0.0 || stall_frac == 0.0) {
-      // in case of zero misses or stall time make the smallest
-      // partition most attractive
-      if(partition[proc_id] == 1) {
-        pred_perf = 1.0;
-      } else {
-        pred_perf = 0.0;
-      }
-    } else {
-      pred_perf = 1.0 / (1.0 + (miss_rate / miss_rate0 - 1) * stall_frac);
-    }
-    product *= pred_perf;
-  }
-  return -product;
+          get_partition_cost(old_partition), get_partition_cost(new_partition));
 }
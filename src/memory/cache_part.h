@@ -41,6 +41,8 @@ struct Mem_Req_struct;
 
 DECLARE_ENUM(Cache_Part_Metric, CACHE_PART_METRIC_LIST, CACHE_PART_METRIC_);
 
+/* LOOKAHEAD is UCP's greedy lookahead; BRUTE_FORCE finds the best partition
+   (by dynamic programming over the per-core costs, not by enumeration) */
 #define CACHE_PART_SEARCH_LIST(elem) elem(LOOKAHEAD) elem(BRUTE_FORCE)
 
 DECLARE_ENUM(Cache_Part_Search, CACHE_PART_SEARCH_LIST, CACHE_PART_SEARCH_);
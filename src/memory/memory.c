@@ -75,6 +75,8 @@
 #define MLC(proc_id) (mem->uncores[proc_id].mlc)
 #define L1(proc_id) (mem->uncores[proc_id].l1)
 
+#define MEM_QUEUE_INDEX_BUCKETS 1601
+
 /**************************************************************************************/
 /* Global Variables */
 
@@ -112,6 +114,9 @@ static void unmark_l1_miss_deps(Op* op);
 static void update_mem_req_occupancy_counter(Mem_Req_Type type, int delta);
 
 int         mem_compare_priority(const void* a, const void* b);
+static void mem_sort_queue(Mem_Queue* queue);
+static void mem_sort_entries(Mem_Queue_Entry* base, int count);
+static void mem_merge_entries(Mem_Queue_Entry* base, int mid, int count);
 void        mem_start_mlc_access(Mem_Req* req);
 static void mem_process_core_fill_reqs(uns proc_id);
 Flag mem_process_mlc_hit_access(Mem_Req* req, Mem_Queue_Entry* mlc_queue_entry,
@@ -186,6 +191,11 @@ static void mem_init_new_req(Mem_Req* new_req, Mem_Req_Type type,
 
 static inline void init_mem_queue(Mem_Queue* queue, char* name, uns size,
                                   Mem_Queue_Type type);
+static void reset_mem_queue(Mem_Queue* queue);
+static void mem_queue_index_add(Mem_Queue* queue, Mem_Queue_Entry* entry,
+                                Mem_Req* req);
+static void mem_queue_remove_tail(Mem_Queue* queue, int count);
+static int  mem_queue_index_count(Mem_Queue* queue, Addr addr);
 
 static void print_mem_queue_generic(Mem_Queue* queue);
 
@@ -232,6 +242,97 @@ static inline void init_mem_queue(Mem_Queue* queue, char* name, uns size,
   queue->reserved_entry_count = 0;
   queue->type                 = type;
   strcpy(queue->name, name);
+
+  /* only the queues searched by mem_search_reqbuf need the address index */
+  queue->indexed         = !(type & QUEUE_CORE_FILL);
+  queue->num_index_sizes = 0;
+  if(queue->indexed)
+    init_hash_table(&queue->addr_index, name, MEM_QUEUE_INDEX_BUCKETS,
+                    sizeof(int));
+}
+
+/**************************************************************************************/
+/* reset_mem_queue: */
+
+static void reset_mem_queue(Mem_Queue* queue) {
+  queue->entry_count = 0;
+  if(queue->indexed)
+    hash_table_clear(&queue->addr_index);
+}
+
+/**************************************************************************************/
+/* mem_queue_index_add: Counts a newly inserted entry in the address index.
+ * The key is remembered in the entry because the request buffer can be
+ * reused before the entry leaves the queue. */
+
+static void mem_queue_index_add(Mem_Queue* queue, Mem_Queue_Entry* entry,
+                                Mem_Req* req) {
+  uns  slot;
+  Flag new_entry;
+  int* count;
+
+  if(!queue->indexed)
+    return;
+
+  for(slot = 0; slot < queue->num_index_sizes; slot++)
+    if(queue->index_sizes[slot] == req->size)
+      break;
+  if(slot == queue->num_index_sizes) {
+    if(slot == MEM_QUEUE_INDEX_SIZES) {
+      /* too many request sizes to index, fall back to full searches */
+      queue->indexed = FALSE;
+      hash_table_clear(&queue->addr_index);
+      return;
+    }
+    ASSERT(req->proc_id, req->size >= MEM_QUEUE_INDEX_SIZES);
+    queue->index_sizes[queue->num_index_sizes++] = req->size;
+  }
+
+  entry->index_key = CACHE_SIZE_ADDR(req->size, req->addr) | slot;
+  count = (int*)hash_table_access_create(&queue->addr_index, entry->index_key,
+                                         &new_entry);
+  if(new_entry)
+    *count = 0;
+  (*count)++;
+}
+
+/**************************************************************************************/
+/* mem_queue_remove_tail: Removes the last count entries (the ones the last
+ * sort moved to the end) from the queue and its address index. */
+
+static void mem_queue_remove_tail(Mem_Queue* queue, int count) {
+  ASSERT(0, count >= 0 && count <= queue->entry_count);
+
+  if(queue->indexed) {
+    for(int ii = queue->entry_count - count; ii < queue->entry_count; ii++) {
+      Addr key = queue->base[ii].index_key;
+      int* num = (int*)hash_table_access(&queue->addr_index, key);
+      ASSERT(0, num && *num > 0);
+      if(--(*num) == 0)
+        hash_table_access_delete(&queue->addr_index, key);
+    }
+  }
+  queue->entry_count -= count;
+}
+
+/**************************************************************************************/
+/* mem_queue_index_count: Returns how many queue entries cover addr, or the
+ * whole queue size if the queue is not indexed. */
+
+static int mem_queue_index_count(Mem_Queue* queue, Addr addr) {
+  int total = 0;
+
+  if(!queue->indexed)
+    return queue->entry_count;
+
+  for(uns slot = 0; slot < queue->num_index_sizes; slot++) {
+    int* num = (int*)hash_table_access(
+      &queue->addr_index,
+      CACHE_SIZE_ADDR(queue->index_sizes[slot], addr) | slot);
+    if(num)
+      total += *num;
+  }
+  return total;
 }
 
 /**************************************************************************************/
@@ -509,11 +610,11 @@ void reset_memory() {
 
   clear_list(&mem->req_buffer_free_list);
 
-  mem->l1_queue.entry_count       = 0;
-  mem->mlc_queue.entry_count      = 0;
-  mem->bus_out_queue.entry_count  = 0;
-  mem->l1fill_queue.entry_count   = 0;
-  mem->mlc_fill_queue.entry_count = 0;
+  reset_mem_queue(&mem->l1_queue);
+  reset_mem_queue(&mem->mlc_queue);
+  reset_mem_queue(&mem->bus_out_queue);
+  reset_mem_queue(&mem->l1fill_queue);
+  reset_mem_queue(&mem->mlc_fill_queue);
 
   for(ii = 0; ii < mem->total_mem_req_buffers; ii++) {
     int* free_list_entry      = sl_list_add_tail(&mem->req_buffer_free_list);
@@ -823,20 +924,17 @@ void update_memory_queues() {
   }
 
   if(!ALL_FIFO_QUEUES && (cycle_l1q_insert_count > 0)) {
-    qsort(mem->l1_queue.base, mem->l1_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_sort_queue(&mem->l1_queue);
     cycle_l1q_insert_count = 0;
   }
 
   if(!ALL_FIFO_QUEUES && (cycle_mlcq_insert_count > 0)) {
-    qsort(mem->mlc_queue.base, mem->mlc_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_sort_queue(&mem->mlc_queue);
     cycle_mlcq_insert_count = 0;
   }
 
   if(!ALL_FIFO_QUEUES && (cycle_busoutq_insert_count > 0)) {
-    qsort(mem->bus_out_queue.base, mem->bus_out_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_sort_queue(&mem->bus_out_queue);
     cycle_busoutq_insert_count = 0;
   }
 }
@@ -908,6 +1006,34 @@ void update_memory() {
   }
 }
 
+/**************************************************************************************/
+/* mem_next_event: Returns the first L1 cycle at which update_memory can do
+ * more than collect stats and tick Ramulator. Requests that are inside
+ * Ramulator do not count; they come back through the l1fill_queue. */
+
+Counter mem_next_event(void) {
+  Counter cur_cycle = freq_cycle_count(FREQ_DOMAIN_L1);
+
+  if(mem->l1_queue.entry_count || mem->mlc_queue.entry_count ||
+     mem->bus_out_queue.entry_count || mem->l1fill_queue.entry_count ||
+     mem->mlc_fill_queue.entry_count)
+    return cur_cycle;
+
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if(mem->core_fill_queues[proc_id].entry_count)
+      return cur_cycle;
+  }
+
+  if(l1_in_buf_count || cycle_l1q_insert_count || cycle_mlcq_insert_count ||
+     cycle_busoutq_insert_count)
+    return cur_cycle;
+
+  if(!pref_queues_empty())
+    return cur_cycle;
+
+  return MAX_CTR;
+}
+
 /**************************************************************************************/
 /* mem_compare_priority: */
 
@@ -925,6 +1051,73 @@ int mem_compare_priority(const void* a, const void* b) {
     return 0;
 }
 
+/**************************************************************************************/
+/* mem_sort_queue: Stable sort of a queue by priority. Equivalent to the glibc
+ * (merge sort) qsort the queues used to be sorted with, but cheap for the
+ * common case of a sorted queue with a few entries appended since the last
+ * sort: the sorted prefix is found with one scan, only the appended tail is
+ * sorted, and the two are merged in a single pass. */
+
+#define MEM_SORT_INSERTION_MAX 16
+
+static Mem_Queue_Entry* mem_sort_scratch      = NULL;
+static int              mem_sort_scratch_size = 0;
+
+static void mem_sort_queue(Mem_Queue* queue) {
+  if(queue->entry_count > mem_sort_scratch_size) {
+    mem_sort_scratch_size = queue->entry_count;
+    mem_sort_scratch      = (Mem_Queue_Entry*)realloc(
+      mem_sort_scratch, sizeof(Mem_Queue_Entry) * mem_sort_scratch_size);
+  }
+  mem_sort_entries(queue->base, queue->entry_count);
+}
+
+static void mem_sort_entries(Mem_Queue_Entry* base, int count) {
+  int sorted = 1;
+
+  while(sorted < count && base[sorted - 1].priority <= base[sorted].priority)
+    sorted++;
+  if(sorted >= count)
+    return;
+
+  if(count <= MEM_SORT_INSERTION_MAX) {
+    for(int ii = sorted; ii < count; ii++) {
+      Mem_Queue_Entry entry = base[ii];
+      int             jj    = ii;
+      for(; jj > 0 && base[jj - 1].priority > entry.priority; jj--)
+        base[jj] = base[jj - 1];
+      base[jj] = entry;
+    }
+    return;
+  }
+
+  if(sorted < count / 2) {
+    sorted = count / 2;
+    mem_sort_entries(base, sorted);
+  }
+  mem_sort_entries(base + sorted, count - sorted);
+  mem_merge_entries(base, sorted, count);
+}
+
+/* merges the sorted runs [0, mid) and [mid, count); ties keep the left entry
+ * first */
+static void mem_merge_entries(Mem_Queue_Entry* base, int mid, int count) {
+  int ii = 0, jj = mid, kk = 0;
+
+  if(base[mid - 1].priority <= base[mid].priority)
+    return;
+
+  memcpy(mem_sort_scratch, base, sizeof(Mem_Queue_Entry) * mid);
+  while(ii < mid && jj < count) {
+    if(mem_sort_scratch[ii].priority <= base[jj].priority)
+      base[kk++] = mem_sort_scratch[ii++];
+    else
+      base[kk++] = base[jj++];
+  }
+  while(ii < mid)
+    base[kk++] = mem_sort_scratch[ii++];
+}
+
 /**************************************************************************************/
 /* mem_start_mlc_access: */
 
@@ -1542,6 +1735,7 @@ static Flag mem_complete_l1_access(Mem_Req*         req,
   if(!PREFETCH_UPDATE_LRU_L1 &&
      (req->type == MRT_DPRF || req->type == MRT_IPRF))
     update_l1_lru = FALSE;
+  L1(req->proc_id)->cache.repl_pc = req->loadPC;
   data = (L1_Data*)cache_access(&L1(req->proc_id)->cache, req->addr, &line_addr,
                                 update_l1_lru);  // access L2
   cache_part_l1_access(req);
@@ -1911,9 +2105,8 @@ static void mem_process_l1_reqs() {
     /* After this sort requests that should be removed will be at the tail of
      * the l1_queue */
     DEBUG(0, "l1_queue removal\n");
-    qsort(mem->l1_queue.base, mem->l1_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
-    mem->l1_queue.entry_count -= l1_queue_removal_count;
+    mem_sort_queue(&mem->l1_queue);
+    mem_queue_remove_tail(&mem->l1_queue, l1_queue_removal_count);
     ASSERT(req->proc_id, mem->l1_queue.entry_count >= 0);
     /* if HIER_MSHR_ON, requests stay in the queues until filled (by reserving
      * entries) */
@@ -1925,11 +2118,9 @@ static void mem_process_l1_reqs() {
   /* Sort the out queue if requests were inserted */
   if(!ALL_FIFO_QUEUES && (out_queue_insertion_count > 0)) {
     if(CONSTANT_MEMORY_LATENCY) {  // request went straight to L1 fill queue
-      qsort(mem->l1fill_queue.base, mem->l1fill_queue.entry_count,
-            sizeof(Mem_Queue_Entry), mem_compare_priority);
+      mem_sort_queue(&mem->l1fill_queue);
     } else {
-      qsort(mem->bus_out_queue.base, mem->bus_out_queue.entry_count,
-            sizeof(Mem_Queue_Entry), mem_compare_priority);
+      mem_sort_queue(&mem->bus_out_queue);
     }
   }
 }
@@ -2002,9 +2193,8 @@ static void mem_process_mlc_reqs() {
     /* After this sort requests that should be removed will be at the tail of
      * the mlc_queue */
     DEBUG(0, "mlc_queue removal\n");
-    qsort(mem->mlc_queue.base, mem->mlc_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
-    mem->mlc_queue.entry_count -= mlc_queue_removal_count;
+    mem_sort_queue(&mem->mlc_queue);
+    mem_queue_remove_tail(&mem->mlc_queue, mlc_queue_removal_count);
     ASSERT(req->proc_id, mem->mlc_queue.entry_count >= 0);
     /* if HIER_MSHR_ON, requests stay in the queues until filled (by reserving
      * entries) */
@@ -2015,8 +2205,7 @@ static void mem_process_mlc_reqs() {
 
   /* Sort the l1 queue if requests were inserted */
   if(!ALL_FIFO_QUEUES && (l1_queue_insertion_count > 0)) {
-    qsort(mem->l1_queue.base, mem->l1_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_sort_queue(&mem->l1_queue);
   }
 }
 
@@ -2334,9 +2523,8 @@ static void mem_process_bus_out_reqs() {
     //}
 
     DEBUG(0, "bus_out_queue removal\n");
-    qsort(mem->bus_out_queue.base, mem->bus_out_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
-    mem->bus_out_queue.entry_count--;
+    mem_sort_queue(&mem->bus_out_queue);
+    mem_queue_remove_tail(&mem->bus_out_queue, 1);
     ASSERT(req->proc_id, mem->bus_out_queue.entry_count >= 0);
 
     // Ramulator_remove: Ramulator implements its own request queues. This
@@ -2412,9 +2600,8 @@ static void remove_from_l1_fill_queue(uns  proc_id,
     /* After this sort requests that should be removed will be at the tail of
      * the l1_queue */
     DEBUG(0, "l1fill_queue removal\n");
-    qsort(mem->l1fill_queue.base, mem->l1fill_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
-    mem->l1fill_queue.entry_count -= *p_l1fill_queue_removal_count;
+    mem_sort_queue(&mem->l1fill_queue);
+    mem_queue_remove_tail(&mem->l1fill_queue, *p_l1fill_queue_removal_count);
     ASSERT(proc_id, mem->l1fill_queue.entry_count >= 0);
     /* free corresponding reserved entries in the L1 queue if HIER_MSHR_ON */
     if(HIER_MSHR_ON) {
@@ -2594,9 +2781,8 @@ static void mem_process_mlc_fill_reqs() {
     /* After this sort requests that should be removed will be at the tail of
      * the mlc_queue */
     DEBUG(0, "mlc_fill_queue removal\n");
-    qsort(mem->mlc_fill_queue.base, mem->mlc_fill_queue.entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
-    mem->mlc_fill_queue.entry_count -= mlc_fill_queue_removal_count;
+    mem_sort_queue(&mem->mlc_fill_queue);
+    mem_queue_remove_tail(&mem->mlc_fill_queue, mlc_fill_queue_removal_count);
     ASSERT(req->proc_id, mem->mlc_fill_queue.entry_count >= 0);
     /* free corresponding reserved entries in the MLC queue if HIER_MSHR_ON */
     if(HIER_MSHR_ON) {
@@ -2648,9 +2834,8 @@ static void mem_process_core_fill_reqs(uns proc_id) {
     /* After this sort requests that should be removed will be at the tail of
      * the core_fill_queue */
     DEBUG(0, "core_fill_queue removal\n");
-    qsort(core_fill_queue->base, core_fill_queue->entry_count,
-          sizeof(Mem_Queue_Entry), mem_compare_priority);
-    core_fill_queue->entry_count -= core_fill_queue_removal_count;
+    mem_sort_queue(core_fill_queue);
+    mem_queue_remove_tail(core_fill_queue, core_fill_queue_removal_count);
     ASSERT(req->proc_id, core_fill_queue->entry_count >= 0);
   }
 }
@@ -2691,6 +2876,7 @@ static inline Mem_Req* mem_search_queue(
   Flag     match        = FALSE;
   int      ii           = 0;
   Addr     src_addr, dest_addr;
+  int      candidates;
 
   if(proc_id)
     ASSERTM(proc_id, addr, "type %i\n", type);
@@ -2701,13 +2887,23 @@ static inline Mem_Req* mem_search_queue(
 
   // CMP ignore "size" from argument
 
-  for(ii = 0; ii < queue->entry_count; ii++) {
+  /* the scan can stop once every entry with a matching address was seen */
+  candidates = mem_queue_index_count(queue, addr);
+
+  for(ii = 0; ii < queue->entry_count && candidates > 0; ii++) {
     used_reqbuf_id = queue->base[ii].reqbuf;
     req            = &mem->req_buffer[used_reqbuf_id];
     dest_addr      = CACHE_SIZE_ADDR(req->size, req->addr);
     src_addr       = CACHE_SIZE_ADDR(req->size, addr);
     match          = FALSE;
 
+    if(queue->indexed) {
+      Addr key  = queue->base[ii].index_key;
+      uns  slot = key & (MEM_QUEUE_INDEX_SIZES - 1);
+      if(key == (CACHE_SIZE_ADDR(queue->index_sizes[slot], addr) | slot))
+        candidates--;
+    }
+
     if((dest_addr == src_addr) &&
        !is_final_state(req->state)) { /* address match */
       ASSERTM(proc_id, proc_id == get_proc_id_from_cmp_addr(addr),
@@ -3042,8 +3238,7 @@ Flag mem_adjust_matching_request(Mem_Req* req, Mem_Req_Type type, Addr addr,
         req->type = type;
         memview_req_changed_type(req);
       }
-      qsort(req->queue->base, req->queue->entry_count, sizeof(Mem_Queue_Entry),
-            mem_compare_priority); /* Sort the associated queue */
+      mem_sort_queue(req->queue); /* Sort the associated queue */
     }
 
     switch(req->queue->type) {
@@ -3220,8 +3415,7 @@ static Mem_Req* mem_kick_out_prefetch_from_queue(uns mem_bank, Mem_Queue* queue,
   if(queue->entry_count == 0)
     return NULL;
 
-  qsort(queue->base, queue->entry_count, sizeof(Mem_Queue_Entry),
-        mem_compare_priority);
+  mem_sort_queue(queue);
 
   if(KICKOUT_OLDEST_PREFETCH) {
     int      ii, oldest_index = 0;
@@ -3268,9 +3462,8 @@ static Mem_Req* mem_kick_out_prefetch_from_queue(uns mem_bank, Mem_Queue* queue,
       queue->base[oldest_index].priority =
         Mem_Req_Priority_Offset[MRT_MIN_PRIORITY];
       DEBUG(0, "%s removal\n", queue->name);
-      qsort(queue->base, queue->entry_count, sizeof(Mem_Queue_Entry),
-            mem_compare_priority);
-      queue->entry_count--;
+      mem_sort_queue(queue);
+      mem_queue_remove_tail(queue, 1);
       pref_req_drop_process(
         req_kicked_out->proc_id,
         mem->req_buffer[queue->base[oldest_index].reqbuf].prefetcher_id);
@@ -3293,7 +3486,7 @@ static Mem_Req* mem_kick_out_prefetch_from_queue(uns mem_bank, Mem_Queue* queue,
                  ONPATH_KICKED_OUT_PREFETCH);
       queue->base[queue->entry_count - 1].priority =
         Mem_Req_Priority_Offset[MRT_MIN_PRIORITY];
-      queue->entry_count--;
+      mem_queue_remove_tail(queue, 1);
       pref_req_drop_process(mem->req_buffer[kickout_reqbuf_num].proc_id,
                             mem->req_buffer[kickout_reqbuf_num].prefetcher_id);
       return &(mem->req_buffer[kickout_reqbuf_num]);
@@ -3553,6 +3746,7 @@ static inline Mem_Queue_Entry* mem_insert_req_into_queue(Mem_Req*   new_req,
   Mem_Queue_Entry* new_entry = &queue->base[queue->entry_count];
   new_entry->reqbuf          = new_req->id;
   new_entry->priority        = priority > 0 ? priority : new_req->priority;
+  mem_queue_index_add(queue, new_entry, new_req);
   queue->entry_count++;
 
 
@@ -4438,6 +4632,9 @@ Flag l1_fill_line(Mem_Req* req) {
     }
   }
 
+  // PC for PC-indexed replacement policies (SHiP, Hawkeye)
+  L1(req->proc_id)->cache.repl_pc = req->loadPC;
+
   // Put prefetches in the right position for replacement
   // cmp FIXME prefetchers
   if(req->type == MRT_DPRF || req->type == MRT_IPRF) {
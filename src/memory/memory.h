@@ -90,8 +90,11 @@ typedef struct Mem_Queue_Entry_struct {
   int     reqbuf;   /* request buffer num */
   Counter priority; /* priority of the miss */
   Counter rdy_cycle;
+  Addr    index_key; /* key of the request in the queue's addr_index */
 } Mem_Queue_Entry;
 
+#define MEM_QUEUE_INDEX_SIZES 4
+
 typedef struct Mem_Queue_struct {
   Mem_Queue_Entry* base;
   int              entry_count;
@@ -99,6 +102,14 @@ typedef struct Mem_Queue_struct {
   uns              size;
   char             name[20];
   Mem_Queue_Type   type;
+
+  /* Number of entries per size-aligned request address, so that searches can
+     skip queues without a matching line. Requests of different sizes are
+     kept apart by the size's slot in the low bits of the key. */
+  Flag       indexed;
+  Hash_Table addr_index;
+  uns        index_sizes[MEM_QUEUE_INDEX_SIZES];
+  uns        num_index_sizes;
 } Mem_Queue;
 
 typedef struct Mem_Bank_Queue_Entry_struct {
@@ -219,6 +230,8 @@ void recover_memory(void);
 void debug_memory(void);
 void update_memory(void);
 
+Counter mem_next_event(void);
+
 Flag     scan_stores(Addr, uns);
 void     op_nuke_mem_req(Op*);
 Flag     mem_req_younger_than_uniquenum(int, Counter);
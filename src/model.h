@@ -30,6 +30,7 @@
 #define __MODEL_H__
 
 #include "globals/global_types.h"
+#include "libs/ckpt_lib.h"
 #include "packet_build.h"
 
 
@@ -74,6 +75,12 @@ typedef struct Model_struct {
   void (*op_fetched_hook)(Op*);
   void (*op_retired_hook)(Op*);  // called just before the op is freed
   void (*warmup_func)(Op* op);   /* called for warmup(may be NULL) */
+  Flag (*idle_func)(void); /* called in place of the cycle_func when
+                              IDLE_CYCLE_SKIP is on; returns TRUE if it
+                              simulated the cycle, and maybe the ones after
+                              it (may be NULL) */
+  void (*ckpt_func)(Ckpt*); /* called after warmup to save or restore the
+                               warmed-up state (may be NULL) */
 
   /*      void (*l0_cache_miss_hook)      (Op *); */
   /*      void (*resolve_mispredict_hook) (Op *); */
@@ -109,6 +109,7 @@ void init_node_stage(uns8 proc_id, const char* name) {
   // allocate wires to functional units
   node->sd.max_op_count = NUM_FUS;  // Bandwidth between schedule and FUS
   node->sd.ops          = (Op**)malloc(sizeof(Op*) * node->sd.max_op_count);
+  node->sched_check     = (Op**)malloc(sizeof(Op*) * NODE_TABLE_SIZE);
 
   reset_node_stage();
 }
@@ -127,6 +128,8 @@ void reset_node_stage() {
   node->rdy_head        = NULL;
   node->next_op_into_rs = NULL;
 
+  node->sched_check_count = 0;
+
   node->node_count           = 0;
   node->ret_op               = 1;
   node->last_scheduled_opnum = 0;
@@ -149,6 +152,8 @@ void reset_all_ops_node_stage() {
   node->rdy_head        = NULL;
   node->next_op_into_rs = NULL;
 
+  node->sched_check_count = 0;
+
   node->node_count       = 0;
   node->node_count       = 0;
   node->mem_blocked      = FALSE;
@@ -180,18 +185,42 @@ void recover_node_stage() {
     debug_node_stage();
 }
 
+void node_add_to_ready_list(Op* op) {
+  ASSERT(node->proc_id, !op->in_rdy_list);
+  op->next_rdy = node->rdy_head;
+  op->prev_rdy = NULL;
+  if(node->rdy_head)
+    node->rdy_head->prev_rdy = op;
+  node->rdy_head  = op;
+  op->in_rdy_list = TRUE;
+}
+
+static void remove_from_ready_list(Op* op) {
+  ASSERT(node->proc_id, op->in_rdy_list);
+  if(op->prev_rdy)
+    op->prev_rdy->next_rdy = op->next_rdy;
+  else
+    node->rdy_head = op->next_rdy;
+  if(op->next_rdy)
+    op->next_rdy->prev_rdy = op->prev_rdy;
+  op->in_rdy_list = FALSE;
+}
+
 void flush_ready_list() {
-  Op*  op;
-  Op** last;
-  for(op = node->rdy_head, last = &node->rdy_head; op; op = op->next_rdy) {
+  Op* op;
+  uns ii, kept = 0;
+  for(op = node->rdy_head; op; op = op->next_rdy) {
     ASSERT(node->proc_id, node->proc_id == op->proc_id);
     if(FLUSH_OP(op)) {
       ASSERT(node->proc_id, op->op_num > bp_recovery_info->recovery_op_num);
-      *last           = op->next_rdy;
-      op->in_rdy_list = FALSE;
-    } else
-      last = &op->next_rdy;
+      remove_from_ready_list(op);
+    }
+  }
+  for(ii = 0; ii < node->sched_check_count; ii++) {
+    if(node->sched_check[ii]->in_rdy_list)
+      node->sched_check[kept++] = node->sched_check[ii];
   }
+  node->sched_check_count = kept;
 }
 
 void flush_scheduling_buffer() {
@@ -502,78 +531,6 @@ void check_if_mem_blocked() {
   node->mem_block_length += node->mem_blocked;
 }
 
-/**************************************************************************************/
-/* bubble: bubble pass for the ready list. Part of the bubble sort function
- * below. */
-
-static Flag bubble(Op* head, int n) {
-  Flag swapped     = FALSE;
-  Flag swapped_now = FALSE;
-  int  i;
-  Op*  prev = NULL;
-  Op*  cur  = head;
-  Op*  next = head->next_rdy;
-
-  for(i = 0; i < n - 1; i++) {
-    swapped_now = FALSE;
-    if(cur->op_num > next->op_num) {
-      if(prev)
-        prev->next_rdy = next;
-      cur->next_rdy  = next->next_rdy;
-      next->next_rdy = cur;
-      swapped        = TRUE;
-      swapped_now    = TRUE;
-      if(!prev)
-        node->rdy_head = next;
-    }
-    if(swapped_now) {
-      prev = next;
-      next = cur->next_rdy;
-    } else {
-      prev = cur;
-      cur  = next;
-      next = next->next_rdy;
-    }
-  }
-
-  return swapped;
-}
-
-/**************************************************************************************/
-/* sort_node_ready_list: sorts the ready list */
-
-inline static void sort_node_ready_list() {
-  Op* op;
-  int i;
-  int count_rdy = 0;
-  for(op = node->rdy_head; op; op = op->next_rdy) {
-    count_rdy++;
-  }
-
-  DEBUG(node->proc_id, "Unsorted ready list: count: %d\n", count_rdy);
-  if(DEBUG_NODE_STAGE && DEBUG_RANGE_COND(node->proc_id)) {
-    for(op = node->rdy_head; op; op = op->next_rdy) {
-      DPRINTF("%s ", unsstr64(op->op_num));
-    }
-    DPRINTF("\n");
-  }
-
-  for(i = count_rdy; (i > 1) && bubble(node->rdy_head, i); i--)
-    ;
-
-  count_rdy = 0;
-  for(op = node->rdy_head; op; op = op->next_rdy)
-    count_rdy++;
-
-  DEBUG(node->proc_id, "Sorted ready list: count: %d\n", count_rdy);
-  if(DEBUG_NODE_STAGE && DEBUG_RANGE_COND(node->proc_id)) {
-    for(op = node->rdy_head; op; op = op->next_rdy) {
-      DPRINTF("%s ", unsstr64(op->op_num));
-    }
-    DPRINTF("\n");
-  }
-}
-
 /**************************************************************************************/
 /* Schedulers:
  *      The interface to the schedule functions is that Scarab will pass the
@@ -587,64 +544,40 @@ inline static void sort_node_ready_list() {
  */
 
 void oldest_first_sched(Op* op) {
-  int32 youngest_slot_op_id = -1;  //-1 means not found
-
-  // Iterate through the FUs that this RS is connected to.
-  Reservation_Station* rs = &node->rs[op->rs_id];
-  for(uns32 i = 0; i < rs->num_fus; ++i) {
-    Func_Unit* fu    = rs->connected_fus[i];
-    uns32      fu_id = fu->fu_id;
-
-    // check if this op can be executed by this FU
-    if(get_fu_type(op->table_info->op_type, op->table_info->is_simd) &
-       fu->type) {
-      Op* s_op = node->sd.ops[fu_id];
-      if(!s_op) {  // nobody has been scheduled to this FU yet
-        DEBUG(node->proc_id,
-              "Scheduler selecting    op_num:%s  fu_id:%d op:%s l1:%d\n",
-              unsstr64(op->op_num), fu_id, disasm_op(op, TRUE),
-              op->engine_info.l1_miss);
-        ASSERT(node->proc_id, fu_id < node->sd.max_op_count);
-        op->fu_num                 = fu_id;
-        node->sd.ops[op->fu_num]   = op;
-        node->last_scheduled_opnum = op->op_num;
-        node->sd.op_count += !s_op;
-        ASSERT(node->proc_id, node->sd.op_count <= node->sd.max_op_count);
-        youngest_slot_op_id = -1;
-        break;
-      } else if(op->op_num < s_op->op_num) {
-        // The slot is not empty, but we are older than the op that is in the
-        // slot
-        if(youngest_slot_op_id == -1) {
-          youngest_slot_op_id = fu_id;
-        } else {
-          Op* youngest_op = node->sd.ops[youngest_slot_op_id];
-          if(s_op->op_num > youngest_op->op_num) {
-            // this slot is younger than the youngest known op
-            youngest_slot_op_id = fu_id;
-          }
-        }
-      }
-    }
-  }
-
-  if(youngest_slot_op_id != -1) {
-    /*Did not find an empty slot, but we did find a slot that is younger that
-     * us*/
-    uns32 fu_id = youngest_slot_op_id;
-    DEBUG(node->proc_id,
-          "Scheduler selecting    op_num:%s  fu_id:%d op:%s l1:%d\n",
-          unsstr64(op->op_num), fu_id, disasm_op(op, TRUE),
-          op->engine_info.l1_miss);
-    ASSERT(node->proc_id, fu_id < node->sd.max_op_count);
-    op->fu_num                 = fu_id;
-    node->sd.ops[op->fu_num]   = op;
-    node->last_scheduled_opnum = op->op_num;
-    node->sd.op_count += 0;  // replacing an op, not adding a new one.
+  Reservation_Station* rs      = &node->rs[op->rs_id];
+  uns64                fu_type = get_fu_type(op->table_info->op_type,
+                                             op->table_info->is_simd);
+  uns64                fus     = rs->type_fus[__builtin_ctzll(fu_type)];
+  uns64                empty   = fus & ~node->sched_fus;
+  int32                fu_id   = -1;  //-1 means not found
+
+  if(empty) {
+    // take the first FU that nobody has been scheduled to yet
+    fu_id = __builtin_ctzll(empty);
+    node->sd.op_count++;
     ASSERT(node->proc_id, node->sd.op_count <= node->sd.max_op_count);
   } else {
-    /*Did not find an empty slot or a slot that is younger than me, do nothing*/
+    // all FUs are taken, replace the youngest op that is younger than us
+    for(; fus; fus &= fus - 1) {
+      uns32 ii   = __builtin_ctzll(fus);
+      Op*   s_op = node->sd.ops[ii];
+      if(op->op_num < s_op->op_num &&
+         (fu_id == -1 || s_op->op_num > node->sd.ops[fu_id]->op_num))
+        fu_id = ii;
+    }
+    if(fu_id == -1)
+      return;  // no slot that is younger than me, do nothing
   }
+
+  DEBUG(node->proc_id,
+        "Scheduler selecting    op_num:%s  fu_id:%d op:%s l1:%d\n",
+        unsstr64(op->op_num), fu_id, disasm_op(op, TRUE),
+        op->engine_info.l1_miss);
+  ASSERT(node->proc_id, fu_id < node->sd.max_op_count);
+  op->fu_num                 = fu_id;
+  node->sd.ops[op->fu_num]   = op;
+  node->last_scheduled_opnum = op->op_num;
+  node->sched_fus |= 1ull << fu_id;
 }
 
 /**************************************************************************************/
@@ -663,6 +596,8 @@ void node_sched_ops() {
   /* the next stage is supposed to clear them out, regardless of
      whether they are actually sent to a functional unit */
   ASSERT(node->proc_id, node->sd.op_count == 0);
+  node->sched_fus         = 0;
+  node->sched_check_count = 0;
 
   // Check to see if the L1 Q is (still) full
   check_if_mem_blocked();
@@ -671,13 +606,17 @@ void node_sched_ops() {
     ASSERT(node->proc_id, node->proc_id == op->proc_id);
     ASSERTM(node->proc_id, op->in_rdy_list, "op_num %llu\n", op->op_num);
     if(op->state == OS_WAIT_MEM) {
-      if(node->mem_blocked)
+      if(node->mem_blocked) {
+        node->sched_check[node->sched_check_count++] = op;
         continue;
-      else
+      } else
         op->state = OS_READY;
     }
-    if(op->state == OS_TENTATIVE || op->state == OS_WAIT_DCACHE)
+    if(op->state == OS_TENTATIVE || op->state == OS_WAIT_DCACHE) {
+      // the op is in the dcache stage, which may finish it
+      node->sched_check[node->sched_check_count++] = op;
       continue;
+    }
     ASSERTM(node->proc_id,
             op->state == OS_IN_RS || op->state == OS_READY ||
               op->state == OS_WAIT_FWD,
@@ -706,6 +645,12 @@ void node_sched_ops() {
       }
     }
   }
+
+  // the exec stage may finish the selected ops
+  for(uns64 sched = node->sched_fus; sched; sched &= sched - 1)
+    node->sched_check[node->sched_check_count++] =
+      node->sd.ops[__builtin_ctzll(sched)];
+  ASSERT(node->proc_id, node->sched_check_count <= NODE_TABLE_SIZE);
 }
 
 
@@ -935,9 +880,7 @@ void node_fill_rs() {
       DEBUG(node->proc_id, "Adding to ready list  op_num:%s op:%s l1:%d\n",
             unsstr64(op->op_num), disasm_op(op, TRUE), op->engine_info.l1_miss);
       op->state = (cycle_count + 1 >= op->rdy_cycle ? OS_READY : OS_WAIT_FWD);
-      op->next_rdy    = node->rdy_head;
-      node->rdy_head  = op;
-      op->in_rdy_list = TRUE;
+      node_add_to_ready_list(op);
     }
 
     // This is the max number of ops we can fill into the RS per cycle.
@@ -955,23 +898,75 @@ void node_fill_rs() {
  * FUs), we need to remove scheduled ops from the RS and ready queue */
 
 void node_handle_scheduled_ops() {
-  /* this traversal could be made more efficient since we know what
-     ops we tried to schedule last cycle, but for now let's look at
-     the whole ready list */
-  Op** last = &node->rdy_head;
-  for(Op* op = node->rdy_head; op; op = op->next_rdy) {
+  /* only the ops that node_sched_ops selected or left in the dcache stage
+     last cycle can have been scheduled since */
+  for(uns ii = 0; ii < node->sched_check_count; ii++) {
+    Op* op = node->sched_check[ii];
+    ASSERT(node->proc_id, op->in_rdy_list);
     if(op->state == OS_SCHEDULED || op->state == OS_MISS) {
       DEBUG(node->proc_id,
             "Removing from RS (and ready list)  op_num:%s op:%s l1:%d\n",
             unsstr64(op->op_num), disasm_op(op, TRUE), op->engine_info.l1_miss);
-      *last           = op->next_rdy;
-      op->in_rdy_list = FALSE;
+      remove_from_ready_list(op);
       ASSERT(node->proc_id, node->rs[op->rs_id].rs_op_count > 0);
       node->rs[op->rs_id].rs_op_count--;
-    } else {
-      last = &op->next_rdy;
     }
   }
+  node->sched_check_count = 0;
+}
+
+/**************************************************************************************/
+/* node_stage_next_event: Returns the first cycle at which the node stage (and
+ * node_sched_ops) can change anything besides stats and the stall length
+ * counters. Returns cycle_count if the stage is active now and MAX_CTR if it
+ * waits for an outside event (a wake-up, a fill or a free MSHR). */
+
+Counter node_stage_next_event(Stage_Data* src_sd) {
+  Counter next = MAX_CTR;
+  Op*     op;
+
+  if(node->sd.op_count)
+    return cycle_count;
+
+  /* node_issue */
+  if(src_sd->op_count && !is_node_table_full())
+    return cycle_count;
+
+  /* node_fill_rs */
+  if(node->next_op_into_rs && find_emptiest_rs(node->next_op_into_rs) != -1)
+    return cycle_count;
+
+  /* check_if_mem_blocked */
+  if(node->mem_blocked &&
+     mem_can_allocate_req_buffer(node->proc_id, MRT_DFETCH, FALSE))
+    return cycle_count;
+
+  /* node_handle_scheduled_ops and node_sched_ops */
+  for(op = node->rdy_head; op; op = op->next_rdy) {
+    if(op->state == OS_SCHEDULED || op->state == OS_MISS)
+      return cycle_count;
+    if(op->state == OS_TENTATIVE || op->state == OS_WAIT_DCACHE)
+      continue;
+    if(op->state == OS_WAIT_MEM) {
+      if(node->mem_blocked)
+        continue;
+      return cycle_count;
+    }
+    if(cycle_count >= op->rdy_cycle - 1)
+      return cycle_count;
+    next = MIN2(next, op->rdy_cycle - 1);
+  }
+
+  /* node_retire */
+  op = node->node_head;
+  if(op) {
+    if(!op_not_ready_for_retire(op))
+      return cycle_count;
+    if(op->state != OS_DONE)
+      next = MIN2(next, op->done_cycle);
+  }
+
+  return next;
 }
 
 /**************************************************************************************/
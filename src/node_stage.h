@@ -45,6 +45,8 @@ typedef struct Reservation_Station_struct {
                               // to.
   uns32 num_fus;              // number of fus that this rs is connected to.
   uns32 rs_op_count;          // number of ops in this reservation station
+  uns64* type_fus;  // per fu type bit (see get_fu_type), bitmask of the ids
+                    // of the connected fus that can execute it
 } Reservation_Station;
 
 typedef struct Node_Stage_struct {
@@ -62,6 +64,13 @@ typedef struct Node_Stage_struct {
   Counter ret_op;  // next op number to retire
 
   Counter last_scheduled_opnum;  // opnum of the last scheduled op
+  uns64   sched_fus;  // bitmask of the fus that node_sched_ops has
+                      // selected an op for this cycle
+
+  Op** sched_check;  // ready ops that the exec and dcache stages may move to
+                     // OS_SCHEDULED or OS_MISS before the next
+                     // node_handle_scheduled_ops
+  uns  sched_check_count;
 
   Op* next_op_into_rs;      // oldest issued op not yet in the scheduling window
                             // (RS)
@@ -91,6 +100,8 @@ void debug_node_stage(void);
 void update_node_stage(Stage_Data*);
 Flag is_node_stage_stalled(void);
 
+Counter node_stage_next_event(Stage_Data*);
+
 void  node_sched_ops(void);
 void  node_handle_scheduled_ops(void);
 void  node_issue(Stage_Data*);
@@ -98,6 +109,7 @@ void  node_fill_rs(void);
 void  node_retire(void);
 void  check_if_mem_blocked(void);
 void  oldest_first_sched(Op*);
+void  node_add_to_ready_list(Op*);
 int64 find_emptiest_rs(Op*);
 
 /**************************************************************************************/
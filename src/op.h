@@ -213,6 +213,7 @@ struct Op_struct {
                       // recoveries)
 
   struct Op_struct* next_rdy;      // pointer to next ready op (node table)
+  struct Op_struct* prev_rdy;      // pointer to previous ready op (node table)
   Flag              in_rdy_list;   // is the op in the node stage's ready list?
   struct Op_struct* next_node;     // pointer to the next op in the node table
   Flag              in_node_list;  // is the op in the node list?
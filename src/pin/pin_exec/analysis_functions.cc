@@ -82,7 +82,8 @@ void process_syscall(ADDRINT ip, ADDRINT num, ADDRINT arg0, ADDRINT arg1,
 
     checkpoints.append_to_cir_buf();
     checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                on_wrongpath_nop_mode, next_eip, 0);
+                                on_wrongpath_nop_mode, next_eip,
+                                undo_log.end());
 #ifndef ASSUME_PERFECT
     save_context(ctxt);
 #endif
@@ -156,16 +157,13 @@ void check_if_region_written_to(ADDRINT write_addr) {
   }
 }
 
-void save_mem(ADDRINT write_addr, UINT32 write_size, UINT write_index) {
+void save_mem(ADDRINT write_addr, UINT32 write_size) {
 #ifndef ASSUME_PERFECT
   write_addr = ADDR_MASK(write_addr);
 
   check_if_region_written_to(write_addr);
 
-  checkpoints.get_tail().mem_state_list[write_index].init(write_addr,
-                                                          write_size);
-  PIN_SafeCopy(checkpoints.get_tail().mem_state_list[write_index].mem_data_ptr,
-               (void*)write_addr, write_size);
+  undo_log.save(write_addr, write_size);
 #endif
 }
 
@@ -183,7 +181,8 @@ void finish_before_ins_all(CONTEXT* ctxt, bool from_syscall) {
 
       checkpoints.append_to_cir_buf();
       checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                  on_wrongpath_nop_mode, next_eip, 0);
+                                  on_wrongpath_nop_mode, next_eip,
+                                  undo_log.end());
       uid_ctr++;
       save_context(ctxt);
       PIN_SetContextRegval(&(checkpoints.get_tail().ctxt), REG_INST_PTR,
@@ -223,7 +222,8 @@ void add_right_path_exec_br(CONTEXT* ctxt) {
   // Save checkpoint
   checkpoints.append_to_cir_buf();
   checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                              on_wrongpath_nop_mode, next_eip, 0);
+                              on_wrongpath_nop_mode, next_eip,
+                              undo_log.end());
   uid_ctr++;
 #ifndef ASSUME_PERFECT
   save_context(ctxt);
@@ -244,7 +244,8 @@ void before_ins_no_mem(CONTEXT* ctxt) {
 
     checkpoints.append_to_cir_buf();
     checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                on_wrongpath_nop_mode, next_eip, 0);
+                                on_wrongpath_nop_mode, next_eip,
+                                undo_log.end());
     uid_ctr++;
 #ifndef ASSUME_PERFECT
     save_context(ctxt);
@@ -268,12 +269,13 @@ void before_ins_one_mem(CONTEXT* ctxt, ADDRINT write_addr, UINT32 write_size) {
 
     checkpoints.append_to_cir_buf();
     checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                on_wrongpath_nop_mode, next_eip, 1);
+                                on_wrongpath_nop_mode, next_eip,
+                                undo_log.end());
     uid_ctr++;
 #ifndef ASSUME_PERFECT
     save_context(ctxt);
 #endif
-    save_mem(write_addr, write_size, 0);
+    save_mem(write_addr, write_size);
     finish_before_ins_all(ctxt, false);
   }
 }
@@ -311,7 +313,8 @@ void before_ins_multi_mem(CONTEXT*                   ctxt,
 
     checkpoints.append_to_cir_buf();
     checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                on_wrongpath_nop_mode, next_eip, numMemOps);
+                                on_wrongpath_nop_mode, next_eip,
+                                undo_log.end());
     uid_ctr++;
 #ifndef ASSUME_PERFECT
     save_context(ctxt);
@@ -331,7 +334,7 @@ void before_ins_multi_mem(CONTEXT*                   ctxt,
         write_size = mem_access_info_from_pin->memop[i].bytesAccessed;
       }
 
-      save_mem(write_addr, write_size, i);
+      save_mem(write_addr, write_size);
     }
     finish_before_ins_all(ctxt, false);
   }
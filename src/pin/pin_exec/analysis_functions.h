@@ -34,9 +34,7 @@ void save_context(CONTEXT* ctxt);
 
 void check_if_region_written_to(ADDRINT write_addr);
 
-void save_mem(ADDRINT write_addr, UINT32 write_size, UINT write_index);
-
-void undo_mem(const ProcState& undo_state);
+void save_mem(ADDRINT write_addr, UINT32 write_size);
 
 void finish_before_ins_all(CONTEXT* ctxt, bool from_syscall);
 
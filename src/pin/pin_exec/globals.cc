@@ -27,6 +27,7 @@ Address_Tracker instrumented_rip_tracker;
 
 CirBuf<ProcState, checkpoints_init_capacity> checkpoints =
   CirBuf<ProcState, checkpoints_init_capacity>();
+Undo_Log undo_log;
 
 UINT64 uid_ctr = 0;
 UINT64 dbg_print_start_uid;
@@ -37,6 +38,8 @@ CONTEXT last_ctxt;
 ADDRINT next_eip;
 
 Client*                   scarab;
+Op_Ring*                  op_ring       = NULL;
+uint32_t                  op_ring_epoch = 0;
 ScarabOpBuffer_type       scarab_op_buffer;
 compressed_op             op_mailbox;
 bool                      op_mailbox_full           = false;
@@ -34,6 +34,7 @@
 #undef WARNING
 
 #include "../pin_lib/message_queue_interface_lib.h"
+#include "../pin_lib/op_ring.h"
 #include "read_mem_map.h"
 #include "utils.h"
 
@@ -44,6 +45,7 @@ extern Address_Tracker instrumented_rip_tracker;
 
 const int checkpoints_init_capacity = 512;
 extern CirBuf<ProcState, checkpoints_init_capacity> checkpoints;
+extern Undo_Log                                     undo_log;
 
 extern UINT64 uid_ctr;
 extern UINT64 dbg_print_start_uid;
@@ -54,6 +56,8 @@ extern CONTEXT last_ctxt;
 extern ADDRINT next_eip;
 
 extern Client*                   scarab;
+extern Op_Ring*                  op_ring;
+extern uint32_t                  op_ring_epoch;
 extern ScarabOpBuffer_type       scarab_op_buffer;
 extern compressed_op             op_mailbox;
 extern bool                      op_mailbox_full;
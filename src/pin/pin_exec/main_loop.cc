@@ -26,67 +26,73 @@
 #include "../pin_lib/decoder.h"
 
 namespace {
-void undo_mem(const ProcState& undo_state) {
-  for(uint i = 0; i < undo_state.num_mem_state; i++) {
-    void*  write_addr = (void*)undo_state.mem_state_list[i].mem_addr;
-    UINT32 write_size = undo_state.mem_state_list[i].mem_size;
-    void*  prev_data  = undo_state.mem_state_list[i].mem_data_ptr;
-    PIN_SafeCopy(write_addr, prev_data, write_size);
+// Checkpoint uids never decrease, so the youngest match is found by bisection
+INT64 find_checkpoint(UINT64 uid) {
+  INT64 lo = checkpoints.get_head_index();
+  INT64 hi = checkpoints.get_tail_index();
+  while(lo < hi) {
+    INT64 mid = lo + (hi - lo + 1) / 2;
+    if(checkpoints[mid].uid <= uid) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
   }
+  ASSERTM(0, !checkpoints.empty() && checkpoints[lo].uid == uid,
+          "Checkpoint %" PRIu64 " not found. \n", uid);
+  return lo;
 }
 
 void recover_to_past_checkpoint(UINT64 uid, bool is_redirect_recover,
                                 bool enter_ff) {
-  INT64 idx = checkpoints.get_tail_index();
+  INT64 idx = find_checkpoint(uid);
 
   scarab_clear_all_buffers();
 
-  while(!checkpoints.empty()) {
-    if(checkpoints[idx].uid == uid) {
-      // Resumes execution at the saved context
+  // Roll back every younger instruction at once
+  if(idx < checkpoints.get_tail_index()) {
+    ProcState& younger = checkpoints[idx + 1];
+    undo_log.undo(younger.undo_begin);
+    undo_log.truncate(younger.undo_begin);
+    if(is_redirect_recover && younger.uid == (uid + 1)) {
+      PIN_SaveContext(&(younger.ctxt), &last_ctxt);
+    }
+    checkpoints.remove_from_cir_buf_tail_after(idx);
+  }
 
-      ADDRINT this_eip;
+  // Resumes execution at the saved context
+  ProcState& ckp = checkpoints[idx];
+  ADDRINT    this_eip;
 
-      on_wrongpath          = checkpoints[idx].wrongpath;
-      on_wrongpath_nop_mode = checkpoints[idx].wrongpath_nop_mode;
-      generate_dummy_nops   = (generate_dummy_nops && on_wrongpath_nop_mode);
-      if(is_redirect_recover) {
-        return;
-      } else {
-        undo_mem(checkpoints[idx]);
-        PIN_SaveContext(&(checkpoints[idx].ctxt), &last_ctxt);
-
-        if(!on_wrongpath_nop_mode) {
-          if(enter_ff) {
-            excp_ff = true;
-            fast_forward_count += 2;
-            // pin skips (ffc - 1) instructions
-          } else {
-            idx = checkpoints.remove_from_cir_buf_tail();
-          }
-          PIN_ExecuteAt(&last_ctxt);
-          ASSERTM(0, false, "PIN_ExecuteAt did not redirect execution.\n");
-        } else {
-          ADDRINT prev_eip;
-          PIN_GetContextRegval(&last_ctxt, REG_INST_PTR, (UINT8*)&prev_eip);
-          this_eip = checkpoints[idx].wpnm_eip;
-          next_eip = ADDR_MASK(enter_ff ? this_eip : prev_eip);
-          return;
-        }
-      }
-      ASSERTM(0, false,
-              "Recover: found uid %" PRIu64 ", but eip not changed.\n", uid);
-    }
+  on_wrongpath          = ckp.wrongpath;
+  on_wrongpath_nop_mode = ckp.wrongpath_nop_mode;
+  generate_dummy_nops   = (generate_dummy_nops && on_wrongpath_nop_mode);
+  if(is_redirect_recover) {
+    return;
+  }
 
-    undo_mem(checkpoints[idx]);
+  // When re-executing the instruction in fast forward mode, its writes stay
+  // in the log so that an older recovery still undoes them
+  undo_log.undo(ckp.undo_begin);
+  PIN_SaveContext(&(ckp.ctxt), &last_ctxt);
 
-    if(is_redirect_recover && (checkpoints[idx].uid == (uid + 1))) {
-      PIN_SaveContext(&(checkpoints[idx].ctxt), &last_ctxt);
+  if(!on_wrongpath_nop_mode) {
+    if(enter_ff) {
+      excp_ff = true;
+      fast_forward_count += 2;
+      // pin skips (ffc - 1) instructions
+    } else {
+      undo_log.truncate(ckp.undo_begin);
+      checkpoints.remove_from_cir_buf_tail();
     }
-
-    idx = checkpoints.remove_from_cir_buf_tail();
+    PIN_ExecuteAt(&last_ctxt);
+    ASSERTM(0, false, "PIN_ExecuteAt did not redirect execution.\n");
+  } else {
+    ADDRINT prev_eip;
+    PIN_GetContextRegval(&last_ctxt, REG_INST_PTR, (UINT8*)&prev_eip);
+    this_eip = ckp.wpnm_eip;
+    next_eip = ADDR_MASK(enter_ff ? this_eip : prev_eip);
   }
-  ASSERTM(0, false, "Checkpoint %" PRIu64 " not found. \n", uid);
 }
 
 void redirect_to_inst(ADDRINT inst_addr, CONTEXT* ctxt, UINT64 uid) {
@@ -137,6 +143,9 @@ void retire_older_checkpoints(UINT64 uid) {
     }
   }
   ASSERTM(0, found_uid, "Checkpoint %" PRIu64 " not found. \n", uid);
+  undo_log.retire(checkpoints.empty() ?
+                    undo_log.end() :
+                    checkpoints[checkpoints.get_head_index()].undo_begin);
 }
 
 bool do_fe_recover(Scarab_To_Pin_Msg& cmd, CONTEXT* ctxt) {
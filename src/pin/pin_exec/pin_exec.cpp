@@ -325,6 +325,13 @@ int main(int argc, char* argv[]) {
   PIN_AddFiniFunction(Fini, 0);
 
   scarab = new Client(KnobSocketPath, KnobCoreId);
+  // Scarab creates the rings before it accepts connections
+  op_ring = op_ring_attach(KnobSocketPath.Value(), KnobCoreId.Value());
+  if(op_ring) {
+    ASSERTM(0, max_buffer_size <= OP_RING_SLOT_OPS,
+            "max_buffer_size (%u) does not fit in an op ring slot (%u)\n",
+            max_buffer_size, OP_RING_SLOT_OPS);
+  }
 
   // Start the program, never returns
   PIN_StartProgram();
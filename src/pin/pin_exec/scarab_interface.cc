@@ -21,12 +21,59 @@
 
 #include "scarab_interface.h"
 
+namespace {
+
+/* With the op ring, PIN does not wait for Scarab to ask for the next buffer:
+   while it is not stopped at a syscall or exception and the ring has room, a
+   missing command is treated as FE_FETCH_OP. Scarab's own FE_FETCH_OP is only
+   honored if it was sent after Scarab consumed every buffer sent so far. */
+Scarab_To_Pin_Msg get_ring_cmd() {
+  Scarab_To_Pin_Msg cmd;
+  uint32_t          spins = 0;
+
+  while(true) {
+    if(op_ring_pop_cmd(op_ring, &cmd)) {
+      if(cmd.type == FE_FETCH_OP && cmd.inst_uid != op_ring->op_head)
+        continue;
+      if(cmd.type == FE_REDIRECT || cmd.type == FE_RECOVER_BEFORE ||
+         cmd.type == FE_RECOVER_AFTER)
+        op_ring_epoch++;
+      return cmd;
+    }
+
+    bool run_ahead = !pending_fetch_op && !pending_syscall &&
+                     !pending_exception && !buffer_sentinel;
+    if(run_ahead && !op_ring_full(op_ring)) {
+      cmd.type      = FE_FETCH_OP;
+      cmd.inst_uid  = op_ring->op_head;
+      cmd.inst_addr = 0;
+      return cmd;
+    }
+    op_ring_wait(&spins);
+  }
+}
+
+void ring_send_buffer() {
+  uint64_t head  = op_ring->op_head;
+  uint32_t spins = 0;
+  while(op_ring_full(op_ring))
+    op_ring_wait(&spins);
+
+  Op_Ring_Slot* slot = &op_ring->ops[head % OP_RING_SLOTS];
+  slot->count        = scarab_op_buffer.size();
+  slot->epoch        = op_ring_epoch;
+  std::copy(scarab_op_buffer.begin(), scarab_op_buffer.end(), slot->ops);
+  op_ring_store(&op_ring->op_head, head + 1);
+}
+
+}  // namespace
+
 Scarab_To_Pin_Msg get_scarab_cmd() {
   Scarab_To_Pin_Msg cmd;
 
   DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
             "START: Receiving from Scarab\n");
-  cmd = scarab->receive<Scarab_To_Pin_Msg>();
+  cmd = op_ring ? get_ring_cmd() : scarab->receive<Scarab_To_Pin_Msg>();
   DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
             "END: %d Received from Scarab\n", cmd.type);
 
@@ -45,10 +92,14 @@ bool scarab_buffer_full() {
 }
 
 void scarab_send_buffer() {
-  Message<ScarabOpBuffer_type> message = scarab_op_buffer;
   DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
             "START: Sending message to Scarab.\n");
-  scarab->send(message);
+  if(op_ring) {
+    ring_send_buffer();
+  } else {
+    Message<ScarabOpBuffer_type> message = scarab_op_buffer;
+    scarab->send(message);
+  }
   DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
             "END: Sending message to Scarab.\n");
   scarab_op_buffer.clear();
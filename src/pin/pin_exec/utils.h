@@ -24,6 +24,7 @@
 
 #include <cinttypes>
 #include <stdio.h>
+#include <string.h>
 #include <unordered_map>
 
 #undef UNUSED
@@ -66,74 +67,119 @@
     }                                                                       \
   } while(0)
 
-struct MemState {
-  ADDRINT mem_addr;
-  UINT32  mem_size;
-  VOID*   mem_data_ptr;
+/* Bytes overwritten by in-flight instructions, oldest first, in one arena.
+   Positions are absolute and keep growing as entries retire, so a checkpoint
+   only needs to remember where its writes begin. Recovering to a checkpoint
+   rolls back everything after that position in a single pass. */
+class Undo_Log {
+  struct Undo_Record {
+    ADDRINT addr;
+    UINT64  offset;  // into bytes
+    UINT32  size;
+  };
+
+  Undo_Record* records       = NULL;
+  UINT8*       bytes         = NULL;
+  UINT64       base          = 0;  // absolute position of records[0]
+  UINT64       first         = 0;  // oldest record that has not retired
+  UINT64       num_records   = 0;
+  UINT64       num_bytes     = 0;
+  UINT64       records_space = 0;
+  UINT64       bytes_space   = 0;
+
+  UINT64 index(UINT64 pos) const {
+    ASSERTM(0, pos >= base + first && pos <= base + num_records,
+            "undo log position %llu outside [%llu, %llu]\n",
+            (unsigned long long)pos, (unsigned long long)(base + first),
+            (unsigned long long)(base + num_records));
+    return pos - base;
+  }
 
-  MemState() : mem_size(0), mem_data_ptr(NULL) {}
+  void reserve(UINT32 size) {
+    if(num_records == records_space) {
+      records_space = records_space ? records_space * 2 : 1024;
+      records = (Undo_Record*)realloc(records,
+                                      records_space * sizeof(Undo_Record));
+      ASSERTM(0, NULL != records, "realloc for undo log records failed\n");
+    }
+    if(num_bytes + size > bytes_space) {
+      while(num_bytes + size > bytes_space)
+        bytes_space = bytes_space ? bytes_space * 2 : 16384;
+      bytes = (UINT8*)realloc(bytes, bytes_space);
+      ASSERTM(0, NULL != bytes, "realloc for undo log bytes failed\n");
+    }
+  }
 
-  void resize(UINT32 new_mem_size) {
-    // we need to free the old mem_data_ptr if we need to reallocate a longer
-    // one
-    if(new_mem_size > mem_size) {
-      if(mem_data_ptr) {
-        free(mem_data_ptr);
-      }
+ public:
+  UINT64 end() const { return base + num_records; }
+
+  void save(ADDRINT addr, UINT32 size) {
+    reserve(size);
+    Undo_Record& rec = records[num_records++];
+    rec.addr         = addr;
+    rec.offset       = num_bytes;
+    rec.size         = size;
+    PIN_SafeCopy(bytes + num_bytes, (void*)addr, size);
+    num_bytes += size;
+  }
 
-      mem_data_ptr = malloc(new_mem_size);
+  // Writes back everything saved at or after pos, newest first
+  void undo(UINT64 pos) {
+    UINT64 stop = index(pos);
+    for(UINT64 i = num_records; i > stop; i--) {
+      const Undo_Record& rec = records[i - 1];
+      PIN_SafeCopy((void*)rec.addr, bytes + rec.offset, rec.size);
     }
   }
 
-  void init(ADDRINT _mem_addr, UINT32 _mem_size) {
-    resize(_mem_size);
-
-    mem_addr = _mem_addr;
-    mem_size = _mem_size;
+  // Forgets everything saved at or after pos
+  void truncate(UINT64 pos) {
+    UINT64 i = index(pos);
+    if(i < num_records) {
+      num_bytes   = records[i].offset;
+      num_records = i;
+    }
   }
 
-  ~MemState() {
-    if(mem_data_ptr) {
-      free(mem_data_ptr);
+  // Forgets everything saved before pos. The live part is moved to the front
+  // once the retired part is larger, to keep the arena bounded.
+  void retire(UINT64 pos) {
+    first = index(pos);
+    if(first == num_records) {
+      base += first;
+      first = num_records = num_bytes = 0;
+    } else if(first * 2 >= num_records) {
+      UINT64 shift = records[first].offset;
+      memmove(bytes, bytes + shift, num_bytes - shift);
+      memmove(records, records + first,
+              (num_records - first) * sizeof(Undo_Record));
+      base += first;
+      num_records -= first;
+      num_bytes -= shift;
+      first = 0;
+      for(UINT64 i = 0; i < num_records; i++)
+        records[i].offset -= shift;
     }
   }
 };
 
 struct ProcState {
-  UINT64    uid;
-  MemState* mem_state_list = NULL;
-  UINT      num_mem_state;
-  CONTEXT   ctxt;
-  bool      unretireable_instruction;
-  bool      wrongpath;
-  bool      wrongpath_nop_mode;
-  ADDRINT   wpnm_eip;
-
-  ProcState() : mem_state_list(NULL), num_mem_state(0) {}
+  UINT64  uid;
+  UINT64  undo_begin;  // Undo_Log position of this instruction's writes
+  CONTEXT ctxt;
+  bool    unretireable_instruction;
+  bool    wrongpath;
+  bool    wrongpath_nop_mode;
+  ADDRINT wpnm_eip;
 
   void init(UINT64 _uid, bool _u_i, bool _wrongpath, bool _wrongpath_nop_mode,
-            ADDRINT _wpnm_eip, UINT _num_mem_state) {
+            ADDRINT _wpnm_eip, UINT64 _undo_begin) {
     uid                      = _uid;
     unretireable_instruction = _u_i;
     wrongpath                = _wrongpath;
     wrongpath_nop_mode       = _wrongpath_nop_mode;
     wpnm_eip                 = _wpnm_eip;
-
-    if(_num_mem_state > num_mem_state) {
-      if(NULL != mem_state_list) {
-        free(mem_state_list);
-      }
-
-      mem_state_list = (MemState*)malloc(_num_mem_state * sizeof(MemState));
-    }
-
-    num_mem_state = _num_mem_state;
-  }
-
-  ~ProcState() {
-    if(NULL != mem_state_list) {
-      free(mem_state_list);
-    }
+    undo_begin               = _undo_begin;
   }
 };
 
@@ -233,6 +279,18 @@ class CirBuf {
     return cir_buf_tail_index;
   }
 
+  // Removes every entry younger than index
+  INT64 remove_from_cir_buf_tail_after(INT64 index) {
+    ASSERTM(0, index >= get_head_index() - 1 && index <= get_tail_index(),
+            "truncating to invalid index %lld\n", (long long int)index);
+    cir_buf_size -= cir_buf_tail_index - index;
+    cir_buf_tail_index = index;
+
+    check_cir_buf_invariant();
+
+    return cir_buf_tail_index;
+  }
+
   void append_to_cir_buf() {
     check_capacity();
 
@@ -0,0 +1,337 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ ** File         : compact_trace.h
+ ** Author       : HPS Research Group
+ ** Date         : 10/16/2026
+ ** Description  : Compact encoding of a ctype_pin_inst stream, shared by the
+ **                trace generator and the trace frontend.
+ **
+ ** The stream starts with COMPACT_TRACE_MAGIC, whose last character is the
+ ** format version; readers reject versions they do not know. Every record
+ ** begins with a
+ ** varint (index << 1 | define). Index selects an entry in the static
+ ** dictionary. The first time a PC is seen, define is set and the full
+ ** ctype_pin_inst follows; that record becomes the dictionary entry.
+ ** Otherwise a varint of Compact_Trace_Flags follows, then the fields that
+ ** the entry does not predict:
+ **   - the branch target and the next address (zigzag delta to the predicted
+ **     value),
+ **   - the load/store counts and sizes,
+ **   - each load and store address (zigzag delta to the same slot of the
+ **     previous instance of this PC).
+ ** Any other change falls back to a full record (CT_FULL). Every decoded
+ ** record replaces its dictionary entry. Address slots past num_ld/num_st
+ ** are not preserved. A record with index 0 and CT_RESET empties the
+ ** dictionary, so that the stream can be decoded from that point on (see
+ ** trace_index.h).
+ ****************************************************************************************/
+
+#ifndef __COMPACT_TRACE_H__
+#define __COMPACT_TRACE_H__
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "../../ctype_pin_inst.h"
+
+#define COMPACT_TRACE_MAGIC "SCRBCTR1"
+#define COMPACT_TRACE_MAGIC_LEN 8
+#define COMPACT_TRACE_ID_LEN 7  // magic without the version character
+#define COMPACT_TRACE_VERSION '1'
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Compact_Trace_Flags_enum {
+  CT_TAKEN  = 0x01,  // actually_taken
+  CT_TARGET = 0x02,  // branch_target differs from the dictionary entry
+  CT_NEXT   = 0x04,  // instruction_next_addr is not the fall-through/target
+  CT_COUNTS = 0x08,  // num_ld, num_st, ld_size, st_size follow
+  CT_FULL   = 0x10,  // a full ctype_pin_inst follows
+  CT_RESET  = 0x20,  // not a record, the dictionary starts over
+} Compact_Trace_Flags;
+
+/* Rebuilds the dynamic fields of a record from its dictionary entry. Shared by
+   the writer (to decide what to emit) and the reader. */
+class Compact_Trace_Codec {
+ protected:
+  std::vector<ctype_pin_inst> dict;
+  uint64_t                    last_uid;
+
+  Compact_Trace_Codec() : last_uid(0) {}
+
+  void clear() {
+    dict.clear();
+    last_uid = 0;
+  }
+
+  static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (v >> 63); }
+  static int64_t  unzigzag(uint64_t v) { return (v >> 1) ^ -(int64_t)(v & 1); }
+
+  static void clear_unused_addrs(ctype_pin_inst* inst) {
+    for(int ii = inst->num_ld; ii < MAX_LD_NUM; ii++)
+      inst->ld_vaddr[ii] = 0;
+    for(int ii = inst->num_st; ii < MAX_ST_NUM; ii++)
+      inst->st_vaddr[ii] = 0;
+  }
+
+  static uint64_t predicted_next(const ctype_pin_inst& inst) {
+    return inst.actually_taken ? inst.branch_target :
+                                 inst.instruction_addr + inst.size;
+  }
+};
+
+/**************************************************************************************/
+/* Writer */
+
+class Compact_Trace_Writer : public Compact_Trace_Codec {
+ public:
+  explicit Compact_Trace_Writer(FILE* stream) : stream(stream) {
+    put_bytes(COMPACT_TRACE_MAGIC, COMPACT_TRACE_MAGIC_LEN);
+  }
+
+  ~Compact_Trace_Writer() { flush(); }
+
+  /* Flushes to the current stream and continues in a new one, which a reader
+     can start decoding from. */
+  void restart(FILE* new_stream) {
+    flush();
+    stream = new_stream;
+    if(!dict.empty()) {
+      put_varint(0);
+      put_varint(CT_RESET);
+    }
+    clear();
+    pc_to_index.clear();
+  }
+
+  void write(const ctype_pin_inst& orig) {
+    ctype_pin_inst inst = orig;
+    clear_unused_addrs(&inst);
+
+    auto it = pc_to_index.find(inst.instruction_addr);
+    if(it == pc_to_index.end()) {
+      pc_to_index[inst.instruction_addr] = dict.size();
+      put_varint((dict.size() << 1) | 1);
+      put_bytes(&inst, sizeof(inst));
+      dict.push_back(inst);
+      last_uid = inst.inst_uid;
+      return;
+    }
+
+    ctype_pin_inst& entry = dict[it->second];
+    ctype_pin_inst  pred  = entry;
+    uint64_t        flags = inst.actually_taken ? CT_TAKEN : 0;
+
+    pred.actually_taken = inst.actually_taken;
+    pred.inst_uid       = last_uid + 1;
+    if(inst.branch_target != entry.branch_target) {
+      flags |= CT_TARGET;
+      pred.branch_target = inst.branch_target;
+    }
+    if(inst.num_ld != entry.num_ld || inst.num_st != entry.num_st ||
+       inst.ld_size != entry.ld_size || inst.st_size != entry.st_size) {
+      flags |= CT_COUNTS;
+      pred.num_ld  = inst.num_ld;
+      pred.num_st  = inst.num_st;
+      pred.ld_size = inst.ld_size;
+      pred.st_size = inst.st_size;
+    }
+    memcpy(pred.ld_vaddr, inst.ld_vaddr, sizeof(pred.ld_vaddr));
+    memcpy(pred.st_vaddr, inst.st_vaddr, sizeof(pred.st_vaddr));
+    uint64_t next_addr         = predicted_next(pred);
+    pred.instruction_next_addr = next_addr;
+    if(inst.instruction_next_addr != next_addr) {
+      flags |= CT_NEXT;
+      pred.instruction_next_addr = inst.instruction_next_addr;
+    }
+    if(memcmp(&pred, &inst, sizeof(inst)))
+      flags = CT_FULL;
+
+    put_varint(it->second << 1);
+    put_varint(flags);
+    if(flags & CT_FULL) {
+      put_bytes(&inst, sizeof(inst));
+    } else {
+      if(flags & CT_TARGET)
+        put_varint(zigzag(inst.branch_target - entry.branch_target));
+      if(flags & CT_NEXT)
+        put_varint(zigzag(inst.instruction_next_addr - next_addr));
+      if(flags & CT_COUNTS) {
+        uint8_t counts[4] = {inst.num_ld, inst.num_st, inst.ld_size,
+                             inst.st_size};
+        put_bytes(counts, sizeof(counts));
+      }
+      for(int ii = 0; ii < inst.num_ld; ii++)
+        put_varint(zigzag(inst.ld_vaddr[ii] - entry.ld_vaddr[ii]));
+      for(int ii = 0; ii < inst.num_st; ii++)
+        put_varint(zigzag(inst.st_vaddr[ii] - entry.st_vaddr[ii]));
+    }
+    entry    = inst;
+    last_uid = inst.inst_uid;
+  }
+
+  void flush() {
+    if(!buf.empty())
+      fwrite(buf.data(), 1, buf.size(), stream);
+    buf.clear();
+  }
+
+ private:
+  FILE*                                  stream;
+  std::vector<uint8_t>                   buf;
+  std::unordered_map<uint64_t, uint64_t> pc_to_index;
+
+  void put_bytes(const void* src, size_t len) {
+    buf.insert(buf.end(), (const uint8_t*)src, (const uint8_t*)src + len);
+    if(buf.size() >= 65536)
+      flush();
+  }
+
+  void put_varint(uint64_t v) {
+    while(v >= 0x80) {
+      buf.push_back((uint8_t)v | 0x80);
+      v >>= 7;
+    }
+    buf.push_back((uint8_t)v);
+  }
+};
+
+/**************************************************************************************/
+/* Reader */
+
+/* Read is a callable bool(void* dst, size_t len) that returns false at the end
+   of the underlying (already decompressed) stream. The magic is consumed by
+   the caller. */
+class Compact_Trace_Reader : public Compact_Trace_Codec {
+ public:
+  /* Why the last read() failed, or NULL if it reached the end of the stream
+     at a record boundary */
+  const char* error = NULL;
+
+  template <typename Read>
+  bool read(Read& get, ctype_pin_inst* inst) {
+    uint8_t  first;
+    uint64_t head, flags, v;
+    if(!get(&first, 1))
+      return false;
+    if(!get_varint(get, &head, first))
+      return fail("truncated record");
+
+    uint64_t index = head >> 1;
+    if(head & 1) {
+      if(index != dict.size())
+        return fail("dictionary entry out of order");
+      if(!get(inst, sizeof(*inst)))
+        return fail("truncated record");
+      dict.push_back(*inst);
+      last_uid = inst->inst_uid;
+      return true;
+    }
+    if(!get_varint(get, &flags))
+      return fail("truncated record");
+    if(flags & CT_RESET) {
+      clear();
+      return read(get, inst);
+    }
+    if(index >= dict.size())
+      return fail("dictionary index out of range");
+
+    ctype_pin_inst& entry = dict[index];
+
+    if(flags & CT_FULL) {
+      if(!get(inst, sizeof(*inst)))
+        return fail("truncated record");
+    } else {
+      *inst                = entry;
+      inst->actually_taken = (flags & CT_TAKEN) ? 1 : 0;
+      inst->inst_uid       = last_uid + 1;
+      if(flags & CT_TARGET) {
+        if(!get_varint(get, &v))
+          return fail("truncated record");
+        inst->branch_target = entry.branch_target + unzigzag(v);
+      }
+      inst->instruction_next_addr = predicted_next(*inst);
+      if(flags & CT_NEXT) {
+        if(!get_varint(get, &v))
+          return fail("truncated record");
+        inst->instruction_next_addr += unzigzag(v);
+      }
+      if(flags & CT_COUNTS) {
+        uint8_t counts[4];
+        if(!get(counts, sizeof(counts)))
+          return fail("truncated record");
+        inst->num_ld  = counts[0];
+        inst->num_st  = counts[1];
+        inst->ld_size = counts[2];
+        inst->st_size = counts[3];
+      }
+      if(inst->num_ld > MAX_LD_NUM || inst->num_st > MAX_ST_NUM)
+        return fail("too many loads or stores");
+      for(int ii = 0; ii < inst->num_ld; ii++) {
+        if(!get_varint(get, &v))
+          return fail("truncated record");
+        inst->ld_vaddr[ii] = entry.ld_vaddr[ii] + unzigzag(v);
+      }
+      for(int ii = 0; ii < inst->num_st; ii++) {
+        if(!get_varint(get, &v))
+          return fail("truncated record");
+        inst->st_vaddr[ii] = entry.st_vaddr[ii] + unzigzag(v);
+      }
+      clear_unused_addrs(inst);
+    }
+    entry    = *inst;
+    last_uid = inst->inst_uid;
+    return true;
+  }
+
+ private:
+  bool fail(const char* why) {
+    error = why;
+    return false;
+  }
+
+  template <typename Read>
+  static bool get_varint(Read& get, uint64_t* v) {
+    uint8_t byte;
+    return get(&byte, 1) && get_varint(get, v, byte);
+  }
+
+  /* Same, with the first byte already read. Fails on an overlong varint too. */
+  template <typename Read>
+  static bool get_varint(Read& get, uint64_t* v, uint8_t byte) {
+    *v = 0;
+    for(int shift = 0; shift < 64; shift += 7) {
+      if(shift && !get(&byte, 1))
+        return false;
+      *v |= (uint64_t)(byte & 0x7f) << shift;
+      if(!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+};
+
+#endif  // __COMPACT_TRACE_H__
@@ -0,0 +1,176 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : op_ring.h
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Shared-memory rings between one pin_exec client and Scarab.
+ *
+ * The rings replace the per-buffer socket round trip of the exec-driven
+ * frontend. Scarab creates one mapping per core next to the socket (the
+ * socket is still used to connect and to detect shutdown); pin_exec maps it
+ * after connecting. Both rings are single-producer/single-consumer:
+ *   - ops:  buffers of compressed_ops written by PIN. PIN fills slots ahead of
+ *           Scarab's fetch requests while the ring has room. Every slot carries
+ *           the number of redirects/recoveries PIN had seen when it was built,
+ *           so Scarab can drop slots from before its last redirect.
+ *   - cmds: Scarab_To_Pin_Msgs written by Scarab. FE_FETCH_OP carries the
+ *           number of op slots Scarab had consumed, which PIN uses to ignore
+ *           requests that were already satisfied by running ahead.
+ * Only the open/mmap calls are used, so that the header also builds against
+ * the Pin CRT.
+ ***************************************************************************************/
+
+#ifndef __OP_RING_H__
+#define __OP_RING_H__
+
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string>
+
+#include "pin_scarab_common_lib.h"
+
+#define OP_RING_MAGIC "SCRBORG1"
+#define OP_RING_SLOTS 64      // op buffers in flight, power of 2
+#define OP_RING_SLOT_OPS 64   // max ops per buffer
+#define OP_RING_CMDS 1024     // commands in flight, power of 2
+#define OP_RING_SPINS 1024    // pause iterations before yielding the CPU
+#define OP_RING_LINE 64
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Op_Ring_Slot_struct {
+  uint32_t      count;  // valid entries in ops
+  uint32_t      epoch;  // redirects + recoveries seen by PIN
+  compressed_op ops[OP_RING_SLOT_OPS];
+} Op_Ring_Slot;
+
+/* Heads are only written by the producer, tails only by the consumer. Each
+   index lives on its own line to keep the two processes from false sharing. */
+typedef struct Op_Ring_struct {
+  char              magic[8];
+  alignas(OP_RING_LINE) uint64_t op_head;   // op slots written by PIN
+  alignas(OP_RING_LINE) uint64_t op_tail;   // op slots consumed by Scarab
+  alignas(OP_RING_LINE) uint64_t cmd_head;  // commands written by Scarab
+  alignas(OP_RING_LINE) uint64_t cmd_tail;  // commands consumed by PIN
+  alignas(OP_RING_LINE) Op_Ring_Slot ops[OP_RING_SLOTS];
+  Scarab_To_Pin_Msg cmds[OP_RING_CMDS];
+} Op_Ring;
+
+/**************************************************************************************/
+/* Mapping */
+
+inline std::string op_ring_path(const std::string& socket_path,
+                                uint32_t           core_id) {
+  std::string name = socket_path;
+  for(char& c : name)
+    if(c == '/')
+      c = '_';
+  return "/dev/shm/scarab_op_ring" + name + "." + std::to_string(core_id);
+}
+
+inline Op_Ring* op_ring_map(const std::string& path, bool create) {
+  if(create)
+    unlink(path.c_str());
+  int fd = open(path.c_str(), create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR,
+                0600);
+  if(fd < 0)
+    return NULL;
+  if(create && ftruncate(fd, sizeof(Op_Ring))) {
+    close(fd);
+    return NULL;
+  }
+  void* addr = mmap(NULL, sizeof(Op_Ring), PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+  close(fd);
+  if(addr == MAP_FAILED)
+    return NULL;
+
+  Op_Ring* ring = (Op_Ring*)addr;
+  if(create) {
+    memcpy(ring->magic, OP_RING_MAGIC, sizeof(ring->magic));
+  } else if(memcmp(ring->magic, OP_RING_MAGIC, sizeof(ring->magic))) {
+    munmap(addr, sizeof(Op_Ring));
+    return NULL;
+  }
+  return ring;
+}
+
+/* Returns NULL when Scarab did not create a ring for this core. */
+inline Op_Ring* op_ring_attach(const std::string& socket_path,
+                               uint32_t           core_id) {
+  return op_ring_map(op_ring_path(socket_path, core_id), false);
+}
+
+inline void op_ring_unmap(Op_Ring* ring) {
+  munmap(ring, sizeof(Op_Ring));
+}
+
+/**************************************************************************************/
+/* Synchronization */
+
+inline uint64_t op_ring_load(const uint64_t* index) {
+  return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+inline void op_ring_store(uint64_t* index, uint64_t value) {
+  __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+/* Called in a polling loop; spins briefly, then gives up the CPU so that the
+   two processes can share a core. */
+inline void op_ring_wait(uint32_t* spins) {
+  if(++*spins < OP_RING_SPINS)
+    __builtin_ia32_pause();
+  else
+    sched_yield();
+}
+
+/* Producer side of the command ring (Scarab). */
+inline void op_ring_push_cmd(Op_Ring* ring, const Scarab_To_Pin_Msg& msg) {
+  uint64_t head  = ring->cmd_head;
+  uint32_t spins = 0;
+  while(head - op_ring_load(&ring->cmd_tail) >= OP_RING_CMDS)
+    op_ring_wait(&spins);
+  ring->cmds[head % OP_RING_CMDS] = msg;
+  op_ring_store(&ring->cmd_head, head + 1);
+}
+
+/* Consumer side of the command ring (PIN). Returns false if it is empty. */
+inline bool op_ring_pop_cmd(Op_Ring* ring, Scarab_To_Pin_Msg* msg) {
+  uint64_t tail = ring->cmd_tail;
+  if(op_ring_load(&ring->cmd_head) == tail)
+    return false;
+  *msg = ring->cmds[tail % OP_RING_CMDS];
+  op_ring_store(&ring->cmd_tail, tail + 1);
+  return true;
+}
+
+inline bool op_ring_full(Op_Ring* ring) {
+  return ring->op_head - op_ring_load(&ring->op_tail) >= OP_RING_SLOTS;
+}
+
+#endif  // __OP_RING_H__
@@ -41,9 +41,13 @@ extern "C" {
 
 enum class CustomOp : uint8_t { NONE, PREFETCH_CODE };
 
+struct MemtraceInstRecord;
+
 struct InstInfo {
   uint64_t                  pc;           // instruction address
-  const xed_decoded_inst_t* ins;          // XED info
+  const xed_decoded_inst_t* ins;          // XED info (may be NULL if rec is
+                                          // from the instruction cache)
+  const MemtraceInstRecord* rec;          // decoded static info
   uint64_t                  pid;          // process ID
   uint64_t                  tid;          // thread ID
   uint64_t                  target;       // branch target
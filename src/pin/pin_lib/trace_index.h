@@ -0,0 +1,70 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ ** File         : trace_index.h
+ ** Author       : HPS Research Group
+ ** Date         : 10/16/2026
+ ** Description  : Sidecar index of a trace, written by the trace generator
+ **                next to the trace as <trace>.idx and used by the trace
+ **                frontend to seek.
+ **
+ ** The generator closes the compressed stream every `interval` records and
+ ** starts a new one, resetting the compact dictionary, so that each block can
+ ** be decoded on its own. A TRACE_INDEX_BLOCK entry gives the record number
+ ** and the file offset at which a block starts. A TRACE_INDEX_ROI entry gives
+ ** the record number of an `xchg rcx,rcx` ROI marker (offset is unused).
+ ** Entries of each kind are sorted by record number. The offsets only hold for
+ ** the file as written, so the header keeps its size.
+ ****************************************************************************************/
+
+#ifndef __TRACE_INDEX_H__
+#define __TRACE_INDEX_H__
+
+#include <stdint.h>
+
+#define TRACE_INDEX_MAGIC "SCRBTIX1"
+#define TRACE_INDEX_MAGIC_LEN 8
+#define TRACE_INDEX_SUFFIX ".idx"
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Trace_Index_Kind_enum {
+  TRACE_INDEX_BLOCK,
+  TRACE_INDEX_ROI,
+} Trace_Index_Kind;
+
+typedef struct Trace_Index_Header_struct {
+  char     magic[TRACE_INDEX_MAGIC_LEN];
+  uint64_t trace_size;  // size of the trace file the offsets refer to
+  uint64_t interval;    // records per block
+  uint64_t count;       // number of entries that follow
+} Trace_Index_Header;
+
+typedef struct Trace_Index_Entry_struct {
+  uint64_t inst;    // record number, counting from 0
+  uint64_t offset;  // file offset of the block (TRACE_INDEX_BLOCK only)
+  uint32_t kind;    // Trace_Index_Kind
+  uint32_t pad;
+} Trace_Index_Entry;
+
+#endif  // __TRACE_INDEX_H__
@@ -58,6 +58,8 @@ END_LEGAL */
 #include <stddef.h>
 #include <stdio.h>
 #include <string>
+#include <sys/stat.h>
+#include <vector>
 
 #include "control_manager.H"
 #include "instlib.H"
@@ -77,6 +79,8 @@ using namespace CONTROLLER;
 
 #include "../../ctype_pin_inst.h"
 #include "../../table_info.h"
+#include "../pin_lib/compact_trace.h"
+#include "../pin_lib/trace_index.h"
 
 std::vector<std::string> iclass_prints;
 
@@ -95,6 +99,14 @@ KNOB<BOOL> KnobPinPlayReplayer(KNOB_MODE_WRITEONCE, "pintool", "replay", "0",
 // Knobs that control trace generation
 KNOB<string> Knob_output(KNOB_MODE_WRITEONCE, "pintool", "o", "trace.bz2",
                          "trace outputfilename");
+KNOB<BOOL>   Knob_compact(KNOB_MODE_WRITEONCE, "pintool", "compact", "0",
+                        "write the compact (dictionary + delta) trace format "
+                        "instead of packed ctype_pin_inst records; older "
+                        "Scarab builds cannot read it");
+KNOB<UINT64> Knob_index_interval(
+  KNOB_MODE_WRITEONCE, "pintool", "index_interval", "10000000",
+  "start an independently decodable block every this many instructions and "
+  "write their offsets (and the ROI markers) to <trace>.idx (0: no index)");
 
 // Trace start and end options
 KNOB<UINT64> KnobStartRip(
@@ -108,7 +120,12 @@ KNOB<UINT64> KnobFastForward(
   "Number of instructions to fast-forward before generating the trace");
 
 /*** globals ***/
-FILE* output_stream;
+FILE*                 output_stream;
+Compact_Trace_Writer* compact_writer = NULL;
+
+std::vector<Trace_Index_Entry> trace_index;
+uint64_t                       insts_written = 0;
+uint64_t                       insts_dumped  = 0;
 
 ctype_pin_inst mailbox;
 bool           mailbox_full = false;
@@ -125,6 +142,73 @@ INT32 Usage() {
   return -1;
 }
 
+uint64_t output_size() {
+  struct stat st;
+  if(stat(Knob_output.Value().c_str(), &st)) {
+    std::cerr << "Cannot stat " << Knob_output.Value() << "\n";
+    PIN_ExitProcess(1);
+  }
+  return st.st_size;
+}
+
+void open_output(const char* mode) {
+  char popename[1024];
+  sprintf(popename, "bzip2 %s %s", mode, Knob_output.Value().c_str());
+  output_stream = popen(popename, "w");
+}
+
+void add_index_entry(uint64_t inst, uint64_t offset, Trace_Index_Kind kind) {
+  Trace_Index_Entry entry;
+  entry.inst   = inst;
+  entry.offset = offset;
+  entry.kind   = kind;
+  entry.pad    = 0;
+  trace_index.push_back(entry);
+}
+
+/* Ends the current bzip2 stream and appends a new one, so that a reader can
+   start decompressing at its offset. */
+void start_block() {
+  if(compact_writer)
+    compact_writer->flush();
+  pclose(output_stream);
+  add_index_entry(insts_written, output_size(), TRACE_INDEX_BLOCK);
+  open_output(">>");
+  if(compact_writer)
+    compact_writer->restart(output_stream);
+}
+
+void write_index() {
+  Trace_Index_Header header;
+  std::string        name = Knob_output.Value() + TRACE_INDEX_SUFFIX;
+  FILE*              file = fopen(name.c_str(), "wb");
+  if(!file) {
+    std::cerr << "Cannot write trace index " << name << "\n";
+    return;
+  }
+  memcpy(header.magic, TRACE_INDEX_MAGIC, TRACE_INDEX_MAGIC_LEN);
+  header.trace_size = output_size();
+  header.interval   = Knob_index_interval.Value();
+  header.count      = trace_index.size();
+  fwrite(&header, sizeof(header), 1, file);
+  fwrite(trace_index.data(), sizeof(Trace_Index_Entry), trace_index.size(),
+         file);
+  fclose(file);
+}
+
+void write_instruction(const ctype_pin_inst& inst) {
+  if(Knob_index_interval.Value() && insts_written &&
+     insts_written % Knob_index_interval.Value() == 0) {
+    start_block();
+  }
+  insts_written++;
+  if(compact_writer) {
+    compact_writer->write(inst);
+  } else {
+    fwrite(&inst, sizeof(inst), 1, output_stream);
+  }
+}
+
 void change_rip(CONTEXT* ctx) {
   std::cout << "Changing RIP to " << std::hex << KnobStartRip.Value() << "\n";
   need_to_change_rip = false;
@@ -137,9 +221,12 @@ LOCALFUN VOID Fini(int n, void* v) {
   pin_decoder_print_unknown_opcodes();
   if(output_stream) {
     if(mailbox_full) {
-      fwrite(&mailbox, sizeof(mailbox), 1, output_stream);
+      write_instruction(mailbox);
     }
+    delete compact_writer;
     pclose(output_stream);
+    if(Knob_index_interval.Value())
+      write_index();
   }
 }
 
@@ -171,19 +258,30 @@ void check_end_of_trace() {
   trace_insts_left -= 1;
 }
 
-void dump_instruction() {
+void dump_instruction(BOOL roi_marker) {
   if(skip_dumping_instructions)
     return;
 
+  if(roi_marker)
+    add_index_entry(insts_dumped, 0, TRACE_INDEX_ROI);
+  insts_dumped++;
+
   ctype_pin_inst* info = pin_decoder_get_latest_inst();
   if(mailbox_full) {
     mailbox.instruction_next_addr = info->instruction_addr;
-    fwrite(&mailbox, sizeof(mailbox), 1, output_stream);
+    write_instruction(mailbox);
   }
   mailbox      = *info;
   mailbox_full = true;
 }
 
+/* xchg rcx,rcx marks the region of interest */
+BOOL is_roi_marker(const INS& ins) {
+  return INS_Opcode(ins) == XED_ICLASS_XCHG && INS_OperandIsReg(ins, 0) &&
+         INS_OperandIsReg(ins, 1) && INS_OperandReg(ins, 0) == REG_RCX &&
+         INS_OperandReg(ins, 1) == REG_RCX;
+}
+
 template <typename Func>
 void for_ins_in_trace(const TRACE& trace, Func f) {
   for(BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
@@ -208,7 +306,8 @@ void insert_instrumentation(TRACE trace, void* v) {
       INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)check_end_of_trace, IARG_END);
       pin_decoder_insert_analysis_functions(ins);
       if(output_stream) {
-        INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)dump_instruction, IARG_END);
+        INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)dump_instruction,
+                       IARG_BOOL, is_roi_marker(ins), IARG_END);
       }
     });
   }
@@ -222,9 +321,12 @@ int main(int argc, char* argv[]) {
   pinplay_engine.Activate(argc, argv, KnobPinPlayLogger, KnobPinPlayReplayer);
 
   if(!Knob_output.Value().empty()) {
-    char popename[1024];
-    sprintf(popename, "bzip2 > %s", Knob_output.Value().c_str());
-    output_stream = popen(popename, "w");
+    open_output(">");
+    if(Knob_index_interval.Value())
+      add_index_entry(0, 0, TRACE_INDEX_BLOCK);
+    if(Knob_compact.Value()) {
+      compact_writer = new Compact_Trace_Writer(output_stream);
+    }
   } else {
     cout << "No trace specified. Only verifying opcodes." << endl;
   }
@@ -0,0 +1,367 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : power_engine.c
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : In-process power model.
+ *
+ * The dynamic energy of a domain is modeled as a weighted sum of its POWER_*
+ * events. The weights below only fix the ratios between the events of a
+ * domain; the energy scale of each domain is fitted to the runtime dynamic
+ * power McPAT/CACTI report for the calibration interval. Static, leakage and
+ * peak results, voltage and frequency depend on the configuration only, so
+ * they are taken from the same run. Calibrations are kept in POWER_INTF_CACHE
+ * under a hash of the McPAT/CACTI input without its stats.
+ ***************************************************************************************/
+
+#include "power/power_engine.h"
+#include <stdio.h>
+#include <string.h>
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/utils.h"
+#include "statistics.h"
+
+#include "core.param.h"
+#include "debug/debug.param.h"
+#include "general.param.h"
+#include "power/power.param.h"
+#include "power/power_scarab_config.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#undef DEBUG
+#define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_POWER_UTILS, ##args)
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Power_Event_Scope_enum {
+  POWER_EVENT_CORE,    // charged to the domain of the core that counted it
+  POWER_EVENT_UNCORE,  // summed over all cores, charged to the uncore
+  POWER_EVENT_MEMORY,  // summed over all cores, charged to the DRAM
+} Power_Event_Scope;
+
+typedef struct Power_Event_struct {
+  Stat_Enum         stat;
+  Power_Event_Scope scope;
+  double            weight;  // nominal energy per event, nJ
+} Power_Event;
+
+/**************************************************************************************/
+/* Global Variables */
+
+/* Nominal per-event energies of a 22nm core at 3.2GHz */
+static const Power_Event power_events[] = {
+  {POWER_CYCLE, POWER_EVENT_CORE, 0.150},  // clock network and idle pipeline
+  {POWER_ITLB_ACCESS, POWER_EVENT_CORE, 0.005},
+  {POWER_DTLB_ACCESS, POWER_EVENT_CORE, 0.005},
+  {POWER_ICACHE_ACCESS, POWER_EVENT_CORE, 0.030},
+  {POWER_ICACHE_MISS, POWER_EVENT_CORE, 0.040},
+  {POWER_BTB_READ, POWER_EVENT_CORE, 0.010},
+  {POWER_BTB_WRITE, POWER_EVENT_CORE, 0.012},
+  {POWER_ROB_READ, POWER_EVENT_CORE, 0.008},
+  {POWER_ROB_WRITE, POWER_EVENT_CORE, 0.010},
+  {POWER_RENAME_READ, POWER_EVENT_CORE, 0.004},
+  {POWER_RENAME_WRITE, POWER_EVENT_CORE, 0.006},
+  {POWER_FP_RENAME_READ, POWER_EVENT_CORE, 0.004},
+  {POWER_FP_RENAME_WRITE, POWER_EVENT_CORE, 0.006},
+  {POWER_FUNCTION_CALL, POWER_EVENT_CORE, 0.002},
+  {POWER_INST_WINDOW_READ, POWER_EVENT_CORE, 0.010},
+  {POWER_INST_WINDOW_WRITE, POWER_EVENT_CORE, 0.012},
+  {POWER_INST_WINDOW_WAKEUP_ACCESS, POWER_EVENT_CORE, 0.003},
+  {POWER_INT_REGFILE_READ, POWER_EVENT_CORE, 0.004},
+  {POWER_INT_REGFILE_WRITE, POWER_EVENT_CORE, 0.006},
+  {POWER_IALU_ACCESS, POWER_EVENT_CORE, 0.020},
+  {POWER_CDB_IALU_ACCESS, POWER_EVENT_CORE, 0.005},
+  {POWER_MUL_ACCESS, POWER_EVENT_CORE, 0.080},
+  {POWER_CDB_MUL_ACCESS, POWER_EVENT_CORE, 0.005},
+  {POWER_FP_INST_WINDOW_READ, POWER_EVENT_CORE, 0.012},
+  {POWER_FP_INST_WINDOW_WRITE, POWER_EVENT_CORE, 0.012},
+  {POWER_FP_INST_WINDOW_WAKEUP_ACCESS, POWER_EVENT_CORE, 0.003},
+  {POWER_FP_REGFILE_READ, POWER_EVENT_CORE, 0.006},
+  {POWER_FP_REGFILE_WRITE, POWER_EVENT_CORE, 0.008},
+  {POWER_FPU_ACCESS, POWER_EVENT_CORE, 0.120},
+  {POWER_CDB_FPU_ACCESS, POWER_EVENT_CORE, 0.008},
+  {POWER_DCACHE_READ_ACCESS, POWER_EVENT_CORE, 0.040},
+  {POWER_DCACHE_WRITE_ACCESS, POWER_EVENT_CORE, 0.045},
+  {POWER_DCACHE_READ_MISS, POWER_EVENT_CORE, 0.050},
+  {POWER_DCACHE_WRITE_MISS, POWER_EVENT_CORE, 0.050},
+  {POWER_BRANCH_MISPREDICT, POWER_EVENT_CORE, 0.100},  // flush and refetch
+  {POWER_LLC_READ_ACCESS, POWER_EVENT_UNCORE, 0.250},
+  {POWER_LLC_WRITE_ACCESS, POWER_EVENT_UNCORE, 0.280},
+  {POWER_LLC_READ_MISS, POWER_EVENT_UNCORE, 0.300},
+  {POWER_LLC_WRITE_MISS, POWER_EVENT_UNCORE, 0.300},
+  {POWER_MEMORY_CTRL_READ, POWER_EVENT_UNCORE, 0.100},
+  {POWER_MEMORY_CTRL_WRITE, POWER_EVENT_UNCORE, 0.100},
+  {POWER_DRAM_PRECHARGE, POWER_EVENT_MEMORY, 1.400},
+  {POWER_DRAM_ACTIVATE, POWER_EVENT_MEMORY, 1.500},
+  {POWER_DRAM_READ, POWER_EVENT_MEMORY, 1.200},
+  {POWER_DRAM_WRITE, POWER_EVENT_MEMORY, 1.300},
+};
+
+#define NUM_POWER_EVENTS (sizeof(power_events) / sizeof(power_events[0]))
+
+static Flag          cache_checked;
+static Flag          calibrated;
+static uns64         config_hash;
+static Power_Results calib;  // static results, DYNAMIC holds J per nJ weight
+static Counter       last_counts[MAX_NUM_PROCS][NUM_POWER_EVENTS];
+static Counter       last_cycles;
+static double        check_energy[POWER_DOMAIN_NUM_ELEMS];  // J, for the check
+static FILE*         check_log;
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static double consume_activity(double activity[POWER_DOMAIN_NUM_ELEMS]);
+static double eval_activity(Power_Results* results);
+static void   load_calibration(void);
+static void   store_calibration(void);
+
+/**************************************************************************************/
+/* consume_activity: Weighted event counts of each domain since the last call.
+   Returns the length of the interval at the reference chip frequency. */
+
+static double consume_activity(double activity[POWER_DOMAIN_NUM_ELEMS]) {
+  memset(activity, 0, sizeof(double) * POWER_DOMAIN_NUM_ELEMS);
+
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    for(uns ii = 0; ii < NUM_POWER_EVENTS; ii++) {
+      Power_Event const* event = &power_events[ii];
+      Counter            count = GET_TOTAL_STAT_EVENT(proc_id, event->stat);
+      /* reset_stats() may have cleared the counter since the last call */
+      Counter last = count >= last_counts[proc_id][ii] ?
+                       last_counts[proc_id][ii] :
+                       0;
+      double energy            = event->weight * (double)(count - last);
+      last_counts[proc_id][ii] = count;
+      switch(event->scope) {
+        case POWER_EVENT_CORE:
+          activity[POWER_DOMAIN_CORE_0 + proc_id] += energy;
+          break;
+        case POWER_EVENT_UNCORE:
+          activity[POWER_DOMAIN_UNCORE] += energy;
+          break;
+        case POWER_EVENT_MEMORY:
+          activity[POWER_DOMAIN_MEMORY] += energy;
+          break;
+      }
+    }
+  }
+
+  /* McPAT and the DRAM model both take the interval as the chip cycles of core
+     0 at the reference frequency */
+  Counter cycles = GET_TOTAL_STAT_EVENT(0, POWER_CYCLE);
+  Counter last   = cycles >= last_cycles ? last_cycles : 0;
+  last_cycles    = cycles;
+  return (double)(cycles - last) / POWER_INTF_REF_CHIP_FREQ;
+}
+
+/**************************************************************************************/
+/* power_engine_calibrated: */
+
+Flag power_engine_calibrated(void) {
+  if(!cache_checked) {
+    cache_checked = TRUE;
+    config_hash   = power_config_hash();
+    if(POWER_INTF_CACHE)
+      load_calibration();
+  }
+  return calibrated;
+}
+
+/**************************************************************************************/
+/* power_engine_calibrate: */
+
+void power_engine_calibrate(Power_Results const* ref) {
+  double activity[POWER_DOMAIN_NUM_ELEMS];
+  double ref_time = consume_activity(activity);
+
+  memset(&calib, 0, sizeof(calib));
+  for(uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; domain++) {
+    if(!ref->set[domain][POWER_RESULT_STATIC])
+      continue;
+    for(uns result = 0; result < POWER_RESULT_NUM_ELEMS; result++) {
+      if(result == POWER_RESULT_DYNAMIC || result == POWER_RESULT_TOTAL)
+        continue;
+      calib.set[domain][result]   = ref->set[domain][result];
+      calib.value[domain][result] = ref->value[domain][result];
+    }
+
+    /* Without activity to fit to, take the nominal weights as they are */
+    double scale = 1.0e-9;
+    if(ref->set[domain][POWER_RESULT_DYNAMIC] && activity[domain] > 0.0)
+      scale = ref->value[domain][POWER_RESULT_DYNAMIC] * ref_time /
+              activity[domain];
+    calib.set[domain][POWER_RESULT_DYNAMIC]   = TRUE;
+    calib.value[domain][POWER_RESULT_DYNAMIC] = scale;
+    check_energy[domain]                      = scale * activity[domain];
+    DEBUG(0, "Power engine: %s energy scale %le J/nJ\n",
+          Power_Domain_str(domain), scale);
+  }
+
+  calibrated = TRUE;
+  if(POWER_INTF_CACHE)
+    store_calibration();
+}
+
+/**************************************************************************************/
+/* power_engine_eval: */
+
+void power_engine_eval(Power_Results* results) {
+  eval_activity(results);
+}
+
+/* eval_activity: power_engine_eval, returning the length of the interval */
+
+static double eval_activity(Power_Results* results) {
+  ASSERT(0, calibrated);
+  double activity[POWER_DOMAIN_NUM_ELEMS];
+  double ref_time = consume_activity(activity);
+
+  *results = calib;
+  for(uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; domain++) {
+    if(!calib.set[domain][POWER_RESULT_DYNAMIC])
+      continue;
+    results->value[domain][POWER_RESULT_DYNAMIC] =
+      ref_time > 0.0 ?
+        calib.value[domain][POWER_RESULT_DYNAMIC] * activity[domain] /
+          ref_time :
+        0.0;
+  }
+  return ref_time;
+}
+
+/**************************************************************************************/
+/* power_engine_check: McPAT/CACTI see the stats since the start of the run (or
+   the last reset_stats()), so the model's energy is summed over the same
+   span. Logs "<cycles>\t<domain>\t<ref W>\t<model W>\t<error %>" lines. */
+
+void power_engine_check(Power_Results const* ref) {
+  Power_Results results;
+  double        ref_time   = eval_activity(&results);
+  Counter       cycles     = GET_TOTAL_STAT_EVENT(0, POWER_CYCLE);
+  double        total_time = (double)cycles / POWER_INTF_REF_CHIP_FREQ;
+
+  if(!check_log) {
+    check_log = file_tag_fopen(NULL, "power_check", "w");
+    ASSERTM(0, check_log, "Could not open power check log file\n");
+  }
+  /* after reset_stats() the interval is all there is */
+  if(total_time <= ref_time)
+    memset(check_energy, 0, sizeof(check_energy));
+
+  for(uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; domain++) {
+    if(!results.set[domain][POWER_RESULT_DYNAMIC] ||
+       !ref->set[domain][POWER_RESULT_DYNAMIC])
+      continue;
+    check_energy[domain] += results.value[domain][POWER_RESULT_DYNAMIC] *
+                            ref_time;
+    if(total_time <= 0.0)
+      continue;
+    double ref_power   = ref->value[domain][POWER_RESULT_DYNAMIC];
+    double model_power = check_energy[domain] / total_time;
+    fprintf(check_log, "%llu\t%s\t%le\t%le\t%+.2f\n", cycles,
+            Power_Domain_str(domain), ref_power, model_power,
+            ref_power > 0.0 ? 100.0 * (model_power / ref_power - 1.0) : 0.0);
+  }
+  fflush(check_log);
+}
+
+/**************************************************************************************/
+/* load_calibration: Find the calibration of this configuration in
+   POWER_INTF_CACHE. Each calibration is a "config <hash>" line, one
+   "<domain>\t<result>\t<value>" line per result (DYNAMIC holding the energy
+   scale) and an "end" line. */
+
+static void load_calibration(void) {
+  FILE* file = fopen(POWER_INTF_CACHE, "r");
+  if(!file)
+    return;
+
+  char  line[MAX_STR_LENGTH + 1];
+  char  domain_str[MAX_STR_LENGTH + 1];
+  char  result_str[MAX_STR_LENGTH + 1];
+  uns64 hash;
+  Flag  in_match = FALSE;
+
+  while(fgets(line, MAX_STR_LENGTH, file)) {
+    if(sscanf(line, "config %llx", &hash) == 1) {
+      in_match = hash == config_hash;
+      if(in_match)
+        memset(&calib, 0, sizeof(calib));
+      continue;
+    }
+    if(!strncmp(line, "end", 3)) {
+      if(in_match) {
+        calibrated = TRUE;
+        break;
+      }
+      continue;
+    }
+    if(!in_match)
+      continue;
+
+    double value;
+    uns    num_matches = sscanf(line, "%s\t%s\t%le", domain_str, result_str,
+                             &value);
+    ASSERTM(0, num_matches == 3, "Malformed line in %s: %s\n",
+            POWER_INTF_CACHE, line);
+    Power_Domain domain         = Power_Domain_parse(domain_str);
+    Power_Result result         = Power_Result_parse(result_str);
+    calib.set[domain][result]   = TRUE;
+    calib.value[domain][result] = value;
+  }
+  fclose(file);
+
+  DEBUG(0, "Power engine: calibration %016llx %sfound in %s\n", config_hash,
+        calibrated ? "" : "not ", POWER_INTF_CACHE);
+}
+
+/**************************************************************************************/
+/* store_calibration: Append the calibration to POWER_INTF_CACHE. The record
+   is written with a single fwrite so that concurrent runs appending to the
+   same file do not interleave. */
+
+static void store_calibration(void) {
+  char   buf[POWER_DOMAIN_NUM_ELEMS * POWER_RESULT_NUM_ELEMS * 64 + 64];
+  size_t len = sprintf(buf, "config %016llx\n", config_hash);
+  for(uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; domain++) {
+    for(uns result = 0; result < POWER_RESULT_NUM_ELEMS; result++) {
+      if(!calib.set[domain][result])
+        continue;
+      len += sprintf(buf + len, "%s\t%s\t%.17le\n", Power_Domain_str(domain),
+                     Power_Result_str(result), calib.value[domain][result]);
+    }
+  }
+  len += sprintf(buf + len, "end\n");
+  ASSERT(0, len < sizeof(buf));
+
+  FILE* file = fopen(POWER_INTF_CACHE, "a");
+  ASSERTM(0, file, "Could not open %s\n", POWER_INTF_CACHE);
+  ASSERTM(0, fwrite(buf, 1, len, file) == len, "Error writing %s\n",
+          POWER_INTF_CACHE);
+  fclose(file);
+}
@@ -0,0 +1,66 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : power_engine.h
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : In-process power model. One McPAT/CACTI run per configuration
+ *                supplies the static results and the energy scale of each
+ *                domain; every later interval is evaluated from the POWER_*
+ *                stats without files or subprocesses.
+ ***************************************************************************************/
+
+#ifndef __POWER_ENGINE_H__
+#define __POWER_ENGINE_H__
+
+#include "globals/global_types.h"
+#include "power/power_intf.h"
+
+/**************************************************************************************/
+/* Types */
+
+/* Power results in the units and at the reference V/f of McPAT/CACTI, before
+   the DRAM chip count, other system power and scaling are applied */
+typedef struct Power_Results_struct {
+  Flag   set[POWER_DOMAIN_NUM_ELEMS][POWER_RESULT_NUM_ELEMS];
+  double value[POWER_DOMAIN_NUM_ELEMS][POWER_RESULT_NUM_ELEMS];
+} Power_Results;
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Is a calibration for the current configuration available? Looks it up in
+   POWER_INTF_CACHE on the first call. */
+Flag power_engine_calibrated(void);
+
+/* Calibrate from the results of a McPAT/CACTI run over the activity since the
+   last call, and add the calibration to POWER_INTF_CACHE */
+void power_engine_calibrate(Power_Results const* ref);
+
+/* Evaluate the results for the activity since the last call */
+void power_engine_eval(Power_Results* results);
+
+/* Compare the model with the results of a McPAT/CACTI run over the whole run
+   so far, and log the dynamic power of both (POWER_INTF_INLINE_CHECK) */
+void power_engine_check(Power_Results const* ref);
+
+#endif  // __POWER_ENGINE_H__
@@ -28,6 +28,7 @@
 
 #include "power_intf.h"
 #include <stdio.h>
+#include <string.h>
 #include "globals/assert.h"
 #include "globals/global_defs.h"
 #include "globals/utils.h"
@@ -35,6 +36,7 @@
 
 #include "general.param.h"
 #include "power/power.param.h"
+#include "power/power_engine.h"
 #include "power/power_scarab_config.h"
 #include "ramulator.h"
 #include "ramulator.param.h"
@@ -61,7 +63,8 @@ typedef struct Value_struct {
 
 // static void dump_power_stats(void);
 static void           run_power_model_exec(void);
-static void           parse_power_model_results(void);
+static void           parse_power_model_results(Power_Results* results);
+static void           set_power_results(Power_Results const* results);
 static void           update_energy_stats(void);
 static void           scale_values(Power_Domain domain);
 static Freq_Domain_Id freq_domain(Power_Domain);
@@ -73,8 +76,9 @@ static const char* model_results_filename = "power_model_results";
 /**************************************************************************************/
 /* Global Variables */
 
-static Value  values[POWER_DOMAIN_NUM_ELEMS][POWER_RESULT_NUM_ELEMS];
-static double elapsed_time;  // time elapsed in this interval, seconds
+static Value   values[POWER_DOMAIN_NUM_ELEMS][POWER_RESULT_NUM_ELEMS];
+static double  elapsed_time;     // time elapsed in this interval, seconds
+static Counter last_power_time;  // POWER_TIME at the last inline calculation
 
 /**************************************************************************************/
 /* power_intf_init: */
@@ -94,11 +98,35 @@ void power_intf_init(void) {
 /* power_intf_calc: */
 
 void power_intf_calc(void) {
-  double fempto_elapsed_time = (double)GET_TOTAL_STAT_EVENT(0, POWER_TIME);
-  elapsed_time               = fempto_elapsed_time * 1.0e-15;
+  Counter       power_time = GET_TOTAL_STAT_EVENT(0, POWER_TIME);
+  Power_Results results;
+
+  if(POWER_INTF_INLINE) {
+    /* Only the activity since the last call is evaluated; McPAT and CACTI run
+       just once per configuration to calibrate the in-process model */
+    Counter last    = power_time >= last_power_time ? last_power_time : 0;
+    elapsed_time    = (double)(power_time - last) * 1.0e-15;
+    last_power_time = power_time;
+
+    if(power_engine_calibrated() && POWER_INTF_INLINE_CHECK) {
+      /* comparison run: McPAT and CACTI still provide the results */
+      run_power_model_exec();
+      parse_power_model_results(&results);
+      power_engine_check(&results);
+    } else if(power_engine_calibrated()) {
+      power_engine_eval(&results);
+    } else {
+      run_power_model_exec();
+      parse_power_model_results(&results);
+      power_engine_calibrate(&results);
+    }
+  } else {
+    elapsed_time = (double)power_time * 1.0e-15;
+    run_power_model_exec();
+    parse_power_model_results(&results);
+  }
 
-  run_power_model_exec();
-  parse_power_model_results();
+  set_power_results(&results);
   update_energy_stats();
 }
 
@@ -127,6 +155,8 @@ void power_intf_done(void) {
 }
 
 void run_power_model_exec(void) {
+  /* power_intf.pl reads the DRAM activity from the power stat files */
+  dump_power_energy_stats();
   power_print_mcpat_xml_infile();
   power_print_cacti_cfg_infile();
 
@@ -140,13 +170,8 @@ void run_power_model_exec(void) {
   ASSERTM(0, rc == 0, "Command \"%s\" failed\n", cmd);
 }
 
-void parse_power_model_results(void) {
-  /* Mark all values as unset */
-  for(uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
-    for(uns result = 0; result < POWER_RESULT_NUM_ELEMS; ++result) {
-      values[domain][result].set = FALSE;
-    }
-  }
+void parse_power_model_results(Power_Results* results) {
+  memset(results, 0, sizeof(*results));
 
   FILE* file = file_tag_fopen(NULL, model_results_filename, "r");
   ASSERTM(0, file, "Could not open %s\n", model_results_filename);
@@ -155,7 +180,6 @@ void parse_power_model_results(void) {
   char   domain_str[MAX_STR_LENGTH + 1];
   char   result_str[MAX_STR_LENGTH + 1];
   double value;
-  Flag   read[POWER_DOMAIN_NUM_ELEMS][POWER_RESULT_NUM_ELEMS] = {};
 
   while(fgets(line, MAX_STR_LENGTH, file)) {
     uns num_matches = sscanf(line, "%s\t%s\t%le", domain_str, result_str,
@@ -166,16 +190,24 @@ void parse_power_model_results(void) {
 
     Power_Domain domain = Power_Domain_parse(domain_str);
     Power_Result result = Power_Result_parse(result_str);
-    ASSERTM(0, !read[domain][result],
+    ASSERTM(0, !results->set[domain][result],
             "Power model result {%s, %s} read twice\n", domain_str, result_str);
-    values[domain][result].intf_value = value;
-    values[domain][result].set        = TRUE;
-    read[domain][result]              = TRUE;
+    results->value[domain][result] = value;
+    results->set[domain][result]   = TRUE;
   }
 
   ASSERTM(0, feof(file) && !ferror(file), "Error reading %s\n",
           model_results_filename);
   fclose(file);
+}
+
+void set_power_results(Power_Results const* results) {
+  for(uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+    for(uns result = 0; result < POWER_RESULT_NUM_ELEMS; ++result) {
+      values[domain][result].intf_value = results->value[domain][result];
+      values[domain][result].set        = results->set[domain][result];
+    }
+  }
 
   /* Adjusting DRAM power */
   /* CACTI reports numbers for a single DRAM chip:
@@ -31,6 +31,7 @@
 #include <iomanip>
 #include <ios>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
 #include <string>
 
@@ -130,22 +131,22 @@ uint32_t       num_l3_caches;
  * Local Prototypes
  ***********************************************************************************************************/
 
-void power_print_system_params(std::ofstream& out);
-void power_print_core_params(std::ofstream& out, uint32_t core_id);
-void power_print_cache_directory_params(std::ofstream& out,
-                                        uint32_t       num_l1_directories,
-                                        uint32_t       num_l2_directories);
-void power_print_l2_params(std::ofstream& out, uint32_t l2_id);
-void power_print_l3_params(std::ofstream& out);
-void power_print_mc_params(std::ofstream& out);
-void power_print_noc_params(std::ofstream& out);
-void power_print_io_params(std::ofstream& out);
+void power_print_system_params(std::ostream& out);
+void power_print_core_params(std::ostream& out, uint32_t core_id);
+void power_print_cache_directory_params(std::ostream& out,
+                                        uint32_t      num_l1_directories,
+                                        uint32_t      num_l2_directories);
+void power_print_l2_params(std::ostream& out, uint32_t l2_id);
+void power_print_l3_params(std::ostream& out);
+void power_print_mc_params(std::ostream& out);
+void power_print_noc_params(std::ostream& out);
+void power_print_io_params(std::ostream& out);
 
 /***********************************************************************************************************
  * Local Functions
  ***********************************************************************************************************/
 
-void power_print_system_params(std::ofstream& out) {
+void power_print_system_params(std::ostream& out) {
   std::string header = "";
 
   ADD_XML_PARAM(out, header, "number_of_cores", NUM_CORES, );
@@ -210,7 +211,7 @@ void power_print_system_params(std::ofstream& out) {
                     "Scarab: McPAT ignores this");
 }
 
-void power_print_core_params(std::ofstream& out, uint32_t core_id) {
+void power_print_core_params(std::ostream& out, uint32_t core_id) {
   uns PIPELINE_DEPTH = DECODE_CYCLES + MAP_CYCLES + 1 + 1 + 1 +
                        1;  // icache, node, exec, retire
 
@@ -692,9 +693,9 @@ void power_print_core_params(std::ofstream& out, uint32_t core_id) {
   END_OF_COMPONENT(out, header);
 }
 
-void power_print_cache_directory_params(std::ofstream& out,
-                                        uint32_t       num_l1_directories,
-                                        uint32_t       num_l2_directories) {
+void power_print_cache_directory_params(std::ostream& out,
+                                        uint32_t      num_l1_directories,
+                                        uint32_t      num_l2_directories) {
   std::string header = "\t";
 
   for(uint32_t i = 0; i < num_l1_directories; ++i) {
@@ -758,7 +759,7 @@ void power_print_cache_directory_params(std::ofstream& out,
   }
 }
 
-void power_print_l2_params(std::ofstream& out, uint32_t l2_id) {
+void power_print_l2_params(std::ostream& out, uint32_t l2_id) {
   std::string header = "\t";
 
   uint32_t PRIVATE_L1_SIZE  = L1_SIZE / NUM_CORES;
@@ -802,7 +803,7 @@ void power_print_l2_params(std::ofstream& out, uint32_t l2_id) {
   END_OF_COMPONENT(out, header);
 }
 
-void power_print_l3_params(std::ofstream& out) {
+void power_print_l3_params(std::ostream& out) {
   std::string header = "\t";
 
   ADD_XML_COMPONENT(out, header, std::string("system.L30"),
@@ -841,7 +842,7 @@ void power_print_l3_params(std::ofstream& out) {
   END_OF_COMPONENT(out, header);
 }
 
-void power_print_noc_params(std::ofstream& out) {
+void power_print_noc_params(std::ostream& out) {
   std::string header = "\t";
 
   ADD_XML_COMPONENT(out, header, std::string("system.NoC0"),
@@ -880,7 +881,7 @@ void power_print_noc_params(std::ofstream& out) {
   END_OF_COMPONENT(out, header);
 }
 
-void power_print_mc_params(std::ofstream& out) {
+void power_print_mc_params(std::ostream& out) {
   double MEMORY_FREQ_IN_MHZ             = (1e15 / RAMULATOR_TCK) / 1e6;
   double MEMORY_PEAK_RATE_IN_MB_PER_SEC = (double(BUS_WIDTH_IN_BYTES) /
                                            1000000.0) *
@@ -935,7 +936,7 @@ void power_print_mc_params(std::ofstream& out) {
   END_OF_COMPONENT(out, header);
 }
 
-void power_print_io_params(std::ofstream& out) {
+void power_print_io_params(std::ostream& out) {
   std::string header = "\t";
 
   /***********************************************************************/
@@ -994,7 +995,7 @@ void power_print_io_params(std::ofstream& out) {
   END_OF_COMPONENT(out, header);
 }
 
-void power_print_memory_parts(std::ofstream& out) {
+void power_print_memory_parts(std::ostream& out) {
   double DRAM_TECH_IN_UM = ((double)DRAM_TECH_IN_NM) / 1000;  // default is 32nm
   uint32_t DRAM_BURST_LENGTH = RAMULATOR_TBL * 2;  // RAMULATOR_TBL is in
                                                    // cycles, burst length is in
@@ -1123,11 +1124,7 @@ void power_print_memory_parts(std::ofstream& out) {
  * Global Functions
  ***********************************************************************************************************/
 
-void power_print_mcpat_xml_infile() {
-  std::string   mcpat_infile_name = std::string(FILE_TAG) + "mcpat_infile.xml";
-  std::ofstream out;
-  out.open(mcpat_infile_name, std::ofstream::out | std::ofstream::trunc);
-
+static void power_print_mcpat_xml(std::ostream& out) {
   std::string header = "";
   out << "<?xml version=\"1.0\" ?>" << std::endl;
   ADD_XML_COMPONENT(out, header, std::string("root"), std::string("root"), );
@@ -1160,6 +1157,14 @@ void power_print_mcpat_xml_infile() {
 
   END_OF_COMPONENT(out, header);
   END_OF_COMPONENT(out, header);
+}
+
+void power_print_mcpat_xml_infile() {
+  std::string   mcpat_infile_name = std::string(FILE_TAG) + "mcpat_infile.xml";
+  std::ofstream out;
+  out.open(mcpat_infile_name, std::ofstream::out | std::ofstream::trunc);
+
+  power_print_mcpat_xml(out);
 
   out.close();
 }
@@ -1174,6 +1179,28 @@ void power_print_cacti_cfg_infile() {
   out.close();
 }
 
+uns64 power_config_hash() {
+  std::ostringstream out;
+  power_print_mcpat_xml(out);
+  power_print_memory_parts(out);
+
+  /* Hash everything except the activity: the <stat> lines and the duty cycle
+     derived from the ops per cycle (FNV-1a) */
+  std::istringstream in(out.str());
+  std::string        line;
+  uns64              hash = 0xcbf29ce484222325ULL;
+  while(std::getline(in, line)) {
+    if(line.find("<stat ") != std::string::npos ||
+       line.find("pipeline_duty_cycle") != std::string::npos)
+      continue;
+    for(char c : line) {
+      hash ^= (unsigned char)c;
+      hash *= 0x100000001b3ULL;
+    }
+  }
+  return hash;
+}
+
 #undef ADD_XML_COMPONENT
 #undef END_OF_COMPONENT
 #undef ADD_XML_PARAM
@@ -29,6 +29,8 @@
 #ifndef __POWER_REGISTER_UNIT_H__
 #define __POWER_REGISTER_UNIT_H__
 
+#include "globals/global_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -50,6 +52,9 @@ extern "C" {
 void power_print_mcpat_xml_infile();
 void power_print_cacti_cfg_infile();
 
+/* Hash of the McPAT and CACTI configuration, without the activity stats */
+uns64 power_config_hash();
+
 #ifdef __cplusplus
 }
 #endif
@@ -124,6 +124,8 @@ void pref_core_init(HWP_Core* pref_core) {
 
   pref_core->ul1req_queue_req_pos  = -1;
   pref_core->ul1req_queue_send_pos = 0;
+
+  pref_core->queued = FALSE;
 }
 
 void pref_init(void) {
@@ -562,6 +564,7 @@ Flag pref_addto_dl0req_queue(uns8 proc_id, Addr line_index,
   *dl0req_queue_req_pos = (*dl0req_queue_req_pos + 1) % PREF_DL0REQ_QUEUE_SIZE;
 
   dl0req_queue[*dl0req_queue_req_pos] = new_req;
+  pref.cores[proc_id]->queued          = TRUE;
   return TRUE;
 }
 
@@ -601,6 +604,7 @@ Flag pref_addto_umlc_req_queue(uns8 proc_id, Addr line_index,
                             PREF_UMLC_REQ_QUEUE_SIZE;
 
   umlc_req_queue[*umlc_req_queue_req_pos] = new_req;
+  pref.cores[proc_id]->queued              = TRUE;
   return TRUE;
 }
 
@@ -654,6 +658,7 @@ Flag pref_addto_ul1req_queue_set(uns8 proc_id, Addr line_index,
   *ul1req_queue_req_pos = (*ul1req_queue_req_pos + 1) % PREF_UL1REQ_QUEUE_SIZE;
 
   ul1req_queue[*ul1req_queue_req_pos] = new_req;
+  pref.cores[proc_id]->queued          = TRUE;
   return TRUE;
 }
 
@@ -852,6 +857,59 @@ void pref_update_core(uns proc_id) {
   }
 }
 
+/* pref_queues_empty: TRUE if no prefetch request is waiting in any queue, in
+ * which case pref_update only rotates the send positions. The queues of a
+ * core are only searched if a request was queued since they were last found
+ * empty. */
+Flag pref_queues_empty(void) {
+  if(!PREF_FRAMEWORK_ON)
+    return TRUE;
+
+  for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if(!pref.cores[proc_id]->queued)
+      continue;
+
+    Pref_Mem_Req* dl0req_queue   = pref.cores[proc_id]->dl0req_queue;
+    Pref_Mem_Req* umlc_req_queue = pref.cores[proc_id]->umlc_req_queue;
+    Pref_Mem_Req* ul1req_queue   = pref.cores[proc_id]->ul1req_queue;
+
+    for(uns ii = 0; ii < PREF_DL0REQ_QUEUE_SIZE; ii++)
+      if(dl0req_queue[ii].valid)
+        return FALSE;
+    for(uns ii = 0; ii < PREF_UMLC_REQ_QUEUE_SIZE; ii++)
+      if(umlc_req_queue[ii].valid)
+        return FALSE;
+    for(uns ii = 0; ii < PREF_UL1REQ_QUEUE_SIZE; ii++)
+      if(ul1req_queue[ii].valid)
+        return FALSE;
+    pref.cores[proc_id]->queued = FALSE;
+  }
+  return TRUE;
+}
+
+/* pref_skip_cycles: moves the send positions as far as that many calls of
+ * pref_update would with every queue empty. The caller makes sure no
+ * hfilter reset falls in the skipped cycles. */
+void pref_skip_cycles(Counter cycles) {
+  if(!PREF_FRAMEWORK_ON)
+    return;
+
+  for(uns proc_id = 0; proc_id < (PREF_SHARED_QUEUES ? 1 : NUM_CORES);
+      proc_id++) {
+    HWP_Core* core = pref.cores[proc_id];
+
+    core->dl0req_queue_send_pos = (core->dl0req_queue_send_pos +
+                                   cycles * PREF_DL0SCHEDULE_NUM) %
+                                  PREF_DL0REQ_QUEUE_SIZE;
+    core->umlc_req_queue_send_pos = (core->umlc_req_queue_send_pos +
+                                     cycles * PREF_UMLC_SCHEDULE_NUM) %
+                                    PREF_UMLC_REQ_QUEUE_SIZE;
+    core->ul1req_queue_send_pos = (core->ul1req_queue_send_pos +
+                                   cycles * PREF_UL1SCHEDULE_NUM) %
+                                  PREF_UL1REQ_QUEUE_SIZE;
+  }
+}
+
 void pref_ul1sent(uns8 proc_id, Addr addr, uns8 prefetcher_id) {
   if(!PREF_FRAMEWORK_ON)
     return;
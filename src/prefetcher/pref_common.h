@@ -138,6 +138,8 @@ typedef struct HWP_Core_struct {
   int ul1req_queue_req_pos;
   int ul1req_queue_send_pos;
 
+  Flag queued;  // a request was queued since pref_queues_empty found none
+
   Counter ul1_misses;
   Counter curr_ul1_misses;
 
@@ -202,6 +204,8 @@ void pref_ul1_pref_hit_late(uns8 proc_id, Addr line_addr, Addr load_PC,
                             uns32 global_hist, uns8 prefetcher_id);
 
 void pref_update(void);
+Flag pref_queues_empty(void);
+void pref_skip_cycles(Counter cycles);
 
 // returns true if req hits in the req queue. It also invalidates the request in
 // the pref queue.
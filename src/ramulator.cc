@@ -27,8 +27,6 @@
  ***************************************************************************************/
 
 #include <deque>
-#include <list>
-#include <map>
 #include <utility>
 
 
@@ -37,8 +35,11 @@
 #include "ramulator/ScarabWrapper.h"
 
 extern "C" {
+#include "dvfs/dvfs.param.h"
 #include "general.param.h"
 #include "globals/assert.h"
+#include "globals/utils.h"
+#include "libs/hash_lib.h"
 #include "memory/memory.h"
 #include "memory/memory.param.h"
 #include "ramulator.h"
@@ -51,6 +52,11 @@ extern "C" {
 
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_MEMORY, ##args)
 
+/* An instruction and a data request may share one DRAM read */
+#define RAMULATOR_MAX_READS_PER_ADDR 2
+/* Completed reads of one address that can wait in resp_queue at once */
+#define RAMULATOR_MAX_RESPS_PER_ADDR 8
+
 /**************************************************************************************/
 
 
@@ -66,11 +72,25 @@ void enqueue_response(Request& req);
 
 void stats_callback(int coreid, int type);
 
-deque<pair<long, Mem_Req*>> resp_queue;  // completed read request that need to
-                                         // send back to Scarab
+/* Scarab requests waiting on the DRAM read of one address, oldest first */
+typedef struct Inflight_Reads_struct {
+  uns      count;
+  Mem_Req* reqs[RAMULATOR_MAX_READS_PER_ADDR];
+} Inflight_Reads;
+
+/* resp_queue entries of one address, in resp_queue order (a ring) */
+typedef struct Resp_Queue_Entries_struct {
+  uns      head;
+  uns      count;
+  Mem_Req* reqs[RAMULATOR_MAX_RESPS_PER_ADDR];
+} Resp_Queue_Entries;
 
-map<long, list<Mem_Req*>> inflight_read_reqs;
-// map<long, Mem_Req*> inflight_read_reqs;
+deque<pair<long, Mem_Req*>, PoolAllocator<pair<long, Mem_Req*>>>
+  resp_queue;  // completed read request that need to send back to Scarab
+Hash_Table resp_queue_index;  // Resp_Queue_Entries by address
+
+Hash_Table inflight_read_reqs;  // Inflight_Reads by address
+uns dram_reads_inflight[MAX_NUM_PROCS];  // by proc of the first requester
 
 void ramulator_init() {
   ASSERTM(0, ICACHE_LINE_SIZE == DCACHE_LINE_SIZE,
@@ -83,6 +103,11 @@ void ramulator_init() {
   configs = new Config();
   init_configs();
 
+  init_hash_table(&inflight_read_reqs, "ramulator inflight reads", 256,
+                  sizeof(Inflight_Reads));
+  init_hash_table(&resp_queue_index, "ramulator resp queue", 256,
+                  sizeof(Resp_Queue_Entries));
+
   wrapper = new ScarabWrapper(*configs, DCACHE_LINE_SIZE, &stats_callback);
 
   DPRINTF("Initialized Ramulator. \n");
@@ -177,20 +202,22 @@ int ramulator_send(Mem_Req* scarab_req) {
   // Mem_Req_Type_str(scarab_req->type), scarab_req->addr);
 
   // does inflight_read_reqs have the proc_id in the req?
-  auto it_scarab_req = inflight_read_reqs.find(req.addr);
-  if(it_scarab_req != inflight_read_reqs.end() &&
-     req.type == Request::Type::READ) {
+  Inflight_Reads* inflight = (Inflight_Reads*)hash_table_access(
+    &inflight_read_reqs, req.addr);
+  if(inflight && req.type == Request::Type::READ) {
     DEBUG(scarab_req->proc_id,
           "Ramulator: Duplicate (%s) request to address %llx\n",
           Mem_Req_Type_str(scarab_req->type), scarab_req->addr);
     // Can have duplicate Ifetch and Dfetch requests, but only one of each
-    ASSERT(0, it_scarab_req->second.size() <= 1);
-
-    if(req.type == Request::Type::READ)
-      inflight_read_reqs[req.addr].push_back(
-        scarab_req);  // save it as an inflight request so later it will be
-                      // moved to the resp_queue at the same time with the older
-                      // request
+    if(inflight->count == RAMULATOR_MAX_READS_PER_ADDR)
+      FATAL_ERROR(scarab_req->proc_id,
+                  "Ramulator: more than %d requests share the DRAM read of "
+                  "address %lx. Raise RAMULATOR_MAX_READS_PER_ADDR.\n",
+                  RAMULATOR_MAX_READS_PER_ADDR, req.addr);
+
+    // save it as an inflight request so later it will be moved to the
+    // resp_queue at the same time with the older request
+    inflight->reqs[inflight->count++] = scarab_req;
     scarab_req->mem_queue_cycle = cycle_count;
     return true;  // a request to the same address is already issued
   }
@@ -201,11 +228,15 @@ int ramulator_send(Mem_Req* scarab_req) {
     STAT_EVENT(scarab_req->proc_id, POWER_MEMORY_CTRL_ACCESS);
 
     if(req.type == Request::Type::READ) {
-      ASSERTM(0, inflight_read_reqs.find(req.addr) == inflight_read_reqs.end(),
+      Flag new_entry;
+      inflight = (Inflight_Reads*)hash_table_access_create(
+        &inflight_read_reqs, req.addr, &new_entry);
+      ASSERTM(0, new_entry,
               "ERROR: A read request to the same address shouldn't be sent "
               "multiple times to Ramulator\n");
-      // inflight_read_reqs[req.addr] = scarab_req;
-      inflight_read_reqs[req.addr].push_back(scarab_req);
+      inflight->count   = 1;
+      inflight->reqs[0] = scarab_req;
+      dram_reads_inflight[scarab_req->proc_id]++;
       STAT_EVENT(scarab_req->proc_id, POWER_MEMORY_CTRL_READ);
     } else if(req.type == Request::Type::WRITE) {
       STAT_EVENT(scarab_req->proc_id, POWER_MEMORY_CTRL_WRITE);
@@ -228,17 +259,33 @@ void enqueue_response(Request& req) {
   // This should only be called by READ requests
   ASSERTM(0, req.type == Request::Type::READ,
           "ERROR: Responses should be sent only for read requests! \n");
-  ASSERTM(0, inflight_read_reqs.find(req.addr) != inflight_read_reqs.end(),
+  Inflight_Reads* inflight = (Inflight_Reads*)hash_table_access(
+    &inflight_read_reqs, req.addr);
+  ASSERTM(0, inflight,
           "ERROR: A corresponding Scarab request was not found for the "
           "Ramulator request that read address: %lu\n",
           req.addr);
 
-  auto it_scarab_req = inflight_read_reqs.find(req.addr);
-  for(auto req : it_scarab_req->second)
-    resp_queue.push_back(make_pair(it_scarab_req->first, req));
-  // resp_queue.push_back(make_pair(it_scarab_req->first,
-  // it_scarab_req->second));
-  inflight_read_reqs.erase(it_scarab_req);
+  Flag                new_entry;
+  Resp_Queue_Entries* entries = (Resp_Queue_Entries*)hash_table_access_create(
+    &resp_queue_index, req.addr, &new_entry);
+  if(new_entry) {
+    entries->head  = 0;
+    entries->count = 0;
+  }
+  for(uns ii = 0; ii < inflight->count; ii++) {
+    if(entries->count == RAMULATOR_MAX_RESPS_PER_ADDR)
+      FATAL_ERROR(0,
+                  "Ramulator: more than %d completed reads of address %lx "
+                  "wait in resp_queue. Raise RAMULATOR_MAX_RESPS_PER_ADDR.\n",
+                  RAMULATOR_MAX_RESPS_PER_ADDR, req.addr);
+    resp_queue.push_back(make_pair(req.addr, inflight->reqs[ii]));
+    entries->reqs[(entries->head + entries->count++) %
+                  RAMULATOR_MAX_RESPS_PER_ADDR] = inflight->reqs[ii];
+  }
+  ASSERT(0, dram_reads_inflight[inflight->reqs[0]->proc_id] > 0);
+  dram_reads_inflight[inflight->reqs[0]->proc_id]--;
+  hash_table_access_delete(&inflight_read_reqs, req.addr);
 }
 
 bool try_completing_request(Mem_Req* req) {
@@ -298,9 +345,26 @@ void to_ramulator_req(const Mem_Req* scarab_req, Request* ramulator_req) {
 void ramulator_tick() {
   wrapper->tick();
 
+  if(DVFS_ON) {
+    // inputs of the DVFS DRAM sharing model, sampled once per DRAM cycle
+    INC_STAT_EVENT(0, DRAM_BANK_IN_DEMAND, wrapper->banks_in_demand());
+    for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      STAT_EVENT(proc_id, DRAM_CYCLES);
+      INC_STAT_EVENT(proc_id, DRAM_GLOBAL_MLP, dram_reads_inflight[proc_id]);
+    }
+  }
+
   if(resp_queue.size() > 0) {
-    if(try_completing_request(resp_queue.front().second))
+    if(try_completing_request(resp_queue.front().second)) {
+      Resp_Queue_Entries* entries = (Resp_Queue_Entries*)hash_table_access(
+        &resp_queue_index, resp_queue.front().first);
+      ASSERT(0, entries && entries->reqs[entries->head] ==
+                             resp_queue.front().second);
+      entries->head = (entries->head + 1) % RAMULATOR_MAX_RESPS_PER_ADDR;
+      if(--entries->count == 0)
+        hash_table_access_delete(&resp_queue_index, resp_queue.front().first);
       resp_queue.pop_front();
+    }
   }
 }
 
@@ -326,11 +390,13 @@ Mem_Req* ramulator_search_queue(long phys_addr, Mem_Req_Type type) {
     (type == MRT_IFETCH) || (type == MRT_DFETCH) || (type == MRT_IPRF) ||
       (type == MRT_DPRF) || (type == MRT_DSTORE) || (type == MRT_MIN_PRIORITY),
     "Ramulator: Cannot search write requests in Ramulator request queue\n");
-  auto it_req = inflight_read_reqs.find(phys_addr);
+  Inflight_Reads* inflight = (Inflight_Reads*)hash_table_access(
+    &inflight_read_reqs, phys_addr);
 
   // Search request queue
-  if(it_req != inflight_read_reqs.end()) {
-    for(auto req : it_req->second) {
+  if(inflight) {
+    for(uns ii = 0; ii < inflight->count; ii++) {
+      Mem_Req* req = inflight->reqs[ii];
       if((req->type == MRT_IFETCH || req->type == MRT_IPRF) &&
          (type == MRT_IFETCH || type == MRT_IPRF))
         return req;
@@ -342,16 +408,19 @@ Mem_Req* ramulator_search_queue(long phys_addr, Mem_Req_Type type) {
   }
 
   // Search response queue
-  for(auto resp : resp_queue) {
-    if(resp.first == phys_addr) {
-      if((resp.second->type == MRT_IFETCH || resp.second->type == MRT_IPRF) &&
+  Resp_Queue_Entries* entries = (Resp_Queue_Entries*)hash_table_access(
+    &resp_queue_index, phys_addr);
+  if(entries) {
+    for(uns ii = 0; ii < entries->count; ii++) {
+      Mem_Req* req = entries->reqs[(entries->head + ii) %
+                                   RAMULATOR_MAX_RESPS_PER_ADDR];
+      if((req->type == MRT_IFETCH || req->type == MRT_IPRF) &&
          (type == MRT_IFETCH || type == MRT_IPRF))
-        return resp.second;
-      else if((resp.second->type == MRT_DFETCH ||
-               resp.second->type == MRT_DPRF ||
-               resp.second->type == MRT_DSTORE) &&
+        return req;
+      else if((req->type == MRT_DFETCH || req->type == MRT_DPRF ||
+               req->type == MRT_DSTORE) &&
               (type == MRT_DFETCH || type == MRT_DPRF || type == MRT_DSTORE))
-        return resp.second;
+        return req;
     }
   }
 
@@ -97,9 +97,25 @@ public:
     Refresh<T>* refresh;
 
     struct Queue {
-        list<Request> q;
+        ReqList q;
+        ReqBuckets<T> buckets;  // index of q by bank for the scheduler
         unsigned int max = 32;
         unsigned int size() {return q.size();}
+
+        // requests must be added and removed through these to keep buckets
+        // in sync with q
+        void push_back(const Request& req) {
+            q.push_back(req);
+            buckets.insert(prev(q.end()));
+        }
+        void pop_back() {
+            buckets.remove(prev(q.end()));
+            q.pop_back();
+        }
+        void erase(ReqList::iterator req) {
+            buckets.remove(req);
+            q.erase(req);
+        }
     };
 
     Queue readq;  // queue for read requests
@@ -111,7 +127,7 @@ public:
                    // after ACTIVATE w/o READ of WRITE command)
     Queue otherq;  // queue for all "other" requests (e.g., refresh)
 
-    deque<Request> pending;  // read requests that are about to receive data from DRAM
+    deque<Request, PoolAllocator<Request>> pending;  // read requests that are about to receive data from DRAM
     bool write_mode = false;  // whether write requests should be prioritized over reads
     float wr_high_watermark = 0.8f; // threshold for switching to write mode
     float wr_low_watermark = 0.2f; // threshold for switching back to read mode
@@ -127,6 +143,10 @@ public:
     // callback function for passing stats to Scarab when an event occurs
     void (*stats_callback)(int, int) = nullptr;
 
+    // scratch for banks_in_demand()
+    vector<long> bank_demand_mark;
+    long bank_demand_stamp = 0;
+
 
     /* Constructor */
     Controller(const Config& configs, DRAM<T>* channel, void (*_stats_callback)(int,int)) :
@@ -154,6 +174,8 @@ public:
 
         readq.max = (unsigned int) configs.get_int("readq_entries");
         writeq.max = (unsigned int) configs.get_int("writeq_entries");
+        for (Queue* queue : {&readq, &writeq, &actq, &otherq})
+            queue->buckets.init(channel->spec, queue->max);
 
         // regStats
 
@@ -349,14 +371,14 @@ public:
             return false;
 
         req.arrive = clk;
-        queue.q.push_back(req);
+        queue.push_back(req);
         // shortcut for read requests, if a write to same addr exists
         // necessary for coherence
         if (req.type == Request::Type::READ && find_if(writeq.q.begin(), writeq.q.end(),
                 [req](Request& wreq){ return req.addr == wreq.addr;}) != writeq.q.end()){
             req.depart = clk + 1;
             pending.push_back(req);
-            readq.q.pop_back();
+            readq.pop_back();
         }
         return true;
     }
@@ -406,20 +428,20 @@ public:
         // are requests available to service in this cycle
         Queue* queue = &actq;
 
-        auto req = scheduler->get_head(queue->q);
+        auto req = scheduler->get_head(queue->q, queue->buckets);
         if (req == queue->q.end() || !is_ready(req)) {
             queue = !write_mode ? &readq : &writeq;
 
             if (otherq.size())
                 queue = &otherq;  // "other" requests are rare, so we give them precedence over reads/writes
 
-            req = scheduler->get_head(queue->q);
+            req = scheduler->get_head(queue->q, queue->buckets);
         }
 
         if (req == queue->q.end() || !is_ready(req)) {
             // we couldn't find a command to schedule -- let's try to be speculative
             auto cmd = T::Command::PRE;
-            vector<int> victim = rowpolicy->get_victim(cmd);
+            AddrVec victim = rowpolicy->get_victim(cmd);
             if (!victim.empty()){
                 issue_cmd(cmd, victim, 0);
             }
@@ -469,8 +491,8 @@ public:
         if (!(channel->spec->is_accessing(cmd) || channel->spec->is_refreshing(cmd))) {
             if(channel->spec->is_opening(cmd)) {
                 // promote the request that caused issuing activation to actq
-                actq.q.push_back(*req);
-                queue->q.erase(req);
+                actq.push_back(*req);
+                queue->erase(req);
             }
 
             return;
@@ -487,40 +509,40 @@ public:
         }
 
         // remove request from queue
-        queue->q.erase(req);
+        queue->erase(req);
     }
 
-    bool is_ready(list<Request>::iterator req)
+    bool is_ready(ReqList::iterator req)
     {
         typename T::Command cmd = get_first_cmd(req);
         return channel->check(cmd, req->addr_vec.data(), clk);
     }
 
-    bool is_ready(typename T::Command cmd, const vector<int>& addr_vec)
+    bool is_ready(typename T::Command cmd, const AddrVec& addr_vec)
     {
         return channel->check(cmd, addr_vec.data(), clk);
     }
 
-    bool is_row_hit(list<Request>::iterator req)
+    bool is_row_hit(ReqList::iterator req)
     {
         // cmd must be decided by the request type, not the first cmd
         typename T::Command cmd = channel->spec->translate[int(req->type)];
         return channel->check_row_hit(cmd, req->addr_vec.data());
     }
 
-    bool is_row_hit(typename T::Command cmd, const vector<int>& addr_vec)
+    bool is_row_hit(typename T::Command cmd, const AddrVec& addr_vec)
     {
         return channel->check_row_hit(cmd, addr_vec.data());
     }
 
-    bool is_row_open(list<Request>::iterator req)
+    bool is_row_open(ReqList::iterator req)
     {
         // cmd must be decided by the request type, not the first cmd
         typename T::Command cmd = channel->spec->translate[int(req->type)];
         return channel->check_row_open(cmd, req->addr_vec.data());
     }
 
-    bool is_row_open(typename T::Command cmd, const vector<int>& addr_vec)
+    bool is_row_open(typename T::Command cmd, const AddrVec& addr_vec)
     {
         return channel->check_row_open(cmd, addr_vec.data());
     }
@@ -539,6 +561,24 @@ public:
       return clk <= channel->end_of_refreshing;
     }
 
+    // Number of banks with at least one queued read or write (for the DVFS
+    // DRAM sharing model). Without a bank index, each non-empty queue counts
+    // as one bank.
+    int banks_in_demand() {
+      if (readq.buckets.banks.empty())
+        return (readq.size() > 0) + (writeq.size() > 0) + (actq.size() > 0);
+      bank_demand_stamp++;
+      bank_demand_mark.resize(readq.buckets.banks.size(), 0);
+      int banks = 0;
+      for (Queue* queue : {&readq, &writeq, &actq})
+        for (int bank : queue->buckets.active)
+          if (bank_demand_mark[bank] != bank_demand_stamp) {
+            bank_demand_mark[bank] = bank_demand_stamp;
+            banks++;
+          }
+      return banks;
+    }
+
     void set_high_writeq_watermark(const float watermark) {
        wr_high_watermark = watermark; 
     }
@@ -559,7 +599,7 @@ public:
     }
 
 private:
-    typename T::Command get_first_cmd(list<Request>::iterator req)
+    typename T::Command get_first_cmd(ReqList::iterator req)
     {
         typename T::Command cmd = channel->spec->translate[int(req->type)];
         return channel->decode(cmd, req->addr_vec.data());
@@ -567,7 +607,7 @@ private:
 
     // upgrade to an autoprecharge command
     void cmd_issue_autoprecharge(typename T::Command& cmd,
-                                            const vector<int>& addr_vec) {
+                                            const AddrVec& addr_vec) {
 
         // currently, autoprecharge is only used with closed row policy
         if(channel->spec->is_accessing(cmd) && rowpolicy->type == RowPolicy<T>::Type::ClosedAP) {
@@ -615,7 +655,7 @@ private:
 
     }
 
-    void issue_cmd(typename T::Command cmd, const vector<int>& addr_vec, int coreid)
+    void issue_cmd(typename T::Command cmd, const AddrVec& addr_vec, int coreid)
     {
         cmd_issue_autoprecharge(cmd, addr_vec);
         assert(is_ready(cmd, addr_vec));
@@ -663,17 +703,17 @@ private:
             printf("\n");
         }
     }
-    vector<int> get_addr_vec(typename T::Command cmd, list<Request>::iterator req){
+    AddrVec get_addr_vec(typename T::Command cmd, ReqList::iterator req){
         return req->addr_vec;
     }
 };
 
 template <>
-vector<int> Controller<SALP>::get_addr_vec(
-    SALP::Command cmd, list<Request>::iterator req);
+AddrVec Controller<SALP>::get_addr_vec(
+    SALP::Command cmd, ReqList::iterator req);
 
 template <>
-bool Controller<SALP>::is_ready(list<Request>::iterator req);
+bool Controller<SALP>::is_ready(ReqList::iterator req);
 
 template <>
 void Controller<ALDRAM>::update_temp(ALDRAM::Temp current_temperature);
@@ -683,7 +723,7 @@ void Controller<TLDRAM>::tick();
 
 template <>
 void Controller<TLDRAM>::cmd_issue_autoprecharge(typename TLDRAM::Command& cmd,
-                                                    const vector<int>& addr_vec);
+                                                    const AddrVec& addr_vec);
 
 } /*namespace ramulator*/
 
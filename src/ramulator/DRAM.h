@@ -22,6 +22,7 @@
 #ifndef __DRAM_H
 #define __DRAM_H
 
+#include "PoolAllocator.h"
 #include "Statistics.h"
 #include <iostream>
 #include <vector>
@@ -69,7 +70,9 @@ public:
     // State of Rows:
     // There are too many rows for them to be instantiated individually
     // Instead, their bank (or an equivalent entity) tracks their state for them
-    map<int, typename T::State> row_state;
+    // (rows open and close on every ACT/PRE, so their nodes are pooled)
+    map<int, typename T::State, less<int>,
+        PoolAllocator<pair<const int, typename T::State>>> row_state;
 
     // Insert a node as one of my child nodes
     void insert(DRAM<T>* child);
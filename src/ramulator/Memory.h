@@ -56,6 +56,7 @@ public:
     virtual void tick() = 0;
     virtual bool send(Request req) = 0;
     virtual int pending_requests() = 0;
+    virtual int banks_in_demand() = 0;
     virtual void finish(void) = 0;
     virtual long page_allocator(long addr, int coreid) = 0;
     virtual void record_core(int coreid) = 0;
@@ -411,6 +412,14 @@ public:
         return reqs;
     }
 
+    int banks_in_demand()
+    {
+        int banks = 0;
+        for (auto ctrl: ctrls)
+            banks += ctrl->banks_in_demand();
+        return banks;
+    }
+
     void set_high_writeq_watermark(const float watermark) {
         for (auto ctrl: ctrls)
             ctrl->set_high_writeq_watermark(watermark);
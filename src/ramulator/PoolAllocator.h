@@ -0,0 +1,113 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __POOL_ALLOCATOR_H
+#define __POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+namespace ramulator
+{
+
+// Free lists of the blocks released by one container, one per block size
+// (list and map nodes, deque chunks). Nothing is returned to the heap before
+// the pool goes away, and a pool must only be used by one thread at a time.
+struct BlockPool {
+    enum { MAX_SIZES = 4 };
+    size_t sizes[MAX_SIZES] = {0};
+    vector<void*> free_blocks[MAX_SIZES];
+
+    vector<void*>* blocks_of(size_t bytes)
+    {
+        for (int i = 0; i < MAX_SIZES; i++) {
+            if (sizes[i] == 0)
+                sizes[i] = bytes;
+            if (sizes[i] == bytes)
+                return &free_blocks[i];
+        }
+        return nullptr;  // too many sizes, use the heap directly
+    }
+
+    ~BlockPool()
+    {
+        for (auto& blocks : free_blocks)
+            for (void* block : blocks)
+                ::operator delete(block);
+    }
+};
+
+// Allocator that hands the blocks a container frees out again, so a queue that
+// has reached its steady-state size stops calling malloc. A container and the
+// allocators it rebinds from this one share one BlockPool.
+template <typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    shared_ptr<BlockPool> pool;
+
+    PoolAllocator() : pool(make_shared<BlockPool>()) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n)
+    {
+        vector<void*>* blocks = pool->blocks_of(n * sizeof(T));
+        if (blocks && !blocks->empty()) {
+            void* block = blocks->back();
+            blocks->pop_back();
+            return static_cast<T*>(block);
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* block, size_t n)
+    {
+        vector<void*>* blocks = pool->blocks_of(n * sizeof(T));
+        if (blocks)
+            blocks->push_back(block);
+        else
+            ::operator delete(block);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b)
+{
+    return a.pool == b.pool;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b)
+{
+    return a.pool != b.pool;
+}
+
+} /*namespace ramulator*/
+
+#endif /*__POOL_ALLOCATOR_H*/
@@ -24,19 +24,78 @@
 
 #include <vector>
 #include <functional>
+#include <list>
+#include <cassert>
+#include <algorithm>
+
+#include "PoolAllocator.h"
 
 using namespace std;
 
 namespace ramulator
 {
 
+// Address of a request split into levels (channel, rank, ..., column). The
+// levels are stored inline, so copying a request does not allocate.
+class AddrVec
+{
+public:
+    enum { MAX_LEVELS = 8 };  // more than any standard has
+
+    AddrVec() : len(0) {}
+    AddrVec(const vector<int>& vec) { assign(vec.begin(), vec.end()); }
+
+    template <typename It>
+    void assign(It begin, It end)
+    {
+        len = 0;
+        for (It itr = begin; itr != end; itr++) {
+            assert(len < MAX_LEVELS);
+            levels[len++] = *itr;
+        }
+    }
+
+    void resize(size_t n)
+    {
+        assert(n <= MAX_LEVELS);
+        for (size_t i = len; i < n; i++)
+            levels[i] = 0;
+        len = n;
+    }
+
+    size_t size() const {return len;}
+    bool empty() const {return len == 0;}
+    int* data() {return levels;}
+    const int* data() const {return levels;}
+    int* begin() {return levels;}
+    int* end() {return levels + len;}
+    const int* begin() const {return levels;}
+    const int* end() const {return levels + len;}
+    int& operator[](size_t i) {return levels[i];}
+    const int& operator[](size_t i) const {return levels[i];}
+
+    bool operator<(const AddrVec& other) const
+    {
+        return lexicographical_compare(begin(), end(), other.begin(), other.end());
+    }
+
+    bool operator==(const AddrVec& other) const
+    {
+        return len == other.len && equal(begin(), end(), other.begin());
+    }
+
+private:
+    int levels[MAX_LEVELS];
+    size_t len;
+};
+
 class Request
 {
 public:
     bool is_first_command;
     long addr;
     // long addr_row;
-    vector<int> addr_vec;
+    AddrVec addr_vec;
     // specify which core this request sent from, for virtual address translation
     int coreid;
 
@@ -62,13 +121,16 @@ public:
     Request(long addr, Type type, function<void(Request&)> callback, int coreid = 0)
         : is_first_command(true), addr(addr), coreid(coreid), type(type), callback(callback) {}
 
-    Request(vector<int>& addr_vec, Type type, function<void(Request&)> callback, int coreid = 0)
+    Request(const vector<int>& addr_vec, Type type, function<void(Request&)> callback, int coreid = 0)
         : is_first_command(true), addr_vec(addr_vec), coreid(coreid), type(type), callback(callback) {}
 
     Request()
         : is_first_command(true), coreid(0) {}
 };
 
+// Controller queues recycle their nodes instead of allocating one per request
+typedef list<Request, PoolAllocator<Request>> ReqList;
+
 } /*namespace ramulator*/
 
 #endif /*__REQUEST_H*/
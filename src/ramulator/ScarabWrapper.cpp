@@ -78,6 +78,10 @@ bool ScarabWrapper::send(Request req) {
   return mem->send(req);
 }
 
+int ScarabWrapper::banks_in_demand() {
+  return mem->banks_in_demand();
+}
+
 void ScarabWrapper::finish(void) {
   mem->finish();
   Stats::statlist.printall();
@@ -45,6 +45,7 @@ public:
     void tick();
     bool send(Request req);
     void finish(void);
+    int banks_in_demand();
 
     int get_chip_width() const;
     int get_chip_size()  const;
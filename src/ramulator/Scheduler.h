@@ -39,6 +39,119 @@ namespace ramulator
 template <typename T>
 class Controller;
 
+// Index of a request queue by bank (the lowest level above Row), kept in sync
+// with the queue by Controller::Queue. Each bank keeps its requests oldest
+// first, so the scheduler only looks at the oldest request of each kind per
+// bank instead of walking the whole queue.
+template <typename T>
+class ReqBuckets
+{
+public:
+    typedef ReqList::iterator ReqIter;
+
+    struct Entry {
+        long arrive;
+        long seq;  // position in the queue, breaks ties between equal arrive
+        ReqIter req;
+    };
+
+    vector<vector<Entry>> banks;  // requests of each bank, oldest first
+    vector<int> active;           // banks with at least one request
+    vector<int> active_pos;       // index of each bank in active, -1 if none
+    vector<int> group;            // row group (scope of PRE) of each bank
+    int num_groups = 0;
+    int unindexed = 0;  // requests that are not reads or writes to one bank
+    long seq = 0;
+
+    void init(const T* spec, unsigned int queue_max)
+    {
+        int pre_level = int(spec->scope[int(T::Command::PRE)]);
+        int num_banks = 1, banks_per_group = 1;
+        for (int lev = 1; lev < int(T::Level::Row); lev++) {
+            count[lev] = spec->org_entry.count[lev];
+            if (count[lev] <= 0)
+                return;  // unknown organization, leave the queue unindexed
+            num_banks *= count[lev];
+            if (lev > pre_level)
+                banks_per_group *= count[lev];
+        }
+        num_groups = num_banks / banks_per_group;
+
+        banks.resize(num_banks);
+        for (auto& reqs : banks)
+            reqs.reserve(queue_max);
+        active.reserve(num_banks);
+        active_pos.assign(num_banks, -1);
+        group.resize(num_banks);
+        for (int bank = 0; bank < num_banks; bank++)
+            group[bank] = bank / banks_per_group;
+    }
+
+    void insert(ReqIter req)
+    {
+        Entry entry = {req->arrive, seq++, req};
+        int bank = bank_of(*req);
+        if (bank < 0 || (req->type != Request::Type::READ &&
+                         req->type != Request::Type::WRITE)) {
+            unindexed++;
+            return;
+        }
+
+        // requests promoted to actq may be older than the ones already there
+        auto& reqs = banks[bank];
+        auto pos = reqs.end();
+        while (pos != reqs.begin() && prev(pos)->arrive > entry.arrive)
+            --pos;
+        reqs.insert(pos, entry);
+
+        if (active_pos[bank] < 0) {
+            active_pos[bank] = active.size();
+            active.push_back(bank);
+        }
+    }
+
+    void remove(ReqIter req)
+    {
+        int bank = bank_of(*req);
+        if (bank >= 0) {
+            auto& reqs = banks[bank];
+            for (auto itr = reqs.begin(); itr != reqs.end(); itr++) {
+                if (itr->req != req)
+                    continue;
+                reqs.erase(itr);
+                if (reqs.empty()) {
+                    int pos = active_pos[bank];
+                    active[pos] = active.back();
+                    active_pos[active[pos]] = pos;
+                    active.pop_back();
+                    active_pos[bank] = -1;
+                }
+                return;
+            }
+        }
+        assert(unindexed > 0);
+        unindexed--;
+    }
+
+private:
+    int count[int(T::Level::MAX)];
+
+    // the type is not looked at here since it can change while queued
+    int bank_of(const Request& req) const
+    {
+        if (banks.empty() || int(req.addr_vec.size()) < int(T::Level::Row))
+            return -1;
+        int bank = 0;
+        for (int lev = 1; lev < int(T::Level::Row); lev++) {
+            int idx = req.addr_vec[lev];
+            if (idx < 0 || idx >= count[lev])
+                return -1;
+            bank = bank * count[lev] + idx;
+        }
+        return bank;
+    }
+};
+
 template <typename T>
 class Scheduler
 {
@@ -68,7 +181,98 @@ sure to set RAMULATOR_SCHEDULING_POLICY to one of the \
 available policies: FCFS, FRFCFS, FRFCFS_Cap, \
 FRFCFS_PriorHit"); }
 
-    list<Request>::iterator get_head(list<Request>& q)
+    // Same choice as get_head(q), using the bank index of the queue. Within a
+    // bank, all reads (or writes) that hit the open row share their first
+    // command and readiness, and so do all those that miss, so only the oldest
+    // of each of these kinds can be picked. The work per tick is bounded by
+    // the number of banks with requests rather than by the queue length, and
+    // nothing is allocated once the scratch vectors have grown.
+    ReqList::iterator get_head(ReqList& q, ReqBuckets<T>& buckets)
+    {
+        if (!q.size())
+            return q.end();
+        if (buckets.unindexed || buckets.banks.empty())
+            return get_head(q);
+
+        cands.clear();
+        for (int bank : buckets.active) {
+            auto& reqs = buckets.banks[bank];
+            if (policy == Policy::FCFS) {
+                cands.push_back({&reqs.front(), bank, false, false, false});
+                continue;
+            }
+
+            bool bank_open = this->ctrl->is_row_open(reqs.front().req);
+            int open_row = -1;
+            int found = 0;  // kinds seen, bit (is write) * 2 + (is row hit)
+            for (auto& entry : reqs) {
+                auto req = entry.req;
+                if (req->type != Request::Type::READ &&
+                    req->type != Request::Type::WRITE)
+                    return get_head(q);  // e.g. converted to a migration
+
+                int row = req->addr_vec[int(T::Level::Row)];
+                bool hit = false;
+                if (open_row >= 0)
+                    hit = row == open_row;
+                else if (bank_open && this->ctrl->is_row_hit(req)) {
+                    hit = true;
+                    open_row = row;
+                }
+
+                int kind = (req->type == Request::Type::WRITE) * 2 + hit;
+                if (found & (1 << kind))
+                    continue;
+                found |= 1 << kind;
+
+                bool ready = this->ctrl->is_ready(req);
+                if (policy == Policy::FRFCFS_Cap && hit)
+                    ready = ready && (this->ctrl->rowtable->get_hits(req->addr_vec) <= this->cap);
+                cands.push_back({&entry, bank, hit, bank_open, ready});
+                if (found == 0xf)
+                    break;
+            }
+        }
+
+        const Candidate* head = nullptr;
+        if (policy == Policy::FRFCFS_PriorHit) {
+            // the oldest ready row hit goes first
+            for (const auto& cand : cands)
+                if (cand.ready && cand.hit && (!head || older(cand, *head)))
+                    head = &cand;
+            if (head)
+                return head->entry->req;
+
+            // otherwise do not close a row that still has hits pending
+            if (group_hit.size() < size_t(buckets.num_groups))
+                group_hit.resize(buckets.num_groups);
+            for (const auto& cand : cands)
+                if (cand.hit)
+                    group_hit[buckets.group[cand.bank]] = true;
+            for (const auto& cand : cands) {
+                if (!cand.hit && cand.row_open && group_hit[buckets.group[cand.bank]])
+                    continue;
+                if (!head || (cand.ready && !head->ready) ||
+                    (cand.ready == head->ready && older(cand, *head)))
+                    head = &cand;
+            }
+            for (const auto& cand : cands)
+                group_hit[buckets.group[cand.bank]] = false;
+
+            // if we can't find proper request, we need to return q.end(),
+            // so that no command will be scheduled
+            return head ? head->entry->req : q.end();
+        }
+
+        for (const auto& cand : cands) {
+            if (!head || (policy != Policy::FCFS && cand.ready && !head->ready) ||
+                ((policy == Policy::FCFS || cand.ready == head->ready) && older(cand, *head)))
+                head = &cand;
+        }
+        return head->entry->req;
+    }
+
+    ReqList::iterator get_head(ReqList& q)
     {
       // TODO make the decision at compile time
       if (policy != Policy::FRFCFS_PriorHit) {
@@ -140,7 +344,25 @@ FRFCFS_PriorHit"); }
     }
 
 private:
-    typedef list<Request>::iterator ReqIter;
+    typedef ReqList::iterator ReqIter;
+
+    struct Candidate {
+        const typename ReqBuckets<T>::Entry* entry;
+        int bank;
+        bool hit;
+        bool row_open;
+        bool ready;
+    };
+    vector<Candidate> cands;  // scratch for get_head
+    vector<char> group_hit;   // scratch for get_head, all false between calls
+
+    static bool older(const Candidate& cand1, const Candidate& cand2)
+    {
+        if (cand1.entry->arrive != cand2.entry->arrive)
+            return cand1.entry->arrive < cand2.entry->arrive;
+        return cand1.entry->seq < cand2.entry->seq;
+    }
+
     function<ReqIter(ReqIter, ReqIter)> compare[int(Policy::MAX)] = {
         // FCFS
         [this] (ReqIter req1, ReqIter req2) {
@@ -205,37 +427,37 @@ public:
 
     RowPolicy(Controller<T>* ctrl) : ctrl(ctrl) {}
 
-    vector<int> get_victim(typename T::Command cmd)
+    AddrVec get_victim(typename T::Command cmd)
     {
         return policy[int(type)](cmd);
     }
 
 private:
-    function<vector<int>(typename T::Command)> policy[int(Type::MAX)] = {
+    function<AddrVec(typename T::Command)> policy[int(Type::MAX)] = {
         // Closed
-        [this] (typename T::Command cmd) -> vector<int> {
+        [this] (typename T::Command cmd) -> AddrVec {
             for (auto& kv : this->ctrl->rowtable->table) {
                 if (!this->ctrl->is_ready(cmd, kv.first))
                     continue;
                 return kv.first;
             }
-            return vector<int>();},
+            return AddrVec();},
 
         // ClosedAP
-        [this] (typename T::Command cmd) -> vector<int> {
+        [this] (typename T::Command cmd) -> AddrVec {
             for (auto& kv : this->ctrl->rowtable->table) {
                 if (!this->ctrl->is_ready(cmd, kv.first))
                     continue;
                 return kv.first;
             }
-            return vector<int>();},
+            return AddrVec();},
 
         // Opened
         [this] (typename T::Command cmd) {
-            return vector<int>();},
+            return AddrVec();},
 
         // Timeout
-        [this] (typename T::Command cmd) -> vector<int> {
+        [this] (typename T::Command cmd) -> AddrVec {
             for (auto& kv : this->ctrl->rowtable->table) {
                 auto& entry = kv.second;
                 if (this->ctrl->clk - entry.timestamp < timeout)
@@ -244,7 +466,7 @@ private:
                     continue;
                 return kv.first;
             }
-            return vector<int>();}
+            return AddrVec();}
     };
 
 };
@@ -262,15 +484,23 @@ public:
         long timestamp;
     };
 
-    map<vector<int>, Entry> table;
+    // keyed by the levels above Row; the nodes are recycled so that opening
+    // and closing rows does not allocate
+    map<AddrVec, Entry, less<AddrVec>, PoolAllocator<pair<const AddrVec, Entry>>> table;
 
     RowTable(Controller<T>* ctrl) : ctrl(ctrl) {}
 
-    void update(typename T::Command cmd, const vector<int>& addr_vec, long clk)
+private:
+    AddrVec rowgroup_key;  // scratch key for lookups
+
+public:
+
+    void update(typename T::Command cmd, const AddrVec& addr_vec, long clk)
     {
         auto begin = addr_vec.begin();
         auto end = begin + int(T::Level::Row);
-        vector<int> rowgroup(begin, end); // bank or subarray
+        AddrVec rowgroup;
+        rowgroup.assign(begin, end); // bank or subarray
         int row = *end;
 
         T* spec = ctrl->channel->spec;
@@ -309,15 +539,15 @@ public:
         } /* closing */
     }
 
-    int get_hits(const vector<int>& addr_vec, const bool to_opened_row = false)
+    int get_hits(const AddrVec& addr_vec, const bool to_opened_row = false)
     {
         auto begin = addr_vec.begin();
         auto end = begin + int(T::Level::Row);
 
-        vector<int> rowgroup(begin, end);
+        rowgroup_key.assign(begin, end);
         int row = *end;
 
-        auto itr = table.find(rowgroup);
+        auto itr = table.find(rowgroup_key);
         if (itr == table.end())
             return 0;
 
@@ -327,13 +557,13 @@ public:
         return itr->second.hits;
     }
 
-    int get_open_row(const vector<int>& addr_vec) {
+    int get_open_row(const AddrVec& addr_vec) {
         auto begin = addr_vec.begin();
         auto end = begin + int(T::Level::Row);
 
-        vector<int> rowgroup(begin, end);
+        rowgroup_key.assign(begin, end);
 
-        auto itr = table.find(rowgroup);
+        auto itr = table.find(rowgroup_key);
         if(itr == table.end())
             return -1;
 
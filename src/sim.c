@@ -61,6 +61,7 @@
 #include "core.param.h"
 #include "debug/debug.param.h"
 #include "general.param.h"
+#include "memory/memory.param.h"
 
 #include "ramulator.h"
 
@@ -122,6 +123,8 @@ static void init_model(uns mode);
 static void init_output_streams(void);
 static void process_params(void);
 static void reset_uop_mode_counters(void);
+static void warmup_ckpt_check(void);
+static void warmup_ckpt(void);
 
 static inline void    check_heartbeat(uns8 proc_id, Flag final);
 static inline Counter check_forward_progress(uns8 proc_id);
@@ -563,7 +566,8 @@ void uop_sim() {
 
           switch(operating_mode) {
             case WARMUP_MODE:
-              model->warmup_func(&op);
+              if(!WARMUP_CKPT_LOAD)
+                model->warmup_func(&op);
               break;
             case SIMULATION_MODE:
               if(!sim_done[proc_id]) {
@@ -608,6 +612,62 @@ void uop_sim() {
   }
 }
 
+/**************************************************************************************/
+/* warmup_ckpt: Saves the state warmed up by uop_sim to WARMUP_CKPT_SAVE or
+   replaces it with the state in WARMUP_CKPT_LOAD. When the frontend can seek
+   (frontend_can_ckpt), the checkpoint holds its position too and loading
+   skips the warmup instructions entirely. Otherwise uop_sim still reads them
+   (without warming anything up when loading) so that the frontend ends up in
+   the same place. warmup_ckpt_check rejects unsupported configurations before
+   the warmup starts; the model does the same for its parts at init. */
+
+static void warmup_ckpt_check(void) {
+  if(WARMUP_CKPT_SAVE && WARMUP_CKPT_LOAD)
+    FATAL_ERROR(0,
+                "Only one of WARMUP_CKPT_SAVE and WARMUP_CKPT_LOAD can be set\n");
+  if(!WARMUP)
+    FATAL_ERROR(0, "WARMUP_CKPT_SAVE and WARMUP_CKPT_LOAD need a WARMUP\n");
+  if(!model->ckpt_func)
+    FATAL_ERROR(0, "Model %s does not support warmup checkpoints\n",
+                model->name);
+}
+
+static void warmup_ckpt(void) {
+  Ckpt  ckpt;
+  uns64 config[8] = {NUM_CORES,
+                     WARMUP,
+                     FRONTEND,
+                     BP_MECH,
+                     LATE_BP_MECH,
+                     DCACHE_REPL,
+                     L1_CACHE_REPL_POLICY,
+                     frontend_can_ckpt()};
+  uns64 saved[8];
+
+  if(WARMUP_CKPT_LOAD)
+    ckpt_open_restore(&ckpt, WARMUP_CKPT_LOAD);
+  else
+    ckpt_open_save(&ckpt, WARMUP_CKPT_SAVE);
+
+  memcpy(saved, config, sizeof(config));
+  ckpt_region(&ckpt, "config", saved, sizeof(saved));
+  if(memcmp(saved, config, sizeof(config)))
+    FATAL_ERROR(0,
+                "Checkpoint %s was saved with NUM_CORES %llu, WARMUP %llu, "
+                "FRONTEND %llu, BP_MECH %llu, LATE_BP_MECH %llu, DCACHE_REPL "
+                "%llu, L1_CACHE_REPL_POLICY %llu, %s trace seeking\n",
+                ckpt.file_name, saved[0], saved[1], saved[2], saved[3],
+                saved[4], saved[5], saved[6], saved[7] ? "with" : "without");
+
+  if(frontend_can_ckpt())
+    frontend_ckpt(&ckpt);
+  freq_ckpt(&ckpt);
+  sim_time = freq_time();
+  model->ckpt_func(&ckpt);
+  stats_ckpt(&ckpt);
+  ckpt_close(&ckpt);
+}
+
 /**************************************************************************************/
 /* full_sim: This is the main loop for running in full simulation mode.*/
 
@@ -618,10 +678,15 @@ void full_sim() {
 
   /* perform initialization  */
   init_model(WARMUP_MODE);  // make sure this happens before init_op_pool
+  if(WARMUP_CKPT_SAVE || WARMUP_CKPT_LOAD)
+    warmup_ckpt_check();
 
   if(WARMUP) {
     operating_mode = WARMUP_MODE;
-    uop_sim();
+    if(!(WARMUP_CKPT_LOAD && frontend_can_ckpt()))
+      uop_sim();
+    if(WARMUP_CKPT_SAVE || WARMUP_CKPT_LOAD)
+      warmup_ckpt();
     reset_uop_mode_counters();
     reset_stats(FALSE);  // ignore stats accumulated during warmup
     /* The call below resets the cycle counts of all frequency
@@ -659,7 +724,10 @@ void full_sim() {
       break;
     freq_advance_time();
     sim_time = freq_time();
-    model->cycle_func();
+    if(!(IDLE_CYCLE_SKIP && model->idle_func && model->idle_func()))
+      model->cycle_func();
+    else
+      sim_time = freq_time();  // the idle_func may simulate several steps
     if(SIM_MODEL != DUMB_MODEL && DUMB_CORE_ON)
       model_table[DUMB_MODEL].cycle_func();
 
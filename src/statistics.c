@@ -55,6 +55,14 @@ Stat global_stat_sample[] = {
 #undef DEF_STAT
 
 Stat** global_stat_array;
+Flag*  global_stat_written;
+uns*   global_stat_written_log;
+uns    global_stat_num_written;
+
+/**************************************************************************************/
+/* Static prototypes */
+
+static void stat_mark_all_written(void);
 
 /**************************************************************************************/
 // init_global_stats_array:
@@ -79,6 +87,11 @@ void init_global_stats_array() {
     memcpy(global_stat_array[ii], global_stat_sample,
            NUM_GLOBAL_STATS * sizeof(Stat));
   }
+  global_stat_written     = (Flag*)malloc(NUM_CORES * NUM_GLOBAL_STATS *
+                                      sizeof(Flag));
+  global_stat_written_log = (uns*)malloc(NUM_CORES * NUM_GLOBAL_STATS *
+                                         sizeof(uns));
+  stat_mark_all_written();
 }
 
 /**************************************************************************************/
@@ -355,6 +368,7 @@ void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
     else
       s->count = 0;
   }
+  stat_mark_all_written();
 }
 
 /**************************************************************************************/
@@ -385,6 +399,7 @@ void reset_stats(Flag keep_total) {
       }
     }
   }
+  stat_mark_all_written();
 }
 
 /**************************************************************************************/
@@ -420,9 +435,109 @@ Counter get_accum_stat_event(Stat_Enum name) {
   if(name == NUM_GLOBAL_STATS)
     return 0;
 
+  /* total_count only covers the stats up to the last dump_stats() */
   for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    accum += global_stat_array[proc_id][name].total_count;
+    accum += GET_TOTAL_STAT_EVENT(proc_id, name);
   }
 
   return accum;
 }
+
+/**************************************************************************************/
+/* stat_mark_all_written: used after writing counts without the stat macros */
+
+static void stat_mark_all_written(void) {
+  global_stat_num_written = NUM_CORES * NUM_GLOBAL_STATS;
+  for(uns ii = 0; ii < global_stat_num_written; ii++) {
+    global_stat_written[ii]     = TRUE;
+    global_stat_written_log[ii] = ii;
+  }
+}
+
+/**************************************************************************************/
+/* stat_snapshot: brings snapshot (NUM_CORES * NUM_GLOBAL_STATS entries) up to
+ * date with the current interval count of every stat of every core. Only the
+ * stats written since the last call of stat_snapshot or stat_get_deltas are
+ * copied, so there can be only one snapshot, and the first call sees every
+ * stat as written. */
+
+void stat_snapshot(Counter* snapshot) {
+  for(uns ii = 0; ii < global_stat_num_written; ii++) {
+    uns idx                  = global_stat_written_log[ii];
+    global_stat_written[idx] = FALSE;
+    snapshot[idx] = global_stat_array[idx / NUM_GLOBAL_STATS]
+                                     [idx % NUM_GLOBAL_STATS]
+                                       .count;
+  }
+  global_stat_num_written = 0;
+}
+
+/**************************************************************************************/
+/* stat_get_deltas: fills deltas with every counter that changed since
+ * snapshot was brought up to date, in the order the stats were first
+ * written, and brings it up to date again (see stat_snapshot). Returns FALSE
+ * if a float stat changed, since float increments cannot be replayed
+ * exactly. */
+
+Flag stat_get_deltas(Counter* snapshot, Stat_Delta* deltas, uns* num_deltas) {
+  Flag exact  = TRUE;
+  *num_deltas = 0;
+  for(uns ii = 0; ii < global_stat_num_written; ii++) {
+    uns   idx  = global_stat_written_log[ii];
+    Stat* stat = &global_stat_array[idx / NUM_GLOBAL_STATS]
+                                   [idx % NUM_GLOBAL_STATS];
+    global_stat_written[idx] = FALSE;
+    if(stat->count == snapshot[idx])
+      continue;
+    if(stat->type == FLOAT_TYPE_STAT)
+      exact = FALSE;
+    deltas[*num_deltas].count = &stat->count;
+    deltas[*num_deltas].index = idx;
+    deltas[*num_deltas].inc   = stat->count - snapshot[idx];
+    (*num_deltas)++;
+    snapshot[idx] = stat->count;
+  }
+  global_stat_num_written = 0;
+  return exact;
+}
+
+/**************************************************************************************/
+/* stat_apply_deltas: adds each delta times times */
+
+void stat_apply_deltas(const Stat_Delta* deltas, uns num_deltas,
+                       Counter times) {
+  for(uns ii = 0; ii < num_deltas; ii++) {
+    *deltas[ii].count += deltas[ii].inc * times;
+    STAT_WRITTEN(deltas[ii].index / NUM_GLOBAL_STATS,
+                 deltas[ii].index % NUM_GLOBAL_STATS);
+  }
+}
+
+/**************************************************************************************/
+/* stats_ckpt: saves or restores the counts of every stat of every core, so
+ * that NORESET stats accumulated during warmup survive a warmup checkpoint */
+
+void stats_ckpt(Ckpt* ckpt) {
+  uns      num    = NUM_CORES * NUM_GLOBAL_STATS;
+  Counter* counts = (Counter*)malloc(sizeof(Counter) * num * 2);
+
+  if(!ckpt->restoring) {
+    for(uns ii = 0; ii < num; ii++) {
+      Stat* stat = &global_stat_array[ii / NUM_GLOBAL_STATS]
+                                     [ii % NUM_GLOBAL_STATS];
+      counts[2 * ii]     = stat->count;
+      counts[2 * ii + 1] = stat->total_count;
+    }
+  }
+  ckpt_region(ckpt, "stats", counts, sizeof(Counter) * num * 2);
+  if(ckpt->restoring) {
+    for(uns ii = 0; ii < num; ii++) {
+      Stat* stat = &global_stat_array[ii / NUM_GLOBAL_STATS]
+                                     [ii % NUM_GLOBAL_STATS];
+      stat->count       = counts[2 * ii];
+      stat->total_count = counts[2 * ii + 1];
+    }
+    stat_mark_all_written();
+  }
+  free(counts);
+}
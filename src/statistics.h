@@ -33,6 +33,7 @@
 #include "core.param.h"
 #include "general.param.h"
 #include "globals/global_defs.h"
+#include "libs/ckpt_lib.h"
 
 
 /**************************************************************************************/
@@ -89,42 +90,72 @@ typedef struct Stat_struct {
   Flag noreset;  // this stat does not get reset (name has prefix "NORESET")
 } Stat;
 
+/* Per-cycle change of one counter, see stat_get_deltas() */
+typedef struct Stat_Delta_struct {
+  Counter* count;  // &global_stat_array[proc_id][stat].count
+  uns      index;  // proc_id * NUM_GLOBAL_STATS + stat
+  Counter  inc;
+} Stat_Delta;
+
 
 /**************************************************************************************/
 /* Macros */
 
 #ifndef NO_STAT
+/* Logs the first write of a stat since the last stat_snapshot() or
+   stat_get_deltas(), so that they look at the written stats only. Only idle
+   cycle skipping uses the log, so it is not kept without IDLE_CYCLE_SKIP. */
+#define STAT_WRITTEN(proc_id, stat)                                     \
+  do {                                                                  \
+    if(IDLE_CYCLE_SKIP) {                                               \
+      uns stat_idx_ = (proc_id)*NUM_GLOBAL_STATS + (stat);              \
+      if(!global_stat_written[stat_idx_]) {                             \
+        global_stat_written[stat_idx_]                     = TRUE;      \
+        global_stat_written_log[global_stat_num_written++] = stat_idx_; \
+      }                                                                 \
+    }                                                                   \
+  } while(0)
+
 #define STAT_EVENT(proc_id, stat)             \
   do {                                        \
     global_stat_array[proc_id][stat].count++; \
+    STAT_WRITTEN(proc_id, stat);              \
   } while(0)
 
 #define STAT_EVENT_ALL(stat)                             \
   do {                                                   \
     for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
-      global_stat_array[proc_id][stat].count++;          \
+      STAT_EVENT(proc_id, stat);                         \
   } while(0)
 
 #define INC_STAT_EVENT(proc_id, stat, inc)           \
   do {                                               \
     global_stat_array[proc_id][stat].count += (inc); \
+    STAT_WRITTEN(proc_id, stat);                     \
   } while(0)
 
 #define INC_STAT_EVENT_ALL(stat, inc)                    \
   do {                                                   \
     for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
-      global_stat_array[proc_id][stat].count += (inc);   \
+      INC_STAT_EVENT(proc_id, stat, inc);                \
   } while(0)
 
 #define INC_STAT_VALUE(proc_id, stat, inc)           \
   do {                                               \
     global_stat_array[proc_id][stat].value += (inc); \
+    STAT_WRITTEN(proc_id, stat);                     \
   } while(0)
 
 #define INC_STAT_VALUE_ALL(stat, inc)                    \
   do {                                                   \
     for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
-      global_stat_array[proc_id][stat].value += (inc);   \
+      INC_STAT_VALUE(proc_id, stat, inc);                \
+  } while(0)
+
+#define SET_STAT_EVENT(proc_id, stat, val)          \
+  do {                                              \
+    global_stat_array[proc_id][stat].count = (val); \
+    STAT_WRITTEN(proc_id, stat);                    \
   } while(0)
 
 #define GET_STAT_EVENT(proc_id, stat) (global_stat_array[proc_id][stat].count)
@@ -147,6 +178,7 @@ typedef struct Stat_struct {
 #define INC_STAT_EVENT_ALL(stat, inc)
 #define INC_STAT_VALUE(proc_id, stat, inc)
 #define INC_STAT_VALUE_ALL(stat, inc)
+#define SET_STAT_EVENT(proc_id, stat, val)
 #define GET_STAT_EVENT(proc_id, stat) 0
 #define GET_TOTAL_STAT_EVENT(proc_id, stat) 0
 #define GET_TOTAL_STAT_VALUE(proc_id, stat)
@@ -161,6 +193,9 @@ typedef struct Stat_struct {
 
 #ifndef NO_STAT
 extern Stat** global_stat_array;
+extern Flag*  global_stat_written;  // [proc_id * NUM_GLOBAL_STATS + stat]
+extern uns*   global_stat_written_log;  // indices of the written stats
+extern uns    global_stat_num_written;
 #endif
 
 
@@ -176,6 +211,12 @@ void        fprint_line(FILE*);
 Stat_Enum   get_stat_idx(const char* name);
 const Stat* get_stat(uns8, const char*);
 Counter     get_accum_stat_event(Stat_Enum name);
+void        stat_snapshot(Counter* snapshot);
+Flag        stat_get_deltas(Counter* snapshot, Stat_Delta* deltas,
+                            uns* num_deltas);
+void        stat_apply_deltas(const Stat_Delta* deltas, uns num_deltas,
+                              Counter times);
+void        stats_ckpt(Ckpt* ckpt);
 
 
 /**************************************************************************************/
@@ -0,0 +1,298 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : test/bp_bench.cc
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Microbenchmark for the TAGE-SC-L predictors. A synthetic
+ *                branch stream with a large static footprint (loops, biased,
+ *                history-correlated and patterned branches, calls and direct
+ *                and indirect jumps) is replayed through the bp_table.def entry
+ *                points in the order bp.c calls them. "make
+ *                bp_bench_compare" runs it against the previous version of
+ *                bp/template_lib as well; the checksums must match.
+ ***************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+extern "C" {
+#include "bp/bp.h"
+#include "bp/tagescl.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+}
+
+/**************************************************************************************/
+/* Stubs for the parameters and globals that the predictors use */
+
+extern "C" {
+uns BP_MECH         = TAGESCL_BP;
+uns NODE_TABLE_SIZE = 256;
+uns NUM_CORES       = 1;
+
+FILE*                mystdout;
+FILE*                mystderr;
+FILE*                mystatus;
+Counter              cycle_count;
+Counter*             op_count;
+Counter*             inst_count;
+
+void breakpoint(const char file[], const int line) {}
+}
+
+/**************************************************************************************/
+/* Synthetic program */
+
+#define NUM_FUNCS 2048
+#define HOT_FUNCS 64
+#define WINDOW 32 /* in-flight branches between prediction and update */
+
+typedef enum Bench_Kind_enum {
+  KIND_LOOP,        // loop back-edge, taken param - 1 times in a row
+  KIND_BIASED,      // taken with probability param / 256
+  KIND_CORRELATED,  // xor of two older outcomes, param branches back
+  KIND_PATTERN,     // repeats the 8-bit pattern param
+  KIND_RANDOM,      // coin flip
+  KIND_UNCOND,      // call, direct or indirect jump (cf_type says which)
+} Bench_Kind;
+
+typedef struct Bench_Branch_struct {
+  Addr       pc;
+  Addr       target;
+  Cf_Type    cf_type;
+  Bench_Kind kind;
+  uns        param;
+  uns        count;
+} Bench_Branch;
+
+typedef struct Bench_Func_struct {
+  uns first; /* index of the first branch of the body in branches */
+  uns num;   /* the last one is the loop back-edge */
+} Bench_Func;
+
+static std::vector<Bench_Branch> branches;
+static Bench_Func                funcs[NUM_FUNCS];
+static uns64                     rand_state = 88172645463325252ULL;
+static uns64                     outcomes; /* most recent outcome in bit 0 */
+
+static inline uns64 bench_rand(void) {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void build_program(void) {
+  Addr pc = 0x400000;
+  for(uns ii = 0; ii < NUM_FUNCS; ii++) {
+    uns num         = 4 + bench_rand() % 44;
+    funcs[ii].first = branches.size();
+    funcs[ii].num   = num;
+    for(uns jj = 0; jj < num; jj++) {
+      Bench_Branch br = {};
+      uns          r  = bench_rand() % 100;
+      pc += 4 + (bench_rand() % 12) * 2;
+      br.pc      = pc;
+      br.target  = pc + 16 + bench_rand() % 256;
+      br.cf_type = CF_CBR;
+      if(jj == num - 1) {
+        br.kind   = KIND_LOOP;
+        br.param  = 1 + bench_rand() % 12;
+        br.target = pc - 64;
+      } else if(r < 40) {
+        br.kind  = KIND_BIASED;
+        br.param = bench_rand() & 1 ? 250 : 6;
+      } else if(r < 65) {
+        br.kind  = KIND_CORRELATED;
+        br.param = 1 + bench_rand() % 40;
+      } else if(r < 80) {
+        br.kind  = KIND_PATTERN;
+        br.param = bench_rand() & 0xff;
+      } else if(r < 85) {
+        br.kind = KIND_RANDOM;
+      } else {
+        br.kind    = KIND_UNCOND;
+        br.cf_type = r < 93 ? CF_CALL : r < 97 ? CF_IBR : CF_BR;
+      }
+      branches.push_back(br);
+    }
+    pc += 64;
+  }
+}
+
+static Flag resolve_dir(Bench_Branch* br) {
+  Flag dir;
+  switch(br->kind) {
+    case KIND_LOOP:
+      dir       = ++br->count < br->param;
+      br->count = dir ? br->count : 0;
+      break;
+    case KIND_BIASED:
+      dir = (bench_rand() & 0xff) < br->param;
+      break;
+    case KIND_CORRELATED:
+      dir = ((outcomes >> br->param) ^ (outcomes >> (br->param / 2))) & 1;
+      break;
+    case KIND_PATTERN:
+      dir = (br->param >> (br->count++ & 7)) & 1;
+      break;
+    case KIND_RANDOM:
+      dir = bench_rand() & 1;
+      break;
+    default:
+      dir = TAKEN;
+      break;
+  }
+  outcomes = (outcomes << 1) | dir;
+  return dir;
+}
+
+/**************************************************************************************/
+/* Replay */
+
+typedef struct Bench_Slot_struct {
+  Op         op;
+  Inst_Info  inst_info;
+  Table_Info table_info;
+} Bench_Slot;
+
+static Bench_Slot slots[WINDOW];
+static uns        head, num_in_flight;
+
+static void retire_oldest(const Bp* bp) {
+  Op* op = &slots[head].op;
+  bp->update_func(op);
+  bp->retire_func(op);
+  head = (head + 1) % WINDOW;
+  num_in_flight--;
+}
+
+/* Predicts one branch the way bp_predict_op does and returns its op. */
+static Op* predict_branch(const Bp* bp, Bench_Branch* br, Flag dir) {
+  Bench_Slot* slot;
+  Op*         op;
+
+  if(num_in_flight == WINDOW)
+    retire_oldest(bp);
+  slot = &slots[(head + num_in_flight++) % WINDOW];
+  op   = &slot->op;
+
+  slot->inst_info.addr           = br->pc;
+  slot->table_info.cf_type       = br->cf_type;
+  op->proc_id                    = 0;
+  op->inst_info                  = &slot->inst_info;
+  op->table_info                 = &slot->table_info;
+  op->oracle_info.dir            = dir;
+  op->oracle_info.target         = br->target;
+  op->recovery_info.proc_id      = 0;
+  op->recovery_info.new_dir      = dir;
+  op->recovery_info.PC           = br->pc;
+  op->recovery_info.cf_type      = br->cf_type;
+  op->recovery_info.oracle_dir   = dir;
+  op->recovery_info.branchTarget = br->target;
+
+  bp->timestamp_func(op);
+  op->oracle_info.pred = br->cf_type == CF_CBR ? bp->pred_func(op) : TAKEN;
+  bp->spec_update_func(op);
+  op->oracle_info.mispred = op->oracle_info.pred != dir;
+  return op;
+}
+
+static void bench_replay(const Bp* bp, uns64 num_branches) {
+  uns64  num_cbrs = 0, num_mispreds = 0, checksum = 0, ii = 0;
+  double start;
+
+  bp->init_func();
+  start = now_ns();
+  while(ii < num_branches) {
+    uns         func = bench_rand() % 8 ? bench_rand() % HOT_FUNCS :
+                                          bench_rand() % NUM_FUNCS;
+    Bench_Func* f    = &funcs[func];
+    uns         jj;
+
+    for(jj = 0; jj < f->num && ii < num_branches; ii++) {
+      Bench_Branch* br  = &branches[f->first + jj];
+      Flag          dir = resolve_dir(br);
+      Op*           op  = predict_branch(bp, br, dir);
+
+      num_cbrs += br->cf_type == CF_CBR;
+      checksum = checksum * 31 + op->oracle_info.pred;
+      if(op->oracle_info.mispred) {
+        // the younger branches would have been on the wrong path, so recover
+        // right away and drain the window
+        num_mispreds++;
+        bp->recover_func(&op->recovery_info);
+        while(num_in_flight)
+          retire_oldest(bp);
+      }
+      // loop back-edges jump to the top of the body
+      jj = br->kind == KIND_LOOP && dir ? 0 : jj + 1;
+    }
+  }
+  while(num_in_flight)
+    retire_oldest(bp);
+
+  printf("%-10s %10llu br %10llu cbr %8.3f mispred/kcbr %7.2f ns/br  "
+         "checksum %016llx\n",
+         bp->name, (unsigned long long)num_branches,
+         (unsigned long long)num_cbrs, 1000.0 * num_mispreds / num_cbrs,
+         (now_ns() - start) / num_branches, (unsigned long long)checksum);
+  fflush(stdout);
+}
+
+/**************************************************************************************/
+
+int main(int argc, char* argv[]) {
+  /* the same rows as bp_table.def */
+  static const Bp bench_bps[] = {
+    {TAGESCL_BP, "tagescl", bp_tagescl_init, bp_tagescl_timestamp,
+     bp_tagescl_pred, bp_tagescl_spec_update, bp_tagescl_update,
+     bp_tagescl_retire, bp_tagescl_recover, NULL},
+    {TAGESCL80_BP, "tagescl80", bp_tagescl_init, bp_tagescl_timestamp,
+     bp_tagescl_pred, bp_tagescl_spec_update, bp_tagescl_update,
+     bp_tagescl_retire, bp_tagescl_recover, NULL},
+  };
+  uns64     num_branches = argc > 1 ? strtoull(argv[1], NULL, 0) : 20000000;
+  const Bp* bp          = &bench_bps[argc > 2 && !strcmp(argv[2], "tagescl80")];
+
+  mystdout = stdout;
+  mystderr = stderr;
+  mystatus = stdout;
+
+  // The predictors are created once per process, so one per run.
+  BP_MECH = bp->id;
+  build_program();
+  bench_replay(bp, num_branches);
+  return 0;
+}
@@ -0,0 +1,221 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : test/hash_lib_bench.c
+ * Author       : HPS Research Group
+ * Date         : 10/16/2026
+ * Description  : Microbenchmarks for libs/hash_lib.c. The workloads mimic the
+ *                main users of the library: the per-core inst_info_hash, the
+ *                oracle memory dependence map, and a table that is created far
+ *                too small. "make hash_lib_bench_compare" runs them against the
+ *                previous version of hash_lib as well; the checksums must
+ *                match.
+ ***************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "libs/hash_lib.h"
+
+/**************************************************************************************/
+/* Stubs for the globals that the assertion macros use */
+
+FILE*                mystdout;
+FILE*                mystderr;
+FILE*                mystatus;
+Counter              cycle_count;
+Counter*             op_count;
+Counter*             inst_count;
+
+extern void print_backtrace(void);
+
+void breakpoint(const char file[], const int line) {}
+
+/**************************************************************************************/
+/* Helpers */
+
+typedef struct Bench_Data_struct {
+  uns64 key;
+  uns64 count;
+  uns64 pad[2];  // roughly the size of a Mem_Map_Entry
+} Bench_Data;
+
+static uns64 rand_state = 88172645463325252ULL;
+
+static inline uns64 bench_rand(void) {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void report(const char* name, uns64 ops, double start,
+                   uns64 checksum) {
+  printf("%-24s %10llu ops %8.2f ns/op  checksum %016llx\n", name,
+         (unsigned long long)ops, (now_ns() - start) / ops,
+         (unsigned long long)checksum);
+  fflush(stdout);
+}
+
+static void sum_data(void* data, void* arg) {
+  *(uns64*)arg += ((Bench_Data*)data)->count;
+}
+
+/**************************************************************************************/
+/* inst_info: a hot working set of PCs looked up with access_create, like
+   uop_generator.c does for every fetched instruction. */
+
+static void bench_inst_info(void) {
+  const uns   num_pcs = 64 * 1024;
+  const uns64 num_ops = 8 * 1024 * 1024;
+  Hash_Table  table;
+  Addr*       pcs = (Addr*)malloc(num_pcs * sizeof(Addr));
+  Addr        pc  = 0x400000;
+  uns64       checksum = 0;
+  uns64       ii;
+  double      start;
+
+  for(ii = 0; ii < num_pcs; ii++) {
+    pc += 1 + bench_rand() % 15;
+    pcs[ii] = pc;
+  }
+
+  init_hash_table(&table, "inst_info", 500021, sizeof(Bench_Data));
+  start = now_ns();
+  for(ii = 0; ii < num_ops; ii++) {
+    // mostly short loops over nearby PCs, with occasional jumps
+    uns         index = (ii % 64 + (bench_rand() % 16 ? ii / 4096 * 64 : 0) +
+                 bench_rand() % 4) %
+                num_pcs;
+    Flag        new_entry;
+    Bench_Data* data = (Bench_Data*)hash_table_access_create(
+      &table, pcs[index], &new_entry);
+    if(new_entry) {
+      data->key   = pcs[index];
+      data->count = 0;
+    }
+    data->count++;
+    checksum += data->key;
+  }
+  report("inst_info create", num_ops, start, checksum);
+  free(pcs);
+}
+
+/**************************************************************************************/
+/* mem_map: a sliding window of in-flight store addresses that are inserted,
+   probed by loads and deleted at retirement, like the oracle_mem_hash in
+   map.c. */
+
+static void bench_mem_map(void) {
+  const uns   window  = 512;
+  const uns64 num_ops = 4 * 1024 * 1024;
+  Hash_Table  table;
+  Addr        stores[512];
+  uns64       checksum = 0;
+  uns64       ii;
+  uns         jj;
+  double      start;
+
+  init_hash_table(&table, "mem_map", 512, sizeof(Bench_Data));
+  start = now_ns();
+  for(ii = 0; ii < num_ops; ii++) {
+    Addr        addr = (0x7fff0000 + (bench_rand() % (1 << 20))) & ~(Addr)7;
+    Flag        new_entry;
+    Bench_Data* data;
+
+    if(ii >= window) {
+      hash_table_access_delete(&table, stores[ii % window]);
+    }
+    data = (Bench_Data*)hash_table_access_create(&table, addr, &new_entry);
+    if(new_entry) {
+      data->key   = addr;
+      data->count = 0;
+    }
+    data->count++;
+    stores[ii % window] = addr;
+
+    for(jj = 0; jj < 4; jj++) {
+      Addr load = jj & 1 ? stores[bench_rand() % window] : addr + 8 * jj;
+      data      = (Bench_Data*)hash_table_access(&table, load);
+      checksum += data ? data->count : 1;
+    }
+  }
+  report("mem_map churn", num_ops * 6, start, checksum);
+}
+
+/**************************************************************************************/
+/* grow: a table created with far too few buckets. */
+
+static void bench_grow(void) {
+  const uns64 num_keys = 64 * 1024;
+  Hash_Table  table;
+  uns64       checksum = 0;
+  uns64       ii;
+  double      start;
+
+  init_hash_table(&table, "grow", 101, sizeof(Bench_Data));
+  start = now_ns();
+  for(ii = 0; ii < num_keys; ii++) {
+    Flag        new_entry;
+    Bench_Data* data = (Bench_Data*)hash_table_access_create(
+      &table, ii * 64, &new_entry);
+    data->key   = ii * 64;
+    data->count = ii;
+  }
+  for(ii = 0; ii < num_keys; ii++)
+    checksum += ((Bench_Data*)hash_table_access(&table, ii * 64))->count;
+  report("grow insert+lookup", num_keys * 2, start, checksum);
+
+  checksum = 0;
+  start    = now_ns();
+  for(ii = 0; ii < 64; ii++)
+    hash_table_scan(&table, sum_data, &checksum);
+  report("grow scan", num_keys * 64, start, checksum);
+
+  start = now_ns();
+  hash_table_clear(&table);
+  report("grow clear", num_keys, start, table.count);
+}
+
+/**************************************************************************************/
+
+int main(int argc, char* argv[]) {
+  mystdout = stdout;
+  mystderr = stderr;
+  mystatus = stdout;
+
+  bench_inst_info();
+  bench_mem_map();
+  bench_grow();
+  return 0;
+}
@@ -44,8 +44,14 @@ struct Trigger_struct {
   Trigger_Type type;
   Counter      period;
   Counter      next_threshold;
+  Trigger*     next;  // in the list of live triggers, see trigger_scan()
 };
 
+/**************************************************************************************/
+/* Global variables */
+
+static Trigger* triggers = NULL;
+
 /**************************************************************************************/
 /* Implementation */
 
@@ -56,6 +62,8 @@ Trigger* trigger_create(const char* name, const char* spec, Trigger_Type type) {
   trigger->name    = strdup(name);
   ASSERT(0, type < TRIGGER_NUM_ELEMS);
   trigger->type = type;
+  trigger->next = triggers;
+  triggers      = trigger;
 
   if(!strcmp(spec, "none") || !strcmp(spec, "never")) {
     trigger->stat  = NULL;
@@ -165,6 +173,20 @@ double trigger_progress(Trigger* trigger) {
 }
 
 void trigger_free(Trigger* trigger) {
+  for(Trigger** link = &triggers; *link; link = &(*link)->next) {
+    if(*link == trigger) {
+      *link = trigger->next;
+      break;
+    }
+  }
   free(trigger->name);
   free(trigger);
 }
+
+void trigger_scan(void (*func)(const Stat* stat, Counter threshold, void* arg),
+                  void* arg) {
+  for(Trigger* trigger = triggers; trigger; trigger = trigger->next) {
+    if(trigger->armed)
+      func(trigger->stat, trigger->next_threshold, arg);
+  }
+}
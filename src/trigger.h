@@ -32,6 +32,7 @@
 #define __TRIGGER_H__
 
 #include "globals/global_types.h"
+#include "statistics.h"
 
 /**************************************************************************************/
 /* Types */
@@ -58,4 +59,9 @@ double trigger_progress(Trigger* trigger);
 
 void trigger_free(Trigger* trigger);
 
+/* Calls func for every armed trigger with the stat it watches and the
+   total count of that stat at which it fires next */
+void trigger_scan(void (*func)(const Stat* stat, Counter threshold, void* arg),
+                  void* arg);
+
 #endif  // __TRIGGER_H__